@@ -17,6 +17,7 @@
 #pragma GCC diagnostic pop
 
 #include <iostream>
+#include <map>
 #include <set>
 #include <algorithm>
 #include <iterator>
@@ -108,22 +109,39 @@ int main(int argc, char **argv)
 
         vector<string> external_directories;
         vector<string> custom_directories;
+        vector<string> cache_ttls;
+        vector<string> include_interfaces;
+        vector<string> exclude_interfaces;
+        vector<string> include_mountpoints;
+        vector<string> exclude_mountpoints;
 
         // Build a list of options visible on the command line
         // Keep this list sorted alphabetically
         po::options_description visible_options("");
         visible_options.add_options()
+            ("cache-ttl", po::value<vector<string>>(&cache_ttls), "Sets the time-to-live, in seconds, of a resolver's cached facts (e.g. \"processor=3600\").\nUse 0 to disable caching for the resolver.")
             ("color", "Enables color output.")
+            ("command-cache", "Runs each distinct command once while resolving facts and reuses its output.")
+            ("command-fallbacks", "Allows facts to be resolved by running slower external commands (e.g. lsb_release or virt-what)\nwhen their native sources are incomplete.")
+            ("compact", "Output JSON without whitespace.")
             ("custom-dir", po::value<vector<string>>(&custom_directories), "A directory to use for custom facts.")
             ("debug,d", "Enable debug output.")
+            ("exclude-interface", po::value<vector<string>>(&exclude_interfaces), "A pattern of network interface names to exclude from networking facts (e.g. \"veth*\").")
+            ("exclude-mountpoint", po::value<vector<string>>(&exclude_mountpoints), "A pattern of mountpoint paths or file system types to exclude from file system facts (e.g. \"tmpfs\").")
             ("external-dir", po::value<vector<string>>(&external_directories), "A directory to use for external facts.")
             ("help", "Print this help message.")
+            ("include-interface", po::value<vector<string>>(&include_interfaces), "A pattern of network interface names to include in networking facts.\nOther interfaces are excluded.")
+            ("include-mountpoint", po::value<vector<string>>(&include_mountpoints), "A pattern of mountpoint paths or file system types to include in file system facts.\nOther mountpoints are excluded.")
             ("json,j", "Output in JSON format.")
             ("log-level,l", po::value<level>()->default_value(level::warning, "warn"), "Set logging level.\nSupported levels are: none, trace, debug, info, warn, error, and fatal.")
+            ("msgpack", "Output in MessagePack binary format.")
+            ("no-cache", "Disables the fact cache.")
             ("no-color", "Disables color output.")
             ("no-custom-facts", "Disables custom facts.")
             ("no-external-facts", "Disables external facts.")
             ("no-ruby", "Disables loading Ruby, facts requiring Ruby, and custom facts.")
+            ("refresh-cache", "Resolves all cached facts and refreshes the fact cache.")
+            ("threads", po::value<unsigned int>()->default_value(0), "The number of threads used to resolve facts.\nUse 0 for one thread per processor or 1 to resolve facts serially.")
             ("trace", "Enable backtraces for custom facts.")
             ("verbose", "Enable verbose (info) output.")
             ("version,v", "Print the version and exit.")
@@ -159,8 +177,11 @@ int main(int argc, char **argv)
             if (vm.count("color") && vm.count("no-color")) {
                 throw po::error("color and no-color options conflict: please specify only one.");
             }
-            if (vm.count("json") && vm.count("yaml")) {
-                throw po::error("json and yaml options conflict: please specify only one.");
+            if ((vm.count("json") + vm.count("yaml") + vm.count("msgpack")) > 1) {
+                throw po::error("json, yaml, and msgpack options conflict: please specify only one.");
+            }
+            if (vm.count("compact") && !vm.count("json")) {
+                throw po::error("compact option requires the json option.");
             }
             if (vm.count("no-external-facts") && vm.count("external-dir")) {
                 throw po::error("no-external-facts and external-dir options conflict: please specify only one.");
@@ -174,6 +195,9 @@ int main(int argc, char **argv)
             if (vm.count("no-ruby") && vm.count("custom-dir")) {
               throw po::error("no-ruby and custom-dir options conflict: please specify only one.");
             }
+            if (vm.count("no-cache") && (vm.count("refresh-cache") || vm.count("cache-ttl"))) {
+                throw po::error("no-cache and refresh-cache or cache-ttl options conflict: please specify only one.");
+            }
         }
         catch (exception& ex) {
             colorize(boost::nowide::cerr, level::error);
@@ -234,6 +258,37 @@ int main(int argc, char **argv)
         log_queries(queries);
 
         collection facts;
+        facts.concurrency(vm["threads"].as<unsigned int>());
+        facts.interface_filter(name_filter(move(include_interfaces), move(exclude_interfaces)));
+        facts.mountpoint_filter(name_filter(move(include_mountpoints), move(exclude_mountpoints)));
+        facts.command_fallbacks(vm.count("command-fallbacks") == 1);
+        if (vm.count("command-cache")) {
+            facts.enable_command_cache();
+        }
+
+        if (!vm.count("no-cache")) {
+            // Cache the facts that rarely change by default
+            map<string, int64_t> ttls = {
+                { "disk", 3600 },
+                { "EC2", 3600 },
+                { "operating system", 3600 },
+                { "processor", 86400 },
+                { "ssh", 86400 },
+            };
+            for (auto const& ttl : cache_ttls) {
+                auto pos = ttl.rfind('=');
+                if (pos == string::npos || pos == 0) {
+                    log(level::warning, "ignoring invalid cache-ttl \"%1%\": expected resolver=seconds.", ttl);
+                    continue;
+                }
+                try {
+                    ttls[ttl.substr(0, pos)] = stoll(ttl.substr(pos + 1));
+                } catch (exception&) {
+                    log(level::warning, "ignoring invalid cache-ttl \"%1%\": expected resolver=seconds.", ttl);
+                }
+            }
+            facts.enable_cache(move(ttls), vm.count("refresh-cache") == 1);
+        }
         facts.add_default_facts(ruby);
 
         if (!vm.count("no-external-facts")) {
@@ -250,12 +305,19 @@ int main(int argc, char **argv)
         // Output the facts
         format fmt = format::hash;
         if (vm.count("json")) {
-            fmt = format::json;
+            fmt = vm.count("compact") ? format::compact_json : format::json;
         } else if (vm.count("yaml")) {
             fmt = format::yaml;
+        } else if (vm.count("msgpack")) {
+            fmt = format::msgpack;
         }
         facts.write(boost::nowide::cout, fmt, queries);
-        boost::nowide::cout << endl;
+        if (fmt == format::msgpack) {
+            // Binary output is not terminated with a newline
+            boost::nowide::cout.flush();
+        } else {
+            boost::nowide::cout << endl;
+        }
     } catch (exception& ex) {
         log(level::fatal, "unhandled exception: %1%", ex.what());
     }
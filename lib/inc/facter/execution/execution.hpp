@@ -11,6 +11,7 @@
 #include <utility>
 #include <stdexcept>
 #include <functional>
+#include <memory>
 #include "../util/option_set.hpp"
 #include "../util/environment.hpp"
 #include "../export.h"
@@ -180,6 +181,99 @@ namespace facter { namespace execution {
         size_t _pid;
     };
 
+    /**
+     * Represents the hit and miss counts of the command cache.
+     */
+    struct LIBFACTER_EXPORT command_cache_statistics
+    {
+        /**
+         * Stores the number of commands whose results were returned from the cache.
+         */
+        size_t command_hits;
+
+        /**
+         * Stores the number of commands that were executed because their results were not cached.
+         */
+        size_t command_misses;
+
+        /**
+         * Stores the number of executable searches that were answered from the cache.
+         */
+        size_t path_hits;
+
+        /**
+         * Stores the number of executable searches that probed the search paths.
+         */
+        size_t path_misses;
+    };
+
+    struct command_cache_state;
+
+    /**
+     * Memoizes command results and executable paths for its lifetime.
+     * While a command cache is current on the calling thread, a command executed with the same executable, arguments,
+     * environment and options as an earlier command returns the earlier command's output and status rather than being run again.
+     * Commands that time out or whose output callback stops early are not cached.
+     * The results of which are also cached so that the search paths are probed once per executable.
+     * Each command cache keeps its own results and statistics; see command_cache::scope.
+     */
+    struct LIBFACTER_EXPORT command_cache
+    {
+        /**
+         * Constructs a command cache.
+         */
+        command_cache();
+
+        /**
+         * Destructs the command cache and discards the cached results.
+         */
+        ~command_cache();
+
+        /**
+         * Prevents the command cache from being copied.
+         */
+        command_cache(command_cache const&) = delete;
+
+        /**
+         * Prevents the command cache from being copied.
+         * @returns Returns this command cache.
+         */
+        command_cache& operator=(command_cache const&) = delete;
+
+        /**
+         * Gets the hit and miss counts since the command cache was constructed.
+         * @return Returns the hit and miss counts.
+         */
+        command_cache_statistics statistics() const;
+
+        /**
+         * Makes a command cache current on the calling thread for the lifetime of the scope.
+         * The previously current command cache is restored when the scope ends.
+         */
+        struct LIBFACTER_EXPORT scope
+        {
+            /**
+             * Constructs the scope and makes the given command cache current.
+             * @param cache The command cache to make current; nullptr to execute commands without caching.
+             */
+            explicit scope(command_cache* cache);
+
+            /**
+             * Restores the previously current command cache.
+             */
+            ~scope();
+
+         private:
+            scope(scope const&) = delete;
+            scope& operator=(scope const&) = delete;
+
+            command_cache_state* _previous;
+        };
+
+     private:
+        std::unique_ptr<command_cache_state> _state;
+    };
+
     /**
      * Searches the given paths for the given executable file.
      * @param file The file to search for.
@@ -12,6 +12,20 @@
 
 namespace facter { namespace facts {
 
+    struct array_value;
+
+    /**
+     * The type tag for array values.
+     */
+    template <>
+    struct value_tag<array_value>
+    {
+        /**
+         * The type tag of array values.
+         */
+        static const value_type type = value_type::array;
+    };
+
     /**
      * Represents an array of values.
      * This type can be moved but cannot be copied.
@@ -23,7 +37,7 @@ namespace facter { namespace facts {
          * @param hidden True if the fact is hidden from output by default or false if not.
          */
         array_value(bool hidden = false) :
-            value(hidden)
+            value(value_type::array, hidden)
         {
         }
 
@@ -92,7 +106,7 @@ namespace facter { namespace facts {
          */
         template <typename T = value> T const* get(size_t i) const
         {
-            return dynamic_cast<T const*>(_elements.at(i).get());
+            return value_cast<T>(_elements.at(i).get());
         }
 
         /**
@@ -102,6 +116,18 @@ namespace facter { namespace facts {
          */
         value const* operator[](size_t i) const;
 
+        /**
+          * Writes the value to the given JSON writer.
+          * @param writer The JSON writer to write to.
+          */
+        virtual void write(json_writer& writer) const override;
+
+        /**
+          * Writes the value to the given MessagePack writer.
+          * @param writer The MessagePack writer to write to.
+          */
+        virtual void write(msgpack_writer& writer) const override;
+
         /**
           * Writes the value to the given stream.
           * @param os The stream to write to.
@@ -6,6 +6,7 @@
 
 #include "resolver.hpp"
 #include "value.hpp"
+#include "name_filter.hpp"
 #include "external/resolver.hpp"
 #include "../export.h"
 #include <list>
@@ -17,6 +18,15 @@
 #include <functional>
 #include <stdexcept>
 #include <iostream>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+namespace facter { namespace execution {
+
+    struct command_cache;
+
+}}  // namespace facter::execution
 
 namespace facter { namespace facts {
 
@@ -33,10 +43,34 @@ namespace facter { namespace facts {
          * Use JSON as the format.
          */
         json,
+        /**
+         * Use JSON without whitespace as the format.
+         */
+        compact_json,
         /**
          * Use YAML as the format.
          */
-        yaml
+        yaml,
+        /**
+         * Use the MessagePack binary format; the facts are written as a map.
+         */
+        msgpack
+    };
+
+    struct resolver_index;
+    struct fact_cache;
+    struct value_arena;
+
+    /**
+     * Thrown when adding a resolver would create a circular dependency between resolvers.
+     */
+    struct LIBFACTER_EXPORT circular_dependency_exception : std::runtime_error
+    {
+        /**
+         * Constructs a circular_dependency_exception.
+         * @param message The exception message.
+         */
+        explicit circular_dependency_exception(std::string const& message);
     };
 
     /**
@@ -90,6 +124,8 @@ namespace facter { namespace facts {
         /**
          * Adds a resolver to the fact collection.
          * The last resolver that was added for a particular name or pattern will "win" resolution.
+         * Resolvers providing the resolver's dependencies are resolved before it.
+         * Throws circular_dependency_exception if the resolver's dependencies lead back to itself.
          * @param res The resolver to add to the fact collection.
          */
         void add(std::shared_ptr<resolver> const& res);
@@ -154,7 +190,7 @@ namespace facter { namespace facts {
         template <typename T = value>
         T const* get(std::string const& name)
         {
-            return dynamic_cast<T const*>(get_value(name));
+            return value_cast<T>(get_value(name));
         }
 
         /**
@@ -168,7 +204,7 @@ namespace facter { namespace facts {
         {
             // Lookup the fact without resolving
             auto it = _facts.find(name);
-            return dynamic_cast<T const*>(it == _facts.end() ? nullptr : it->second.get());
+            return value_cast<T>(it == _facts.end() ? nullptr : it->second.get());
         }
 
         /**
@@ -187,7 +223,7 @@ namespace facter { namespace facts {
         template <typename T = value>
         T const* query(std::string const& query)
         {
-            return dynamic_cast<T const*>(query_value(query));
+            return value_cast<T>(query_value(query));
         }
 
         /**
@@ -209,20 +245,123 @@ namespace facter { namespace facts {
 
         /**
          * Resolves all facts in the collection.
+         * If the collection's concurrency is greater than 1, independent resolvers are resolved on a pool of worker threads.
          */
         void resolve_facts();
 
+        /**
+         * Gets the number of threads used to resolve all facts.
+         * @return Returns the number of threads used to resolve all facts.
+         */
+        unsigned int concurrency() const;
+
+        /**
+         * Sets the number of threads used to resolve all facts.
+         * A value of 1 (the default) resolves facts serially on the calling thread.
+         * @param threads The number of threads to use; 0 uses one thread per hardware thread.
+         */
+        void concurrency(unsigned int threads);
+
+        /**
+         * Gets the filter of the network interfaces that networking facts are resolved for.
+         * @return Returns the interface filter.
+         */
+        name_filter const& interface_filter() const;
+
+        /**
+         * Sets the filter of the network interfaces that networking facts are resolved for.
+         * Filtered interfaces are skipped while interfaces are enumerated, so no data is collected for them.
+         * A resolver with its own interface filter uses that filter instead.
+         * @param filter The filter matched against interface names.
+         */
+        void interface_filter(name_filter filter);
+
+        /**
+         * Gets the filter of the mountpoints that file system facts are resolved for.
+         * @return Returns the mountpoint filter.
+         */
+        name_filter const& mountpoint_filter() const;
+
+        /**
+         * Sets the filter of the mountpoints that file system facts are resolved for.
+         * Filtered mountpoints are skipped while mountpoints are enumerated, so they are never queried for their size.
+         * A resolver with its own mountpoint filter uses that filter instead.
+         * @param filter The filter matched against both the path and the file system type of each mountpoint.
+         */
+        void mountpoint_filter(name_filter filter);
+
+        /**
+         * Gets whether or not resolvers may run external commands when the native sources of their facts are incomplete.
+         * @return Returns true if command fallbacks are enabled or false if not.
+         */
+        bool command_fallbacks() const;
+
+        /**
+         * Sets whether or not resolvers may run external commands (e.g. lsb_release) when the native sources of their facts are incomplete.
+         * Command fallbacks are disabled by default because the commands are much slower than reading the sources directly.
+         * @param enabled True to enable command fallbacks or false to disable them.
+         */
+        void command_fallbacks(bool enabled);
+
+        /**
+         * Enables the persistent fact cache.
+         * The facts of resolvers with a time-to-live are loaded from the cache until they expire.
+         * Otherwise, the resolver is resolved and its facts are written to the cache when the collection is destroyed.
+         * @param ttls The time-to-live, in seconds, of each resolver's cached facts, keyed by resolver name.
+         * @param refresh True to resolve and re-cache all cached facts or false to use unexpired cached facts.
+         * @param path The path to the cache file.  If empty, the default cache file will be used.
+         */
+        void enable_cache(std::map<std::string, int64_t> ttls, bool refresh = false, std::string const& path = {});
+
+        /**
+         * Writes any newly cached facts to the cache file.
+         */
+        void save_cache();
+
+        /**
+         * Enables the command cache for the life of the collection.
+         * The cache is current while the collection resolves facts, so commands run more than once while facts are resolved
+         * (e.g. by several custom facts) are executed only once, and executables are searched for once;
+         * see facter::execution::command_cache.
+         */
+        void enable_command_cache();
+
+        /**
+         * Gets the collection's command cache.
+         * Make it current with facter::execution::command_cache::scope to cache commands run outside of fact resolution.
+         * @return Returns the command cache or nullptr if the command cache is not enabled.
+         */
+        execution::command_cache* command_cache() const;
+
      protected:
         virtual std::vector<std::string> get_external_fact_directories() const;
 
+        /**
+         * Gets the default path to the fact cache file.
+         * @return Returns the default path to the fact cache file.
+         */
+        virtual std::string get_cache_file() const;
+
      private:
         LIBFACTER_NO_EXPORT void resolve_fact(std::string const& name);
+        LIBFACTER_NO_EXPORT void resolve(boost::unique_lock<boost::mutex>& lock, std::shared_ptr<resolver> res);
+        LIBFACTER_NO_EXPORT void resolve_legacy(boost::unique_lock<boost::mutex>& lock, std::shared_ptr<resolver> res);
+        LIBFACTER_NO_EXPORT void resolve_legacy_facts();
+        LIBFACTER_NO_EXPORT void resolve_facts_concurrently(unsigned int threads);
+        LIBFACTER_NO_EXPORT std::shared_ptr<resolver> next_resolver() const;
+        LIBFACTER_NO_EXPORT std::shared_ptr<resolver> pending_dependency(std::shared_ptr<resolver> const& res) const;
+        LIBFACTER_NO_EXPORT bool find_dependency_path(std::shared_ptr<resolver> const& from, std::vector<std::shared_ptr<resolver>> const& targets, std::vector<std::shared_ptr<resolver>>& path) const;
+        LIBFACTER_NO_EXPORT void remove_dependency(std::shared_ptr<resolver> const& res);
+        LIBFACTER_NO_EXPORT bool would_deadlock(std::shared_ptr<resolver> const& res) const;
+        LIBFACTER_NO_EXPORT void remove_resolver(std::shared_ptr<resolver> const& res);
         LIBFACTER_NO_EXPORT value const* get_value(std::string const& name);
         LIBFACTER_NO_EXPORT value const* query_value(std::string const& query);
+        LIBFACTER_NO_EXPORT value const* resolve_query(std::string const& query, std::vector<std::string> const& segments);
         LIBFACTER_NO_EXPORT value const* lookup(value const* value, std::string const& name);
         LIBFACTER_NO_EXPORT void write_hash(std::ostream& stream, std::set<std::string> const& queries);
-        LIBFACTER_NO_EXPORT void write_json(std::ostream& stream, std::set<std::string> const& queries);
+        LIBFACTER_NO_EXPORT void write_json(std::ostream& stream, std::set<std::string> const& queries, bool pretty);
         LIBFACTER_NO_EXPORT void write_yaml(std::ostream& stream, std::set<std::string> const& queries);
+        LIBFACTER_NO_EXPORT void write_msgpack(std::ostream& stream, std::set<std::string> const& queries);
         LIBFACTER_NO_EXPORT void add_common_facts(bool include_ruby_facts);
         LIBFACTER_NO_EXPORT bool add_external_facts_dir(std::vector<std::unique_ptr<external::resolver>> const& resolvers, std::string const& directory, bool warn);
 
@@ -231,9 +370,29 @@ namespace facter { namespace facts {
         LIBFACTER_NO_EXPORT std::vector<std::unique_ptr<external::resolver>> get_external_resolvers();
 
         std::map<std::string, std::unique_ptr<value>> _facts;
+        // Partially resolved facts that answered a query, keyed by query
+        std::map<std::string, std::unique_ptr<value>> _queries;
         std::list<std::shared_ptr<resolver>> _resolvers;
-        std::multimap<std::string, std::shared_ptr<resolver>> _resolver_map;
-        std::list<std::shared_ptr<resolver>> _pattern_resolvers;
+        std::map<std::shared_ptr<resolver>, std::list<std::shared_ptr<resolver>>::iterator> _positions;
+        std::unique_ptr<resolver_index> _index;
+        // Maps each pending resolver to the resolvers providing its dependencies
+        std::map<std::shared_ptr<resolver>, std::vector<std::shared_ptr<resolver>>> _dependencies;
+        // Resolved resolvers whose legacy facts have not yet been added
+        std::vector<std::shared_ptr<resolver>> _legacy;
+        std::unique_ptr<fact_cache> _cache;
+        std::unique_ptr<execution::command_cache> _command_cache;
+        // The arena that values are allocated from while facts are being resolved
+        std::unique_ptr<value_arena> _arena;
+        name_filter _interface_filter;
+        name_filter _mountpoint_filter;
+        bool _command_fallbacks;
+
+        // Concurrent resolution state; the mutex guards all of the above members
+        unsigned int _concurrency;
+        boost::mutex _mutex;
+        boost::condition_variable _resolved;
+        std::map<std::shared_ptr<resolver>, boost::thread::id> _resolving;
+        std::map<boost::thread::id, std::shared_ptr<resolver>> _waiting;
     };
 
 }}  // namespace facter::facts
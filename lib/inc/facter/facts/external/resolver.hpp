@@ -4,8 +4,10 @@
  */
 #pragma once
 
+#include <map>
 #include <stdexcept>
 #include <string>
+#include <vector>
 #include "../../export.h"
 
 namespace facter { namespace facts {
@@ -44,6 +46,16 @@ namespace facter { namespace facts { namespace external {
          * @param facts The fact collection to populate the external facts into.
          */
         virtual void resolve(std::string const& path, collection& facts) const = 0;
+
+        /**
+         * Resolves facts from each of the given files.
+         * By default, the files are resolved one after another; resolvers may override this to resolve them concurrently.
+         * Facts are added to the collection in the order of the files.
+         * @param paths The paths to the files to resolve facts from.
+         * @param facts The fact collection to populate the external facts into.
+         * @return Returns the error message of each file that could not be resolved, keyed by the file's path.
+         */
+        virtual std::map<std::string, std::string> resolve_all(std::vector<std::string> const& paths, collection& facts) const;
     };
 
 }}}  // namespace facter::facts::external
@@ -0,0 +1,130 @@
+/**
+ * @file
+ * Declares the streaming JSON writer for fact values.
+ */
+#pragma once
+
+#include "../export.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace facter { namespace facts {
+
+    /**
+     * Writes JSON directly to an output stream without building a document first.
+     * Output is accumulated in a buffer that is written to the stream in large blocks.
+     * This type cannot be copied.
+     */
+    struct LIBFACTER_EXPORT json_writer
+    {
+        /**
+         * The default size of the output buffer, in bytes.
+         */
+        static const size_t default_buffer_size = 64 * 1024;
+
+        /**
+         * Constructs a JSON writer.
+         * @param stream The stream to write to.
+         * @param pretty True to indent the output or false to write compact output.
+         * @param buffer_size The size of the output buffer, in bytes.
+         */
+        explicit json_writer(std::ostream& stream, bool pretty = true, size_t buffer_size = default_buffer_size);
+
+        /**
+         * Destructs the JSON writer and flushes any buffered output.
+         */
+        ~json_writer();
+
+        /**
+         * Starts writing an object.
+         */
+        void start_object();
+
+        /**
+         * Ends the current object.
+         */
+        void end_object();
+
+        /**
+         * Starts writing an array.
+         */
+        void start_array();
+
+        /**
+         * Ends the current array.
+         */
+        void end_array();
+
+        /**
+         * Writes the key of the next member of the current object.
+         * @param key The key to write.
+         */
+        void write_key(std::string const& key);
+
+        /**
+         * Writes a string value.
+         * @param str The string to write.
+         * @param length The length of the string, in bytes.
+         */
+        void write_string(char const* str, size_t length);
+
+        /**
+         * Writes a string value.
+         * @param str The string to write.
+         */
+        void write_string(std::string const& str);
+
+        /**
+         * Writes an integer value.
+         * @param i The integer to write.
+         */
+        void write_integer(int64_t i);
+
+        /**
+         * Writes a boolean value.
+         * @param b The boolean to write.
+         */
+        void write_boolean(bool b);
+
+        /**
+         * Writes a double value.
+         * @param d The double to write.
+         */
+        void write_double(double d);
+
+        /**
+         * Writes a null value.
+         */
+        void write_null();
+
+        /**
+         * Writes any buffered output to the stream.
+         */
+        void flush();
+
+     private:
+        json_writer(json_writer const&) = delete;
+        json_writer& operator=(json_writer const&) = delete;
+
+        struct level
+        {
+            bool in_array;
+            size_t count;
+        };
+
+        void prefix();
+        void indent();
+        void put(char c);
+        void put(char const* str, size_t length);
+        void escape(char const* str, size_t length);
+
+        std::ostream& _stream;
+        bool _pretty;
+        size_t _buffer_size;
+        std::string _buffer;
+        std::vector<level> _levels;
+    };
+
+}}  // namespace facter::facts
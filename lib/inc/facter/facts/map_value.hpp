@@ -6,15 +6,34 @@
 
 #include "value.hpp"
 #include "../export.h"
-#include <map>
 #include <string>
 #include <memory>
 #include <functional>
+#include <list>
+#include <utility>
+#include <vector>
 
 namespace facter { namespace facts {
 
+    struct map_value;
+    struct string_pool;
+
+    /**
+     * The type tag for map values.
+     */
+    template <>
+    struct value_tag<map_value>
+    {
+        /**
+         * The type tag of map values.
+         */
+        static const value_type type = value_type::map;
+    };
+
     /**
      * Represents a fact value that maps fact names to values.
+     * Elements are stored in a vector sorted by name and the names are interned in a string pool shared with the
+     * other maps created while the same fact collection is resolving.
      * This type can be moved but cannot be copied.
      */
     struct LIBFACTER_EXPORT map_value : value
@@ -24,7 +43,7 @@ namespace facter { namespace facts {
          * @param hidden True if the fact is hidden from output by default or false if not.
          */
         map_value(bool hidden = false) :
-            value(hidden)
+            value(value_type::map, hidden)
         {
         }
 
@@ -56,6 +75,7 @@ namespace facter { namespace facts {
 
         /**
          * Adds a value to the map.
+         * If the map already contains an element with the given name, the value is not added.
          * @param name The name of map element.
          * @param value The value of the map element.
          */
@@ -94,7 +114,7 @@ namespace facter { namespace facts {
          */
         template <typename T = value> T const* get(std::string const& name) const
         {
-            return dynamic_cast<T const*>(this->operator [](name));
+            return value_cast<T>(this->operator [](name));
         }
 
         /**
@@ -104,6 +124,18 @@ namespace facter { namespace facts {
          */
         value const* operator[](std::string const& name) const;
 
+        /**
+          * Writes the value to the given JSON writer.
+          * @param writer The JSON writer to write to.
+          */
+        virtual void write(json_writer& writer) const override;
+
+        /**
+          * Writes the value to the given MessagePack writer.
+          * @param writer The MessagePack writer to write to.
+          */
+        virtual void write(msgpack_writer& writer) const override;
+
         /**
           * Writes the value to the given stream.
           * @param os The stream to write to.
@@ -121,7 +153,13 @@ namespace facter { namespace facts {
         virtual YAML::Emitter& write(YAML::Emitter& emitter) const override;
 
      private:
-        std::map<std::string, std::unique_ptr<value>> _elements;
+        typedef std::pair<std::string const*, std::unique_ptr<value>> element;
+
+        std::vector<element>::const_iterator find(std::string const& name) const;
+
+        std::shared_ptr<string_pool> _strings;
+        std::list<std::string> _names;
+        std::vector<element> _elements;
     };
 
 }}  // namespace facter::facts
@@ -0,0 +1,179 @@
+/**
+ * @file
+ * Declares the MessagePack writer and reader for fact values.
+ */
+#pragma once
+
+#include "value.hpp"
+#include "../export.h"
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace facter { namespace facts {
+
+    /**
+     * Thrown when MessagePack data cannot be read.
+     */
+    struct LIBFACTER_EXPORT msgpack_exception : std::runtime_error
+    {
+        /**
+         * Constructs a msgpack_exception.
+         * @param message The exception message.
+         */
+        explicit msgpack_exception(std::string const& message);
+    };
+
+    /**
+     * Writes fact values in the MessagePack binary format.
+     * Output is appended to a buffer owned by the caller.
+     */
+    struct LIBFACTER_EXPORT msgpack_writer
+    {
+        /**
+         * Constructs a MessagePack writer.
+         * @param buffer The buffer to append the output to.
+         */
+        explicit msgpack_writer(std::string& buffer);
+
+        /**
+         * Writes the header of a map; the keys and values of the map are written after the header.
+         * @param count The number of key-value pairs in the map.
+         */
+        void write_map(size_t count);
+
+        /**
+         * Writes the header of an array; the elements of the array are written after the header.
+         * @param count The number of elements in the array.
+         */
+        void write_array(size_t count);
+
+        /**
+         * Writes a string.
+         * @param str The string to write.
+         */
+        void write_string(std::string const& str);
+
+        /**
+         * Writes a string.
+         * @param str The string to write.
+         * @param length The length of the string, in bytes.
+         */
+        void write_string(char const* str, size_t length);
+
+        /**
+         * Writes an integer.
+         * @param i The integer to write.
+         */
+        void write_integer(int64_t i);
+
+        /**
+         * Writes a boolean.
+         * @param b The boolean to write.
+         */
+        void write_boolean(bool b);
+
+        /**
+         * Writes a double.
+         * @param d The double to write.
+         */
+        void write_double(double d);
+
+        /**
+         * Writes a nil.
+         */
+        void write_nil();
+
+        /**
+         * Writes a fact value; a null value is written as nil.
+         * @param val The value to write.
+         */
+        void write(value const* val);
+
+     private:
+        void put(uint8_t marker, uint64_t value, size_t count);
+
+        std::string& _buffer;
+    };
+
+    /**
+     * Reads fact values from MessagePack data.
+     * Maps are read as map_value, arrays as array_value and scalars as the matching scalar_value.
+     * Throws msgpack_exception if the data is malformed or truncated.
+     */
+    struct LIBFACTER_EXPORT msgpack_reader
+    {
+        /**
+         * The maximum number of arrays and maps that may be nested within each other.
+         * Deeper data is rejected rather than exhausting the stack while reading it.
+         */
+        constexpr static size_t max_depth = 64;
+
+        /**
+         * Constructs a MessagePack reader.
+         * @param data The data to read; the data must outlive the reader.
+         * @param offset The offset in the data to start reading from.
+         * @param length The number of bytes to read, or std::string::npos to read to the end of the data.
+         */
+        explicit msgpack_reader(std::string const& data, size_t offset = 0, size_t length = std::string::npos);
+
+        /**
+         * Determines if all of the data has been read.
+         * @return Returns true if all data has been read or false if not.
+         */
+        bool done() const;
+
+        /**
+         * Gets the current offset in the data.
+         * @return Returns the offset of the next byte to read.
+         */
+        size_t offset() const;
+
+        /**
+         * Reads a value.
+         * Throws msgpack_exception if the data is malformed or nested more deeply than max_depth.
+         * @param hidden True if the value should be hidden from output by default or false if not.
+         * @return Returns the value read or nullptr if a nil was read.
+         */
+        std::unique_ptr<value> read(bool hidden = false);
+
+        /**
+         * Reads a string.
+         * @return Returns the string read.
+         */
+        std::string read_string();
+
+        /**
+         * Reads a map header.
+         * @return Returns the number of key-value pairs in the map.
+         */
+        size_t read_map();
+
+        /**
+         * Reads an unsigned big-endian integer of the given size without a type marker.
+         * @param count The number of bytes to read.
+         * @return Returns the integer read.
+         */
+        uint64_t read_raw(size_t count);
+
+        /**
+         * Reads the given number of bytes without a type marker.
+         * @param count The number of bytes to read.
+         * @return Returns the bytes read.
+         */
+        std::string read_raw_string(size_t count);
+
+     private:
+        std::unique_ptr<value> read_array(size_t count, bool hidden);
+        std::unique_ptr<value> read_map(size_t count, bool hidden);
+
+        void enter();
+
+        std::string const& _data;
+        size_t _offset;
+        size_t _end;
+        size_t _depth;
+    };
+
+}}  // namespace facter::facts
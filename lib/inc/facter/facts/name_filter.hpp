@@ -0,0 +1,74 @@
+/**
+ * @file
+ * Declares the filter used to include or exclude objects by name during fact resolution.
+ */
+#pragma once
+
+#include "../export.h"
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace facter { namespace facts {
+
+    /**
+     * Filters objects such as network interfaces or mountpoints by name.
+     * Patterns are shell-style wildcards where '*' matches any sequence of characters and '?' matches any single character.
+     * A name is included if it matches an include pattern (or there are no include patterns) and does not match an exclude pattern.
+     */
+    struct LIBFACTER_EXPORT name_filter
+    {
+        /**
+         * Constructs a name filter.
+         * @param includes The patterns of the names to include; if empty, all names not excluded are included.
+         * @param excludes The patterns of the names to exclude.
+         */
+        explicit name_filter(std::vector<std::string> includes = {}, std::vector<std::string> excludes = {});
+
+        /**
+         * Determines if the filter has any patterns.
+         * @return Returns true if the filter includes every name or false if the filter has patterns.
+         */
+        bool empty() const;
+
+        /**
+         * Gets the include patterns.
+         * @return Returns the patterns of the names to include.
+         */
+        std::vector<std::string> const& includes() const;
+
+        /**
+         * Gets the exclude patterns.
+         * @return Returns the patterns of the names to exclude.
+         */
+        std::vector<std::string> const& excludes() const;
+
+        /**
+         * Determines if a name is included by the filter.
+         * @param name The name to check.
+         * @return Returns true if the name is included or false if the name is filtered out.
+         */
+        bool includes(std::string const& name) const;
+
+        /**
+         * Determines if an object known by several names (e.g. a mountpoint's path and file system) is included by the filter.
+         * The object is included if any name matches an include pattern and no name matches an exclude pattern.
+         * @param names The names of the object.
+         * @return Returns true if the object is included or false if the object is filtered out.
+         */
+        bool includes(std::initializer_list<std::string> names) const;
+
+        /**
+         * Matches a name against a shell-style wildcard pattern.
+         * @param pattern The pattern to match.
+         * @param name The name to match.
+         * @return Returns true if the entire name matches the pattern or false if it does not.
+         */
+        static bool match(std::string const& pattern, std::string const& name);
+
+     private:
+        std::vector<std::string> _includes;
+        std::vector<std::string> _excludes;
+    };
+
+}}  // namespace facter::facts
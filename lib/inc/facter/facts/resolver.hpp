@@ -26,6 +26,7 @@ namespace facter { namespace facts {
     };
 
     struct collection;
+    struct value;
 
     /**
      * Base class for fact resolvers.
@@ -91,6 +92,12 @@ namespace facter { namespace facts {
          */
         bool has_patterns() const;
 
+        /**
+         * Gets the regular expression patterns for the facts the resolver is responsible for resolving.
+         * @return Returns a vector of patterns.
+         */
+        std::vector<std::string> const& patterns() const;
+
         /**
          * Determines if the given name matches a pattern for the resolver.
          * @param name The fact name to check.
@@ -98,16 +105,79 @@ namespace facter { namespace facts {
          */
         bool is_match(std::string const& name) const;
 
+        /**
+         * Gets the names of the facts the resolver reads while resolving.
+         * The resolvers of these facts are resolved before this resolver.
+         * @return Returns a vector of fact names.
+         */
+        virtual std::vector<std::string> dependencies() const;
+
+        /**
+         * Determines if the resolver can be resolved on a thread other than the one resolving the collection.
+         * Resolvers that are not thread-safe are always resolved on the calling thread.
+         * @return Returns true if the resolver is thread-safe or false if it is not.
+         */
+        virtual bool is_thread_safe() const;
+
         /**
          * Called to resolve all facts the resolver is responsible for.
          * @param facts The fact collection that is resolving facts.
          */
         virtual void resolve(collection& facts) = 0;
 
+        /**
+         * Determines if the resolver adds legacy facts lazily with resolve_legacy.
+         * @return Returns true if the resolver has lazily added legacy facts or false if it does not.
+         */
+        virtual bool has_legacy_facts() const;
+
+        /**
+         * Called to add the legacy facts that are derived from the structured facts the resolver added.
+         * The collection only calls this once a legacy fact provided by the resolver is requested by name
+         * or all facts are enumerated, so hidden flat facts are not created unless they are used.
+         * The default implementation adds nothing.
+         * @param facts The fact collection that is resolving facts.
+         */
+        virtual void resolve_legacy(collection& facts);
+
+        /**
+         * Resolves only the part of a fact needed to answer a query.
+         * The returned value is not added to the fact collection.
+         * @param facts The fact collection that is resolving the query.
+         * @param name The name of the queried fact.
+         * @param path The segments of the query that follow the fact name.
+         * @return Returns a value containing at least the queried part of the fact or nullptr if the query requires resolving all facts.
+         */
+        std::unique_ptr<value> resolve_query(collection& facts, std::string const& name, std::vector<std::string> const& path);
+
+     protected:
+        /**
+         * Called to resolve only the part of a fact needed to answer a query.
+         * Resolvers that can collect a subset of their data override this to avoid resolving every fact.
+         * The default implementation returns nullptr.
+         * @param facts The fact collection that is resolving the query.
+         * @param name The name of the queried fact.
+         * @param path The segments of the query that follow the fact name.
+         * @return Returns a value containing at least the queried part of the fact or nullptr if the query requires resolving all facts.
+         */
+        virtual std::unique_ptr<value> query(collection& facts, std::string const& name, std::vector<std::string> const& path);
+
+        /**
+         * Determines if the data for part of a fact should be collected.
+         * While a query is being resolved, only the data for the queried part of the queried fact is collected.
+         * @param name The name of the fact.
+         * @param path The path to the part of the fact; an empty path refers to the entire fact.
+         * @return Returns true if the data should be collected or false if the data is not needed.
+         */
+        bool is_collected(std::string const& name, std::vector<std::string> const& path = {}) const;
+
      private:
         std::string _name;
         std::vector<std::string> _names;
+        std::vector<std::string> _patterns;
         std::vector<boost::regex> _regexes;
+        std::string _query_name;
+        std::vector<std::string> _query_path;
     };
 
 }}  // namespace facter::facts
@@ -13,6 +13,56 @@
 
 namespace facter { namespace facts {
 
+    template <typename T> struct scalar_value;
+
+    /**
+     * The type tag for string values.
+     */
+    template <>
+    struct value_tag<scalar_value<std::string>>
+    {
+        /**
+         * The type tag of string values.
+         */
+        static const value_type type = value_type::string;
+    };
+
+    /**
+     * The type tag for integer values.
+     */
+    template <>
+    struct value_tag<scalar_value<int64_t>>
+    {
+        /**
+         * The type tag of integer values.
+         */
+        static const value_type type = value_type::integer;
+    };
+
+    /**
+     * The type tag for boolean values.
+     */
+    template <>
+    struct value_tag<scalar_value<bool>>
+    {
+        /**
+         * The type tag of boolean values.
+         */
+        static const value_type type = value_type::boolean;
+    };
+
+    /**
+     * The type tag for double values.
+     */
+    template <>
+    struct value_tag<scalar_value<double>>
+    {
+        /**
+         * The type tag of double values.
+         */
+        static const value_type type = value_type::floating_point;
+    };
+
     /**
      * Represents a simple scalar value.
      * This type can be moved but cannot be copied.
@@ -27,7 +77,7 @@ namespace facter { namespace facts {
          * @param hidden True if the fact is hidden from output by default or false if not.
          */
         scalar_value(T value, bool hidden = false) :
-            facter::facts::value(hidden),
+            facter::facts::value(value_tag<scalar_value>::type, hidden),
             _value(std::move(value))
         {
         }
@@ -70,6 +120,18 @@ namespace facter { namespace facts {
          */
         T const& value() const { return _value; }
 
+        /**
+          * Writes the value to the given JSON writer.
+          * @param writer The JSON writer to write to.
+          */
+        virtual void write(json_writer& writer) const override;
+
+        /**
+          * Writes the value to the given MessagePack writer.
+          * @param writer The MessagePack writer to write to.
+          */
+        virtual void write(msgpack_writer& writer) const override;
+
         /**
           * Writes the value to the given stream.
           * @param os The stream to write to.
@@ -111,6 +173,26 @@ namespace facter { namespace facts {
     template <>
     void scalar_value<double>::to_json(rapidjson::Allocator& allocator, rapidjson::Value& value) const;
 
+    // Declare the specializations for streaming JSON output
+    template <>
+    void scalar_value<std::string>::write(json_writer& writer) const;
+    template <>
+    void scalar_value<int64_t>::write(json_writer& writer) const;
+    template <>
+    void scalar_value<bool>::write(json_writer& writer) const;
+    template <>
+    void scalar_value<double>::write(json_writer& writer) const;
+
+    // Declare the specializations for MessagePack output
+    template <>
+    void scalar_value<std::string>::write(msgpack_writer& writer) const;
+    template <>
+    void scalar_value<int64_t>::write(msgpack_writer& writer) const;
+    template <>
+    void scalar_value<bool>::write(msgpack_writer& writer) const;
+    template <>
+    void scalar_value<double>::write(msgpack_writer& writer) const;
+
     // Declare the specializations for YAML output
     template <>
     YAML::Emitter& scalar_value<std::string>::write(YAML::Emitter& emitter) const;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "../export.h"
+#include <cstdint>
 #include <string>
 #include <functional>
 #include <memory>
@@ -34,9 +35,49 @@ extern "C" {
 
 namespace facter { namespace facts {
 
+    struct json_writer;
+    struct msgpack_writer;
+    struct value_visitor;
+
+    /**
+     * The type tag carried by every value.
+     */
+    enum class value_type
+    {
+        /**
+         * The value is a string_value.
+         */
+        string,
+        /**
+         * The value is an integer_value.
+         */
+        integer,
+        /**
+         * The value is a boolean_value.
+         */
+        boolean,
+        /**
+         * The value is a double_value.
+         */
+        floating_point,
+        /**
+         * The value is an array_value.
+         */
+        array,
+        /**
+         * The value is a map_value.
+         */
+        map,
+        /**
+         * The value is of a type defined outside of libfacter (e.g. a Ruby value).
+         */
+        other
+    };
+
     /**
      * Base class for values.
      * This type can be moved but cannot be copied.
+     * Values are allocated from the value arena of the fact collection that is resolving on the current thread, if any.
      */
     struct LIBFACTER_EXPORT value
     {
@@ -45,6 +86,7 @@ namespace facter { namespace facts {
          * @param hidden True if the fact is hidden from output by default or false if not.
          */
         value(bool hidden = false) :
+            _type(value_type::other),
             _hidden(hidden)
         {
         }
@@ -61,6 +103,7 @@ namespace facter { namespace facts {
         // Visual Studio 12 still doesn't allow default for move constructor.
         value(value&& other)
         {
+            _type = other._type;
             _hidden = other._hidden;
         }
 
@@ -72,10 +115,40 @@ namespace facter { namespace facts {
         // Visual Studio 12 still doesn't allow default for move assignment.
         value& operator=(value&& other)
         {
+            _type = other._type;
             _hidden = other._hidden;
             return *this;
         }
 
+        /**
+         * Allocates memory for a value.
+         * @param size The size of the value, in bytes.
+         * @return Returns the allocated memory.
+         */
+        static void* operator new(size_t size);
+
+        /**
+         * Frees the memory of a value.
+         * @param ptr The memory to free.
+         */
+        static void operator delete(void* ptr);
+
+        /**
+         * Gets the type tag of the value.
+         * @return Returns the type tag of the value.
+         */
+        value_type type() const
+        {
+            return _type;
+        }
+
+        /**
+         * Calls the visitor function for the value's type.
+         * Values with a type tag of value_type::other are passed to the visitor as a base value.
+         * @param visitor The visitor to call.
+         */
+        void accept(value_visitor& visitor) const;
+
         /**
          * Determines if the value is hidden from output by default.
          * @return Returns true if the value is hidden from output by default or false if it is not.
@@ -92,6 +165,18 @@ namespace facter { namespace facts {
          */
         virtual void to_json(rapidjson::Allocator& allocator, rapidjson::Value& value) const = 0;
 
+        /**
+          * Writes the value to the given JSON writer.
+          * @param writer The JSON writer to write to.
+          */
+        virtual void write(json_writer& writer) const = 0;
+
+        /**
+          * Writes the value to the given MessagePack writer.
+          * @param writer The MessagePack writer to write to.
+          */
+        virtual void write(msgpack_writer& writer) const = 0;
+
         /**
           * Writes the value to the given stream.
           * @param os The stream to write to.
@@ -108,13 +193,140 @@ namespace facter { namespace facts {
           */
         virtual YAML::Emitter& write(YAML::Emitter& emitter) const = 0;
 
+     protected:
+        /**
+         * Constructs a value with the given type tag.
+         * @param type The type tag of the value.
+         * @param hidden True if the fact is hidden from output by default or false if not.
+         */
+        value(value_type type, bool hidden) :
+            _type(type),
+            _hidden(hidden)
+        {
+        }
+
      private:
         value(value const&) = delete;
         value& operator=(value const&) = delete;
 
+        value_type _type;
         bool _hidden;
     };
 
+    template <typename T> struct scalar_value;
+    struct array_value;
+    struct map_value;
+
+    /**
+     * Visits values by type without casting.
+     * Derive from this type and override the visit functions for the types of interest.
+     */
+    struct LIBFACTER_EXPORT value_visitor
+    {
+        /**
+         * Destructs the visitor.
+         */
+        virtual ~value_visitor() = default;
+
+        /**
+         * Visits a string value.
+         * @param val The value being visited.
+         */
+        virtual void visit(scalar_value<std::string> const& val) = 0;
+
+        /**
+         * Visits an integer value.
+         * @param val The value being visited.
+         */
+        virtual void visit(scalar_value<int64_t> const& val) = 0;
+
+        /**
+         * Visits a boolean value.
+         * @param val The value being visited.
+         */
+        virtual void visit(scalar_value<bool> const& val) = 0;
+
+        /**
+         * Visits a double value.
+         * @param val The value being visited.
+         */
+        virtual void visit(scalar_value<double> const& val) = 0;
+
+        /**
+         * Visits an array value.
+         * @param val The value being visited.
+         */
+        virtual void visit(array_value const& val) = 0;
+
+        /**
+         * Visits a map value.
+         * @param val The value being visited.
+         */
+        virtual void visit(map_value const& val) = 0;
+
+        /**
+         * Visits a value of a type defined outside of libfacter.
+         * By default, the value is ignored.
+         * @param val The value being visited.
+         */
+        virtual void visit(value const& val);
+    };
+
+    /**
+     * Maps a value type to its type tag.
+     * Types without a specialization use value_type::other and are cast with dynamic_cast.
+     * @tparam T The value type.
+     */
+    template <typename T>
+    struct value_tag
+    {
+        /**
+         * The type tag of values of type T.
+         */
+        static const value_type type = value_type::other;
+    };
+
+    /**
+     * Casts a value to the given value type using the value's type tag.
+     * @tparam T The value type to cast to.
+     * @param val The value to cast.
+     * @return Returns the value as the given type or nullptr if the value is null or not of the given type.
+     */
+    template <typename T>
+    T const* value_cast(value const* val)
+    {
+        if (!val) {
+            return nullptr;
+        }
+        if (value_tag<T>::type == value_type::other) {
+            return dynamic_cast<T const*>(val);
+        }
+        return val->type() == value_tag<T>::type ? static_cast<T const*>(val) : nullptr;
+    }
+
+    /**
+     * Casts a value to the given value type using the value's type tag.
+     * @tparam T The value type to cast to.
+     * @param val The value to cast.
+     * @return Returns the value as the given type or nullptr if the value is null or not of the given type.
+     */
+    template <typename T>
+    T* value_cast(value* val)
+    {
+        return const_cast<T*>(value_cast<T>(static_cast<value const*>(val)));
+    }
+
+    /**
+     * Casts a value to the base value type.
+     * @param val The value to cast.
+     * @return Returns the given value.
+     */
+    template <>
+    inline value const* value_cast<value>(value const* val)
+    {
+        return val;
+    }
+
     /**
      * Utility function for making a value.
      * @tparam T The type of the value being constructed.
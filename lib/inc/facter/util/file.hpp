@@ -5,6 +5,7 @@
 #pragma once
 
 #include "../export.h"
+#include <boost/utility/string_ref.hpp>
 #include <string>
 #include <stdexcept>
 #include <functional>
@@ -18,12 +19,31 @@ namespace facter { namespace util {
     {
         /**
          * Reads each line from the given file.
+         * Both LF and CRLF line endings are removed from the lines.
          * @param path The path to the file to read.
          * @param callback The callback function that is passed each line in the file.
          * @return Returns true if the file was opened successfully or false if it was not.
          */
         static bool each_line(std::string const& path, std::function<bool(std::string&)> callback);
 
+        /**
+         * Reads each line from the given file without copying the lines.
+         * The file is read into a single buffer.
+         * @param path The path to the file to read.
+         * @param callback The callback function that is passed each line in the file; the line is only valid during the call.
+         * @return Returns true if the file was opened successfully or false if it was not.
+         */
+        static bool each_line_ref(std::string const& path, std::function<bool(boost::string_ref)> callback);
+
+        /**
+         * Calls the given callback for each line in the given buffer.
+         * Lines are separated by newlines (a carriage return before a newline is not part of the line); a trailing newline does not start another line.
+         * @param data The buffer to split into lines.
+         * @param size The size of the buffer, in bytes.
+         * @param callback The callback function that is passed each line in the buffer; returns false to stop.
+         */
+        static void each_line_ref(char const* data, size_t size, std::function<bool(boost::string_ref)> const& callback);
+
         /**
          * Reads the entire contents of the given file into a string.
          * @param path The path of the file to read.
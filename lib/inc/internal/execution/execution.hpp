@@ -4,11 +4,67 @@
  */
 #pragma once
 
+#include <facter/execution/execution.hpp>
+#include <cstdint>
+#include <exception>
 #include <string>
 #include <functional>
+#include <tuple>
+#include <vector>
 
 namespace facter { namespace execution {
 
+    /**
+     * Searches the given paths for the given executable file without consulting the command cache.
+     * This is implemented by each platform; which calls it when the command cache does not have the file.
+     * @param file The file to search for.
+     * @param directories The directories to search.
+     * @return Returns the full path or empty if the file could not be found.
+     */
+    std::string find_executable(std::string const& file, std::vector<std::string> const& directories);
+
+    /**
+     * Processes the stdout and stderr streams of a child process as data is read from them.
+     * Complete lines are logged and passed to the callbacks; without a callback, the stream is buffered.
+     */
+    struct stream_processor
+    {
+        /**
+         * Constructs a stream processor.
+         * @param trim True if output should be trimmed or false if not.
+         * @param stdout_callback The callback to use when a line is read for stdout.
+         * @param stderr_callback The callback to use when a line is read for stderr.
+         */
+        stream_processor(bool trim, std::function<bool(std::string&)> stdout_callback, std::function<bool(std::string&)> stderr_callback);
+
+        /**
+         * Processes data read from stdout.
+         * @param data The data that was read.
+         * @return Returns true if processing should continue or false if the callback has finished processing output.
+         */
+        bool process_stdout(std::string const& data);
+
+        /**
+         * Processes data read from stderr.
+         * @param data The data that was read.
+         * @return Returns true if processing should continue or false if the callback has finished processing output.
+         */
+        bool process_stderr(std::string const& data);
+
+        /**
+         * Processes any remaining partial lines once the streams have been read.
+         * @return Returns a tuple of stdout and stderr output.  If stdout_callback or stderr_callback is given, it will return empty strings.
+         */
+        std::tuple<std::string, std::string> finish();
+
+     private:
+        bool _trim;
+        std::function<bool(std::string&)> _stdout_callback;
+        std::function<bool(std::string&)> _stderr_callback;
+        std::string _stdout_buffer;
+        std::string _stderr_buffer;
+    };
+
     /**
      * Processes stdout and stderror streams of a child process.
      * @param trim True if output should be trimmed or false if not.
@@ -23,4 +79,75 @@ namespace facter { namespace execution {
         std::function<bool(std::string&)> const& stderr_callback,
         std::function<void(std::function<bool(std::string const&)>, std::function<bool(std::string const&)>)> const& read_streams);
 
+    /**
+     * Represents a command to run with execute_all.
+     */
+    struct command
+    {
+        /**
+         * Stores the name or path of the program to execute.
+         */
+        std::string file;
+
+        /**
+         * Stores the arguments to pass to the program.
+         */
+        std::vector<std::string> arguments;
+
+        /**
+         * Stores the callback that is called with each line of output on stdout or nullptr to buffer stdout.
+         */
+        std::function<bool(std::string&)> stdout_callback;
+
+        /**
+         * Stores the callback that is called with each line of output on stderr or nullptr to buffer stderr.
+         */
+        std::function<bool(std::string&)> stderr_callback;
+
+        /**
+         * Stores the execution options.
+         */
+        facter::util::option_set<execution_options> options;
+
+        /**
+         * Stores the timeout, in seconds, of the command or 0 for no timeout.
+         */
+        uint32_t timeout;
+    };
+
+    /**
+     * Represents the outcome of a command run with execute_all.
+     */
+    struct command_result
+    {
+        /**
+         * Stores whether or not the command succeeded.
+         */
+        bool success;
+
+        /**
+         * Stores the output of the command if not given a stdout callback.
+         */
+        std::string output;
+
+        /**
+         * Stores the error output of the command if not given a stderr callback.
+         */
+        std::string error;
+
+        /**
+         * Stores the exception execute would have thrown for the command or nullptr if none.
+         */
+        std::exception_ptr exception;
+    };
+
+    /**
+     * Runs the given commands concurrently and waits for every command to complete.
+     * Each command is run as execute would run it, but the command cache is not consulted.
+     * The output callbacks are called from the calling thread.
+     * @param commands The commands to run.
+     * @return Returns the result of each command in the same order as the commands.
+     */
+    std::vector<command_result> execute_all(std::vector<command> const& commands);
+
 }}  // namespace facter::execution
@@ -0,0 +1,140 @@
+/**
+ * @file
+ * Declares the engine used for running child processes concurrently on POSIX systems.
+ */
+#pragma once
+
+#include <facter/execution/execution.hpp>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace facter { namespace execution { namespace posix {
+
+    /**
+     * Runs child processes concurrently, each with its own timeout.
+     * A single event loop reads the output of every child and waits for every child to exit or time out.
+     * On Linux, the loop waits with epoll on the child's pipes, a pidfd and a timerfd; elsewhere it uses poll with per-child deadlines.
+     * No signal handlers or process-wide timers are used, so separate engines may run on separate threads at the same time.
+     */
+    struct engine
+    {
+        /**
+         * Represents the outcome of a child process.
+         */
+        struct result
+        {
+            /**
+             * Stores the process identifier of the child or 0 if the child could not be spawned.
+             */
+            size_t pid;
+
+            /**
+             * Stores whether or not the child exited with a zero status code.
+             */
+            bool success;
+
+            /**
+             * Stores whether or not the child was terminated by a signal.
+             */
+            bool signaled;
+
+            /**
+             * Stores whether or not the child was killed because it did not complete before its timeout.
+             */
+            bool timed_out;
+
+            /**
+             * Stores the exit status code or terminating signal of the child, or the error if the child could not be spawned.
+             */
+            int status;
+
+            /**
+             * Stores the output of the child if not given a stdout callback.
+             */
+            std::string output;
+
+            /**
+             * Stores the error output of the child if not given a stderr callback.
+             */
+            std::string error;
+        };
+
+        /**
+         * Constructs an engine with no children.
+         */
+        engine();
+
+        /**
+         * Destructs the engine.
+         * Any child that has not exited is killed along with its process group and then waited for.
+         */
+        ~engine();
+
+        /**
+         * Prevents the engine from being copied.
+         */
+        engine(engine const&) = delete;
+
+        /**
+         * Prevents the engine from being copied.
+         * @returns Returns this engine.
+         */
+        engine& operator=(engine const&) = delete;
+
+        /**
+         * Spawns a child process; its timeout starts now and its output is processed by run.
+         * @param executable The path of the executable to spawn.
+         * @param file The name of the command, used as the first argument of the child.
+         * @param arguments The arguments to pass to the child or nullptr for no arguments.
+         * @param environment The environment variables to pass to the child or nullptr for none.
+         * @param stdout_callback The callback to use when a line is read for stdout or nullptr to buffer stdout.
+         * @param stderr_callback The callback to use when a line is read for stderr or nullptr to buffer stderr.
+         * @param options The execution options.
+         * @param timeout The timeout, in seconds, of the child or 0 for no timeout.
+         * @return Returns the identifier used to get the result of the child.
+         */
+        size_t spawn(
+            std::string const& executable,
+            std::string const& file,
+            std::vector<std::string> const* arguments,
+            std::map<std::string, std::string> const* environment,
+            std::function<bool(std::string&)> stdout_callback,
+            std::function<bool(std::string&)> stderr_callback,
+            facter::util::option_set<execution_options> const& options,
+            uint32_t timeout);
+
+        /**
+         * Runs until every spawned child has exited or has been killed for timing out.
+         * The output callbacks of the children are called from this thread.
+         */
+        void run();
+
+        /**
+         * Gets the result of a child.
+         * The result is complete once run returns.
+         * @param id The identifier returned by spawn.
+         * @return Returns the result of the child.
+         */
+        result& get(size_t id);
+
+     private:
+        struct child;
+        struct poller;
+
+        void read(child& c, bool from_stdout);
+        void close_pipes(child& c);
+        void close_descriptor(int& descriptor);
+        void reap(child& c, bool wait);
+        void time_out(child& c);
+        void complete(child& c);
+
+        std::unique_ptr<poller> _poller;
+        std::vector<std::unique_ptr<child>> _children;
+        std::string _buffer;
+    };
+
+}}}  // namespace facter::execution::posix
@@ -6,6 +6,8 @@
 
 #include "../posix/networking_resolver.hpp"
 #include <map>
+#include <set>
+#include <string>
 #include <ifaddrs.h>
 
 namespace facter { namespace facts { namespace bsd {
@@ -15,6 +17,25 @@ namespace facter { namespace facts { namespace bsd {
      */
     struct networking_resolver : posix::networking_resolver
     {
+        /**
+         * Reads the DHCP servers of the most recent leases in a dhclient lease file.
+         * The file is read backwards from the end and reading stops once the most recent lease of every
+         * given interface is known; if the file is named for one of the interfaces, only that interface's lease is looked for.
+         * Results are reused while the file's modification time and size are unchanged.
+         * @param path The path to the lease file.
+         * @param interfaces The interfaces to find DHCP servers for; reading only stops early if this is non-empty.
+         * @return Returns a map between interface name and the DHCP server of its most recent lease.
+         */
+        static std::map<std::string, std::string> read_dhclient_leases(std::string const& path, std::set<std::string> const& interfaces);
+
+        /**
+         * Gets the interface a dhclient lease file is named for (e.g. eth0 for dhclient.eth0.leases or dhclient-<uuid>-eth0.lease).
+         * @param path The path to the lease file.
+         * @param interfaces The interface names to look for.
+         * @return Returns the longest of the given interfaces the file is named for or empty string if none.
+         */
+        static std::string get_lease_file_interface(std::string const& path, std::set<std::string> const& interfaces);
+
      protected:
         /**
          * Collects the resolver data.
@@ -39,10 +60,11 @@ namespace facter { namespace facts { namespace bsd {
         virtual std::string get_primary_interface() const;
 
         /**
-         * Finds known DHCP servers for all interfaces.
+         * Finds known DHCP servers for the given interfaces.
+         * @param interfaces The interfaces to find DHCP servers for.
          * @return Returns a map between interface name and DHCP server.
          */
-        virtual std::map<std::string, std::string> find_dhcp_servers() const;
+        virtual std::map<std::string, std::string> find_dhcp_servers(std::set<std::string> const& interfaces) const;
 
         /**
          * Finds the DHCP server for the given interface.
@@ -0,0 +1,81 @@
+/**
+ * @file
+ * Declares the persistent fact cache.
+ */
+#pragma once
+
+#include <facter/facts/value.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace facter { namespace facts {
+
+    /**
+     * Represents the persistent cache of the facts resolved by resolvers.
+     * Facts are cached per resolver and expire after the resolver's time-to-live.
+     * The cache is stored in a compact binary file that is validated with a checksum when loaded.
+     * The file (and the directory created for it) can only be read by the user that wrote it.
+     * Facts that only root can read, such as the system serial number and UUID, are never cached.
+     */
+    struct fact_cache
+    {
+        /**
+         * Constructs a fact cache and loads the cache file.
+         * An invalid or missing cache file results in an empty cache.
+         * @param path The path to the cache file.
+         * @param ttls The time-to-live, in seconds, of each resolver's cached facts, keyed by resolver name.
+         * @param refresh True to ignore the facts in the cache file or false to use unexpired facts.
+         */
+        fact_cache(std::string path, std::map<std::string, int64_t> ttls, bool refresh);
+
+        /**
+         * Determines if the facts of the given resolver are cached.
+         * @param resolver The name of the resolver.
+         * @return Returns true if the resolver has a time-to-live or false if its facts are not cached.
+         */
+        bool is_cached(std::string const& resolver) const;
+
+        /**
+         * Loads the cached facts of the given resolver.
+         * @param resolver The name of the resolver.
+         * @param facts The vector to add the cached facts to.
+         * @return Returns true if unexpired facts were loaded or false if the resolver must be resolved.
+         */
+        bool load(std::string const& resolver, std::vector<std::pair<std::string, std::unique_ptr<value>>>& facts) const;
+
+        /**
+         * Stores the facts of the given resolver in the cache.
+         * If any of the facts can only be read by root, the resolver's facts are not stored.
+         * @param resolver The name of the resolver.
+         * @param facts The facts resolved by the resolver.
+         */
+        void store(std::string const& resolver, std::vector<std::pair<std::string, value const*>> const& facts);
+
+        /**
+         * Writes the cache file if any facts were stored since it was loaded.
+         */
+        void save();
+
+     private:
+        struct entry
+        {
+            int64_t timestamp;
+            std::string data;
+        };
+
+        void read_file();
+        static bool is_private(std::string const& name);
+        static bool create_private_directory(std::string const& path);
+        static bool write_private_file(std::string const& path, std::string const& contents);
+
+        std::string _path;
+        std::map<std::string, int64_t> _ttls;
+        std::map<std::string, entry> _entries;
+        bool _modified;
+    };
+
+}}  // namespace facter::facts
@@ -26,6 +26,15 @@ namespace facter { namespace facts { namespace external {
          * @param facts The fact collection to populate the external facts into.
          */
         virtual void resolve(std::string const& path, collection& facts) const;
+
+        /**
+         * Resolves facts from each of the given files.
+         * The executables are run concurrently; their facts are added to the collection in the order of the files.
+         * @param paths The paths to the files to resolve facts from.
+         * @param facts The fact collection to populate the external facts into.
+         * @return Returns the error message of each file that could not be resolved, keyed by the file's path.
+         */
+        virtual std::map<std::string, std::string> resolve_all(std::vector<std::string> const& paths, collection& facts) const;
     };
 
 }}}  // namespace facter::facts::external
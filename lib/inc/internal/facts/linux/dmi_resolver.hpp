@@ -5,7 +5,7 @@
 #pragma once
 
 #include "../resolvers/dmi_resolver.hpp"
-#include <string>
+#include "../../util/smbios.hpp"
 
 namespace facter { namespace facts { namespace linux {
 
@@ -22,8 +22,14 @@ namespace facter { namespace facts { namespace linux {
          */
         virtual data collect_data(collection& facts) override;
 
-     private:
-        std::string read(std::string const& path);
+        /**
+         * Collects the DMI data from decoded SMBIOS structures.
+         * Fields are decoded as the kernel does for /sys/class/dmi/id, so either source produces the same facts.
+         * @param tables The decoded SMBIOS table.
+         * @param result The data to store the DMI data in.
+         * @return Returns true if the table contained DMI data or false if it did not.
+         */
+        static bool collect_smbios_data(util::smbios const& tables, data& result);
     };
 
 }}}  // namespace facter::facts::linux
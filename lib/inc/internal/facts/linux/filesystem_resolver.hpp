@@ -5,6 +5,10 @@
 #pragma once
 
 #include "../resolvers/filesystem_resolver.hpp"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
 
 namespace facter { namespace facts { namespace linux {
 
@@ -13,16 +17,74 @@ namespace facter { namespace facts { namespace linux {
      */
     struct filesystem_resolver : resolvers::filesystem_resolver
     {
+        /**
+         * The number of threads used to get the sizes of mountpoints.
+         */
+        static const unsigned int statfs_threads = 4;
+
+        /**
+         * The time, in milliseconds, to wait for the size of a mountpoint before reporting it as timed out.
+         */
+        static const uint32_t statfs_timeout = 5000;
+
+        /**
+         * The number of threads used to probe devices that are missing from the udev database.
+         */
+        static const unsigned int probe_threads = 4;
+
+        /**
+         * The time, in milliseconds, to wait for a device probe before skipping the device.
+         */
+        static const uint32_t probe_timeout = 5000;
+
+        /**
+         * Reads the mountpoints of devices from a mountinfo file (e.g. /proc/self/mountinfo).
+         * The options of each mountpoint combine the per-mount and the file system options in the order of /proc/mounts.
+         * @param path The path to the mountinfo file.
+         * @param include Called with the path and file system of each mountpoint; returns true to read the mountpoint or false to skip it.
+         * @return Returns the mountpoints read from the file.
+         */
+        static std::vector<mountpoint> read_mountinfo(std::string const& path, std::function<bool(std::string const&, std::string const&)> const& include = nullptr);
+
+        /**
+         * Gets the sizes of mountpoints concurrently on a pool of threads.
+         * A mountpoint whose size is not known within the timeout is marked as timed out and its thread is abandoned,
+         * so a hung file system (e.g. an unreachable NFS server) cannot block fact resolution.
+         * @param points The mountpoints to get the sizes of.
+         * @param threads The maximum number of threads waiting on responsive mountpoints.
+         * @param timeout The time, in milliseconds, to wait for the size of each mountpoint.
+         */
+        static void stat_mountpoints(std::vector<mountpoint*> const& points, unsigned int threads, uint32_t timeout);
+
+        /**
+         * Reads the file system and partition entry information of a device from its udev database file.
+         * @param path The path to the udev database file (e.g. /run/udev/data/b8:1).
+         * @param part The partition to populate.
+         * @return Returns true if any information was read or false if the file is missing or has no information.
+         */
+        static bool read_udev_data(std::string const& path, partition& part);
+
+        /**
+         * Reads partitions from sysfs and the udev database without opening any device.
+         * Devices that udev found no file system or partition entry on are skipped.
+         * @param block_directory The directory of block devices (e.g. /sys/class/block).
+         * @param udev_directory The directory of the udev database (e.g. /run/udev/data).
+         * @param include Called with the name of each device; returns true to read the device or false to skip it.
+         * @param unprobed Populated with the devices missing from the udev database, which need to be probed.
+         * @return Returns the partitions read from the udev database.
+         */
+        static std::vector<partition> read_partitions(std::string const& block_directory, std::string const& udev_directory, std::function<bool(std::string const&)> const& include, std::vector<partition>& unprobed);
+
      protected:
         /**
-         * Collects the DMI data.
+         * Collects the file system data.
          * @param facts The fact collection that is resolving facts.
-         * @return Returns the DMI data.
+         * @return Returns the file system data.
          */
         virtual data collect_data(collection& facts) override;
 
      private:
-        void collect_mountpoint_data(data& result);
+        void collect_mountpoint_data(collection& facts, data& result);
         void collect_filesystem_data(data& result);
         void collect_partition_data(data& result);
     };
@@ -5,6 +5,9 @@
 #pragma once
 
 #include "../bsd/networking_resolver.hpp"
+#include <map>
+#include <string>
+#include <vector>
 
 namespace facter { namespace facts { namespace linux {
 
@@ -13,12 +16,48 @@ namespace facter { namespace facts { namespace linux {
      *
      * The Linux networking_resolver inherits from the BSD networking_resolver.
      * This is because getifaddrs is a BSD concept that was implemented in Linux.
-     * The only thing this resolver is responsible for is handing link-level
-     * addressing and MTU.
+     * Interfaces are enumerated with rtnetlink, which returns every link, address and route in a few dumps
+     * over one socket; the getifaddrs implementation is used if rtnetlink is unavailable.
      */
     struct networking_resolver : bsd::networking_resolver
     {
+        /**
+         * Determines if a link kind can be configured by a DHCP client.
+         * @param kind The link kind reported by rtnetlink (e.g. "veth"); empty for physical links.
+         * @return Returns false for virtual links that never use DHCP (bridges, veth pairs and tun/tap devices) or true otherwise.
+         */
+        static bool is_dhcp_kind(std::string const& kind);
+
+        /**
+         * Finds the DHCP servers in the systemd-networkd lease files of the given directory.
+         * @param directory The lease directory (e.g. /run/systemd/netif/leases).
+         * @return Returns a map between interface index and DHCP server.
+         */
+        static std::map<int, std::string> find_networkd_dhcp_servers(std::string const& directory);
+
+        /**
+         * Finds the DHCP servers in the dhcpcd lease files of the given directory.
+         * @param directory The lease directory (e.g. /var/lib/dhcpcd).
+         * @return Returns a map between interface name and DHCP server.
+         */
+        static std::map<std::string, std::string> find_dhcpcd_lease_servers(std::string const& directory);
+
+        /**
+         * Finds the DHCP servers of the given interfaces by running "dhcpcd -U <interface>" for each interface.
+         * @param dhcpcd The name or path of the dhcpcd executable.
+         * @param interfaces The interfaces to find the DHCP servers for.
+         * @return Returns a map between interface name and DHCP server.
+         */
+        static std::map<std::string, std::string> find_dhcpcd_servers(std::string const& dhcpcd, std::vector<std::string> const& interfaces);
+
      protected:
+        /**
+         * Collects the resolver data.
+         * @param facts The fact collection that is resolving facts.
+         * @return Returns the resolver data.
+         */
+        virtual data collect_data(collection& facts) override;
+
         /**
          * Determines if the given sock address is a link layer address.
          * @param addr The socket address to check.
@@ -47,6 +86,17 @@ namespace facter { namespace facts { namespace linux {
          * @return Returns the primary interface or empty string if one could not be determined.
          */
         virtual std::string get_primary_interface() const override;
+
+        /**
+         * Finds known DHCP servers for the given interfaces.
+         * Leases of dhclient, systemd-networkd and dhcpcd are read from their lease stores.
+         * @param interfaces The interfaces to find DHCP servers for.
+         * @return Returns a map between interface name and DHCP server.
+         */
+        virtual std::map<std::string, std::string> find_dhcp_servers(std::set<std::string> const& interfaces) const override;
+
+     private:
+        bool collect_netlink_data(collection& facts, data& result);
     };
 
 }}}  // namespace facter::facts::linux
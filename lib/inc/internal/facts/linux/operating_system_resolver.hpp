@@ -21,6 +21,23 @@ namespace facter { namespace facts { namespace linux {
          */
         virtual data collect_data(collection& facts) override;
 
+        /**
+         * Collects the Linux Standard Base (LSB) distribution data from release files rather than by running lsb_release.
+         * The files are read in the order lsb_release implementations read them, with later files taking precedence:
+         * os-release, then the release file of Red Hat derived distributions, then lsb-release and lsb-release.d.
+         * @param root The directory the release files are relative to (empty for the root file system).
+         * @param result The resolver data to populate with the specification version and distribution.
+         */
+        static void collect_lsb_data(std::string const& root, data& result);
+
+        /**
+         * Parses a line of "lsb_release -a" output into the resolver data.
+         * Values of "n/a", which lsb_release prints for missing data, are ignored.
+         * @param line The line of output to parse.
+         * @param result The resolver data to populate with the specification version and distribution.
+         */
+        static void parse_lsb_release(std::string const& line, data& result);
+
      private:
         static selinux_data collect_selinux_data();
     };
@@ -5,6 +5,8 @@
 #pragma once
 
 #include "../posix/processor_resolver.hpp"
+#include <string>
+#include <vector>
 
 namespace facter { namespace facts { namespace linux {
 
@@ -13,6 +15,13 @@ namespace facter { namespace facts { namespace linux {
      */
     struct processor_resolver : posix::processor_resolver
     {
+        /**
+         * Parses a CPU list such as /sys/devices/system/cpu/present (e.g. "0-3,8-11").
+         * @param list The CPU list to parse.
+         * @return Returns a mask with an element for each CPU up to the highest listed CPU; listed CPUs are true.
+         */
+        static std::vector<bool> parse_cpu_list(std::string const& list);
+
      protected:
         /**
          * Collects the resolver data.
@@ -20,6 +29,25 @@ namespace facter { namespace facts { namespace linux {
          * @return Returns the resolver data.
          */
         virtual data collect_data(collection& facts) override;
+
+        /**
+         * Collects the logical and physical processor counts from the sysfs CPU topology.
+         * The CPUs of each package are read from the package's first CPU, so only one topology file is read per package.
+         * @param root The sysfs CPU directory (e.g. /sys/devices/system/cpu).
+         * @param result The data to store the counts in.
+         * @return Returns true if the counts were collected or false if the topology is unavailable.
+         */
+        static bool collect_topology(std::string const& root, data& result);
+
+        /**
+         * Collects the processor models, and optionally the counts, from a cpuinfo file in one pass.
+         * The models are stored once in the model table with an index for each logical processor.
+         * @param path The path to the cpuinfo file (e.g. /proc/cpuinfo).
+         * @param result The data to store the models and counts in.
+         * @param collect_counts True to collect the logical and physical counts or false to only collect the models.
+         * @return Returns true if the file was read or false if it was not.
+         */
+        static bool collect_cpuinfo(std::string const& path, data& result, bool collect_counts);
     };
 
 }}}  // namespace facter::facts::linux
@@ -14,6 +14,12 @@ namespace facter { namespace facts { namespace linux {
      */
     struct virtualization_resolver : resolvers::virtualization_resolver
     {
+        /**
+         * Gets the names of the facts the resolver reads while resolving.
+         * @return Returns a vector of fact names.
+         */
+        virtual std::vector<std::string> dependencies() const override;
+
      protected:
         /**
          * Gets the name of the hypervisor.
@@ -22,15 +28,35 @@ namespace facter { namespace facts { namespace linux {
          */
         virtual std::string get_hypervisor(collection& facts) override;
 
+        /**
+         * Gets the name of the hypervisor without running any commands.
+         * The container markers, DMI facts, Xen interfaces, CPUID signature and PCI vendors are checked in one pass
+         * from the most to the least specific; the first match is the hypervisor.
+         * @param facts The fact collection that is resolving facts.
+         * @param root The directory the proc and sys file systems are relative to (empty for the root file system).
+         * @param signature The hypervisor vendor signature from CPUID or empty if there is no hypervisor leaf.
+         * @return Returns the name of the hypervisor or empty string if no hypervisor was detected.
+         */
+        static std::string get_native_vm(collection& facts, std::string const& root, std::string const& signature);
+
+        /**
+         * Gets the hypervisor vendor signature from CPUID (e.g. "KVMKVMKVM").
+         * @return Returns the signature or empty string if the processor does not report a hypervisor.
+         */
+        static std::string get_cpuid_signature();
+
      private:
-        static std::string get_cgroup_vm();
+        static std::string get_cgroup_vm(std::string const& root);
+        static std::string get_environ_vm(std::string const& root);
         static std::string get_gce_vm(collection& facts);
         static std::string get_what_vm();
-        static std::string get_vserver_vm();
+        static std::string get_vserver_vm(std::string const& root);
         static std::string get_vmware_vm();
-        static std::string get_openvz_vm();
-        static std::string get_xen_vm();
+        static std::string get_openvz_vm(std::string const& root);
+        static std::string get_xen_vm(std::string const& root, std::string const& signature);
         static std::string get_product_name_vm(collection& facts);
+        static std::string get_cpuid_vm(std::string const& signature);
+        static std::string get_pci_vm(std::string const& root);
         static std::string get_lspci_vm();
     };
 
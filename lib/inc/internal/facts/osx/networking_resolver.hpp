@@ -44,10 +44,11 @@ namespace facter { namespace facts { namespace osx {
         virtual std::string get_primary_interface() const override;
 
         /**
-         * Finds known DHCP servers for all interfaces.
+         * Finds known DHCP servers for the given interfaces.
+         * @param interfaces The interfaces to find DHCP servers for.
          * @return Returns a map between interface name and DHCP server.
          */
-        virtual std::map<std::string, std::string> find_dhcp_servers() const override;
+        virtual std::map<std::string, std::string> find_dhcp_servers(std::set<std::string> const& interfaces) const override;
 
         /**
          * Finds the DHCP server for the given interface.
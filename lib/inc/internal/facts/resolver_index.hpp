@@ -0,0 +1,78 @@
+/**
+ * @file
+ * Declares the index used to find the resolvers for a fact name.
+ */
+#pragma once
+
+#include <facter/facts/resolver.hpp>
+#include <boost/regex.hpp>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace facter { namespace facts {
+
+    /**
+     * Indexes resolvers by the fact names and patterns they are responsible for.
+     * Fact names and the literal prefixes of anchored patterns are stored in a trie, so finding the
+     * resolvers for a fact name takes time proportional to the length of the name.
+     * Patterns that are not a literal prefix are only matched against names that share their literal prefix.
+     */
+    struct resolver_index
+    {
+        /**
+         * Constructs an empty resolver index.
+         */
+        resolver_index();
+
+        /**
+         * Adds a resolver to the index.
+         * @param res The resolver to add.
+         */
+        void add(std::shared_ptr<resolver> const& res);
+
+        /**
+         * Removes a resolver from the index.
+         * @param res The resolver to remove.
+         */
+        void remove(std::shared_ptr<resolver> const& res);
+
+        /**
+         * Removes all resolvers from the index.
+         */
+        void clear();
+
+        /**
+         * Finds the resolver responsible for the given fact name.
+         * Resolvers that list the name are preferred over resolvers with a matching pattern.
+         * Otherwise, the resolver that was added first (or last) is returned.
+         * @param name The fact name to find the resolver for.
+         * @param latest True to find the resolver that was added last (i.e. the one whose value overrides the others) or false to find the one added first.
+         * @return Returns the resolver or nullptr if no resolver is responsible for the name.
+         */
+        std::shared_ptr<resolver> find(std::string const& name, bool latest = false) const;
+
+     private:
+        struct pattern
+        {
+            std::shared_ptr<resolver> res;
+            std::unique_ptr<boost::regex> regex;
+        };
+
+        struct node
+        {
+            std::map<char, std::unique_ptr<node>> children;
+            std::map<size_t, std::shared_ptr<resolver>> resolvers;
+            std::multimap<size_t, pattern> patterns;
+        };
+
+        node* insert(std::string const& key);
+
+        node _root;
+        std::multimap<size_t, pattern> _unanchored;
+        std::map<std::shared_ptr<resolver>, std::pair<size_t, std::vector<node*>>> _entries;
+        size_t _sequence;
+    };
+
+}}  // namespace facter::facts
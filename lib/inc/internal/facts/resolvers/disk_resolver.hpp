@@ -5,6 +5,7 @@
 #pragma once
 
 #include <facter/facts/resolver.hpp>
+#include <facter/facts/map_value.hpp>
 #include <string>
 #include <cstdint>
 #include <vector>
@@ -76,6 +77,19 @@ namespace facter { namespace facts { namespace resolvers {
          * @return Returns the resolver data.
          */
         virtual data collect_data(collection& facts) = 0;
+
+        /**
+         * Called to resolve only the part of a fact needed to answer a query.
+         * Queries for a single disk only collect the data for that disk.
+         * @param facts The fact collection that is resolving the query.
+         * @param name The name of the queried fact.
+         * @param path The segments of the query that follow the fact name.
+         * @return Returns a value containing at least the queried part of the fact or nullptr if the query requires resolving all facts.
+         */
+        virtual std::unique_ptr<value> query(collection& facts, std::string const& name, std::vector<std::string> const& path) override;
+
+     private:
+        static std::unique_ptr<map_value> make_disk_value(disk const& d);
     };
 
 }}}  // namespace facter::facts::resolvers
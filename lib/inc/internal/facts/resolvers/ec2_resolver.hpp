@@ -18,11 +18,28 @@ namespace facter { namespace facts { namespace resolvers {
          */
         ec2_resolver();
 
+        /**
+         * Gets the names of the facts the resolver reads while resolving.
+         * @return Returns a vector of fact names.
+         */
+        virtual std::vector<std::string> dependencies() const override;
+
         /**
          * Called to resolve all facts the resolver is responsible for.
          * @param facts The fact collection that is resolving facts.
          */
         virtual void resolve(collection& facts) override;
+
+     protected:
+        /**
+         * Called to resolve only the part of a fact needed to answer a query.
+         * Queries for EC2 metadata only request the queried metadata.
+         * @param facts The fact collection that is resolving the query.
+         * @param name The name of the queried fact.
+         * @param path The segments of the query that follow the fact name.
+         * @return Returns a value containing at least the queried part of the fact or nullptr if the query requires resolving all facts.
+         */
+        virtual std::unique_ptr<value> query(collection& facts, std::string const& name, std::vector<std::string> const& path) override;
     };
 
 }}}  // namespace facter::facts::resolvers
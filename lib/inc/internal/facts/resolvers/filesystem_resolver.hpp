@@ -5,6 +5,8 @@
 #pragma once
 
 #include <facter/facts/resolver.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/facts/name_filter.hpp>
 #include <string>
 #include <vector>
 #include <set>
@@ -28,6 +30,19 @@ namespace facter { namespace facts { namespace resolvers {
          */
         virtual void resolve(collection& facts) override;
 
+        /**
+         * Gets the resolver's filter of the mountpoints to collect data for.
+         * @return Returns the mountpoint filter.
+         */
+        name_filter const& mountpoint_filter() const;
+
+        /**
+         * Sets the resolver's filter of the mountpoints to collect data for.
+         * An empty filter defers to the fact collection's mountpoint filter.
+         * @param filter The filter matched against both the path and the file system type of each mountpoint.
+         */
+        void mountpoint_filter(name_filter filter);
+
      protected:
         /**
          * Represents data about a mountpoint.
@@ -39,7 +54,8 @@ namespace facter { namespace facts { namespace resolvers {
              */
             mountpoint() :
                 size(0),
-                available(0)
+                available(0),
+                timed_out(false)
             {
             }
 
@@ -72,6 +88,11 @@ namespace facter { namespace facts { namespace resolvers {
              * Stores the mountpoint options.
              */
             std::vector<std::string> options;
+
+            /**
+             * Stores whether getting the size of the mountpoint timed out.
+             */
+            bool timed_out;
         };
 
         /**
@@ -155,6 +176,32 @@ namespace facter { namespace facts { namespace resolvers {
          * @return Returns the file system data.
          */
         virtual data collect_data(collection& facts) = 0;
+
+        /**
+         * Called to resolve only the part of a fact needed to answer a query.
+         * Queries for a single mountpoint or partition only collect the data for that mountpoint or partition.
+         * @param facts The fact collection that is resolving the query.
+         * @param name The name of the queried fact.
+         * @param path The segments of the query that follow the fact name.
+         * @return Returns a value containing at least the queried part of the fact or nullptr if the query requires resolving all facts.
+         */
+        virtual std::unique_ptr<value> query(collection& facts, std::string const& name, std::vector<std::string> const& path) override;
+
+        /**
+         * Determines if data should be collected for a mountpoint.
+         * Mountpoints are checked against the resolver's filter or, if it is empty, the fact collection's mountpoint filter.
+         * @param facts The fact collection that is resolving facts.
+         * @param name The path of the mountpoint.
+         * @param filesystem The file system type of the mountpoint.
+         * @return Returns true if the mountpoint is included or false if it is filtered out.
+         */
+        bool is_included(collection const& facts, std::string const& name, std::string const& filesystem) const;
+
+     private:
+        static std::unique_ptr<map_value> make_mountpoints_value(std::vector<mountpoint>& mountpoints);
+        static std::unique_ptr<map_value> make_partitions_value(std::vector<partition>& partitions);
+
+        name_filter _mountpoint_filter;
     };
 
 }}}  // namespace facter::facts::resolvers
@@ -25,6 +25,18 @@ namespace facter { namespace facts { namespace resolvers {
          */
         virtual void resolve(collection& facts) override;
 
+        /**
+         * Determines if the resolver adds legacy facts lazily with resolve_legacy.
+         * @return Returns true because the legacy facts are added lazily.
+         */
+        virtual bool has_legacy_facts() const override;
+
+        /**
+         * Adds the legacy memory and swap facts from the memory fact.
+         * @param facts The fact collection that is resolving facts.
+         */
+        virtual void resolve_legacy(collection& facts) override;
+
      protected:
         /**
          * Represents the possible swap encryption status.
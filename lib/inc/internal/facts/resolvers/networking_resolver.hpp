@@ -5,6 +5,8 @@
 #pragma once
 
 #include <facter/facts/resolver.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/facts/name_filter.hpp>
 #include <string>
 #include <vector>
 #include <boost/optional.hpp>
@@ -34,6 +36,31 @@ namespace facter { namespace facts { namespace resolvers {
          */
         virtual void resolve(collection& facts) override;
 
+        /**
+         * Determines if the resolver adds legacy facts lazily with resolve_legacy.
+         * @return Returns true because the per-interface legacy facts are added lazily.
+         */
+        virtual bool has_legacy_facts() const override;
+
+        /**
+         * Adds the per-interface legacy facts (e.g. ipaddress_eth0) and the dhcp_servers fact from the networking fact.
+         * @param facts The fact collection that is resolving facts.
+         */
+        virtual void resolve_legacy(collection& facts) override;
+
+        /**
+         * Gets the resolver's filter of the network interfaces to collect data for.
+         * @return Returns the interface filter.
+         */
+        name_filter const& interface_filter() const;
+
+        /**
+         * Sets the resolver's filter of the network interfaces to collect data for.
+         * An empty filter defers to the fact collection's interface filter.
+         * @param filter The filter matched against interface names.
+         */
+        void interface_filter(name_filter filter);
+
      protected:
         /**
          * Represents an IP address.
@@ -129,6 +156,30 @@ namespace facter { namespace facts { namespace resolvers {
          * @return Returns the resolver data.
          */
         virtual data collect_data(collection& facts) = 0;
+
+        /**
+         * Called to resolve only the part of a fact needed to answer a query.
+         * Queries for a single interface only collect the data for that interface.
+         * @param facts The fact collection that is resolving the query.
+         * @param name The name of the queried fact.
+         * @param path The segments of the query that follow the fact name.
+         * @return Returns a value containing at least the queried part of the fact or nullptr if the query requires resolving all facts.
+         */
+        virtual std::unique_ptr<value> query(collection& facts, std::string const& name, std::vector<std::string> const& path) override;
+
+        /**
+         * Determines if data should be collected for a network interface.
+         * Interfaces are checked against the resolver's filter or, if it is empty, the fact collection's interface filter.
+         * @param facts The fact collection that is resolving facts.
+         * @param name The name of the interface.
+         * @return Returns true if the interface is included or false if it is filtered out.
+         */
+        bool is_included(collection const& facts, std::string const& name) const;
+
+     private:
+        static std::unique_ptr<map_value> make_interface_value(interface const& iface);
+
+        name_filter _interface_filter;
     };
 
 }}}  // namespace facter::facts::resolvers
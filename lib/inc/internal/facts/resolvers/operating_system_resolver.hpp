@@ -19,6 +19,12 @@ namespace facter { namespace facts { namespace resolvers {
          */
         operating_system_resolver();
 
+        /**
+         * Gets the names of the facts the resolver reads while resolving.
+         * @return Returns a vector of fact names.
+         */
+        virtual std::vector<std::string> dependencies() const override;
+
         /**
          * Called to resolve all facts the resolver is responsible for.
          * @param facts The fact collection that is resolving facts.
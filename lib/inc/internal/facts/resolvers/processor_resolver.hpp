@@ -5,6 +5,7 @@
 #pragma once
 
 #include <facter/facts/resolver.hpp>
+#include <facter/facts/map_value.hpp>
 #include <string>
 #include <vector>
 #include <cstdint>
@@ -27,6 +28,18 @@ namespace facter { namespace facts { namespace resolvers {
          */
         virtual void resolve(collection& facts) override;
 
+        /**
+         * Determines if the resolver adds legacy facts lazily with resolve_legacy.
+         * @return Returns true because the legacy facts are added lazily.
+         */
+        virtual bool has_legacy_facts() const override;
+
+        /**
+         * Adds the legacy processor<N> facts from the models in the processors fact.
+         * @param facts The fact collection that is resolving facts.
+         */
+        virtual void resolve_legacy(collection& facts) override;
+
      protected:
         /**
          * Represents processor resolver data.
@@ -58,6 +71,16 @@ namespace facter { namespace facts { namespace resolvers {
              */
             std::vector<std::string> models;
 
+            /**
+             * Stores the distinct processor model strings; used with model_indexes instead of storing a model per processor.
+             */
+            std::vector<std::string> model_names;
+
+            /**
+             * Stores the index into model_names of each processor's model.
+             */
+            std::vector<size_t> model_indexes;
+
             /**
              * Stores the processor speed, in Hz.
              */
@@ -75,6 +98,19 @@ namespace facter { namespace facts { namespace resolvers {
          * @return Returns the resolver data.
          */
         virtual data collect_data(collection& facts) = 0;
+
+        /**
+         * Called to resolve only the part of a fact needed to answer a query.
+         * Queries for a single processors element only collect the data for that element.
+         * @param facts The fact collection that is resolving the query.
+         * @param name The name of the queried fact.
+         * @param path The segments of the query that follow the fact name.
+         * @return Returns a value containing at least the queried part of the fact or nullptr if the query requires resolving all facts.
+         */
+        virtual std::unique_ptr<value> query(collection& facts, std::string const& name, std::vector<std::string> const& path) override;
+
+     private:
+        static std::unique_ptr<map_value> make_processors_value(data& result);
     };
 
 }}}  // namespace facter::facts::resolvers
@@ -18,6 +18,13 @@ namespace facter { namespace facts { namespace resolvers {
          */
         ruby_resolver();
 
+        /**
+         * Determines if the resolver can be resolved on a thread other than the one resolving the collection.
+         * The Ruby VM may only be called from the thread that initialized it.
+         * @return Always returns false.
+         */
+        virtual bool is_thread_safe() const override;
+
         /**
          * Called to resolve all facts the resolver is responsible for.
          * @param facts The fact collection that is resolving facts.
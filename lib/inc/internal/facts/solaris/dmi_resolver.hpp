@@ -13,6 +13,12 @@ namespace facter { namespace facts { namespace solaris {
      */
     struct dmi_resolver : resolvers::dmi_resolver
     {
+        /**
+         * Gets the names of the facts the resolver reads while resolving.
+         * @return Returns a vector of fact names.
+         */
+        virtual std::vector<std::string> dependencies() const override;
+
      protected:
         /**
          * Collects the resolver data.
@@ -22,7 +22,7 @@ namespace facter { namespace facts { namespace solaris {
         virtual data collect_data(collection& facts) override;
 
      private:
-        void collect_mountpoint_data(data& result);
+        void collect_mountpoint_data(collection& facts, data& result);
         void collect_filesystem_data(data& result);
     };
 
@@ -13,6 +13,12 @@ namespace facter { namespace facts { namespace solaris {
      */
     struct virtualization_resolver : resolvers::virtualization_resolver
     {
+        /**
+         * Gets the names of the facts the resolver reads while resolving.
+         * @return Returns a vector of fact names.
+         */
+        virtual std::vector<std::string> dependencies() const override;
+
      protected:
         /**
          * Gets the name of the hypervisor.
@@ -0,0 +1,40 @@
+/**
+ * @file
+ * Declares the pool that map keys are interned in.
+ */
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <string>
+#include <unordered_set>
+
+namespace facter { namespace facts {
+
+    /**
+     * A pool of interned strings.
+     * Interning the same string more than once returns the same pooled string, so the many maps that share keys
+     * (e.g. "ip", "netmask" and "mtu" for every interface) store each key only once.
+     * Pooled strings live as long as the pool; the pool is safe to use from multiple threads.
+     */
+    struct string_pool
+    {
+        /**
+         * Interns a string.
+         * @param str The string to intern.
+         * @return Returns the pooled string, which remains valid for the lifetime of the pool.
+         */
+        std::string const* intern(std::string str);
+
+        /**
+         * Gets the number of strings in the pool.
+         * @return Returns the number of strings in the pool.
+         */
+        size_t size() const;
+
+     private:
+        // Elements of an unordered_set are not moved when it rehashes, so pointers to them remain valid
+        std::unordered_set<std::string> _strings;
+        mutable boost::mutex _mutex;
+    };
+
+}}  // namespace facter::facts
@@ -0,0 +1,105 @@
+/**
+ * @file
+ * Declares the arena that fact values are allocated from.
+ */
+#pragma once
+
+#include <boost/thread/mutex.hpp>
+#include <cstddef>
+#include <memory>
+
+namespace facter { namespace facts {
+
+    struct string_pool;
+
+    /**
+     * An arena that allocates fact values from large blocks of memory.
+     * Each block is freed once the arena no longer allocates from it and every value allocated from it has been freed.
+     * Values may therefore outlive the arena that allocated them.
+     * Values are allocated from the arena that is current on the calling thread; see value_arena::scope.
+     * The arena also owns the pool that the keys of maps created while it is current are interned in.
+     */
+    struct value_arena
+    {
+        /**
+         * The default size of the arena's blocks, in bytes.
+         */
+        static const size_t default_block_size = 64 * 1024;
+
+        /**
+         * Constructs a value arena.
+         * @param block_size The size of the arena's blocks, in bytes.
+         */
+        explicit value_arena(size_t block_size = default_block_size);
+
+        /**
+         * Destructs the value arena.
+         * Blocks with live values are freed when their last value is freed.
+         */
+        ~value_arena();
+
+        /**
+         * Allocates memory from the arena current on the calling thread or the heap if there is no current arena.
+         * @param size The number of bytes to allocate.
+         * @return Returns the allocated memory.
+         */
+        static void* allocate(size_t size);
+
+        /**
+         * Frees memory returned by allocate.
+         * @param ptr The memory to free.
+         */
+        static void deallocate(void* ptr);
+
+        /**
+         * Gets the arena that is current on the calling thread.
+         * @return Returns the current arena or nullptr if there is no current arena.
+         */
+        static value_arena* current();
+
+        /**
+         * Gets the pool that map keys are interned in.
+         * @return Returns the arena's string pool.
+         */
+        std::shared_ptr<string_pool> const& strings() const;
+
+        /**
+         * Makes an arena current on the calling thread for the lifetime of the scope.
+         * The previously current arena is restored when the scope ends.
+         */
+        struct scope
+        {
+            /**
+             * Constructs the scope and makes the given arena current.
+             * @param arena The arena to make current; nullptr to allocate from the heap.
+             */
+            explicit scope(value_arena* arena);
+
+            /**
+             * Restores the previously current arena.
+             */
+            ~scope();
+
+         private:
+            scope(scope const&) = delete;
+            scope& operator=(scope const&) = delete;
+
+            value_arena* _previous;
+        };
+
+     private:
+        value_arena(value_arena const&) = delete;
+        value_arena& operator=(value_arena const&) = delete;
+
+        struct block;
+
+        void* allocate_from_block(size_t size);
+        static void release(block* b);
+
+        size_t _block_size;
+        block* _current;
+        std::shared_ptr<string_pool> _strings;
+        boost::mutex _mutex;
+    };
+
+}}  // namespace facter::facts
@@ -57,6 +57,18 @@ namespace facter { namespace ruby {
          */
         virtual void to_json(rapidjson::Allocator& allocator, rapidjson::Value& value) const override;
 
+        /**
+          * Writes the value to the given JSON writer.
+          * @param writer The JSON writer to write to.
+          */
+        virtual void write(facter::facts::json_writer& writer) const override;
+
+        /**
+          * Writes the value to the given MessagePack writer.
+          * @param writer The MessagePack writer to write to.
+          */
+        virtual void write(facter::facts::msgpack_writer& writer) const override;
+
         /**
           * Writes the value to the given stream.
           * @param os The stream to write to.
@@ -81,6 +93,8 @@ namespace facter { namespace ruby {
 
      private:
         static void to_json(api const& ruby, VALUE value, rapidjson::Allocator& allocator, rapidjson::Value& json);
+        static void write(api const& ruby, VALUE value, facter::facts::json_writer& writer);
+        static void write(api const& ruby, VALUE value, facter::facts::msgpack_writer& writer);
         static void write(api const& ruby, VALUE value, std::ostream& os, bool quoted, unsigned int level);
         static void write(api const& ruby, VALUE value, YAML::Emitter& emitter);
 
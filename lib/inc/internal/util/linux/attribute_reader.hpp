@@ -0,0 +1,84 @@
+/**
+ * @file
+ * Declares the reader of small attribute files such as those in sysfs.
+ */
+#pragma once
+
+#include "../posix/scoped_descriptor.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace facter { namespace util { namespace linux {
+
+    /**
+     * Reads small attribute files (e.g. /sys/block/sda/size) relative to an open directory.
+     * Each attribute is read with a single openat and read into a reusable buffer instead of a stream.
+     * Batches of attributes are read with io_uring when it is available: each attribute is opened, read and closed by a chain
+     * of linked requests, so a batch takes a single system call once the reader has set up its ring.
+     */
+    struct attribute_reader
+    {
+        /**
+         * The maximum size of an attribute read in a batch, in bytes.
+         * Kernel attributes are limited to a page; larger attributes are truncated.
+         */
+        static const size_t batch_attribute_size = 4096;
+
+        /**
+         * Constructs an attribute reader for the given directory.
+         * @param directory The directory that attribute names are relative to.
+         */
+        explicit attribute_reader(std::string const& directory);
+
+        /**
+         * Destructs the attribute reader.
+         */
+        ~attribute_reader();
+
+        /**
+         * Determines if the directory was opened.
+         * @return Returns true if the directory was opened or false if it does not exist or could not be opened.
+         */
+        explicit operator bool() const;
+
+        /**
+         * Determines if a file or directory exists relative to the directory.
+         * @param name The relative path of the file or directory.
+         * @return Returns true if the file or directory exists or false if it does not.
+         */
+        bool exists(std::string const& name) const;
+
+        /**
+         * Reads an attribute; surrounding whitespace (e.g. the trailing newline) is removed.
+         * @param name The relative path of the attribute file.
+         * @param value The string to store the attribute's value in.
+         * @return Returns true if the attribute was read or false if it does not exist or could not be read.
+         */
+        bool read(std::string const& name, std::string& value);
+
+        /**
+         * Reads an attribute; surrounding whitespace (e.g. the trailing newline) is removed.
+         * @param name The relative path of the attribute file.
+         * @return Returns the value of the attribute or an empty string if it could not be read.
+         */
+        std::string read(std::string const& name);
+
+        /**
+         * Reads a batch of attributes; surrounding whitespace (e.g. the trailing newline) is removed.
+         * @param names The relative paths of the attribute files.
+         * @return Returns the value of each attribute, in the order of the names; attributes that could not be read are empty.
+         */
+        std::vector<std::string> read_all(std::vector<std::string> const& names);
+
+     private:
+        struct uring;
+
+        bool read_batch(std::vector<std::string> const& names, size_t offset, size_t count, std::vector<std::string>& values);
+
+        posix::scoped_descriptor _directory;
+        std::vector<char> _buffer;
+        std::unique_ptr<uring> _ring;
+    };
+
+}}}  // namespace facter::util::linux
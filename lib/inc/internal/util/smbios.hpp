@@ -0,0 +1,120 @@
+/**
+ * @file
+ * Declares the decoder of System Management BIOS (SMBIOS) tables.
+ */
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace facter { namespace util {
+
+    /**
+     * Decodes the structures of an SMBIOS table (e.g. /sys/firmware/dmi/tables/DMI).
+     * The table is read once and each structure's formatted area and strings are decoded without interpretation;
+     * callers look up the fields of the structure types they are interested in.
+     */
+    struct smbios
+    {
+        /**
+         * Represents an SMBIOS structure.
+         */
+        struct structure
+        {
+            /**
+             * Stores the type of the structure (e.g. 1 for system information).
+             */
+            uint8_t type;
+
+            /**
+             * Stores the handle of the structure.
+             */
+            uint16_t handle;
+
+            /**
+             * Stores the formatted area of the structure, including the header.
+             */
+            std::vector<uint8_t> formatted;
+
+            /**
+             * Stores the strings of the structure; the string numbered 1 is the first string.
+             */
+            std::vector<std::string> strings;
+
+            /**
+             * Gets a byte field of the structure.
+             * @param offset The offset of the field in the formatted area.
+             * @return Returns the field or 0 if the structure is too short to have the field.
+             */
+            uint8_t byte(size_t offset) const;
+
+            /**
+             * Gets a little-endian word field of the structure.
+             * @param offset The offset of the field in the formatted area.
+             * @return Returns the field or 0 if the structure is too short to have the field.
+             */
+            uint16_t word(size_t offset) const;
+
+            /**
+             * Gets a string field of the structure; surrounding whitespace is removed.
+             * @param offset The offset of the field's string number in the formatted area.
+             * @return Returns the string or an empty string if the field is missing or has no string.
+             */
+            std::string text(size_t offset) const;
+        };
+
+        /**
+         * The SMBIOS structure type that ends the table.
+         */
+        static const uint8_t end_of_table = 127;
+
+        /**
+         * Constructs an empty SMBIOS decoder.
+         */
+        smbios();
+
+        /**
+         * Reads the SMBIOS entry point and structure table from a directory.
+         * @param directory The directory containing the smbios_entry_point and DMI files (e.g. /sys/firmware/dmi/tables).
+         * @return Returns true if the table was read and decoded or false if it is unavailable or invalid.
+         */
+        bool read(std::string const& directory);
+
+        /**
+         * Decodes an SMBIOS entry point and structure table.
+         * Both the 32-bit (_SM_ and legacy _DMI_) and 64-bit (_SM3_) entry points are supported.
+         * @param entry_point The contents of the entry point.
+         * @param table The contents of the structure table.
+         * @return Returns true if the table was decoded or false if the entry point is invalid.
+         */
+        bool decode(std::string const& entry_point, std::string const& table);
+
+        /**
+         * Gets the SMBIOS version of the table as a major version in the high byte and a minor version in the low byte.
+         * @return Returns the version of the table (e.g. 0x0208 for SMBIOS 2.8) or 0 if no table has been decoded.
+         */
+        uint16_t version() const;
+
+        /**
+         * Gets the decoded structures in the order of the table.
+         * @return Returns the decoded structures.
+         */
+        std::vector<structure> const& structures() const;
+
+        /**
+         * Finds the first structure of the given type.
+         * @param type The type of the structure to find.
+         * @return Returns the first structure of the type or nullptr if the table has no structure of the type.
+         */
+        structure const* find(uint8_t type) const;
+
+     private:
+        void decode_table(std::string const& table, size_t max_structures);
+
+        uint16_t _version;
+        std::vector<structure> _structures;
+    };
+
+}}  // namespace facter::util
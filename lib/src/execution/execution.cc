@@ -1,8 +1,13 @@
 #include <facter/execution/execution.hpp>
 #include <facter/util/directory.hpp>
+#include <facter/util/environment.hpp>
+#include <internal/execution/execution.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/tss.hpp>
 #include <cstdlib>
 #include <cstdio>
 #include <sstream>
@@ -71,6 +76,110 @@ namespace facter { namespace execution {
         return _pid;
     }
 
+    // Represents the memoized result of a command
+    struct cached_command
+    {
+        enum class failure
+        {
+            none,
+            exit,
+            signal
+        };
+
+        cached_command() :
+            success(false),
+            failed(failure::none),
+            status(0)
+        {
+        }
+
+        bool success;
+        failure failed;
+        int status;
+        string output;
+        string error;
+        vector<string> output_lines;
+        vector<string> error_lines;
+    };
+
+    // The command cache's state is shared by every thread the cache is current on; the mutex guards it
+    struct command_cache_state
+    {
+        command_cache_state() :
+            statistics()
+        {
+        }
+
+        boost::mutex mutex;
+        map<string, cached_command> commands;
+        map<string, string> executables;
+        command_cache_statistics statistics;
+    };
+
+    static void no_cleanup(command_cache_state*)
+    {
+    }
+
+    static boost::thread_specific_ptr<command_cache_state> current_cache(no_cleanup);
+
+    command_cache::command_cache() :
+        _state(new command_cache_state())
+    {
+    }
+
+    command_cache::~command_cache()
+    {
+        auto const& statistics = _state->statistics;
+        LOG_DEBUG("command cache: %1% hits and %2% misses; executable cache: %3% hits and %4% misses.",
+            statistics.command_hits, statistics.command_misses, statistics.path_hits, statistics.path_misses);
+    }
+
+    command_cache_statistics command_cache::statistics() const
+    {
+        boost::lock_guard<boost::mutex> lock(_state->mutex);
+        return _state->statistics;
+    }
+
+    command_cache::scope::scope(command_cache* cache) :
+        _previous(current_cache.get())
+    {
+        current_cache.reset(cache ? cache->_state.get() : nullptr);
+    }
+
+    command_cache::scope::~scope()
+    {
+        current_cache.reset(_previous);
+    }
+
+    string which(string const& file, vector<string> const& directories)
+    {
+        auto cache = current_cache.get();
+        if (!cache) {
+            return find_executable(file, directories);
+        }
+
+        // The key is the file followed by each search path, separated by nulls
+        string key = file;
+        for (auto const& directory : directories) {
+            key += '\0';
+            key += directory;
+        }
+        {
+            boost::lock_guard<boost::mutex> lock(cache->mutex);
+            auto it = cache->executables.find(key);
+            if (it != cache->executables.end()) {
+                ++cache->statistics.path_hits;
+                return it->second;
+            }
+            ++cache->statistics.path_misses;
+        }
+
+        auto executable = find_executable(file, directories);
+        boost::lock_guard<boost::mutex> lock(cache->mutex);
+        cache->executables[key] = executable;
+        return executable;
+    }
+
     void log_execution(string const& file, vector<string> const* arguments)
     {
         if (!LOG_IS_DEBUG_ENABLED()) {
@@ -136,6 +245,147 @@ namespace facter { namespace execution {
         option_set<execution_options> const& options,
         uint32_t timeout);
 
+    static string get_command_key(
+        string const& file,
+        vector<string> const* arguments,
+        map<string, string> const* environment,
+        bool has_stdout_callback,
+        bool has_stderr_callback,
+        option_set<execution_options> const& options)
+    {
+        // The key is the executable, arguments, environment and options separated by nulls
+        // Buffered output and line callbacks are cached separately because trimming differs between them
+        ostringstream key;
+        auto executable = which(file);
+        key << (executable.empty() ? file : executable) << '\0';
+        if (arguments) {
+            for (auto const& argument : *arguments) {
+                key << argument << '\0';
+            }
+        }
+        key << '\1';
+        if (environment) {
+            for (auto const& variable : *environment) {
+                key << variable.first << '=' << variable.second << '\0';
+            }
+        }
+        key << '\1';
+        if (options[execution_options::merge_environment]) {
+            // The inherited environment may be changed between commands (e.g. by a custom fact)
+            facter::util::environment::each([&](string& name, string& value) {
+                key << name << '=' << value << '\0';
+                return true;
+            });
+        }
+        key << '\1' << options.value() << (has_stdout_callback ? 'o' : '-') << (has_stderr_callback ? 'e' : '-');
+        return key.str();
+    }
+
+    static tuple<bool, string, string> replay(cached_command const& command, function<bool(string&)> const& stdout_callback, function<bool(string&)> const& stderr_callback)
+    {
+        for (auto line : command.output_lines) {
+            if (!stdout_callback(line)) {
+                break;
+            }
+        }
+        for (auto line : command.error_lines) {
+            if (!stderr_callback(line)) {
+                break;
+            }
+        }
+        if (command.failed == cached_command::failure::exit) {
+            throw child_exit_exception("child process returned non-zero exit status.", command.status, command.output, command.error);
+        }
+        if (command.failed == cached_command::failure::signal) {
+            throw child_signal_exception("child process was terminated by signal.", command.status, command.output, command.error);
+        }
+        return make_tuple(command.success, command.output, command.error);
+    }
+
+    static tuple<bool, string, string> execute_cached(
+        string const& file,
+        vector<string> const* arguments,
+        map<string, string> const* environment,
+        function<bool(string&)> const& stdout_callback,
+        function<bool(string&)> const& stderr_callback,
+        option_set<execution_options> const& options,
+        uint32_t timeout)
+    {
+        auto cache = current_cache.get();
+        if (!cache) {
+            return execute(file, arguments, environment, stdout_callback, stderr_callback, options, timeout);
+        }
+
+        auto key = get_command_key(file, arguments, environment, static_cast<bool>(stdout_callback), static_cast<bool>(stderr_callback), options);
+        {
+            boost::unique_lock<boost::mutex> lock(cache->mutex);
+            auto it = cache->commands.find(key);
+            if (it != cache->commands.end()) {
+                ++cache->statistics.command_hits;
+                auto command = it->second;
+                lock.unlock();
+                LOG_DEBUG("using the cached result of command: %1%", file);
+                return replay(command, stdout_callback, stderr_callback);
+            }
+            ++cache->statistics.command_misses;
+        }
+
+        // Record the lines passed to the callbacks so that they can be replayed
+        cached_command command;
+        bool complete = true;
+        function<bool(string&)> recording_stdout_callback;
+        function<bool(string&)> recording_stderr_callback;
+        if (stdout_callback) {
+            recording_stdout_callback = [&](string& line) {
+                command.output_lines.push_back(line);
+                if (!stdout_callback(line)) {
+                    complete = false;
+                    return false;
+                }
+                return true;
+            };
+        }
+        if (stderr_callback) {
+            recording_stderr_callback = [&](string& line) {
+                command.error_lines.push_back(line);
+                if (!stderr_callback(line)) {
+                    complete = false;
+                    return false;
+                }
+                return true;
+            };
+        }
+
+        auto store = [&]() {
+            // A command whose output was not fully processed can't be replayed
+            if (!complete) {
+                return;
+            }
+            boost::lock_guard<boost::mutex> lock(cache->mutex);
+            cache->commands[key] = command;
+        };
+
+        try {
+            tie(command.success, command.output, command.error) = execute(file, arguments, environment, recording_stdout_callback, recording_stderr_callback, options, timeout);
+        } catch (child_exit_exception const& ex) {
+            command.failed = cached_command::failure::exit;
+            command.status = ex.status_code();
+            command.output = ex.output();
+            command.error = ex.error();
+            store();
+            throw;
+        } catch (child_signal_exception const& ex) {
+            command.failed = cached_command::failure::signal;
+            command.status = ex.signal();
+            command.output = ex.output();
+            command.error = ex.error();
+            store();
+            throw;
+        }
+        store();
+        return make_tuple(command.success, command.output, command.error);
+    }
+
     static void setup_execute(function<bool(string&)>& stderr_callback, option_set<execution_options>& options)
     {
         // If not redirecting stderr to stdout, but redirecting to null, use a do-nothing callback so that stderr is logged when the level is debug
@@ -156,7 +406,7 @@ namespace facter { namespace execution {
         auto actual_options = options;
         function<bool(string&)> stderr_callback;
         setup_execute(stderr_callback, actual_options);
-        return execute(file, nullptr, nullptr, nullptr, stderr_callback, actual_options, timeout);
+        return execute_cached(file, nullptr, nullptr, nullptr, stderr_callback, actual_options, timeout);
     }
 
     tuple<bool, string, string> execute(
@@ -168,7 +418,7 @@ namespace facter { namespace execution {
         auto actual_options = options;
         function<bool(string&)> stderr_callback;
         setup_execute(stderr_callback, actual_options);
-        return execute(file, &arguments, nullptr, nullptr, stderr_callback, actual_options, timeout);
+        return execute_cached(file, &arguments, nullptr, nullptr, stderr_callback, actual_options, timeout);
     }
 
     tuple<bool, string, string> execute(
@@ -181,7 +431,7 @@ namespace facter { namespace execution {
         auto actual_options = options;
         function<bool(string&)> stderr_callback;
         setup_execute(stderr_callback, actual_options);
-        return execute(file, &arguments, &environment, nullptr, stderr_callback, actual_options, timeout);
+        return execute_cached(file, &arguments, &environment, nullptr, stderr_callback, actual_options, timeout);
     }
 
     static void setup_each_line(function<bool(string&)>& stdout_callback, function<bool(string&)>& stderr_callback, option_set<execution_options>& options)
@@ -216,7 +466,7 @@ namespace facter { namespace execution {
     {
         auto actual_options = options;
         setup_each_line(stdout_callback, stderr_callback, actual_options);
-        return get<0>(execute(file, nullptr, nullptr, stdout_callback, stderr_callback, actual_options, timeout));
+        return get<0>(execute_cached(file, nullptr, nullptr, stdout_callback, stderr_callback, actual_options, timeout));
     }
 
     bool each_line(
@@ -229,7 +479,7 @@ namespace facter { namespace execution {
     {
         auto actual_options = options;
         setup_each_line(stdout_callback, stderr_callback, actual_options);
-        return get<0>(execute(file, &arguments, nullptr, stdout_callback, stderr_callback, actual_options, timeout));
+        return get<0>(execute_cached(file, &arguments, nullptr, stdout_callback, stderr_callback, actual_options, timeout));
     }
 
     bool each_line(
@@ -243,7 +493,7 @@ namespace facter { namespace execution {
     {
         auto actual_options = options;
         setup_each_line(stdout_callback, stderr_callback, actual_options);
-        return get<0>(execute(file, &arguments, &environment, stdout_callback, stderr_callback, actual_options, timeout));
+        return get<0>(execute_cached(file, &arguments, &environment, stdout_callback, stderr_callback, actual_options, timeout));
     }
 
     static bool process_data(bool trim, string const& data, string& buffer, string const& logger, function<bool(string&)> const& callback)
@@ -308,59 +558,73 @@ namespace facter { namespace execution {
         return true;
     }
 
-    tuple<string, string> process_streams(bool trim, function<bool(string&)> const& stdout_callback, function<bool(string&)> const& stderr_callback, function<void(function<bool(string const&)>, function<bool(string const&)>)> const& read_streams)
+    // Get a special logger used specifically for child process output
+    static const string stdout_logger = "|";
+    static const string stderr_logger = "!!!";
+
+    static void process_remaining(bool trim, string& buffer, string const& logger, function<bool(string&)> const& callback)
     {
-        // Get a special logger used specifically for child process output
-        static const string stdout_logger = "|";
-        static const string stderr_logger = "!!!";
+        if (trim) {
+            boost::trim(buffer);
+        }
+        if (buffer.empty()) {
+            return;
+        }
+        if (LOG_IS_DEBUG_ENABLED()) {
+            log(logger, log_level::debug, 0, buffer);
+        }
+        if (callback) {
+            callback(buffer);
+            buffer.clear();
+        }
+    }
 
-        // Buffers for all of the output or partial line output
-        string stdout_buffer;
-        string stderr_buffer;
+    stream_processor::stream_processor(bool trim, function<bool(string&)> stdout_callback, function<bool(string&)> stderr_callback) :
+        _trim(trim),
+        _stdout_callback(move(stdout_callback)),
+        _stderr_callback(move(stderr_callback))
+    {
+    }
+
+    bool stream_processor::process_stdout(string const& data)
+    {
+        if (!process_data(_trim, data, _stdout_buffer, stdout_logger, _stdout_callback)) {
+            LOG_DEBUG("completed processing output: closing child pipes.");
+            return false;
+        }
+        return true;
+    }
+
+    bool stream_processor::process_stderr(string const& data)
+    {
+        if (!process_data(_trim, data, _stderr_buffer, stderr_logger, _stderr_callback)) {
+            LOG_DEBUG("completed processing output: closing child pipes.");
+            return false;
+        }
+        return true;
+    }
+
+    tuple<string, string> stream_processor::finish()
+    {
+        // Log the last line of output and do a final callback if needed
+        process_remaining(_trim, _stdout_buffer, stdout_logger, _stdout_callback);
+        process_remaining(_trim, _stderr_buffer, stderr_logger, _stderr_callback);
+        return make_tuple(move(_stdout_buffer), move(_stderr_buffer));
+    }
+
+    tuple<string, string> process_streams(bool trim, function<bool(string&)> const& stdout_callback, function<bool(string&)> const& stderr_callback, function<void(function<bool(string const&)>, function<bool(string const&)>)> const& read_streams)
+    {
+        stream_processor processor(trim, stdout_callback, stderr_callback);
 
         // Read the streams
         read_streams(
             [&](string const& data) {
-                if (!process_data(trim, data, stdout_buffer, stdout_logger, stdout_callback)) {
-                    LOG_DEBUG("completed processing output: closing child pipes.");
-                    return false;
-                }
-                return true;
+                return processor.process_stdout(data);
             },
             [&](string const& data) {
-                if (!process_data(trim, data, stderr_buffer, stderr_logger, stderr_callback)) {
-                    LOG_DEBUG("completed processing output: closing child pipes.");
-                    return false;
-                }
-                return true;
+                return processor.process_stderr(data);
             });
-
-        // Log the result and do a final callback if needed.
-        if (trim) {
-            boost::trim(stdout_buffer);
-            boost::trim(stderr_buffer);
-        }
-        // Log the last line of output for stdout
-        if (!stdout_buffer.empty()) {
-            if (LOG_IS_DEBUG_ENABLED()) {
-                log(stdout_logger, log_level::debug, 0, stdout_buffer);
-            }
-            if (stdout_callback) {
-                stdout_callback(stdout_buffer);
-                stdout_buffer.clear();
-            }
-        }
-        // Log the last line of output for stderr
-        if (!stderr_buffer.empty()) {
-            if (LOG_IS_DEBUG_ENABLED()) {
-                log(stderr_logger, log_level::debug, 0, stderr_buffer);
-            }
-            if (stderr_callback) {
-                stderr_callback(stderr_buffer);
-                stderr_buffer.clear();
-            }
-        }
-        return make_tuple(move(stdout_buffer), move(stderr_buffer));
+        return processor.finish();
     }
 
 }}  // namespace facter::executions
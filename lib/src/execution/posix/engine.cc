@@ -0,0 +1,673 @@
+#include <internal/execution/posix/engine.hpp>
+#include <internal/execution/execution.hpp>
+#include <internal/util/posix/scoped_descriptor.hpp>
+#include <facter/util/scope_exit.hpp>
+#include <leatherman/logging/logging.hpp>
+#include <boost/chrono.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <spawn.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+#else
+#include <poll.h>
+#endif  // __linux__
+
+using namespace std;
+using namespace facter::util;
+using namespace facter::util::posix;
+using namespace boost::filesystem;
+
+// Declare environ for OSX
+extern char** environ;
+
+// glibc 2.34 can close every descriptor above a given one in a spawned child
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 34))
+#define HAVE_SPAWN_CLOSEFROM
+#endif  // __GLIBC__
+
+namespace facter { namespace execution { namespace posix {
+
+#ifndef HAVE_SPAWN_CLOSEFROM
+    static uint64_t get_max_descriptor_limit()
+    {
+#ifdef _SC_OPEN_MAX
+        {
+            auto open_max = sysconf(_SC_OPEN_MAX);
+            if (open_max > 0) {
+                return open_max;
+            }
+        }
+#endif  // _SC_OPEN_MAX
+
+#ifdef RLIMIT_NOFILE
+        {
+            rlimit lim;
+            if (getrlimit(RLIMIT_NOFILE, &lim) == 0) {
+                return lim.rlim_cur;
+            }
+        }
+#endif  // RLIMIT_NOFILE
+
+#ifdef OPEN_MAX
+        return OPEN_MAX;
+#else
+        return 256;
+#endif  // OPEN_MAX
+    }
+#endif  // HAVE_SPAWN_CLOSEFROM
+
+    static bool create_pipe(int descriptors[2])
+    {
+#ifdef __linux__
+        // Create the pipe close-on-exec so that children spawned concurrently can't inherit it
+        if (pipe2(descriptors, O_CLOEXEC) == -1) {
+            return false;
+        }
+#else
+        if (::pipe(descriptors) == -1) {
+            return false;
+        }
+        fcntl(descriptors[0], F_SETFD, FD_CLOEXEC);
+        fcntl(descriptors[1], F_SETFD, FD_CLOEXEC);
+#endif  // __linux__
+
+        // Keep the pipe away from the standard descriptors (e.g. when facter was started with stdin closed)
+        // so that redirecting one standard descriptor can't clobber another
+        for (int i = 0; i < 2; ++i) {
+            if (descriptors[i] > STDERR_FILENO) {
+                continue;
+            }
+            int moved = fcntl(descriptors[i], F_DUPFD_CLOEXEC, STDERR_FILENO + 1);
+            close(descriptors[i]);
+            descriptors[i] = moved;
+        }
+        if (descriptors[0] == -1 || descriptors[1] == -1) {
+            if (descriptors[0] != -1) {
+                close(descriptors[0]);
+            }
+            if (descriptors[1] != -1) {
+                close(descriptors[1]);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    static vector<string> build_environment(map<string, string> const* environment, bool merge)
+    {
+        // Set the locale to C unless specified in the given environment
+        map<string, string> overrides;
+        overrides["LC_ALL"] = "C";
+        overrides["LANG"] = "C";
+        if (environment) {
+            for (auto const& variable : *environment) {
+                overrides[variable.first] = variable.second;
+            }
+        }
+
+        // Inherit the variables of the current environment that are not overridden
+        vector<string> variables;
+        if (merge && environ) {
+            for (auto variable = environ; *variable; ++variable) {
+                auto separator = strchr(*variable, '=');
+                if (!separator || overrides.count(string(*variable, separator)) == 0) {
+                    variables.emplace_back(*variable);
+                }
+            }
+        }
+        for (auto const& variable : overrides) {
+            variables.emplace_back(variable.first + "=" + variable.second);
+        }
+        return variables;
+    }
+
+    static bool add_close_actions(posix_spawn_file_actions_t& actions)
+    {
+#ifdef HAVE_SPAWN_CLOSEFROM
+        // The child closes everything above the standard descriptors with close_range
+        return posix_spawn_file_actions_addclosefrom_np(&actions, STDERR_FILENO + 1) == 0;
+#else
+        // Close the open descriptors that would be inherited by the child
+        // Enumerate them rather than closing every descriptor up to the limit, which may be very large
+        vector<int> descriptors;
+        boost::system::error_code ec;
+        for (auto directory : { "/proc/self/fd", "/dev/fd" }) {
+            for (directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+                try {
+                    descriptors.push_back(stoi(it->path().filename().string()));
+                } catch (logic_error&) {
+                }
+            }
+            if (!ec && !descriptors.empty()) {
+                break;
+            }
+            descriptors.clear();
+        }
+        if (descriptors.empty()) {
+            for (decltype(get_max_descriptor_limit()) i = STDERR_FILENO + 1; i < get_max_descriptor_limit(); ++i) {
+                descriptors.push_back(static_cast<int>(i));
+            }
+        }
+        for (auto descriptor : descriptors) {
+            // Descriptors that are close-on-exec (or were closed by the enumeration) don't need to be closed
+            if (descriptor <= STDERR_FILENO) {
+                continue;
+            }
+            int flags = fcntl(descriptor, F_GETFD);
+            if (flags == -1 || (flags & FD_CLOEXEC)) {
+                continue;
+            }
+            if (posix_spawn_file_actions_addclose(&actions, descriptor) != 0) {
+                return false;
+            }
+        }
+        return true;
+#endif  // HAVE_SPAWN_CLOSEFROM
+    }
+
+    // The events a child's descriptors are registered for; each key identifies the child and the event
+    enum class event
+    {
+        output,
+        error,
+        exit,
+        timer,
+        count
+    };
+
+    static uint64_t make_key(size_t id, event kind)
+    {
+        return static_cast<uint64_t>(id) * static_cast<uint64_t>(event::count) + static_cast<uint64_t>(kind);
+    }
+
+    // The size of each read from a child pipe; this is the default capacity of a Linux pipe
+    static const size_t read_size = 65536;
+
+    // The interval, in milliseconds, at which children are checked for exit when they can't be waited upon with a descriptor
+    static const int exit_poll_interval = 1;
+
+#ifdef __linux__
+    // Waits for registered descriptors to become readable with epoll
+    struct engine::poller
+    {
+        poller() :
+            _descriptor(epoll_create1(EPOLL_CLOEXEC))
+        {
+            if (static_cast<int>(_descriptor) < 0) {
+                LOG_ERROR("epoll_create1 failed: %1% (%2%).", strerror(errno), errno);
+                throw execution_exception("failed to create child process poller.");
+            }
+        }
+
+        void add(int descriptor, uint64_t key)
+        {
+            epoll_event ev = {};
+            ev.events = EPOLLIN;
+            ev.data.u64 = key;
+            if (epoll_ctl(_descriptor, EPOLL_CTL_ADD, descriptor, &ev) == -1) {
+                LOG_ERROR("epoll_ctl failed: %1% (%2%).", strerror(errno), errno);
+                throw execution_exception("failed to wait for child process.");
+            }
+        }
+
+        void remove(int descriptor)
+        {
+            epoll_ctl(_descriptor, EPOLL_CTL_DEL, descriptor, nullptr);
+        }
+
+        void wait(int timeout, vector<uint64_t>& ready)
+        {
+            ready.clear();
+            array<epoll_event, 64> events;
+            int count = epoll_wait(_descriptor, events.data(), static_cast<int>(events.size()), timeout);
+            if (count == -1) {
+                if (errno != EINTR) {
+                    LOG_ERROR("epoll_wait call failed: %1% (%2%).", strerror(errno), errno);
+                    throw execution_exception("failed to read child output.");
+                }
+                // Interrupted by signal
+                LOG_DEBUG("epoll_wait call was interrupted and will be retried.");
+                return;
+            }
+            for (int i = 0; i < count; ++i) {
+                ready.push_back(events[i].data.u64);
+            }
+        }
+
+     private:
+        scoped_descriptor _descriptor;
+    };
+#else
+    // Waits for registered descriptors to become readable with poll, which unlike select has no limit on descriptor values
+    struct engine::poller
+    {
+        void add(int descriptor, uint64_t key)
+        {
+            _descriptors[descriptor] = key;
+        }
+
+        void remove(int descriptor)
+        {
+            _descriptors.erase(descriptor);
+        }
+
+        void wait(int timeout, vector<uint64_t>& ready)
+        {
+            ready.clear();
+            vector<pollfd> descriptors;
+            descriptors.reserve(_descriptors.size());
+            for (auto const& descriptor : _descriptors) {
+                pollfd entry = {};
+                entry.fd = descriptor.first;
+                entry.events = POLLIN;
+                descriptors.push_back(entry);
+            }
+            int count = ::poll(descriptors.data(), descriptors.size(), timeout);
+            if (count == -1) {
+                if (errno != EINTR) {
+                    LOG_ERROR("poll call failed: %1% (%2%).", strerror(errno), errno);
+                    throw execution_exception("failed to read child output.");
+                }
+                // Interrupted by signal
+                LOG_DEBUG("poll call was interrupted and will be retried.");
+                return;
+            }
+            for (auto const& descriptor : descriptors) {
+                if (descriptor.revents) {
+                    ready.push_back(_descriptors[descriptor.fd]);
+                }
+            }
+        }
+
+     private:
+        map<int, uint64_t> _descriptors;
+    };
+#endif  // __linux__
+
+    // Represents a spawned child and the descriptors it is waited upon with
+    struct engine::child
+    {
+        child(bool trim, function<bool(string&)> stdout_callback, function<bool(string&)> stderr_callback) :
+            processor(trim, move(stdout_callback), move(stderr_callback)),
+            pid(0),
+            stdout_read(-1),
+            stderr_read(-1),
+            exit_descriptor(-1),
+            timer(-1),
+            timeout(0),
+            exited(false),
+            completed(false),
+            outcome()
+        {
+        }
+
+        ~child()
+        {
+            for (auto descriptor : { stdout_read, stderr_read, exit_descriptor, timer }) {
+                if (descriptor >= 0) {
+                    close(descriptor);
+                }
+            }
+        }
+
+        bool pipes_closed() const
+        {
+            return stdout_read < 0 && stderr_read < 0;
+        }
+
+        stream_processor processor;
+        pid_t pid;
+        int stdout_read;
+        int stderr_read;
+        int exit_descriptor;
+        int timer;
+        uint32_t timeout;
+        boost::chrono::steady_clock::time_point deadline;
+        bool exited;
+        bool completed;
+        result outcome;
+    };
+
+    engine::engine() :
+        _poller(new poller())
+    {
+    }
+
+    engine::~engine()
+    {
+        // Kill any remaining children (e.g. if a callback threw) so that they don't become zombies
+        for (auto& c : _children) {
+            if (c->exited) {
+                continue;
+            }
+            kill(-c->pid, SIGKILL);
+            reap(*c, true);
+        }
+    }
+
+    size_t engine::spawn(
+        string const& executable,
+        string const& file,
+        vector<string> const* arguments,
+        map<string, string> const* environment,
+        function<bool(string&)> stdout_callback,
+        function<bool(string&)> stderr_callback,
+        option_set<execution_options> const& options,
+        uint32_t timeout)
+    {
+        unique_ptr<child> c(new child(options[execution_options::trim_output], move(stdout_callback), move(stderr_callback)));
+        c->timeout = timeout;
+
+        // Create the pipes for stdin/stdout redirection; the child owns the read ends from here on
+        int pipes[2];
+        if (!create_pipe(pipes)) {
+            throw execution_exception("failed to allocate pipe for stdin redirection.");
+        }
+        scoped_descriptor stdin_read(pipes[0]);
+        scoped_descriptor stdin_write(pipes[1]);
+
+        if (!create_pipe(pipes)) {
+            throw execution_exception("failed to allocate pipe for stdout redirection.");
+        }
+        c->stdout_read = pipes[0];
+        scoped_descriptor stdout_write(pipes[1]);
+
+        // Create optional pipes for stderr redirection (if not redirecting stderr to stdout or null)
+        scoped_descriptor stderr_write(-1);
+        if (!options[execution_options::redirect_stderr_to_stdout] && !options[execution_options::redirect_stderr_to_null]) {
+            if (!create_pipe(pipes)) {
+                throw execution_exception("failed to allocate pipe for stderr redirection.");
+            }
+            c->stderr_read = pipes[0];
+            stderr_write = scoped_descriptor(pipes[1]);
+        }
+
+        // Build the arguments and environment in the parent so that the child only has to exec
+        // The first argument is the program name followed by the given program arguments
+        vector<char const*> args;
+        args.reserve((arguments ? arguments->size() : 0) + 2 /* argv[0] + null */);
+        args.push_back(file.c_str());
+        if (arguments) {
+            for (auto const& argument : *arguments) {
+                args.push_back(argument.c_str());
+            }
+        }
+        args.push_back(nullptr);
+
+        auto variables = build_environment(environment, options[execution_options::merge_environment]);
+        vector<char const*> envp;
+        envp.reserve(variables.size() + 1);
+        for (auto const& variable : variables) {
+            envp.push_back(variable.c_str());
+        }
+        envp.push_back(nullptr);
+
+        // Redirect the child's standard descriptors and close everything else
+        // The pipes are close-on-exec, but dup2 clears the flag on the standard descriptors
+        posix_spawn_file_actions_t actions;
+        if (posix_spawn_file_actions_init(&actions) != 0) {
+            throw execution_exception("failed to initialize child process file actions.");
+        }
+        scope_exit actions_destroy([&]() { posix_spawn_file_actions_destroy(&actions); });
+
+        bool actions_added =
+            posix_spawn_file_actions_adddup2(&actions, stdin_read, STDIN_FILENO) == 0 &&
+            posix_spawn_file_actions_adddup2(&actions, stdout_write, STDOUT_FILENO) == 0;
+        if (options[execution_options::redirect_stderr_to_stdout]) {
+            actions_added = actions_added && posix_spawn_file_actions_adddup2(&actions, stdout_write, STDERR_FILENO) == 0;
+        } else if (options[execution_options::redirect_stderr_to_null]) {
+            actions_added = actions_added && posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_RDWR, 0) == 0;
+        } else {
+            actions_added = actions_added && posix_spawn_file_actions_adddup2(&actions, stderr_write, STDERR_FILENO) == 0;
+        }
+        if (!actions_added || !add_close_actions(actions)) {
+            throw execution_exception("failed to setup child process file actions.");
+        }
+
+        // Put the child in its own process group; this will be used if we need to kill the process and its children
+        posix_spawnattr_t attributes;
+        if (posix_spawnattr_init(&attributes) != 0) {
+            throw execution_exception("failed to initialize child process attributes.");
+        }
+        scope_exit attributes_destroy([&]() { posix_spawnattr_destroy(&attributes); });
+        if (posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP) != 0 || posix_spawnattr_setpgroup(&attributes, 0) != 0) {
+            throw execution_exception("failed to set child process group.");
+        }
+
+        // Spawn the child process
+        // Unlike fork, this doesn't copy the page tables of the parent, which are large when Ruby is loaded
+        auto id = _children.size();
+        int result = posix_spawn(&c->pid, executable.c_str(), &actions, &attributes, const_cast<char* const*>(args.data()), const_cast<char* const*>(envp.data()));
+        if (result != 0) {
+            // Report a failure to exec like a child that exited with the error, as a forked child would have
+            LOG_DEBUG("failed to execute %1%: %2% (%3%).", executable, strerror(result), result);
+            c->pid = 0;
+            c->outcome.status = result;
+            c->exited = true;
+            c->completed = true;
+            _children.emplace_back(move(c));
+            return id;
+        }
+        c->outcome.pid = static_cast<size_t>(c->pid);
+        if (timeout) {
+            c->deadline = boost::chrono::steady_clock::now() + boost::chrono::seconds(timeout);
+        }
+
+        // From here on the engine is responsible for killing and reaping the child
+        _children.emplace_back(move(c));
+        auto& spawned = *_children.back();
+        _poller->add(spawned.stdout_read, make_key(id, event::output));
+        if (spawned.stderr_read >= 0) {
+            _poller->add(spawned.stderr_read, make_key(id, event::error));
+        }
+
+#ifdef __linux__
+#ifdef SYS_pidfd_open
+        // Wait for the child to exit with a pidfd (Linux 5.3) rather than by polling it
+        spawned.exit_descriptor = static_cast<int>(syscall(SYS_pidfd_open, spawned.pid, 0));
+        if (spawned.exit_descriptor >= 0) {
+            _poller->add(spawned.exit_descriptor, make_key(id, event::exit));
+        }
+#endif  // SYS_pidfd_open
+
+        // Use a timerfd for the timeout so that it is delivered as an event rather than a signal
+        if (timeout) {
+            spawned.timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+            if (spawned.timer >= 0) {
+                itimerspec expiration = {};
+                expiration.it_value.tv_sec = static_cast<decltype(expiration.it_value.tv_sec)>(timeout);
+                if (timerfd_settime(spawned.timer, 0, &expiration, nullptr) == 0) {
+                    _poller->add(spawned.timer, make_key(id, event::timer));
+                } else {
+                    close_descriptor(spawned.timer);
+                }
+            }
+        }
+#endif  // __linux__
+        return id;
+    }
+
+    void engine::run()
+    {
+        vector<uint64_t> ready;
+        while (true) {
+            // Children without a timer or pidfd have their deadlines and exits checked between waits
+            bool active = false;
+            int wait_timeout = -1;
+            auto now = boost::chrono::steady_clock::now();
+            for (auto& c : _children) {
+                if (c->completed) {
+                    continue;
+                }
+                active = true;
+                if (c->timeout && c->timer < 0) {
+                    auto remaining = boost::chrono::duration_cast<boost::chrono::milliseconds>(c->deadline - now).count() + 1;
+                    remaining = max<decltype(remaining)>(remaining, 0);
+                    wait_timeout = wait_timeout < 0 ? static_cast<int>(remaining) : min(wait_timeout, static_cast<int>(remaining));
+                }
+                if (!c->exited && c->exit_descriptor < 0 && c->pipes_closed()) {
+                    wait_timeout = wait_timeout < 0 ? exit_poll_interval : min(wait_timeout, exit_poll_interval);
+                }
+            }
+            if (!active) {
+                break;
+            }
+
+            _poller->wait(wait_timeout, ready);
+            for (auto key : ready) {
+                auto& c = *_children[key / static_cast<uint64_t>(event::count)];
+                switch (static_cast<event>(key % static_cast<uint64_t>(event::count))) {
+                    case event::output:
+                        read(c, true);
+                        break;
+                    case event::error:
+                        read(c, false);
+                        break;
+                    case event::exit:
+                        reap(c, false);
+                        break;
+                    case event::timer:
+                        time_out(c);
+                        break;
+                    default:
+                        break;
+                }
+                complete(c);
+            }
+
+            now = boost::chrono::steady_clock::now();
+            for (auto& c : _children) {
+                if (c->completed) {
+                    continue;
+                }
+                if (c->timeout && c->timer < 0 && now >= c->deadline) {
+                    time_out(*c);
+                } else if (!c->exited && c->exit_descriptor < 0 && c->pipes_closed()) {
+                    reap(*c, false);
+                }
+                complete(*c);
+            }
+        }
+    }
+
+    engine::result& engine::get(size_t id)
+    {
+        return _children.at(id)->outcome;
+    }
+
+    void engine::read(child& c, bool from_stdout)
+    {
+        int& descriptor = from_stdout ? c.stdout_read : c.stderr_read;
+        if (descriptor < 0) {
+            return;
+        }
+
+        _buffer.resize(read_size);
+        auto count = ::read(descriptor, &_buffer[0], _buffer.size());
+        if (count < 0) {
+            if (errno != EINTR && errno != EAGAIN) {
+                LOG_ERROR("%1% pipe read failed: %2% (%3%).", from_stdout ? "stdout" : "stderr", strerror(errno), errno);
+                throw execution_exception("failed to read child output.");
+            }
+            // Interrupted by signal
+            LOG_DEBUG("%1% pipe read was interrupted and will be retried.", from_stdout ? "stdout" : "stderr");
+            return;
+        }
+        if (count == 0) {
+            // Pipe has closed
+            close_descriptor(descriptor);
+            return;
+        }
+
+        _buffer.resize(count);
+        if (!(from_stdout ? c.processor.process_stdout(_buffer) : c.processor.process_stderr(_buffer))) {
+            // The callback signaled that it's done; if the child hasn't sent all the data yet, it may get SIGPIPE on its next write
+            close_pipes(c);
+        }
+    }
+
+    void engine::close_pipes(child& c)
+    {
+        close_descriptor(c.stdout_read);
+        close_descriptor(c.stderr_read);
+    }
+
+    void engine::close_descriptor(int& descriptor)
+    {
+        if (descriptor < 0) {
+            return;
+        }
+        _poller->remove(descriptor);
+        close(descriptor);
+        descriptor = -1;
+    }
+
+    void engine::reap(child& c, bool wait)
+    {
+        if (c.exited) {
+            return;
+        }
+
+        int status = 0;
+        pid_t result = 0;
+        do {
+            result = waitpid(c.pid, &status, wait ? 0 : WNOHANG);
+        } while (result == -1 && errno == EINTR);
+        if (result == 0) {
+            // Still running
+            return;
+        }
+
+        c.exited = true;
+        close_descriptor(c.exit_descriptor);
+        if (result == -1) {
+            LOG_DEBUG("waitpid failed: %1% (%2%).", strerror(errno), errno);
+            return;
+        }
+        if (WIFEXITED(status)) {
+            c.outcome.status = static_cast<char>(WEXITSTATUS(status));
+            c.outcome.success = c.outcome.status == 0;
+        } else if (WIFSIGNALED(status)) {
+            c.outcome.signaled = true;
+            c.outcome.status = static_cast<char>(WTERMSIG(status));
+        }
+    }
+
+    void engine::time_out(child& c)
+    {
+        if (c.completed) {
+            return;
+        }
+
+        // Kill the child's process group and discard any unprocessed output
+        kill(-c.pid, SIGKILL);
+        c.outcome.timed_out = true;
+        close_pipes(c);
+        reap(c, true);
+    }
+
+    void engine::complete(child& c)
+    {
+        if (c.completed || !c.exited || !c.pipes_closed()) {
+            return;
+        }
+
+        close_descriptor(c.timer);
+        c.completed = true;
+        if (!c.outcome.timed_out) {
+            tie(c.outcome.output, c.outcome.error) = c.processor.finish();
+        }
+    }
+
+}}}  // namespace facter::execution::posix
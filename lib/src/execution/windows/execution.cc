@@ -4,7 +4,6 @@
 #include <facter/util/scope_exit.hpp>
 #include <facter/util/scoped_resource.hpp>
 #include <internal/execution/execution.hpp>
-#include <internal/util/scoped_env.hpp>
 #include <leatherman/windows/system_error.hpp>
 #include <leatherman/windows/windows.hpp>
 #include <leatherman/logging/logging.hpp>
@@ -65,7 +64,7 @@ namespace facter { namespace execution {
         return isfile;
     }
 
-    string which(string const& file, vector<string> const& directories)
+    string find_executable(string const& file, vector<string> const& directories)
     {
         // On Windows, everything has execute permission; Ruby determined
         // executability based on extension {com, exe, bat, cmd}. We'll do the
@@ -365,33 +364,39 @@ namespace facter { namespace execution {
         }
 
         // Setup the execution environment
-        vector<char> modified_environ;
-        vector<scoped_env> scoped_environ;
+        // The environment is always passed to the child as a block rather than by changing the environment of this
+        // process, which would race with commands executed concurrently on other threads.
+        // Environment variables must be sorted alphabetically and case-insensitive,
+        // so copy them all into the same map with case-insensitive key compare:
+        //   http://msdn.microsoft.com/en-us/library/windows/desktop/ms682009(v=vs.85).aspx
+        std::map<string, string, bool(*)(string const&, string const&)> sortedEnvironment(
+            [](string const& a, string const& b) { return ilexicographical_compare(a, b); });
         if (options[execution_options::merge_environment]) {
-            // Modify the existing environment, then restore it after. There's no way to modify environment variables
-            // after the child has started. An alternative would be to use GetEnvironmentStrings and add/modify the block,
-            // but searching for and modifying existing environment strings to update would be cumbersome in that form.
-            // See http://msdn.microsoft.com/en-us/library/windows/desktop/ms682009(v=vs.85).aspx
+            // Start with the environment of this process
+            facter::util::environment::each([&](string& name, string& value) {
+                // Hidden variables such as the current directory of each drive are named with a leading '='
+                if (name.empty()) {
+                    auto pos = value.find('=');
+                    name = "=" + value.substr(0, pos);
+                    value = pos == string::npos ? string() : value.substr(pos + 1);
+                }
+                sortedEnvironment[name] = move(value);
+                return true;
+            });
+
+            // Override LANG and LC_ALL unless they are given
             if (!environment || environment->count("LC_ALL") == 0) {
-                scoped_environ.emplace_back("LC_ALL", "C");
+                sortedEnvironment["LC_ALL"] = "C";
             }
             if (!environment || environment->count("LANG") == 0) {
-                scoped_environ.emplace_back("LANG", "C");
+                sortedEnvironment["LANG"] = "C";
             }
             if (environment) {
                 for (auto const& kv : *environment) {
-                    // Use scoped_env to save the old state and restore it on return.
-                    LOG_DEBUG("child environment %1%=%2%", kv.first, kv.second);
-                    scoped_environ.emplace_back(kv.first, kv.second);
+                    sortedEnvironment[kv.first] = kv.second;
                 }
             }
         } else {
-            // We aren't inheriting the environment, so create an environment block instead of changing existing env.
-            // Environment variables must be sorted alphabetically and case-insensitive,
-            // so copy them all into the same map with case-insensitive key compare:
-            //   http://msdn.microsoft.com/en-us/library/windows/desktop/ms682009(v=vs.85).aspx
-            std::map<string, string, bool(*)(string const&, string const&)> sortedEnvironment(
-                [](string const& a, string const& b) { return ilexicographical_compare(a, b); });
             if (environment) {
                 sortedEnvironment.insert(environment->begin(), environment->end());
             }
@@ -399,18 +404,18 @@ namespace facter { namespace execution {
             // Insert LANG and LC_ALL if they aren't already present. Emplace ensures this behavior.
             sortedEnvironment.emplace("LANG", "C");
             sortedEnvironment.emplace("LC_ALL", "C");
+        }
 
-            // An environment block is a NULL-terminated list of NULL-terminated strings.
-            for (auto const& variable : sortedEnvironment) {
+        // An environment block is a NULL-terminated list of NULL-terminated strings.
+        wstring modified_environ;
+        for (auto const& variable : sortedEnvironment) {
+            if (!options[execution_options::merge_environment] || (environment && environment->count(variable.first))) {
                 LOG_DEBUG("child environment %1%=%2%", variable.first, variable.second);
-                string var = variable.first + "=" + variable.second;
-                for (auto c : var) {
-                    modified_environ.push_back(c);
-                }
-                modified_environ.push_back('\0');
             }
-            modified_environ.push_back('\0');
+            modified_environ += boost::nowide::widen(variable.first + "=" + variable.second);
+            modified_environ += L'\0';
         }
+        modified_environ += L'\0';
 
         // Execute the command, reading the results into a buffer until there's no more to read.
         // See http://msdn.microsoft.com/en-us/library/windows/desktop/ms682499(v=vs.85).aspx
@@ -472,8 +477,8 @@ namespace facter { namespace execution {
             NULL,           /* Don't allow child process to inherit process handle */
             NULL,           /* Don't allow child process to inherit thread handle */
             TRUE,           /* Inherit handles from the calling process for communication */
-            CREATE_NO_WINDOW,
-            options[execution_options::merge_environment] ? NULL : modified_environ.data(),
+            CREATE_NO_WINDOW | CREATE_UNICODE_ENVIRONMENT,
+            &modified_environ[0],
             NULL,           /* Use existing current directory */
             &startupInfo,   /* STARTUPINFO for child process */
             &procInfo)) {   /* PROCESS_INFORMATION pointer for output */
@@ -571,4 +576,21 @@ namespace facter { namespace execution {
         return make_tuple(exit_code == 0, move(output), move(error));
     }
 
+    vector<command_result> execute_all(vector<command> const& commands)
+    {
+        // Windows has no execution engine, so the commands are run one after another
+        vector<command_result> results(commands.size());
+        for (size_t i = 0; i < commands.size(); ++i) {
+            auto const& cmd = commands[i];
+            auto& result = results[i];
+            result.success = false;
+            try {
+                tie(result.success, result.output, result.error) = execute(cmd.file, &cmd.arguments, nullptr, cmd.stdout_callback, cmd.stderr_callback, cmd.options, cmd.timeout);
+            } catch (execution_exception const&) {
+                result.exception = current_exception();
+            }
+        }
+        return results;
+    }
+
 }}  // namespace facter::executions
@@ -1,5 +1,7 @@
 #include <facter/facts/array_value.hpp>
 #include <facter/facts/scalar_value.hpp>
+#include <facter/facts/json_writer.hpp>
+#include <facter/facts/msgpack.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <rapidjson/document.h>
 #include <yaml-cpp/yaml.h>
@@ -65,6 +67,23 @@ namespace facter { namespace facts {
         }
     }
 
+    void array_value::write(json_writer& writer) const
+    {
+        writer.start_array();
+        for (auto const& element : _elements) {
+            element->write(writer);
+        }
+        writer.end_array();
+    }
+
+    void array_value::write(msgpack_writer& writer) const
+    {
+        writer.write_array(_elements.size());
+        for (auto const& element : _elements) {
+            element->write(writer);
+        }
+    }
+
     value const* array_value::operator[](size_t i) const
     {
         if (i >= _elements.size()) {
@@ -1,11 +1,19 @@
 #include <internal/facts/bsd/networking_resolver.hpp>
 #include <internal/util/bsd/scoped_ifaddrs.hpp>
+#include <facter/facts/fact.hpp>
 #include <facter/execution/execution.hpp>
 #include <facter/util/file.hpp>
 #include <facter/util/directory.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <algorithm>
+#include <cstring>
 #include <netinet/in.h>
+#include <sys/stat.h>
 
 using namespace std;
 using namespace facter::util;
@@ -36,16 +44,28 @@ namespace facter { namespace facts { namespace bsd {
                 continue;
             }
 
+            // Skip interfaces that were not queried or are filtered out
+            if (!is_collected(fact::networking, { "interfaces", ptr->ifa_name }) || !is_included(facts, ptr->ifa_name)) {
+                continue;
+            }
+
             interface_map.insert({ ptr->ifa_name, ptr });
         }
 
         data.primary_interface = get_primary_interface();
+        if (!data.primary_interface.empty() && !is_included(facts, data.primary_interface)) {
+            data.primary_interface.clear();
+        }
         if (data.primary_interface.empty()) {
             LOG_DEBUG("no primary interface found: using first interface with an assigned address.");
         }
 
         // Start by getting the DHCP servers
-        auto dhcp_servers = find_dhcp_servers();
+        set<string> names;
+        for (auto const& kvp : interface_map) {
+            names.insert(kvp.first);
+        }
+        auto dhcp_servers = find_dhcp_servers(names);
 
         // Walk the interfaces
         decltype(interface_map.begin()) it = interface_map.begin();
@@ -153,7 +173,7 @@ namespace facter { namespace facts { namespace bsd {
         return {};
     }
 
-    map<string, string> networking_resolver::find_dhcp_servers() const
+    map<string, string> networking_resolver::find_dhcp_servers(set<string> const& interfaces) const
     {
         map<string, string> servers;
 
@@ -165,32 +185,198 @@ namespace facter { namespace facts { namespace bsd {
             "/var/db"
         };
 
+        // The first lease file found for an interface is respected
+        auto all_found = [&]() {
+            return !interfaces.empty() && all_of(interfaces.begin(), interfaces.end(), [&](string const& name) { return servers.count(name) > 0; });
+        };
         for (auto const& dir : dhclient_search_directories) {
+            if (all_found()) {
+                break;
+            }
             LOG_DEBUG("searching \"%1%\" for dhclient lease files.", dir);
             directory::each_file(dir, [&](string const& path) {
-                LOG_DEBUG("reading \"%1%\" for dhclient lease information.", path);
-
-                // Each lease entry should have the interface declaration before the options
-                // We respect the last lease for an interface in the file
-                string interface;
-                file::each_line(path, [&](string& line) {
-                    boost::trim(line);
-                    if (boost::starts_with(line, "interface ")) {
-                        interface = line.substr(10);
-                        trim_if(interface, boost::is_any_of("\";"));
-                    } else if (!interface.empty() && boost::starts_with(line, "option dhcp-server-identifier ")) {
-                        string server = line.substr(30);
-                        trim_if(server, boost::is_any_of("\";"));
-                        servers.emplace(make_pair(move(interface), move(server)));
+                // Only look for the interfaces that don't have a server yet
+                set<string> missing;
+                for (auto const& name : interfaces) {
+                    if (!servers.count(name)) {
+                        missing.insert(name);
                     }
-                    return true;
-                });
-                return true;
+                }
+                LOG_DEBUG("reading \"%1%\" for dhclient lease information.", path);
+                for (auto& kvp : read_dhclient_leases(path, missing)) {
+                    servers.emplace(kvp.first, move(kvp.second));
+                }
+                return !all_found();
             }, "^dhclient.*lease.*$");
         }
         return servers;
     }
 
+    // Lease files are read backwards in blocks of this size
+    static const size_t lease_block_size = 64 * 1024;
+
+    struct lease_file
+    {
+        timespec modified;
+        off_t size;
+        bool complete;
+        map<string, string> servers;
+    };
+
+    static boost::mutex lease_files_mutex;
+    static map<string, lease_file> lease_files;
+
+    static bool starts_with(char const* begin, char const* end, char const* prefix, size_t length)
+    {
+        return static_cast<size_t>(end - begin) >= length && strncmp(begin, prefix, length) == 0;
+    }
+
+    static string lease_value(char const* begin, char const* end)
+    {
+        // Strip the terminating semicolon and any quotes around the value
+        while (begin != end && (isspace(*begin) || *begin == '"')) {
+            ++begin;
+        }
+        while (begin != end && (isspace(*(end - 1)) || *(end - 1) == ';' || *(end - 1) == '"')) {
+            --end;
+        }
+        return string(begin, end);
+    }
+
+    static timespec modification_time(struct stat const& status)
+    {
+#ifdef __APPLE__
+        return status.st_mtimespec;
+#else
+        return status.st_mtim;
+#endif  // __APPLE__
+    }
+
+    string networking_resolver::get_lease_file_interface(string const& path, set<string> const& interfaces)
+    {
+        // Per-interface lease files end with the interface name (e.g. dhclient.eth0.leases or dhclient-<uuid>-eth0.lease)
+        auto name = boost::filesystem::path(path).filename().string();
+        auto extension = name.rfind(".lease");
+        if (extension == string::npos) {
+            return {};
+        }
+        name.resize(extension);
+
+        string result;
+        for (auto const& interface : interfaces) {
+            if (name.size() <= interface.size() || interface.size() <= result.size() || !boost::ends_with(name, interface)) {
+                continue;
+            }
+            char separator = name[name.size() - interface.size() - 1];
+            if (separator == '.' || separator == '-') {
+                result = interface;
+            }
+        }
+        return result;
+    }
+
+    map<string, string> networking_resolver::read_dhclient_leases(string const& path, set<string> const& requested)
+    {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0) {
+            return {};
+        }
+        auto modified = modification_time(status);
+
+        // A file named for a requested interface only needs to be read until that interface's most recent lease
+        set<string> interfaces;
+        auto named = get_lease_file_interface(path, requested);
+        if (named.empty()) {
+            interfaces = requested;
+        } else {
+            interfaces.insert(move(named));
+        }
+
+        // Reuse the servers read from an unchanged file if they include every requested interface
+        {
+            boost::lock_guard<boost::mutex> lock(lease_files_mutex);
+            auto it = lease_files.find(path);
+            if (it != lease_files.end() &&
+                it->second.modified.tv_sec == modified.tv_sec &&
+                it->second.modified.tv_nsec == modified.tv_nsec &&
+                it->second.size == status.st_size) {
+                auto const& cached = it->second;
+                if (cached.complete || (!interfaces.empty() && all_of(interfaces.begin(), interfaces.end(), [&](string const& name) { return cached.servers.count(name) > 0; }))) {
+                    return cached.servers;
+                }
+            }
+        }
+
+        boost::nowide::ifstream file(path.c_str(), ios::binary);
+        if (!file) {
+            return {};
+        }
+
+        lease_file result;
+        result.modified = modified;
+        result.size = status.st_size;
+        result.complete = true;
+
+        // Walking backwards, a lease's server identifier is seen before the interface the lease belongs to
+        // The first server found for an interface is therefore from its most recent lease
+        static const char interface_prefix[] = "interface ";
+        static const char server_prefix[] = "option dhcp-server-identifier ";
+        string server;
+        size_t found = 0;
+        auto process = [&](char const* begin, char const* end) {
+            while (begin != end && isspace(*begin)) {
+                ++begin;
+            }
+            if (starts_with(begin, end, server_prefix, sizeof(server_prefix) - 1)) {
+                if (server.empty()) {
+                    server = lease_value(begin + sizeof(server_prefix) - 1, end);
+                }
+            } else if (starts_with(begin, end, interface_prefix, sizeof(interface_prefix) - 1)) {
+                auto name = lease_value(begin + sizeof(interface_prefix) - 1, end);
+                if (!server.empty() && result.servers.emplace(name, move(server)).second && interfaces.count(name)) {
+                    ++found;
+                }
+                server.clear();
+            }
+            // Stop once the most recent lease of every requested interface is known
+            return interfaces.empty() || found < interfaces.size();
+        };
+
+        string leftover;
+        string block;
+        auto position = static_cast<size_t>(status.st_size);
+        bool reading = true;
+        while (reading && position > 0) {
+            auto count = min(lease_block_size, position);
+            position -= count;
+            block.resize(count);
+            if (!file.seekg(position) || !file.read(&block[0], count)) {
+                break;
+            }
+            block += leftover;
+
+            // Process the complete lines of the block from last to first
+            size_t line_end = block.size();
+            for (size_t i = block.size(); reading && i > 0; --i) {
+                if (block[i - 1] == '\n') {
+                    reading = process(block.data() + i, block.data() + line_end);
+                    line_end = i - 1;
+                }
+            }
+            leftover.assign(block, 0, line_end);
+        }
+        if (reading && position == 0) {
+            process(leftover.data(), leftover.data() + leftover.size());
+        } else {
+            result.complete = false;
+        }
+
+        boost::lock_guard<boost::mutex> lock(lease_files_mutex);
+        auto& cached = lease_files[path];
+        cached = move(result);
+        return cached.servers;
+    }
+
     string networking_resolver::find_dhcp_server(string const& interface) const
     {
         // Use dhcpcd if it's present to get the interface's DHCP lease information
@@ -0,0 +1,225 @@
+#include <internal/facts/cache.hpp>
+#include <facter/facts/msgpack.hpp>
+#include <facter/facts/fact.hpp>
+#include <facter/version.h>
+#include <leatherman/logging/logging.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <algorithm>
+#include <ctime>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+using namespace boost::filesystem;
+
+namespace facter { namespace facts {
+
+    // The cache file starts with a magic string followed by the format version
+    static const string magic = "FCTC";
+    static const uint8_t format_version = 1;
+
+    static uint64_t checksum(string const& data, size_t length)
+    {
+        // FNV-1a 64-bit hash
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<uint8_t>(data[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    static void write_bytes(string& buffer, uint64_t value, size_t count)
+    {
+        // Values are written in big-endian order, as in MessagePack
+        for (size_t i = count; i > 0; --i) {
+            buffer += static_cast<char>((value >> ((i - 1) * 8)) & 0xFF);
+        }
+    }
+
+    fact_cache::fact_cache(string path, map<string, int64_t> ttls, bool refresh) :
+        _path(move(path)),
+        _ttls(move(ttls)),
+        _modified(false)
+    {
+        if (refresh) {
+            LOG_DEBUG("refreshing the fact cache %1%.", _path);
+            return;
+        }
+        read_file();
+    }
+
+    bool fact_cache::is_cached(string const& resolver) const
+    {
+        auto it = _ttls.find(resolver);
+        return it != _ttls.end() && it->second > 0;
+    }
+
+    bool fact_cache::load(string const& resolver, vector<pair<string, unique_ptr<value>>>& facts) const
+    {
+        if (!is_cached(resolver)) {
+            return false;
+        }
+        auto it = _entries.find(resolver);
+        if (it == _entries.end()) {
+            return false;
+        }
+        auto now = static_cast<int64_t>(time(nullptr));
+        auto age = now - it->second.timestamp;
+        if (age < 0 || age >= _ttls.at(resolver)) {
+            LOG_DEBUG("cached facts for resolver \"%1%\" have expired.", resolver);
+            return false;
+        }
+
+        vector<pair<string, unique_ptr<value>>> loaded;
+        try {
+            msgpack_reader data(it->second.data);
+            auto count = data.read_raw(4);
+            for (uint64_t i = 0; i < count; ++i) {
+                auto name = data.read_string();
+                if (is_private(name)) {
+                    throw runtime_error("the facts include facts that can only be read by root.");
+                }
+                bool hidden = data.read_raw(1) != 0;
+                auto val = data.read(hidden);
+                loaded.emplace_back(move(name), move(val));
+            }
+        } catch (runtime_error& ex) {
+            LOG_DEBUG("cached facts for resolver \"%1%\" are invalid: %2%", resolver, ex.what());
+            return false;
+        }
+
+        LOG_DEBUG("using cached facts for resolver \"%1%\".", resolver);
+        for (auto& kvp : loaded) {
+            facts.emplace_back(move(kvp));
+        }
+        return true;
+    }
+
+    void fact_cache::store(string const& resolver, vector<pair<string, value const*>> const& facts)
+    {
+        if (!is_cached(resolver)) {
+            return;
+        }
+        if (any_of(facts.begin(), facts.end(), [](pair<string, value const*> const& kvp) { return is_private(kvp.first); })) {
+            LOG_DEBUG("facts for resolver \"%1%\" will not be cached because some can only be read by root.", resolver);
+            _modified = _entries.erase(resolver) > 0 || _modified;
+            return;
+        }
+
+        entry e;
+        e.timestamp = static_cast<int64_t>(time(nullptr));
+        write_bytes(e.data, facts.size(), 4);
+        msgpack_writer writer(e.data);
+        for (auto const& kvp : facts) {
+            writer.write_string(kvp.first);
+            e.data += static_cast<char>(kvp.second && kvp.second->hidden() ? 1 : 0);
+            writer.write(kvp.second);
+        }
+        _entries[resolver] = move(e);
+        _modified = true;
+    }
+
+    void fact_cache::save()
+    {
+        if (!_modified) {
+            return;
+        }
+
+        string buffer = magic;
+        msgpack_writer writer(buffer);
+        buffer += static_cast<char>(format_version);
+        writer.write_string(LIBFACTER_VERSION);
+        write_bytes(buffer, _entries.size(), 4);
+        for (auto const& kvp : _entries) {
+            writer.write_string(kvp.first);
+            write_bytes(buffer, static_cast<uint64_t>(kvp.second.timestamp), 8);
+            write_bytes(buffer, kvp.second.data.size(), 4);
+            buffer += kvp.second.data;
+        }
+        write_bytes(buffer, checksum(buffer, buffer.size()), 8);
+
+        // Only the directory holding the cache is created private; its parents may be shared (e.g. /opt/puppetlabs)
+        boost::system::error_code ec;
+        path file(_path);
+        auto directory = file.parent_path();
+        if (!directory.empty() && !exists(directory, ec)) {
+            if (directory.has_parent_path()) {
+                create_directories(directory.parent_path(), ec);
+            }
+            create_private_directory(directory.string());
+        }
+
+        // Write to a temporary file and rename it so concurrent runs never see a partial cache
+        path temp = file;
+        temp += unique_path(".%%%%-%%%%");
+        if (!write_private_file(temp.string(), buffer)) {
+            LOG_DEBUG("fact cache %1% could not be written.", _path);
+            boost::filesystem::remove(temp, ec);
+            return;
+        }
+        boost::filesystem::rename(temp, file, ec);
+        if (ec) {
+            LOG_DEBUG("fact cache %1% could not be written: %2%.", _path, ec.message());
+            boost::filesystem::remove(temp, ec);
+            return;
+        }
+        _modified = false;
+    }
+
+    bool fact_cache::is_private(string const& name)
+    {
+        // The serial numbers and UUID come from files that only root can read (e.g. /sys/class/dmi/id/product_serial)
+        static const set<string> names = {
+            fact::dmi,
+            fact::serial_number,
+            fact::board_serial_number,
+            fact::uuid,
+        };
+        return names.count(name) > 0;
+    }
+
+    void fact_cache::read_file()
+    {
+        boost::nowide::ifstream in(_path.c_str(), ios::binary);
+        if (!in) {
+            return;
+        }
+        ostringstream contents;
+        contents << in.rdbuf();
+        string buffer = contents.str();
+
+        try {
+            if (buffer.size() < magic.size() + 1 + 8 || buffer.compare(0, magic.size(), magic) != 0) {
+                throw runtime_error("the file is not a fact cache.");
+            }
+            size_t end = buffer.size() - 8;
+            if (msgpack_reader(buffer, end).read_raw(8) != checksum(buffer, end)) {
+                throw runtime_error("the checksum does not match.");
+            }
+
+            msgpack_reader data(buffer, magic.size(), end - magic.size());
+            if (data.read_raw(1) != format_version) {
+                throw runtime_error("the format version is not supported.");
+            }
+            if (data.read_string() != LIBFACTER_VERSION) {
+                throw runtime_error("the cache was written by a different version of facter.");
+            }
+            auto count = data.read_raw(4);
+            map<string, entry> entries;
+            for (uint64_t i = 0; i < count; ++i) {
+                auto name = data.read_string();
+                entry e;
+                e.timestamp = static_cast<int64_t>(data.read_raw(8));
+                e.data = data.read_raw_string(data.read_raw(4));
+                entries[move(name)] = move(e);
+            }
+            _entries = move(entries);
+        } catch (runtime_error& ex) {
+            LOG_DEBUG("ignoring fact cache %1%: %2%", _path, ex.what());
+        }
+    }
+
+}}  // namespace facter::facts
@@ -4,10 +4,17 @@
 #include <facter/facts/scalar_value.hpp>
 #include <facter/facts/array_value.hpp>
 #include <facter/facts/map_value.hpp>
+#include <facter/facts/json_writer.hpp>
+#include <facter/facts/msgpack.hpp>
+#include <facter/execution/execution.hpp>
 #include <facter/util/directory.hpp>
 #include <facter/util/environment.hpp>
 #include <facter/util/string.hpp>
+#include <facter/util/scope_exit.hpp>
 #include <facter/version.h>
+#include <internal/facts/resolver_index.hpp>
+#include <internal/facts/cache.hpp>
+#include <internal/facts/value_arena.hpp>
 #include <internal/util/dynamic_library.hpp>
 #include <internal/facts/resolvers/ruby_resolver.hpp>
 #include <internal/facts/resolvers/path_resolver.hpp>
@@ -17,20 +24,43 @@
 #include <leatherman/logging/logging.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
-#include <rapidjson/document.h>
-#include <rapidjson/prettywriter.h>
 #include <yaml-cpp/yaml.h>
 #include <algorithm>
+#include <exception>
 
 using namespace std;
 using namespace facter::util;
-using namespace rapidjson;
 using namespace YAML;
 using namespace boost::filesystem;
 
 namespace facter { namespace facts {
 
-    collection::collection()
+    circular_dependency_exception::circular_dependency_exception(string const& message) :
+        runtime_error(message)
+    {
+    }
+
+    static bool provides(resolver const& res, string const& name)
+    {
+        auto const& names = res.names();
+        return find(names.begin(), names.end(), name) != names.end() || res.is_match(name);
+    }
+
+    static bool shares_names(resolver const& first, resolver const& second)
+    {
+        for (auto const& name : first.names()) {
+            if (provides(second, name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    collection::collection() :
+        _index(new resolver_index()),
+        _arena(new value_arena()),
+        _command_fallbacks(false),
+        _concurrency(1)
     {
         // This needs to be defined here since we use incomplete types in the header
     }
@@ -38,9 +68,18 @@ namespace facter { namespace facts {
     collection::~collection()
     {
         // This needs to be defined here since we use incomplete types in the header
+        try {
+            save_cache();
+        } catch (exception& ex) {
+            LOG_DEBUG("fact cache could not be saved: %1%", ex.what());
+        }
     }
 
-    collection::collection(collection&& other)
+    collection::collection(collection&& other) :
+        _index(new resolver_index()),
+        _arena(new value_arena()),
+        _command_fallbacks(false),
+        _concurrency(1)
     {
         *this = std::move(other);
     }
@@ -49,9 +88,21 @@ namespace facter { namespace facts {
     {
         if (this != &other) {
             _facts = std::move(other._facts);
+            _queries = std::move(other._queries);
             _resolvers = std::move(other._resolvers);
-            _resolver_map = std::move(other._resolver_map);
-            _pattern_resolvers = std::move(other._pattern_resolvers);
+            _positions = std::move(other._positions);
+            _index = std::move(other._index);
+            other._index.reset(new resolver_index());
+            _dependencies = std::move(other._dependencies);
+            _legacy = std::move(other._legacy);
+            _cache = std::move(other._cache);
+            _command_cache = std::move(other._command_cache);
+            _arena = std::move(other._arena);
+            other._arena.reset(new value_arena());
+            _concurrency = other._concurrency;
+            _interface_filter = std::move(other._interface_filter);
+            _mountpoint_filter = std::move(other._mountpoint_filter);
+            _command_fallbacks = other._command_fallbacks;
         }
         return *this;
     }
@@ -68,21 +119,65 @@ namespace facter { namespace facts {
             return;
         }
 
-        for (auto const& name : res->names()) {
-            _resolver_map.insert({ name, res });
+        boost::lock_guard<boost::mutex> lock(_mutex);
+
+        // A resolver that is already pending is only resolved once
+        if (_positions.count(res)) {
+            return;
         }
 
-        if (res->has_patterns()) {
-            _pattern_resolvers.push_back(res);
+        // Find the pending resolvers that provide this resolver's dependencies
+        vector<shared_ptr<resolver>> providers;
+        for (auto const& dependency : res->dependencies()) {
+            for (auto const& pending : _resolvers) {
+                if (pending != res && provides(*pending, dependency) && find(providers.begin(), providers.end(), pending) == providers.end()) {
+                    providers.push_back(pending);
+                }
+            }
+        }
+
+        // Find the pending resolvers that depend on facts this resolver provides
+        vector<shared_ptr<resolver>> dependents;
+        for (auto const& kvp : _dependencies) {
+            auto dependencies = kvp.first->dependencies();
+            if (kvp.first != res && any_of(dependencies.begin(), dependencies.end(), [&](string const& dependency) { return provides(*res, dependency); })) {
+                dependents.push_back(kvp.first);
+            }
         }
 
-        _resolvers.push_back(res);
+        // Adding the resolver creates a cycle if any dependent can be reached from a provider
+        vector<shared_ptr<resolver>> path;
+        for (auto const& provider : providers) {
+            if (!find_dependency_path(provider, dependents, path)) {
+                continue;
+            }
+            ostringstream message;
+            message << "resolver \"" << res->name() << "\" has a circular dependency: " << res->name();
+            for (auto const& next : path) {
+                message << " -> " << next->name();
+            }
+            message << " -> " << res->name() << ".";
+            throw circular_dependency_exception(message.str());
+        }
+
+        for (auto const& dependent : dependents) {
+            _dependencies[dependent].push_back(res);
+        }
+        auto& edges = _dependencies[res];
+        edges.insert(edges.end(), providers.begin(), providers.end());
+
+        _index->add(res);
+        _positions[res] = _resolvers.insert(_resolvers.end(), res);
     }
 
     void collection::add(string name, unique_ptr<value> value)
     {
         // Ensure the fact is resolved before replacing it
-        auto old_value = get_value(name);
+        resolve_fact(name);
+
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        auto it = _facts.find(name);
+        auto old_value = it == _facts.end() ? nullptr : it->second.get();
 
         if (LOG_IS_DEBUG_ENABLED()) {
             if (old_value) {
@@ -108,7 +203,7 @@ namespace facter { namespace facts {
 
         if (!value) {
             if (old_value) {
-                remove(name);
+                _facts.erase(it);
             }
             return;
         }
@@ -136,26 +231,33 @@ namespace facter { namespace facts {
 
         LOG_DEBUG("searching %1% for external facts.", search_dir);
 
+        // Group the files by the resolver that can resolve them so that each resolver can resolve its files together
+        vector<vector<string>> paths(resolvers.size());
         directory::each_file(search_dir.string(), [&](string const& path) {
-            for (auto const& res : resolvers) {
-                if (res->can_resolve(path)) {
-                    try {
-                        found = true;
-                        res->resolve(path, *this);
-                    }
-                    catch (external::external_fact_exception& ex) {
-                        LOG_ERROR("error while processing \"%1%\" for external facts: %2%", path, ex.what());
-                    }
+            for (size_t i = 0; i < resolvers.size(); ++i) {
+                if (resolvers[i]->can_resolve(path)) {
+                    found = true;
+                    paths[i].push_back(path);
                     break;
                 }
             }
             return true;
         });
+
+        for (size_t i = 0; i < resolvers.size(); ++i) {
+            if (paths[i].empty()) {
+                continue;
+            }
+            for (auto const& error : resolvers[i]->resolve_all(paths[i], *this)) {
+                LOG_ERROR("error while processing \"%1%\" for external facts: %2%", error.first, error.second);
+            }
+        }
         return found;
     }
 
     void collection::add_external_facts(vector<string> const& directories)
     {
+        value_arena::scope arena(_arena.get());
         auto resolvers = get_external_resolvers();
 
         // Build a map between a file and the resolver that can resolve it
@@ -176,6 +278,7 @@ namespace facter { namespace facts {
 
     void collection::add_environment_facts(function<void(string const& name)> callback)
     {
+        value_arena::scope arena(_arena.get());
         environment::each([&](string& name, string& value) {
             // If the variable starts with "FACTER_", the remainder of the variable is the fact name
             if (!boost::istarts_with(name, "FACTER_")) {
@@ -201,21 +304,31 @@ namespace facter { namespace facts {
             return;
         }
 
-        // Remove all name associations
-        for (auto const& name : res->names()) {
-            auto range = _resolver_map.equal_range(name);
-            auto it = range.first;
-            while (it != range.second) {
-                if (it->second != res) {
-                    ++it;
-                    continue;
-                }
-                it = _resolver_map.erase(it);
-            }
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        remove_resolver(res);
+        remove_dependency(res);
+    }
+
+    void collection::remove_resolver(shared_ptr<resolver> const& res)
+    {
+        auto position = _positions.find(res);
+        if (position == _positions.end()) {
+            return;
         }
 
-        _pattern_resolvers.remove(res);
-        _resolvers.remove(res);
+        _resolvers.erase(position->second);
+        _positions.erase(position);
+        _index->remove(res);
+        _dependencies.erase(res);
+    }
+
+    void collection::remove_dependency(shared_ptr<resolver> const& res)
+    {
+        // Remove the resolver from the dependencies of every pending resolver
+        for (auto& kvp : _dependencies) {
+            auto& providers = kvp.second;
+            providers.erase(std::remove(providers.begin(), providers.end(), res), providers.end());
+        }
     }
 
     void collection::remove(string const& name)
@@ -226,15 +339,20 @@ namespace facter { namespace facts {
             return;
         }
 
+        boost::lock_guard<boost::mutex> lock(_mutex);
         _facts.erase(name);
     }
 
     void collection::clear()
     {
+        boost::lock_guard<boost::mutex> lock(_mutex);
         _facts.clear();
+        _queries.clear();
         _resolvers.clear();
-        _resolver_map.clear();
-        _pattern_resolvers.clear();
+        _positions.clear();
+        _index->clear();
+        _dependencies.clear();
+        _legacy.clear();
     }
 
     bool collection::empty()
@@ -245,6 +363,7 @@ namespace facter { namespace facts {
     size_t collection::size()
     {
         resolve_facts();
+        resolve_legacy_facts();
         return _facts.size();
     }
 
@@ -256,6 +375,7 @@ namespace facter { namespace facts {
     void collection::each(function<bool(string const&, value const*)> func)
     {
         resolve_facts();
+        resolve_legacy_facts();
 
         find_if(begin(_facts), end(_facts), [&func](map<string, unique_ptr<value>>::value_type const& it) {
             return !func(it.first, it.second.get());
@@ -271,48 +391,383 @@ namespace facter { namespace facts {
 
         if (fmt == format::hash) {
             write_hash(stream, queries);
-        } else if (fmt == format::json) {
-            write_json(stream, queries);
+        } else if (fmt == format::json || fmt == format::compact_json) {
+            write_json(stream, queries, fmt == format::json);
         } else if (fmt == format::yaml) {
             write_yaml(stream, queries);
+        } else if (fmt == format::msgpack) {
+            write_msgpack(stream, queries);
         }
         return stream;
     }
 
     void collection::resolve_facts()
     {
-        // Remove the front of the resolvers list and resolve until no resolvers are left
+        auto threads = _concurrency ? _concurrency : max(boost::thread::hardware_concurrency(), 1u);
+        if (threads > 1) {
+            resolve_facts_concurrently(threads);
+            return;
+        }
+
+        // Resolve in dependency order until no resolvers are left
+        boost::unique_lock<boost::mutex> lock(_mutex);
         while (!_resolvers.empty()) {
-            auto resolver = _resolvers.front();
-            remove(resolver);
-            LOG_DEBUG("resolving %1% facts.", resolver->name());
-            resolver->resolve(*this);
+            auto res = next_resolver();
+            resolve(lock, res ? res : _resolvers.front());
+        }
+    }
+
+    unsigned int collection::concurrency() const
+    {
+        return _concurrency;
+    }
+
+    void collection::concurrency(unsigned int threads)
+    {
+        _concurrency = threads;
+    }
+
+    name_filter const& collection::interface_filter() const
+    {
+        return _interface_filter;
+    }
+
+    void collection::interface_filter(name_filter filter)
+    {
+        _interface_filter = move(filter);
+    }
+
+    name_filter const& collection::mountpoint_filter() const
+    {
+        return _mountpoint_filter;
+    }
+
+    void collection::mountpoint_filter(name_filter filter)
+    {
+        _mountpoint_filter = move(filter);
+    }
+
+    bool collection::command_fallbacks() const
+    {
+        return _command_fallbacks;
+    }
+
+    void collection::command_fallbacks(bool enabled)
+    {
+        _command_fallbacks = enabled;
+    }
+
+    void collection::resolve_facts_concurrently(unsigned int threads)
+    {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+
+        // Resolvers that cannot run on a worker thread are resolved on this thread up front
+        auto pending = _resolvers;
+        for (auto const& res : pending) {
+            if (!res->is_thread_safe() && _positions.count(res)) {
+                resolve(lock, res);
+            }
+        }
+
+        if (_resolvers.empty()) {
+            return;
+        }
+        threads = min(threads, static_cast<unsigned int>(_resolvers.size()));
+        LOG_DEBUG("resolving facts using %1% threads.", threads);
+
+        exception_ptr error;
+        auto worker = [&]() {
+            boost::unique_lock<boost::mutex> worker_lock(_mutex);
+            try {
+                while (!error) {
+                    auto res = next_resolver();
+                    if (res) {
+                        resolve(worker_lock, res);
+                        continue;
+                    }
+                    if (_resolvers.empty()) {
+                        break;
+                    }
+                    if (_resolving.empty()) {
+                        // Nothing is in flight to wait on; resolve the front and its dependencies directly
+                        resolve(worker_lock, _resolvers.front());
+                        continue;
+                    }
+                    // Every pending resolver must wait for one that is currently resolving
+                    _resolved.wait(worker_lock);
+                }
+            } catch (...) {
+                // Stop scheduling any further resolvers; the first error is rethrown to the caller
+                if (!error) {
+                    error = current_exception();
+                }
+                _resolved.notify_all();
+            }
+        };
+
+        lock.unlock();
+
+        // The calling thread acts as one of the workers
+        boost::thread_group workers;
+        for (unsigned int i = 1; i < threads; ++i) {
+            workers.create_thread(worker);
+        }
+        worker();
+        workers.join_all();
+
+        if (error) {
+            rethrow_exception(error);
+        }
+    }
+
+    shared_ptr<resolver> collection::next_resolver() const
+    {
+        // Pick the first pending resolver whose dependencies have all been resolved and that does not share a
+        // fact name with a resolver that is resolving or pending ahead of it; this preserves "last added wins"
+        // ordering between them
+        for (auto it = _resolvers.begin(); it != _resolvers.end(); ++it) {
+            auto const& candidate = *it;
+            auto const& providers = _dependencies.at(candidate);
+            bool blocked = any_of(providers.begin(), providers.end(), [&](shared_ptr<resolver> const& provider) {
+                return _dependencies.count(provider) || _resolving.count(provider);
+            });
+            blocked = blocked || any_of(_resolving.begin(), _resolving.end(), [&](pair<shared_ptr<resolver> const, boost::thread::id> const& kvp) {
+                return shares_names(*candidate, *kvp.first);
+            });
+            blocked = blocked || any_of(_resolvers.begin(), it, [&](shared_ptr<resolver> const& previous) {
+                return shares_names(*candidate, *previous);
+            });
+            if (!blocked) {
+                return candidate;
+            }
+        }
+        return nullptr;
+    }
+
+    shared_ptr<resolver> collection::pending_dependency(shared_ptr<resolver> const& res) const
+    {
+        auto it = _dependencies.find(res);
+        if (it == _dependencies.end()) {
+            return nullptr;
+        }
+        // A provider that is resolving on another thread is waited for when its facts are requested
+        auto provider = find_if(it->second.begin(), it->second.end(), [&](shared_ptr<resolver> const& provider) {
+            return _dependencies.count(provider) > 0 && !_resolving.count(provider);
+        });
+        return provider == it->second.end() ? nullptr : *provider;
+    }
+
+    bool collection::find_dependency_path(shared_ptr<resolver> const& from, vector<shared_ptr<resolver>> const& targets, vector<shared_ptr<resolver>>& path) const
+    {
+        // The dependency graph is acyclic, so a depth-first search always terminates
+        path.push_back(from);
+        if (find(targets.begin(), targets.end(), from) != targets.end()) {
+            return true;
+        }
+        auto it = _dependencies.find(from);
+        if (it != _dependencies.end()) {
+            for (auto const& provider : it->second) {
+                if (find_dependency_path(provider, targets, path)) {
+                    return true;
+                }
+            }
+        }
+        path.pop_back();
+        return false;
+    }
+
+    bool collection::would_deadlock(shared_ptr<resolver> const& res) const
+    {
+        // Follow the chain of threads waiting on each other starting at the thread resolving the given resolver
+        // If the chain leads back to the current thread, waiting would never complete
+        auto self = boost::this_thread::get_id();
+        auto resolving = _resolving.find(res);
+        for (size_t i = 0; resolving != _resolving.end() && i <= _waiting.size(); ++i) {
+            if (resolving->second == self) {
+                return true;
+            }
+            auto waiting = _waiting.find(resolving->second);
+            if (waiting == _waiting.end()) {
+                break;
+            }
+            resolving = _resolving.find(waiting->second);
         }
+        return false;
+    }
+
+    void collection::resolve(boost::unique_lock<boost::mutex>& lock, shared_ptr<resolver> res)
+    {
+        // Resolve any pending dependencies first rather than recursing from within the resolver
+        for (auto dependency = pending_dependency(res); dependency; dependency = pending_dependency(res)) {
+            resolve(lock, dependency);
+        }
+
+        // Wait for a query being answered by the resolver on another thread, as the query limits what the resolver collects
+        // If the query is waiting on this thread, the resolver is left pending
+        auto self = boost::this_thread::get_id();
+        for (auto resolving = _resolving.find(res); resolving != _resolving.end(); resolving = _resolving.find(res)) {
+            if (resolving->second == self || would_deadlock(res)) {
+                return;
+            }
+            _waiting[self] = res;
+            _resolved.wait(lock);
+            _waiting.erase(self);
+        }
+
+        // Another thread may have started resolving the resolver while its dependencies were being resolved
+        if (!_positions.count(res)) {
+            return;
+        }
+
+        // Remove the resolver so that it is only resolved once and record which thread is resolving it
+        remove_resolver(res);
+        _resolving.emplace(res, boost::this_thread::get_id());
+
+        // Values created by the resolver are allocated from the collection's arena
+        value_arena::scope arena(_arena.get());
+        execution::command_cache::scope commands(_command_cache.get());
+
+        vector<pair<string, unique_ptr<value>>> cached;
+        bool use_cache = _cache && _cache->is_cached(res->name());
+        bool loaded = use_cache && _cache->load(res->name(), cached);
+        lock.unlock();
+
+        scope_exit finished([&]() {
+            lock.lock();
+            _resolving.erase(res);
+            remove_dependency(res);
+            // The resolver's legacy facts are added when one of them is first requested
+            if (res->has_legacy_facts()) {
+                _legacy.push_back(res);
+            }
+            _resolved.notify_all();
+        });
+
+        if (loaded) {
+            for (auto& kvp : cached) {
+                add(move(kvp.first), move(kvp.second));
+            }
+            return;
+        }
+
+        LOG_DEBUG("resolving %1% facts.", res->name());
+        res->resolve(*this);
+
+        if (use_cache) {
+            lock.lock();
+            vector<pair<string, value const*>> facts;
+            for (auto const& kvp : _facts) {
+                if (provides(*res, kvp.first)) {
+                    facts.emplace_back(kvp.first, kvp.second.get());
+                }
+            }
+            _cache->store(res->name(), facts);
+            lock.unlock();
+        }
+    }
+
+    void collection::enable_cache(map<string, int64_t> ttls, bool refresh, string const& path)
+    {
+        auto cache_file = path.empty() ? get_cache_file() : path;
+        if (cache_file.empty()) {
+            LOG_DEBUG("fact cache file could not be determined: facts will not be cached.");
+            return;
+        }
+        unique_ptr<fact_cache> cache(new fact_cache(cache_file, move(ttls), refresh));
+
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _cache = move(cache);
+    }
+
+    void collection::save_cache()
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        if (_cache) {
+            _cache->save();
+        }
+    }
+
+    void collection::enable_command_cache()
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        if (!_command_cache) {
+            _command_cache.reset(new execution::command_cache());
+        }
+    }
+
+    execution::command_cache* collection::command_cache() const
+    {
+        return _command_cache.get();
     }
 
     void collection::resolve_fact(string const& name)
     {
-        // Resolve every resolver mapped to this name first
-        auto range = _resolver_map.equal_range(name);
-        auto it = range.first;
-        while (it != range.second) {
-            auto resolver = (it++)->second;
-            remove(resolver);
-            LOG_DEBUG("resolving %1% facts.", resolver->name());
-            resolver->resolve(*this);
-        }
-
-         // Resolve every resolver that matches the given name
-        auto pattern_it = _pattern_resolvers.begin();
-        while (pattern_it != _pattern_resolvers.end()) {
-            if (!(*pattern_it)->is_match(name)) {
-                ++pattern_it;
+        auto self = boost::this_thread::get_id();
+        boost::unique_lock<boost::mutex> lock(_mutex);
+
+        while (true) {
+            // Wait for any resolver of this fact that is being resolved on another thread
+            // A resolver being resolved on this thread (or one that would deadlock) is treated as already resolved
+            auto resolving = find_if(_resolving.begin(), _resolving.end(), [&](pair<shared_ptr<resolver> const, boost::thread::id> const& kvp) {
+                return kvp.second != self && provides(*kvp.first, name) && !would_deadlock(kvp.first);
+            });
+            if (resolving != _resolving.end()) {
+                _waiting[self] = resolving->first;
+                _resolved.wait(lock);
+                _waiting.erase(self);
+                continue;
+            }
+
+            // Resolve every resolver mapped to this name first, then every resolver that matches the name
+            auto res = _index->find(name);
+            if (res) {
+                // The resolver is answering a query that is waiting on this thread; its facts are not available yet
+                if (_resolving.count(res)) {
+                    break;
+                }
+                resolve(lock, res);
                 continue;
             }
-            auto resolver = *(pattern_it++);
-            remove(resolver);
-            LOG_DEBUG("resolving %1% facts.", resolver->name());
-            resolver->resolve(*this);
+
+            // Add the legacy facts of a resolved resolver that provides the name if the fact does not exist
+            if (!_facts.count(name)) {
+                auto legacy = find_if(_legacy.begin(), _legacy.end(), [&](shared_ptr<resolver> const& pending) {
+                    return provides(*pending, name);
+                });
+                if (legacy != _legacy.end()) {
+                    resolve_legacy(lock, *legacy);
+                    continue;
+                }
+            }
+            break;
+        }
+    }
+
+    void collection::resolve_legacy(boost::unique_lock<boost::mutex>& lock, shared_ptr<resolver> res)
+    {
+        // Remove the resolver so that its legacy facts are only added once
+        _legacy.erase(std::remove(_legacy.begin(), _legacy.end(), res), _legacy.end());
+        _resolving.emplace(res, boost::this_thread::get_id());
+        lock.unlock();
+
+        scope_exit finished([&]() {
+            lock.lock();
+            _resolving.erase(res);
+            _resolved.notify_all();
+        });
+
+        value_arena::scope arena(_arena.get());
+        execution::command_cache::scope commands(_command_cache.get());
+
+        LOG_DEBUG("resolving %1% legacy facts.", res->name());
+        res->resolve_legacy(*this);
+    }
+
+    void collection::resolve_legacy_facts()
+    {
+        boost::unique_lock<boost::mutex> lock(_mutex);
+        while (!_legacy.empty()) {
+            resolve_legacy(lock, _legacy.front());
         }
     }
 
@@ -321,6 +776,7 @@ namespace facter { namespace facts {
         resolve_fact(name);
 
         // Lookup the fact
+        boost::lock_guard<boost::mutex> lock(_mutex);
         auto it = _facts.find(name);
         return it == _facts.end() ? nullptr : it->second.get();
     }
@@ -334,6 +790,7 @@ namespace facter { namespace facts {
         }
 
         bool in_quotes = false;
+        vector<string> segments;
         string segment;
         for (auto const& c : query) {
             if (c == '"') {
@@ -344,19 +801,92 @@ namespace facter { namespace facts {
                 segment += c;
                 continue;
             }
-            current = lookup(current, segment);
-            if (!current) {
-                return nullptr;
-            }
+            segments.emplace_back(move(segment));
             segment.clear();
         }
 
         if (!segment.empty()) {
-            current = lookup(current, segment);
+            segments.emplace_back(move(segment));
+        }
+
+        // Attempt to resolve only the queried part of the fact before resolving the entire fact
+        current = resolve_query(query, segments);
+        for (size_t i = current ? 1 : 0; i < segments.size(); ++i) {
+            current = lookup(current, segments[i]);
+            if (!current) {
+                return nullptr;
+            }
         }
         return current;
     }
 
+    value const* collection::resolve_query(string const& query, vector<string> const& segments)
+    {
+        if (segments.size() < 2) {
+            return nullptr;
+        }
+
+        auto const& name = segments.front();
+        auto self = boost::this_thread::get_id();
+        boost::unique_lock<boost::mutex> lock(_mutex);
+
+        shared_ptr<resolver> res;
+        while (true) {
+            // Partial resolution only applies to facts that have not been resolved
+            if (_facts.count(name)) {
+                return nullptr;
+            }
+
+            auto it = _queries.find(query);
+            if (it != _queries.end()) {
+                return it->second.get();
+            }
+
+            // The pending resolver added last overrides the fact, so it is the one to answer the query
+            res = _index->find(name, true);
+            if (!res) {
+                return nullptr;
+            }
+
+            // Wait for another query being answered by the resolver; a resolver busy on this thread cannot answer
+            auto resolving = _resolving.find(res);
+            if (resolving == _resolving.end()) {
+                break;
+            }
+            if (resolving->second == self || would_deadlock(res)) {
+                return nullptr;
+            }
+            _waiting[self] = res;
+            _resolved.wait(lock);
+            _waiting.erase(self);
+        }
+
+        // Mark the resolver as resolving so that it is not resolved while the query is being resolved
+        _resolving.emplace(res, self);
+        lock.unlock();
+
+        unique_ptr<value> result;
+        {
+            value_arena::scope arena(_arena.get());
+            execution::command_cache::scope commands(_command_cache.get());
+            scope_exit finished([&]() {
+                lock.lock();
+                _resolving.erase(res);
+                _resolved.notify_all();
+            });
+
+            LOG_DEBUG("resolving query \"%1%\" with %2% facts.", query, res->name());
+            result = res->resolve_query(*this, name, vector<string>(segments.begin() + 1, segments.end()));
+        }
+
+        if (!result) {
+            return nullptr;
+        }
+        auto partial = result.get();
+        _queries[query] = move(result);
+        return partial;
+    }
+
     value const* collection::lookup(value const* value, string const& name)
     {
         if (!value) {
@@ -367,7 +897,7 @@ namespace facter { namespace facts {
             return value;
         }
 
-        auto map = dynamic_cast<map_value const*>(value);
+        auto map = value_cast<map_value>(value);
         if (map) {
             value = (*map)[name];
             if (!value) {
@@ -376,7 +906,7 @@ namespace facter { namespace facts {
             return value;
         }
 
-        auto array = dynamic_cast<array_value const*>(value);
+        auto array = value_cast<array_value>(value);
         if (array) {
             int index;
             try {
@@ -448,54 +978,37 @@ namespace facter { namespace facts {
         }
     }
 
-    struct stream_adapter
+    void collection::write_json(ostream& stream, set<string> const& queries, bool pretty)
     {
-        explicit stream_adapter(ostream& stream) : _stream(stream)
-        {
-        }
+        // Stream the values directly to the output rather than building a JSON document first
+        json_writer json(stream, pretty);
+        json.start_object();
 
-        void Put(char c)
-        {
-            _stream << c;
-        }
-
-     private:
-         ostream& _stream;
-    };
-
-    void collection::write_json(ostream& stream, set<string> const& queries)
-    {
-        Document document;
-        document.SetObject();
-
-        auto builder = ([&](string const& key, value const* val) {
+        auto writer = ([&](string const& key, value const* val) {
             // Ignore facts with hidden values
             if (queries.empty() && val && val->hidden()) {
                 return;
             }
-            rapidjson::Value value;
+            json.write_key(key);
             if (val) {
-                val->to_json(document.GetAllocator(), value);
+                val->write(json);
             } else {
-                value.SetString("", 0);
+                json.write_string("", 0);
             }
-            document.AddMember(key.c_str(), value, document.GetAllocator());
         });
 
         if (!queries.empty()) {
             for (auto const& query : queries) {
-                builder(query, this->query_value(query));
+                writer(query, this->query_value(query));
             }
         } else {
             for (auto const& kvp : _facts) {
-                builder(kvp.first, kvp.second.get());
+                writer(kvp.first, kvp.second.get());
             }
         }
 
-        stream_adapter adapter(stream);
-        PrettyWriter<stream_adapter> writer(adapter);
-        writer.SetIndent(' ', 2);
-        document.Accept(writer);
+        json.end_object();
+        json.flush();
     }
 
     void collection::write_yaml(ostream& stream, set<string> const& queries)
@@ -537,6 +1050,37 @@ namespace facter { namespace facts {
         emitter << EndMap;
     }
 
+    void collection::write_msgpack(ostream& stream, set<string> const& queries)
+    {
+        vector<pair<string const*, value const*>> facts;
+        if (!queries.empty()) {
+            for (auto const& query : queries) {
+                facts.emplace_back(&query, this->query_value(query));
+            }
+        } else {
+            for (auto const& kvp : _facts) {
+                // Ignore facts with hidden values
+                if (kvp.second->hidden()) {
+                    continue;
+                }
+                facts.emplace_back(&kvp.first, kvp.second.get());
+            }
+        }
+
+        string buffer;
+        msgpack_writer writer(buffer);
+        writer.write_map(facts.size());
+        for (auto const& kvp : facts) {
+            writer.write_string(*kvp.first);
+            if (kvp.second) {
+                kvp.second->write(writer);
+            } else {
+                writer.write_string("", 0);
+            }
+        }
+        stream.write(buffer.data(), buffer.size());
+    }
+
     void collection::add_common_facts(bool include_ruby_facts)
     {
         add("facterversion", make_value<string_value>(LIBFACTER_VERSION));
@@ -4,6 +4,7 @@
 #include <facter/facts/map_value.hpp>
 #include <facter/facts/scalar_value.hpp>
 #include <facter/execution/execution.hpp>
+#include <internal/execution/execution.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -24,14 +25,29 @@ namespace facter { namespace facts { namespace external {
 
     void execution_resolver::resolve(string const& path, collection& facts) const
     {
-        LOG_DEBUG("resolving facts from executable file \"%1%\".", path);
+        auto errors = resolve_all({ path }, facts);
+        if (!errors.empty()) {
+            throw external_fact_exception(errors.begin()->second);
+        }
+    }
 
-        try
+    map<string, string> execution_resolver::resolve_all(vector<string> const& paths, collection& facts) const
+    {
+        // Each executable's facts and error output are kept apart so that the executables can run concurrently
+        struct output
         {
+            vector<pair<string, string>> facts;
             string error;
-            execution::each_line(
-                path,
-                [&](string const& line) {
+        };
+        vector<output> outputs(paths.size());
+        vector<command> commands;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            LOG_DEBUG("resolving facts from executable file \"%1%\".", paths[i]);
+            auto& out = outputs[i];
+            commands.push_back({
+                paths[i],
+                {},
+                [&](string& line) {
                     auto pos = line.find('=');
                     if (pos == string::npos) {
                         LOG_DEBUG("ignoring line in output: %1%", line);
@@ -40,33 +56,60 @@ namespace facter { namespace facts { namespace external {
                     // Add as a string fact
                     string fact = line.substr(0, pos);
                     boost::to_lower(fact);
-                    facts.add(move(fact), make_value<string_value>(line.substr(pos+1)));
+                    out.facts.emplace_back(move(fact), line.substr(pos + 1));
                     return true;
                 },
-                [&](string const& line) {
-                    if (!error.empty()) {
-                        error += "\n";
+                [&](string& line) {
+                    if (!out.error.empty()) {
+                        out.error += "\n";
                     }
-                    error += line;
+                    out.error += line;
                     return true;
                 },
-                0,
                 {
                     execution_options::trim_output,
                     execution_options::merge_environment,
                     execution_options::throw_on_failure
-                });
+                },
+                0
+            });
+        }
 
-            // Log a warning if there is error output from the command
-            if (!error.empty()) {
-                LOG_WARNING("external fact file \"%1%\" had output on stderr: %2%", path, error);
-            }
+        vector<command_result> results;
+        try {
+            results = execute_all(commands);
         }
         catch (execution_exception& ex) {
-            throw external_fact_exception(ex.what());
+            map<string, string> errors;
+            for (auto const& path : paths) {
+                errors.emplace(path, ex.what());
+            }
+            return errors;
         }
 
-        LOG_DEBUG("completed resolving facts from executable file \"%1%\".", path);
+        map<string, string> errors;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            auto const& path = paths[i];
+            for (auto& fact : outputs[i].facts) {
+                facts.add(move(fact.first), make_value<string_value>(move(fact.second)));
+            }
+            if (results[i].exception) {
+                try {
+                    rethrow_exception(results[i].exception);
+                }
+                catch (execution_exception& ex) {
+                    errors.emplace(path, ex.what());
+                }
+                continue;
+            }
+
+            // Log a warning if there is error output from the command
+            if (!outputs[i].error.empty()) {
+                LOG_WARNING("external fact file \"%1%\" had output on stderr: %2%", path, outputs[i].error);
+            }
+            LOG_DEBUG("completed resolving facts from executable file \"%1%\".", path);
+        }
+        return errors;
     }
 
 }}}  // namespace facter::facts::external
@@ -68,7 +68,7 @@ namespace facter { namespace facts { namespace external {
         void String(char const* s, SizeType len, bool copy)
         {
             // If the stack is empty or the top is a map and we don't have a key yet, set the key
-            if ((_stack.empty() || dynamic_cast<map_value*>(get<1>(_stack.top()).get())) && _key.empty()) {
+            if ((_stack.empty() || value_cast<map_value>(get<1>(_stack.top()).get())) && _key.empty()) {
                 check_initialized();
                 _key = s;
                 return;
@@ -141,12 +141,12 @@ namespace facter { namespace facts { namespace external {
             // If there's an array or map on the stack, add the value as an element
             auto& top = _stack.top();
             auto& current = get<1>(top);
-            auto array = dynamic_cast<array_value*>(current.get());
+            auto array = value_cast<array_value>(current.get());
             if (array) {
                 array->add(move(val));
                 return;
             }
-            auto map = dynamic_cast<map_value*>(current.get());
+            auto map = value_cast<map_value>(current.get());
             if (map) {
                 if (_key.empty()) {
                     throw external::external_fact_exception("expected non-empty key in object.");
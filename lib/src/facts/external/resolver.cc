@@ -9,4 +9,17 @@ namespace facter { namespace facts { namespace external {
     {
     }
 
+    map<string, string> resolver::resolve_all(vector<string> const& paths, collection& facts) const
+    {
+        map<string, string> errors;
+        for (auto const& path : paths) {
+            try {
+                resolve(path, facts);
+            } catch (external_fact_exception& ex) {
+                errors.emplace(path, ex.what());
+            }
+        }
+        return errors;
+    }
+
 }}}  // namespace facter::facts::external
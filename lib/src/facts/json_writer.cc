@@ -0,0 +1,217 @@
+#include <facter/facts/json_writer.hpp>
+#include <cstdio>
+
+using namespace std;
+
+namespace facter { namespace facts {
+
+    json_writer::json_writer(ostream& stream, bool pretty, size_t buffer_size) :
+        _stream(stream),
+        _pretty(pretty),
+        _buffer_size(buffer_size)
+    {
+        _buffer.reserve(_buffer_size);
+    }
+
+    json_writer::~json_writer()
+    {
+        flush();
+    }
+
+    void json_writer::start_object()
+    {
+        prefix();
+        _levels.push_back({ false, 0 });
+        put('{');
+    }
+
+    void json_writer::end_object()
+    {
+        bool empty = _levels.back().count == 0;
+        _levels.pop_back();
+        if (_pretty && !empty) {
+            put('\n');
+            indent();
+        }
+        put('}');
+    }
+
+    void json_writer::start_array()
+    {
+        prefix();
+        _levels.push_back({ true, 0 });
+        put('[');
+    }
+
+    void json_writer::end_array()
+    {
+        bool empty = _levels.back().count == 0;
+        _levels.pop_back();
+        if (_pretty && !empty) {
+            put('\n');
+            indent();
+        }
+        put(']');
+    }
+
+    void json_writer::write_key(string const& key)
+    {
+        prefix();
+        escape(key.c_str(), key.size());
+    }
+
+    void json_writer::write_string(char const* str, size_t length)
+    {
+        prefix();
+        escape(str, length);
+    }
+
+    void json_writer::write_string(string const& str)
+    {
+        write_string(str.c_str(), str.size());
+    }
+
+    void json_writer::write_integer(int64_t i)
+    {
+        prefix();
+
+        // Format the digits in reverse into a local buffer
+        char buffer[20];
+        char* p = buffer + sizeof(buffer);
+        auto magnitude = i < 0 ? 0 - static_cast<uint64_t>(i) : static_cast<uint64_t>(i);
+        do {
+            *--p = static_cast<char>('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude > 0);
+
+        if (i < 0) {
+            put('-');
+        }
+        put(p, buffer + sizeof(buffer) - p);
+    }
+
+    void json_writer::write_boolean(bool b)
+    {
+        prefix();
+        if (b) {
+            put("true", 4);
+        } else {
+            put("false", 5);
+        }
+    }
+
+    void json_writer::write_double(double d)
+    {
+        prefix();
+        char buffer[100];
+        int length = snprintf(buffer, sizeof(buffer), "%g", d);
+        if (length > 0) {
+            put(buffer, static_cast<size_t>(length));
+        }
+    }
+
+    void json_writer::write_null()
+    {
+        prefix();
+        put("null", 4);
+    }
+
+    void json_writer::flush()
+    {
+        if (_buffer.empty()) {
+            return;
+        }
+        _stream.write(_buffer.data(), _buffer.size());
+        _buffer.clear();
+    }
+
+    void json_writer::prefix()
+    {
+        if (_levels.empty()) {
+            return;
+        }
+
+        // Object members alternate between keys (even counts) and values (odd counts)
+        auto& current = _levels.back();
+        bool key = !current.in_array && current.count % 2 == 0;
+        if (current.in_array || key) {
+            if (current.count > 0) {
+                put(',');
+            }
+            if (_pretty) {
+                put('\n');
+                indent();
+            }
+        } else {
+            put(':');
+            if (_pretty) {
+                put(' ');
+            }
+        }
+        ++current.count;
+    }
+
+    void json_writer::indent()
+    {
+        _buffer.append(_levels.size() * 2, ' ');
+    }
+
+    void json_writer::put(char c)
+    {
+        _buffer += c;
+        if (_buffer.size() >= _buffer_size) {
+            flush();
+        }
+    }
+
+    void json_writer::put(char const* str, size_t length)
+    {
+        _buffer.append(str, length);
+        if (_buffer.size() >= _buffer_size) {
+            flush();
+        }
+    }
+
+    void json_writer::escape(char const* str, size_t length)
+    {
+        static const char hex_digits[] = "0123456789ABCDEF";
+
+        put('"');
+
+        // Copy runs of characters that do not need escaping in one append
+        char const* run = str;
+        char const* end = str + length;
+        for (char const* p = str; p != end; ++p) {
+            auto c = static_cast<unsigned char>(*p);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            _buffer.append(run, p - run);
+            run = p + 1;
+
+            char escaped[6] = { '\\', 0 };
+            size_t escaped_length = 2;
+            switch (c) {
+                case '"':  escaped[1] = '"';  break;
+                case '\\': escaped[1] = '\\'; break;
+                case '\b': escaped[1] = 'b';  break;
+                case '\f': escaped[1] = 'f';  break;
+                case '\n': escaped[1] = 'n';  break;
+                case '\r': escaped[1] = 'r';  break;
+                case '\t': escaped[1] = 't';  break;
+                default:
+                    escaped[1] = 'u';
+                    escaped[2] = '0';
+                    escaped[3] = '0';
+                    escaped[4] = hex_digits[c >> 4];
+                    escaped[5] = hex_digits[c & 0xF];
+                    escaped_length = 6;
+                    break;
+            }
+            _buffer.append(escaped, escaped_length);
+        }
+        _buffer.append(run, end - run);
+        put('"');
+    }
+
+}}  // namespace facter::facts
@@ -1,13 +1,14 @@
 #include <internal/facts/linux/disk_resolver.hpp>
-#include <facter/util/file.hpp>
+#include <facter/facts/fact.hpp>
 #include <facter/util/directory.hpp>
+#include <internal/util/linux/attribute_reader.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/filesystem.hpp>
-#include <boost/algorithm/string.hpp>
 
 using namespace std;
 using namespace facter::util;
+using facter::util::linux::attribute_reader;
 using namespace boost::filesystem;
 using boost::lexical_cast;
 using boost::bad_lexical_cast;
@@ -29,46 +30,36 @@ namespace facter { namespace facts { namespace linux {
             return result;
         }
 
+        // Read each disk's attributes in one batch
+        attribute_reader attributes(root_directory);
         directory::each_subdirectory(root_directory, [&](string const& dir) {
-            path device_directory(dir);
-
             disk d;
-            d.name = device_directory.filename().string();
+            d.name = path(dir).filename().string();
+
+            // Skip disks that were not queried
+            if (!is_collected(fact::disks, { d.name })) {
+                return true;
+            }
 
             // Check for the device subdirectory's existence
-            path device_subdirectory = device_directory / "device";
-            boost::system::error_code ec;
-            if (!is_directory(device_subdirectory, ec)) {
+            if (!attributes.exists(d.name + "/device")) {
                 return true;
             }
 
-            string size_file_path = (device_directory / "size").string();
-            string vendor_file_path = (device_subdirectory / "vendor").string();
-            string model_file_path = (device_subdirectory / "model").string();
+            auto values = attributes.read_all({ d.name + "/size", d.name + "/device/vendor", d.name + "/device/model" });
 
             // Read the size of the block device
             // The size is in 512 byte blocks
-            if (is_regular_file(size_file_path, ec)) {
+            if (!values[0].empty()) {
                 try {
-                    string blocks = file::read(size_file_path);
-                    boost::trim(blocks);
-                    d.size = lexical_cast<uint64_t>(blocks) * block_size;
+                    d.size = lexical_cast<uint64_t>(values[0]) * block_size;
                 } catch (bad_lexical_cast& ex) {
                     LOG_DEBUG("size of disk %1% is invalid: size information is unavailable.", d.name);
                 }
             }
 
-            // Read the vendor fact
-            if (is_regular_file(vendor_file_path, ec)) {
-                d.vendor = file::read(vendor_file_path);
-                boost::trim(d.vendor);
-            }
-
-            // Read the model fact
-            if (is_regular_file(model_file_path, ec)) {
-                d.model = file::read(model_file_path);
-                boost::trim(d.model);
-            }
+            d.vendor = move(values[1]);
+            d.model = move(values[2]);
 
             result.disks.emplace_back(move(d));
             return true;
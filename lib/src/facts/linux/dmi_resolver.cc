@@ -1,51 +1,149 @@
 #include <internal/facts/linux/dmi_resolver.hpp>
+#include <internal/util/linux/attribute_reader.hpp>
 #include <leatherman/logging/logging.hpp>
-#include <facter/util/file.hpp>
-#include <boost/filesystem.hpp>
-#include <boost/algorithm/string.hpp>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
 
 using namespace std;
-using namespace facter::util;
-using namespace boost::filesystem;
-namespace bs = boost::system;
+using facter::util::smbios;
+using facter::util::linux::attribute_reader;
 
 namespace facter { namespace facts { namespace linux {
 
-    dmi_resolver::data dmi_resolver::collect_data(collection& facts)
+    // The SMBIOS structure types that DMI facts are decoded from
+    enum class structure_type : uint8_t
     {
-        data result;
-        result.bios_vendor          = read("/sys/class/dmi/id/bios_vendor");
-        result.bios_version         = read("/sys/class/dmi/id/bios_version");
-        result.bios_release_date    = read("/sys/class/dmi/id/bios_date");
-        result.board_asset_tag      = read("/sys/class/dmi/id/board_asset_tag");
-        result.board_manufacturer   = read("/sys/class/dmi/id/board_vendor");
-        result.board_product_name   = read("/sys/class/dmi/id/board_name");
-        result.board_serial_number  = read("/sys/class/dmi/id/board_serial");
-        result.chassis_asset_tag    = read("/sys/class/dmi/id/chassis_asset_tag");
-        result.manufacturer         = read("/sys/class/dmi/id/sys_vendor");
-        result.product_name         = read("/sys/class/dmi/id/product_name");
-        result.serial_number        = read("/sys/class/dmi/id/product_serial");
-        result.uuid                 = read("/sys/class/dmi/id/product_uuid");
-        result.chassis_type         = to_chassis_description(read("/sys/class/dmi/id/chassis_type"));
-        return result;
+        bios = 0,
+        system = 1,
+        baseboard = 2,
+        chassis = 3
+    };
+
+    static smbios::structure const* find(smbios const& tables, structure_type type)
+    {
+        return tables.find(static_cast<uint8_t>(type));
     }
 
-    string dmi_resolver::read(std::string const& path)
+    static string decode_uuid(smbios::structure const& system, uint16_t version)
     {
-        bs::error_code ec;
-        if (!is_regular_file(path, ec)) {
-            LOG_DEBUG("%1%: %2%.", path, ec.message());
+        // The UUID was added in SMBIOS 2.1
+        static const size_t uuid_offset = 0x08;
+        if (system.formatted.size() < uuid_offset + 16) {
             return {};
         }
+        auto bytes = system.formatted.data() + uuid_offset;
 
-        string value;
-        if (!file::read(path, value)) {
-            LOG_DEBUG("%1%: file could not be read.", path);
+        // All ones means the UUID is not present and all zeros means it is not set
+        bool all_ones = true;
+        bool all_zeros = true;
+        for (size_t i = 0; i < 16; ++i) {
+            all_ones = all_ones && bytes[i] == 0xFF;
+            all_zeros = all_zeros && bytes[i] == 0x00;
+        }
+        if (all_ones || all_zeros) {
             return {};
         }
 
-        boost::trim(value);
-        return value;
+        // Since SMBIOS 2.6 the first three fields are little-endian
+        static const int little_endian_order[] = { 3, 2, 1, 0, 5, 4, 7, 6, 8, 9, 10, 11, 12, 13, 14, 15 };
+        static const int big_endian_order[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+        auto order = version >= 0x0206 ? little_endian_order : big_endian_order;
+
+        string uuid;
+        char buffer[3];
+        for (size_t i = 0; i < 16; ++i) {
+            if (i == 4 || i == 6 || i == 8 || i == 10) {
+                uuid += '-';
+            }
+            snprintf(buffer, sizeof(buffer), "%02x", bytes[order[i]]);
+            uuid += buffer;
+        }
+        return uuid;
+    }
+
+    bool dmi_resolver::collect_smbios_data(smbios const& tables, data& result)
+    {
+        bool found = false;
+        if (auto bios = find(tables, structure_type::bios)) {
+            result.bios_vendor          = bios->text(0x04);
+            result.bios_version         = bios->text(0x05);
+            result.bios_release_date    = bios->text(0x08);
+            found = true;
+        }
+        if (auto system = find(tables, structure_type::system)) {
+            result.manufacturer         = system->text(0x04);
+            result.product_name         = system->text(0x05);
+            result.serial_number        = system->text(0x07);
+            result.uuid                 = decode_uuid(*system, tables.version());
+            found = true;
+        }
+        if (auto board = find(tables, structure_type::baseboard)) {
+            result.board_manufacturer   = board->text(0x04);
+            result.board_product_name   = board->text(0x05);
+            result.board_serial_number  = board->text(0x07);
+            result.board_asset_tag      = board->text(0x08);
+            found = true;
+        }
+        if (auto chassis = find(tables, structure_type::chassis)) {
+            // The high bit of the chassis type is the chassis lock
+            if (chassis->formatted.size() > 0x05) {
+                result.chassis_type     = to_chassis_description(to_string(chassis->byte(0x05) & 0x7F));
+            }
+            result.chassis_asset_tag    = chassis->text(0x08);
+            found = true;
+        }
+        return found;
+    }
+
+    dmi_resolver::data dmi_resolver::collect_data(collection& facts)
+    {
+        static string const tables_directory = "/sys/firmware/dmi/tables";
+        static string const root_directory = "/sys/class/dmi/id";
+
+        data result;
+
+        // Decode the SMBIOS table in one read; it is only readable by root, so fall back to the per-field sysfs attributes
+        smbios tables;
+        if (tables.read(tables_directory) && collect_smbios_data(tables, result)) {
+            return result;
+        }
+
+        attribute_reader attributes(root_directory);
+        if (!attributes) {
+            LOG_DEBUG("%1%: %2%: DMI facts are unavailable.", root_directory, strerror(errno));
+            return result;
+        }
+
+        auto values = attributes.read_all({
+            "bios_vendor",
+            "bios_version",
+            "bios_date",
+            "board_asset_tag",
+            "board_vendor",
+            "board_name",
+            "board_serial",
+            "chassis_asset_tag",
+            "sys_vendor",
+            "product_name",
+            "product_serial",
+            "product_uuid",
+            "chassis_type"
+        });
+        result.bios_vendor          = move(values[0]);
+        result.bios_version         = move(values[1]);
+        result.bios_release_date    = move(values[2]);
+        result.board_asset_tag      = move(values[3]);
+        result.board_manufacturer   = move(values[4]);
+        result.board_product_name   = move(values[5]);
+        result.board_serial_number  = move(values[6]);
+        result.chassis_asset_tag    = move(values[7]);
+        result.manufacturer         = move(values[8]);
+        result.product_name         = move(values[9]);
+        result.serial_number        = move(values[10]);
+        result.uuid                 = move(values[11]);
+        result.chassis_type         = to_chassis_description(values[12]);
+        return result;
     }
 
 }}}  // namespace facter::facts::linux
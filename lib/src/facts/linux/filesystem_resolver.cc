@@ -1,10 +1,17 @@
 #include <internal/facts/linux/filesystem_resolver.hpp>
 #include <internal/util/scoped_file.hpp>
+#include <internal/util/linux/attribute_reader.hpp>
+#include <facter/facts/fact.hpp>
 #include <facter/util/file.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/chrono.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <cstring>
 #include <mntent.h>
 #include <sys/vfs.h>
 #include <set>
@@ -17,6 +24,7 @@
 using namespace std;
 using namespace facter::facts;
 using namespace facter::util;
+using facter::util::linux::attribute_reader;
 using namespace boost::filesystem;
 
 using boost::lexical_cast;
@@ -27,41 +35,302 @@ namespace facter { namespace facts { namespace linux {
     filesystem_resolver::data filesystem_resolver::collect_data(collection& facts)
     {
         data result;
-        collect_mountpoint_data(result);
-        collect_filesystem_data(result);
-        collect_partition_data(result);
+
+        // Partitions report where they are mounted, so mountpoints are needed for either fact
+        if (is_collected(fact::mountpoints) || is_collected(fact::partitions)) {
+            collect_mountpoint_data(facts, result);
+        }
+        if (is_collected(fact::filesystems)) {
+            collect_filesystem_data(result);
+        }
+        if (is_collected(fact::partitions)) {
+            collect_partition_data(result);
+        }
         return result;
     }
 
-    void filesystem_resolver::collect_mountpoint_data(data& result)
+    void filesystem_resolver::collect_mountpoint_data(collection& facts, data& result)
     {
-        // Populate the mountpoint data
-        scoped_file file(setmntent("/etc/mtab", "r"));
-        if (!static_cast<FILE *>(file)) {
-            LOG_ERROR("setmntent failed: %1% (%2%): mountpoints are unavailable.", strerror(errno), errno);
-            return;
-        }
-        mntent entry;
-        char buffer[4096];
-        while (mntent *ptr = getmntent_r(file, &entry, buffer, sizeof(buffer))) {
-            // Skip over anything that doesn't map to a device
-            if (!boost::starts_with(ptr->mnt_fsname, "/dev/")) {
+        auto include = [&](string const& name, string const& filesystem) {
+            return is_included(facts, name, filesystem);
+        };
+
+        // Prefer mountinfo over mtab, which may be a stale file rather than a link to /proc/self/mounts
+        if (boost::filesystem::exists("/proc/self/mountinfo")) {
+            result.mountpoints = read_mountinfo("/proc/self/mountinfo", include);
+        } else {
+            scoped_file file(setmntent("/etc/mtab", "r"));
+            if (!static_cast<FILE *>(file)) {
+                LOG_ERROR("setmntent failed: %1% (%2%): mountpoints are unavailable.", strerror(errno), errno);
+                return;
+            }
+            mntent entry;
+            char buffer[4096];
+            while (mntent *ptr = getmntent_r(file, &entry, buffer, sizeof(buffer))) {
+                // Skip over anything that doesn't map to a device
+                if (!boost::starts_with(ptr->mnt_fsname, "/dev/") || !include(ptr->mnt_dir, ptr->mnt_type)) {
+                    continue;
+                }
+
+                mountpoint point;
+                point.name = ptr->mnt_dir;
+                point.device = ptr->mnt_fsname;
+                point.filesystem = ptr->mnt_type;
+                boost::split(point.options, ptr->mnt_opts, boost::is_any_of(","), boost::token_compress_on);
+                result.mountpoints.emplace_back(move(point));
+            }
+        }
+
+        // Only get the size of mountpoints that were queried
+        vector<mountpoint*> points;
+        for (auto& point : result.mountpoints) {
+            if (is_collected(fact::mountpoints, { point.name })) {
+                points.push_back(&point);
+            }
+        }
+        stat_mountpoints(points, statfs_threads, statfs_timeout);
+    }
+
+    static string unescape_mountinfo(char const* begin, char const* end)
+    {
+        // Whitespace and backslashes in paths are escaped as three octal digits (e.g. \040 for a space)
+        string result;
+        result.reserve(end - begin);
+        for (auto ptr = begin; ptr != end; ++ptr) {
+            if (*ptr == '\\' && end - ptr >= 4 &&
+                ptr[1] >= '0' && ptr[1] <= '3' &&
+                ptr[2] >= '0' && ptr[2] <= '7' &&
+                ptr[3] >= '0' && ptr[3] <= '7') {
+                result += static_cast<char>(((ptr[1] - '0') << 6) | ((ptr[2] - '0') << 3) | (ptr[3] - '0'));
+                ptr += 3;
                 continue;
             }
+            result += *ptr;
+        }
+        return result;
+    }
+
+    vector<filesystem_resolver::mountpoint> filesystem_resolver::read_mountinfo(string const& path, function<bool(string const&, string const&)> const& include)
+    {
+        vector<mountpoint> mountpoints;
+
+        // Each line is: ID parent major:minor root mountpoint options [optional fields...] - filesystem source super-options
+        vector<pair<char const*, char const*>> fields;
+        bool read = file::each_line_ref(path, [&](boost::string_ref line) {
+            auto line_end = line.end();
+            fields.clear();
+            for (auto field = line.begin(); field < line_end;) {
+                auto field_end = static_cast<char const*>(memchr(field, ' ', line_end - field));
+                if (!field_end) {
+                    field_end = line_end;
+                }
+                if (field_end != field) {
+                    fields.emplace_back(field, field_end);
+                }
+                field = field_end + 1;
+            }
+
+            // Find the separator that ends the optional fields
+            size_t separator = 6;
+            while (separator < fields.size() && !(fields[separator].second - fields[separator].first == 1 && *fields[separator].first == '-')) {
+                ++separator;
+            }
+            if (separator + 2 >= fields.size()) {
+                return true;
+            }
+
+            // Skip over anything that doesn't map to a device
+            auto const& source = fields[separator + 2];
+            if (source.second - source.first < 5 || strncmp(source.first, "/dev/", 5) != 0) {
+                return true;
+            }
 
             mountpoint point;
-            point.name = ptr->mnt_dir;
-            point.device = ptr->mnt_fsname;
-            point.filesystem = ptr->mnt_type;
-            boost::split(point.options, ptr->mnt_opts, boost::is_any_of(","), boost::token_compress_on);
+            point.name = unescape_mountinfo(fields[4].first, fields[4].second);
+            point.filesystem = unescape_mountinfo(fields[separator + 1].first, fields[separator + 1].second);
+            if (include && !include(point.name, point.filesystem)) {
+                return true;
+            }
+            point.device = unescape_mountinfo(source.first, source.second);
 
-            struct statfs stats;
-            if (statfs(ptr->mnt_dir, &stats) != -1) {
-                point.size = stats.f_frsize * stats.f_blocks;
-                point.available = stats.f_frsize * stats.f_bfree;
+            // Combine the options like /proc/mounts: the access mode, the generic super block flags,
+            // the per-mount options, and then the file system specific options
+            vector<string> mount_options;
+            boost::split(mount_options, fields[5], boost::is_any_of(","), boost::token_compress_on);
+            vector<string> super_options;
+            if (separator + 3 < fields.size()) {
+                boost::split(super_options, fields[separator + 3], boost::is_any_of(","), boost::token_compress_on);
+            }
+            static set<string> const super_block_flags = { "sync", "dirsync", "mand", "lazytime" };
+            bool read_only = (!mount_options.empty() && mount_options.front() == "ro") || (!super_options.empty() && super_options.front() == "ro");
+            point.options.emplace_back(read_only ? "ro" : "rw");
+            auto super_it = super_options.begin();
+            if (super_it != super_options.end() && (*super_it == "ro" || *super_it == "rw")) {
+                ++super_it;
+            }
+            for (; super_it != super_options.end() && super_block_flags.count(*super_it); ++super_it) {
+                point.options.emplace_back(move(*super_it));
+            }
+            auto mount_it = mount_options.begin();
+            if (mount_it != mount_options.end() && (*mount_it == "ro" || *mount_it == "rw")) {
+                ++mount_it;
+            }
+            for (; mount_it != mount_options.end(); ++mount_it) {
+                point.options.emplace_back(move(*mount_it));
+            }
+            for (; super_it != super_options.end(); ++super_it) {
+                point.options.emplace_back(move(*super_it));
+            }
+
+            mountpoints.emplace_back(move(point));
+            return true;
+        });
+        if (!read) {
+            LOG_ERROR("%1% could not be read: mountpoints are unavailable.", path);
+        }
+        return mountpoints;
+    }
+
+    // The state shared between run_with_deadlines and its threads
+    // Threads waiting on a hung device are abandoned, so the state outlives the call
+    struct deadline_batch
+    {
+        enum class status { pending, running, done, timed_out };
+
+        struct entry
+        {
+            string description;
+            function<void()> task;
+            status state;
+            boost::chrono::steady_clock::time_point started;
+        };
+
+        boost::mutex mutex;
+        boost::condition_variable changed;
+        vector<entry> entries;
+        size_t next;
+        size_t finished;
+    };
+
+    static void deadline_worker(shared_ptr<deadline_batch> batch)
+    {
+        boost::unique_lock<boost::mutex> lock(batch->mutex);
+        while (batch->next < batch->entries.size()) {
+            auto& entry = batch->entries[batch->next++];
+            entry.state = deadline_batch::status::running;
+            entry.started = boost::chrono::steady_clock::now();
+            auto task = entry.task;
+            lock.unlock();
+
+            task();
+
+            lock.lock();
+            if (entry.state == deadline_batch::status::timed_out) {
+                // This thread was replaced while it waited; let the replacement take the remaining tasks
+                return;
+            }
+            entry.state = deadline_batch::status::done;
+            ++batch->finished;
+            batch->changed.notify_all();
+        }
+    }
+
+    // Runs tasks on a pool of detached threads and returns which tasks missed their deadline
+    // Tasks must only write to state they share ownership of, since a timed out task may finish after this returns
+    static vector<char> run_with_deadlines(vector<pair<string, function<void()>>> tasks, unsigned int threads, uint32_t timeout, char const* what)
+    {
+        vector<char> timed_out(tasks.size(), 0);
+        if (tasks.empty()) {
+            return timed_out;
+        }
+
+        auto batch = make_shared<deadline_batch>();
+        batch->next = 0;
+        batch->finished = 0;
+        for (auto& task : tasks) {
+            batch->entries.push_back({ move(task.first), move(task.second), deadline_batch::status::pending, {} });
+        }
+
+        auto start_worker = [&]() {
+            try {
+                boost::thread(deadline_worker, batch).detach();
+                return true;
+            } catch (boost::thread_resource_error& ex) {
+                LOG_DEBUG("failed to start a thread to get %1%: %2%.", what, ex.what());
+                return false;
+            }
+        };
+
+        boost::unique_lock<boost::mutex> lock(batch->mutex);
+        size_t workers = 0;
+        for (size_t i = 0; i < max(threads, 1u) && i < batch->entries.size(); ++i) {
+            workers += start_worker() ? 1 : 0;
+        }
+        if (workers == 0) {
+            // Without threads, run the tasks on this thread (they cannot time out)
+            lock.unlock();
+            deadline_worker(batch);
+            lock.lock();
+        }
+
+        auto limit = boost::chrono::milliseconds(timeout);
+        while (batch->finished < batch->entries.size()) {
+            // Time out tasks that have taken too long and replace their threads
+            auto now = boost::chrono::steady_clock::now();
+            auto deadline = now + limit;
+            for (auto& entry : batch->entries) {
+                if (entry.state != deadline_batch::status::running) {
+                    continue;
+                }
+                if (now - entry.started >= limit) {
+                    LOG_WARNING("timed out getting %1% for %2% after %3% ms: the device may be unresponsive.", what, entry.description, timeout);
+                    entry.state = deadline_batch::status::timed_out;
+                    ++batch->finished;
+                    if (batch->next < batch->entries.size() && !start_worker()) {
+                        // Without a replacement thread, the remaining tasks are not waited for
+                        for (; batch->next < batch->entries.size(); ++batch->next) {
+                            batch->entries[batch->next].state = deadline_batch::status::timed_out;
+                            ++batch->finished;
+                        }
+                    }
+                    continue;
+                }
+                deadline = min(deadline, entry.started + limit);
+            }
+            if (batch->finished < batch->entries.size()) {
+                batch->changed.wait_until(lock, deadline);
             }
+        }
+
+        for (size_t i = 0; i < batch->entries.size(); ++i) {
+            timed_out[i] = batch->entries[i].state == deadline_batch::status::timed_out;
+        }
+        return timed_out;
+    }
+
+    void filesystem_resolver::stat_mountpoints(vector<mountpoint*> const& points, unsigned int threads, uint32_t timeout)
+    {
+        // The sizes are stored in shared state so that abandoned threads never write to the mountpoints
+        auto sizes = make_shared<vector<pair<uint64_t, uint64_t>>>(points.size());
+        vector<pair<string, function<void()>>> tasks;
+        for (size_t i = 0; i < points.size(); ++i) {
+            string path = points[i]->name;
+            tasks.emplace_back(path, [sizes, i, path]() {
+                struct statfs stats;
+                if (statfs(path.c_str(), &stats) != -1) {
+                    (*sizes)[i] = make_pair(static_cast<uint64_t>(stats.f_frsize * stats.f_blocks), static_cast<uint64_t>(stats.f_frsize * stats.f_bfree));
+                }
+            });
+        }
 
-            result.mountpoints.emplace_back(move(point));
+        auto timed_out = run_with_deadlines(move(tasks), threads, timeout, "the size of the mountpoint");
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (timed_out[i]) {
+                points[i]->timed_out = true;
+                continue;
+            }
+            points[i]->size = (*sizes)[i].first;
+            points[i]->available = (*sizes)[i].second;
         }
     }
 
@@ -81,99 +350,179 @@ namespace facter { namespace facts { namespace linux {
         });
     }
 
-    void filesystem_resolver::collect_partition_data(data& result)
+    static string decode_udev_value(string const& value)
+    {
+        // udev encodes unsafe characters in labels as \xHH
+        string result;
+        result.reserve(value.size());
+        for (size_t i = 0; i < value.size(); ++i) {
+            if (value[i] == '\\' && i + 3 < value.size() && value[i + 1] == 'x' && isxdigit(value[i + 2]) && isxdigit(value[i + 3])) {
+                result += static_cast<char>(stoi(value.substr(i + 2, 2), nullptr, 16));
+                i += 3;
+                continue;
+            }
+            result += value[i];
+        }
+        return result;
+    }
+
+    bool filesystem_resolver::read_udev_data(string const& path, partition& part)
+    {
+        bool found = false;
+        bool read = file::each_line(path, [&](string& line) {
+            if (!boost::starts_with(line, "E:ID_")) {
+                return true;
+            }
+            auto pos = line.find('=');
+            if (pos == string::npos) {
+                return true;
+            }
+            string key = line.substr(2, pos - 2);
+            string value = line.substr(pos + 1);
+            if (key == "ID_FS_TYPE") {
+                part.filesystem = move(value);
+            } else if (key == "ID_FS_LABEL_ENC") {
+                part.label = decode_udev_value(value);
+            } else if (key == "ID_FS_LABEL" && part.label.empty()) {
+                part.label = move(value);
+            } else if (key == "ID_FS_UUID") {
+                part.uuid = move(value);
+            } else if (key == "ID_PART_ENTRY_NAME") {
+                part.partition_label = decode_udev_value(value);
+            } else if (key == "ID_PART_ENTRY_UUID") {
+                part.partition_uuid = move(value);
+            } else {
+                return true;
+            }
+            found = true;
+            return true;
+        });
+        return read && found;
+    }
+
+    vector<filesystem_resolver::partition> filesystem_resolver::read_partitions(string const& block_directory, string const& udev_directory, function<bool(string const&)> const& include, vector<partition>& unprobed)
     {
-        // Only return partition data if we're using libblkid
-#ifdef USE_BLKID
         // The size of a block, in bytes, read in from /sys/class/block
-        const int block_size = 512;
+        const uint64_t block_size = 512;
 
-        // Get a default cache
-        blkid_cache cache;
-        if (blkid_get_cache(&cache, nullptr) < 0) {
-            LOG_ERROR("blkid_get_cache failed: %1% (%2%): partition data is unavailable.", strerror(errno), errno);
-            return;
+        vector<partition> partitions;
+        boost::system::error_code ec;
+        if (!is_directory(block_directory, ec)) {
+            return partitions;
         }
 
-        // Probe all block devices
-        if (blkid_probe_all(cache) < 0) {
-            blkid_put_cache(cache);
-            LOG_ERROR("blkid_probe_all failed: %1% (%2%): partition data is unavailable.", strerror(errno), errno);
-            return;
+        // Sort the devices so that partitions are reported in a stable order
+        vector<path> devices;
+        for (directory_iterator it(block_directory, ec), end; !ec && it != end; it.increment(ec)) {
+            devices.push_back(it->path());
         }
+        sort(devices.begin(), devices.end());
 
-        // Begin iteration
-        auto iter = blkid_dev_iterate_begin(cache);
-        if (!iter) {
-            blkid_put_cache(cache);
-            LOG_ERROR("blkid_dev_iterate_begin failed: %1% (%2%): partition data is unavailable.", strerror(errno), errno);
-            return;
-        }
+        attribute_reader attributes(block_directory);
+        for (auto const& device : devices) {
+            auto filename = device.filename().string();
+            auto values = attributes.read_all({ filename + "/dm/name", filename + "/size", filename + "/dev" });
 
-        // Populate a map of device -> mountpoint
-        map<string, string> device_mountpoints;
-        for (auto const& point : result.mountpoints) {
-            device_mountpoints.insert(make_pair(point.device, point.name));
-        }
+            // Device mapper devices are known by their mapped name
+            string name = values[0].empty() ? "/dev/" + filename : "/dev/mapper/" + values[0];
+            if (include && !include(name)) {
+                continue;
+            }
 
-        // Loop each block device
-        blkid_dev device;
-        while (blkid_dev_next(iter, &device) == 0) {
             partition part;
-            part.name = blkid_dev_devname(device);
-
-            // Populate the tags
-            blkid_tag_iterate tag_iter;
-            tag_iter = blkid_tag_iterate_begin(device);
-            if (tag_iter) {
-                const char* tag_name;
-                const char* tag_value;
-                while (blkid_tag_next(tag_iter, &tag_name, &tag_value) == 0) {
-                    string* ptr = nullptr;
-                    string attribute = tag_name;
-                    boost::to_lower(attribute);
-                    if (attribute == "type") {
-                        ptr = &part.filesystem;
-                    } else if (attribute == "label") {
-                        ptr = &part.label;
-                    } else if (attribute == "partlabel") {
-                        ptr = &part.partition_label;
-                    } else if (attribute == "uuid") {
-                        ptr = &part.uuid;
-                    } else if (attribute == "partuuid") {
-                        ptr = &part.partition_uuid;
-                    }
-                    if (!ptr) {
-                        continue;
-                    }
-                    (*ptr) = tag_value;
+            part.name = move(name);
+
+            // Devices without a size (e.g. unused loop devices) have nothing to report
+            try {
+                part.size = lexical_cast<uint64_t>(values[1]) * block_size;
+            } catch (bad_lexical_cast&) {
+            }
+            if (part.size == 0) {
+                continue;
+            }
+
+            // Look up the device in the udev database by its device number
+            // Devices on which udev found no file system or partition entry are not reported
+            auto const& number = values[2];
+            auto udev_path = path(udev_directory) / ("b" + number);
+            if (!number.empty() && exists(udev_path, ec)) {
+                if (read_udev_data(udev_path.string(), part)) {
+                    partitions.emplace_back(move(part));
                 }
-                blkid_tag_iterate_end(tag_iter);
+                continue;
             }
+            unprobed.emplace_back(move(part));
+        }
+        return partitions;
+    }
 
-            // Populate the size (the size is given in 512 byte blocks)
-            string blocks = file::read((path("/sys/class/block") / path(part.name).filename() / "/size").string());
-            boost::trim(blocks);
-            if (!blocks.empty()) {
-                try {
-                    part.size = lexical_cast<uint64_t>(blocks) * block_size;
-                } catch (bad_lexical_cast& ex) {
+    void filesystem_resolver::collect_partition_data(data& result)
+    {
+        // Read the partitions from sysfs and the udev database; only devices unknown to udev are probed
+        vector<partition> unprobed;
+        result.partitions = read_partitions("/sys/class/block", "/run/udev/data", [&](string const& name) {
+            return is_collected(fact::partitions, { name });
+        }, unprobed);
+
+#ifdef USE_BLKID
+        // Probe the devices concurrently so that slow or idle devices do not delay each other
+        auto probed = make_shared<vector<partition>>(unprobed);
+        vector<pair<string, function<void()>>> tasks;
+        for (size_t i = 0; i < unprobed.size(); ++i) {
+            tasks.emplace_back(unprobed[i].name, [probed, i]() {
+                auto& part = (*probed)[i];
+                auto probe = blkid_new_probe_from_filename(part.name.c_str());
+                if (!probe) {
+                    return;
                 }
+                blkid_probe_enable_superblocks(probe, 1);
+                blkid_probe_set_superblocks_flags(probe, BLKID_SUBLKS_LABEL | BLKID_SUBLKS_UUID | BLKID_SUBLKS_TYPE);
+                blkid_probe_enable_partitions(probe, 1);
+                blkid_probe_set_partitions_flags(probe, BLKID_PARTS_ENTRY_DETAILS);
+                if (blkid_do_safeprobe(probe) == 0) {
+                    static vector<pair<char const*, string partition::*>> const tags = {
+                        { "TYPE",       &partition::filesystem },
+                        { "LABEL",      &partition::label },
+                        { "UUID",       &partition::uuid },
+                        { "PART_ENTRY_NAME", &partition::partition_label },
+                        { "PART_ENTRY_UUID", &partition::partition_uuid },
+                    };
+                    for (auto const& tag : tags) {
+                        char const* value = nullptr;
+                        if (blkid_probe_lookup_value(probe, tag.first, &value, nullptr) == 0 && value) {
+                            part.*(tag.second) = value;
+                        }
+                    }
+                }
+                blkid_free_probe(probe);
+            });
+        }
+        auto timed_out = run_with_deadlines(move(tasks), probe_threads, probe_timeout, "partition information");
+        for (size_t i = 0; i < unprobed.size(); ++i) {
+            // Like devices in the udev database, only report devices with a file system or partition entry
+            auto& part = (*probed)[i];
+            if (timed_out[i] || (part.filesystem.empty() && part.uuid.empty() && part.label.empty() && part.partition_uuid.empty() && part.partition_label.empty())) {
+                continue;
             }
+            result.partitions.emplace_back(move(part));
+        }
+#else
+        if (!unprobed.empty()) {
+            LOG_INFO("partition information for %1% devices missing from the udev database is unavailable: facter was built without blkid support.", unprobed.size());
+        }
+#endif  // USE_BLKID
 
-            // Populate the mountpoint if there is one
+        // Populate the mountpoint of each partition
+        map<string, string> device_mountpoints;
+        for (auto const& point : result.mountpoints) {
+            device_mountpoints.insert(make_pair(point.device, point.name));
+        }
+        for (auto& part : result.partitions) {
             auto it = device_mountpoints.find(part.name);
             if (it != device_mountpoints.end()) {
                 part.mount = it->second;
             }
-
-            result.partitions.emplace_back(move(part));
         }
-        blkid_dev_iterate_end(iter);
-        blkid_put_cache(cache);
-#else
-        LOG_INFO("partition information is unavailable: facter was built without blkid support.");
-#endif  // USE_BLKID
     }
 
 }}}  // namespace facter::facts::linux
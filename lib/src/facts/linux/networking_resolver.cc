@@ -1,19 +1,470 @@
 #include <internal/facts/linux/networking_resolver.hpp>
 #include <internal/util/posix/scoped_descriptor.hpp>
+#include <facter/facts/collection.hpp>
+#include <facter/facts/fact.hpp>
+#include <facter/execution/execution.hpp>
+#include <facter/util/directory.hpp>
 #include <facter/util/file.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <boost/algorithm/string.hpp>
 #include <cstring>
+#include <map>
+#include <set>
+#include <arpa/inet.h>
+#include <netinet/in.h>
 #include <netpacket/packet.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 
 using namespace std;
 using namespace facter::util;
 using namespace facter::util::posix;
+using namespace facter::execution;
 
 namespace facter { namespace facts { namespace linux {
 
+    // The size of the buffer netlink dump responses are read into
+    static const size_t netlink_buffer_size = 32 * 1024;
+
+    template <typename Message>
+    static bool request_dump(int sock, uint16_t type, Message const& message, uint32_t sequence)
+    {
+        struct {
+            nlmsghdr header;
+            Message message;
+        } request;
+        memset(&request, 0, sizeof(request));
+        request.header.nlmsg_len = NLMSG_LENGTH(sizeof(Message));
+        request.header.nlmsg_type = type;
+        request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+        request.header.nlmsg_seq = sequence;
+        request.message = message;
+
+        sockaddr_nl kernel;
+        memset(&kernel, 0, sizeof(kernel));
+        kernel.nl_family = AF_NETLINK;
+        return sendto(sock, &request, request.header.nlmsg_len, 0, reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) == static_cast<ssize_t>(request.header.nlmsg_len);
+    }
+
+    static bool read_dump(int sock, uint32_t sequence, vector<char>& buffer, function<void(nlmsghdr const*)> const& callback)
+    {
+        while (true) {
+            auto received = recv(sock, buffer.data(), buffer.size(), 0);
+            if (received < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (received == 0) {
+                return false;
+            }
+
+            // Each read returns one or more messages of the dump; the dump ends with NLMSG_DONE
+            int length = static_cast<int>(received);
+            for (auto header = reinterpret_cast<nlmsghdr const*>(buffer.data()); NLMSG_OK(header, length); header = NLMSG_NEXT(header, length)) {
+                if (header->nlmsg_seq != sequence) {
+                    continue;
+                }
+                if (header->nlmsg_type == NLMSG_DONE) {
+                    return true;
+                }
+                if (header->nlmsg_type == NLMSG_ERROR) {
+                    auto error = reinterpret_cast<nlmsgerr const*>(NLMSG_DATA(header));
+                    errno = error->error ? -error->error : EIO;
+                    return false;
+                }
+                callback(header);
+            }
+        }
+    }
+
+    static sockaddr_storage make_address(int family, void const* bytes)
+    {
+        sockaddr_storage address;
+        memset(&address, 0, sizeof(address));
+        address.ss_family = family;
+        if (family == AF_INET) {
+            memcpy(&reinterpret_cast<sockaddr_in*>(&address)->sin_addr, bytes, sizeof(in_addr));
+        } else {
+            memcpy(&reinterpret_cast<sockaddr_in6*>(&address)->sin6_addr, bytes, sizeof(in6_addr));
+        }
+        return address;
+    }
+
+    static sockaddr_storage make_netmask(int family, unsigned int prefix_length)
+    {
+        uint8_t bytes[sizeof(in6_addr)] = {};
+        size_t size = family == AF_INET ? sizeof(in_addr) : sizeof(in6_addr);
+        for (size_t i = 0; i < size && prefix_length > 0; ++i) {
+            auto bits = min(prefix_length, 8u);
+            bytes[i] = static_cast<uint8_t>(0xFF << (8 - bits));
+            prefix_length -= bits;
+        }
+        return make_address(family, bytes);
+    }
+
+    bool networking_resolver::collect_netlink_data(collection& facts, data& result)
+    {
+        scoped_descriptor sock(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE));
+        if (static_cast<int>(sock) < 0) {
+            LOG_DEBUG("netlink socket failed: %1% (%2%): falling back to getifaddrs.", strerror(errno), errno);
+            return false;
+        }
+
+        vector<char> buffer(netlink_buffer_size);
+        uint32_t sequence = 0;
+
+        // Dump the links for the name, MTU and MAC address of every interface
+        map<int, interface> links;
+        set<string> non_dhcp;
+        ifinfomsg link_request;
+        memset(&link_request, 0, sizeof(link_request));
+        link_request.ifi_family = AF_UNSPEC;
+        bool success = request_dump(sock, RTM_GETLINK, link_request, ++sequence) &&
+            read_dump(sock, sequence, buffer, [&](nlmsghdr const* header) {
+                if (header->nlmsg_type != RTM_NEWLINK) {
+                    return;
+                }
+                auto info = reinterpret_cast<ifinfomsg const*>(NLMSG_DATA(header));
+                interface iface;
+                string kind;
+                int length = IFLA_PAYLOAD(header);
+                for (auto attribute = IFLA_RTA(info); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+                    if (attribute->rta_type == IFLA_LINKINFO) {
+                        int info_length = RTA_PAYLOAD(attribute);
+                        for (auto nested = reinterpret_cast<rtattr const*>(RTA_DATA(attribute)); RTA_OK(nested, info_length); nested = RTA_NEXT(nested, info_length)) {
+                            if (nested->rta_type == IFLA_INFO_KIND) {
+                                kind.assign(reinterpret_cast<char const*>(RTA_DATA(nested)), strnlen(reinterpret_cast<char const*>(RTA_DATA(nested)), RTA_PAYLOAD(nested)));
+                            }
+                        }
+                    } else if (attribute->rta_type == IFLA_IFNAME) {
+                        iface.name = reinterpret_cast<char const*>(RTA_DATA(attribute));
+                    } else if (attribute->rta_type == IFLA_MTU && RTA_PAYLOAD(attribute) >= sizeof(uint32_t)) {
+                        iface.mtu = *reinterpret_cast<uint32_t const*>(RTA_DATA(attribute));
+                    } else if (attribute->rta_type == IFLA_ADDRESS && RTA_PAYLOAD(attribute) == 6) {
+                        iface.macaddress = macaddress_to_string(reinterpret_cast<uint8_t const*>(RTA_DATA(attribute)));
+                    }
+                }
+                // Filtered interfaces are dropped along with their addresses
+                if (iface.name.empty() || !is_included(facts, iface.name)) {
+                    return;
+                }
+                if ((info->ifi_flags & IFF_LOOPBACK) || !is_dhcp_kind(kind)) {
+                    non_dhcp.insert(iface.name);
+                }
+                links.emplace(info->ifi_index, move(iface));
+            });
+
+        // Dump the addresses of every interface
+        struct address
+        {
+            int index;
+            string label;
+            sockaddr_storage ip;
+            sockaddr_storage netmask;
+        };
+        vector<address> addresses;
+        ifaddrmsg address_request;
+        memset(&address_request, 0, sizeof(address_request));
+        address_request.ifa_family = AF_UNSPEC;
+        success = success && request_dump(sock, RTM_GETADDR, address_request, ++sequence) &&
+            read_dump(sock, sequence, buffer, [&](nlmsghdr const* header) {
+                if (header->nlmsg_type != RTM_NEWADDR) {
+                    return;
+                }
+                auto info = reinterpret_cast<ifaddrmsg const*>(NLMSG_DATA(header));
+                if (info->ifa_family != AF_INET && info->ifa_family != AF_INET6) {
+                    return;
+                }
+                size_t size = info->ifa_family == AF_INET ? sizeof(in_addr) : sizeof(in6_addr);
+
+                // Like getifaddrs, prefer the local address (the address is the peer on point-to-point links)
+                // and name IPv4 addresses after their label so that aliases are reported as interfaces
+                void const* local = nullptr;
+                void const* addr = nullptr;
+                address entry;
+                entry.index = info->ifa_index;
+                int length = IFA_PAYLOAD(header);
+                for (auto attribute = IFA_RTA(info); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+                    if (attribute->rta_type == IFA_LOCAL && RTA_PAYLOAD(attribute) == size) {
+                        local = RTA_DATA(attribute);
+                    } else if (attribute->rta_type == IFA_ADDRESS && RTA_PAYLOAD(attribute) == size) {
+                        addr = RTA_DATA(attribute);
+                    } else if (attribute->rta_type == IFA_LABEL && info->ifa_family == AF_INET) {
+                        entry.label = reinterpret_cast<char const*>(RTA_DATA(attribute));
+                    }
+                }
+                if (!local && !addr) {
+                    return;
+                }
+                entry.ip = make_address(info->ifa_family, local ? local : addr);
+                entry.netmask = make_netmask(info->ifa_family, info->ifa_prefixlen);
+                addresses.emplace_back(move(entry));
+            });
+
+        // Dump the IPv4 routes of the main table for the default route
+        int default_index = 0;
+        rtmsg route_request;
+        memset(&route_request, 0, sizeof(route_request));
+        route_request.rtm_family = AF_INET;
+        success = success && request_dump(sock, RTM_GETROUTE, route_request, ++sequence) &&
+            read_dump(sock, sequence, buffer, [&](nlmsghdr const* header) {
+                if (header->nlmsg_type != RTM_NEWROUTE || default_index) {
+                    return;
+                }
+                auto info = reinterpret_cast<rtmsg const*>(NLMSG_DATA(header));
+                if (info->rtm_family != AF_INET || info->rtm_dst_len != 0 || info->rtm_table != RT_TABLE_MAIN) {
+                    return;
+                }
+                int length = RTM_PAYLOAD(header);
+                for (auto attribute = RTM_RTA(info); RTA_OK(attribute, length); attribute = RTA_NEXT(attribute, length)) {
+                    if (attribute->rta_type == RTA_OIF && RTA_PAYLOAD(attribute) >= sizeof(int)) {
+                        default_index = *reinterpret_cast<int const*>(RTA_DATA(attribute));
+                    }
+                }
+            });
+
+        if (!success) {
+            LOG_DEBUG("netlink request failed: %1% (%2%): falling back to getifaddrs.", strerror(errno), errno);
+            return false;
+        }
+
+        // Group the addresses by interface name; interfaces are reported in name order
+        map<string, interface> interfaces;
+        map<string, vector<address const*>> interface_addresses;
+        for (auto const& kvp : links) {
+            if (!is_collected(fact::networking, { "interfaces", kvp.second.name })) {
+                continue;
+            }
+            if (kvp.first == default_index) {
+                result.primary_interface = kvp.second.name;
+            }
+            interfaces.emplace(kvp.second.name, kvp.second);
+        }
+        for (auto const& addr : addresses) {
+            auto link = links.find(addr.index);
+            if (link == links.end()) {
+                continue;
+            }
+            string const& name = addr.label.empty() ? link->second.name : addr.label;
+            if (!is_collected(fact::networking, { "interfaces", name }) || !is_included(facts, name)) {
+                continue;
+            }
+            auto& iface = interfaces[name];
+            iface.name = name;
+            interface_addresses[name].push_back(&addr);
+        }
+
+        if (result.primary_interface.empty()) {
+            LOG_DEBUG("no primary interface found: using first interface with an assigned address.");
+        }
+
+        // Only the interfaces that could have been configured by DHCP bound the search for leases
+        set<string> names;
+        for (auto const& kvp : interfaces) {
+            if (!non_dhcp.count(kvp.first) && !non_dhcp.count(kvp.first.substr(0, kvp.first.find(':')))) {
+                names.insert(kvp.first);
+            }
+        }
+        auto dhcp_servers = find_dhcp_servers(names);
+
+        // Ask dhcpcd for the interfaces without a lease that could have been configured by DHCP; it is run once per interface
+        if (facts.command_fallbacks()) {
+            vector<string> unleased;
+            for (auto const& kvp : interfaces) {
+                if (!dhcp_servers.count(kvp.first) && !non_dhcp.count(kvp.first) && !non_dhcp.count(kvp.first.substr(0, kvp.first.find(':')))) {
+                    unleased.push_back(kvp.first);
+                }
+            }
+            for (auto& kvp : find_dhcpcd_servers("dhcpcd", unleased)) {
+                dhcp_servers.emplace(kvp.first, move(kvp.second));
+            }
+        }
+
+        for (auto& kvp : interfaces) {
+            auto& iface = kvp.second;
+            auto const& addrs = interface_addresses[kvp.first];
+
+            // If there's no primary interface, treat the first interface with a non-loopback network as primary
+            if (result.primary_interface.empty()) {
+                for (auto addr : addrs) {
+                    string network = address_to_string(reinterpret_cast<sockaddr const*>(&addr->ip), reinterpret_cast<sockaddr const*>(&addr->netmask));
+                    if (!boost::starts_with(network, "127.") && network != "::1" && !boost::starts_with(network, "fe80")) {
+                        result.primary_interface = iface.name;
+                        break;
+                    }
+                }
+            }
+
+            // The last address of each family is reported, along with the netmask and network of the first
+            for (auto addr : addrs) {
+                auto ip = reinterpret_cast<sockaddr const*>(&addr->ip);
+                auto netmask = reinterpret_cast<sockaddr const*>(&addr->netmask);
+                bool v4 = ip->sa_family == AF_INET;
+                (v4 ? iface.address.v4 : iface.address.v6) = address_to_string(ip);
+                auto& mask = v4 ? iface.netmask.v4 : iface.netmask.v6;
+                if (mask.empty()) {
+                    mask = address_to_string(netmask);
+                    (v4 ? iface.network.v4 : iface.network.v6) = address_to_string(ip, netmask);
+                }
+            }
+
+            auto dhcp_server_it = dhcp_servers.find(iface.name);
+            if (dhcp_server_it != dhcp_servers.end()) {
+                iface.dhcp_server = dhcp_server_it->second;
+            }
+
+            result.interfaces.emplace_back(move(iface));
+        }
+        return true;
+    }
+
+    map<string, string> networking_resolver::find_dhcp_servers(set<string> const& interfaces) const
+    {
+        // Start with the dhclient leases, then add the leases of systemd-networkd and dhcpcd
+        auto servers = bsd::networking_resolver::find_dhcp_servers(interfaces);
+
+        for (auto const& kvp : find_networkd_dhcp_servers("/run/systemd/netif/leases")) {
+            char name[IF_NAMESIZE] = {};
+            if (if_indextoname(static_cast<unsigned int>(kvp.first), name)) {
+                servers.emplace(name, kvp.second);
+            }
+        }
+
+        for (auto const& dir : { "/var/lib/dhcpcd", "/var/lib/dhcpcd5" }) {
+            for (auto& kvp : find_dhcpcd_lease_servers(dir)) {
+                servers.emplace(kvp.first, move(kvp.second));
+            }
+        }
+        return servers;
+    }
+
+    map<string, string> networking_resolver::find_dhcpcd_servers(string const& dhcpcd, vector<string> const& interfaces)
+    {
+        map<string, string> servers;
+        if (interfaces.empty() || execution::which(dhcpcd).empty()) {
+            return servers;
+        }
+
+        // Without an interface, dhcpcd -U only dumps the lease of the first interface it finds
+        for (auto const& interface : interfaces) {
+            execution::each_line(dhcpcd, { "-U", interface }, [&](string& line) {
+                if (boost::starts_with(line, "dhcp_server_identifier=")) {
+                    string server = line.substr(23);
+                    boost::trim_if(server, boost::is_any_of("'\" "));
+                    servers.emplace(interface, move(server));
+                    return false;
+                }
+                return true;
+            });
+        }
+        return servers;
+    }
+
+    bool networking_resolver::is_dhcp_kind(string const& kind)
+    {
+        // Virtual links that are never configured by a DHCP client
+        static const set<string> non_dhcp_kinds = {
+            "bridge",
+            "tun",
+            "veth",
+        };
+        return !non_dhcp_kinds.count(kind);
+    }
+
+    map<int, string> networking_resolver::find_networkd_dhcp_servers(string const& directory)
+    {
+        // Each lease file is named after the interface index and contains KEY=VALUE lines
+        map<int, string> servers;
+        directory::each_file(directory, [&](string const& path) {
+            int index = 0;
+            try {
+                index = stoi(path.substr(path.find_last_of('/') + 1));
+            } catch (logic_error&) {
+                return true;
+            }
+            file::each_line(path, [&](string& line) {
+                if (boost::starts_with(line, "SERVER_ADDRESS=")) {
+                    string server = line.substr(15);
+                    boost::trim(server);
+                    if (!server.empty()) {
+                        servers.emplace(index, move(server));
+                    }
+                    return false;
+                }
+                return true;
+            });
+            return true;
+        }, "^[0-9]+$");
+        return servers;
+    }
+
+    map<string, string> networking_resolver::find_dhcpcd_lease_servers(string const& directory)
+    {
+        // dhcpcd stores each lease as the DHCP message received from the server in <interface>.lease
+        // (dhcpcd-<interface>.lease for older versions)
+        static const size_t options_offset = 240;
+        static const uint8_t magic_cookie[] = { 99, 130, 83, 99 };
+        static const uint8_t option_pad = 0;
+        static const uint8_t option_server_identifier = 54;
+        static const uint8_t option_end = 255;
+
+        map<string, string> servers;
+        directory::each_file(directory, [&](string const& path) {
+            string name = path.substr(path.find_last_of('/') + 1);
+            name = name.substr(0, name.size() - 6);
+            if (boost::starts_with(name, "dhcpcd-")) {
+                name = name.substr(7);
+            }
+
+            string contents;
+            if (!file::read(path, contents) || contents.size() < options_offset ||
+                memcmp(contents.data() + options_offset - sizeof(magic_cookie), magic_cookie, sizeof(magic_cookie)) != 0) {
+                LOG_DEBUG("\"%1%\" is not a DHCP lease file.", path);
+                return true;
+            }
+
+            auto bytes = reinterpret_cast<uint8_t const*>(contents.data());
+            for (size_t offset = options_offset; offset < contents.size();) {
+                auto option = bytes[offset++];
+                if (option == option_pad) {
+                    continue;
+                }
+                if (option == option_end || offset >= contents.size()) {
+                    break;
+                }
+                size_t length = bytes[offset++];
+                if (offset + length > contents.size()) {
+                    break;
+                }
+                if (option == option_server_identifier && length == sizeof(in_addr)) {
+                    char buffer[INET_ADDRSTRLEN] = {};
+                    if (inet_ntop(AF_INET, bytes + offset, buffer, sizeof(buffer))) {
+                        servers.emplace(move(name), buffer);
+                    }
+                    break;
+                }
+                offset += length;
+            }
+            return true;
+        }, "^.+\\.lease$");
+        return servers;
+    }
+
+    networking_resolver::data networking_resolver::collect_data(collection& facts)
+    {
+        // Use rtnetlink to dump the links, addresses and routes in a few requests
+        auto result = posix::networking_resolver::collect_data(facts);
+        if (collect_netlink_data(facts, result)) {
+            return result;
+        }
+        return bsd::networking_resolver::collect_data(facts);
+    }
+
     bool networking_resolver::is_link_address(sockaddr const* addr) const
     {
         return addr && addr->sa_family == AF_PACKET;
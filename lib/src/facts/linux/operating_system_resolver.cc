@@ -13,6 +13,8 @@
 #include <facter/util/file.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cctype>
 #include <map>
 #include <vector>
 #include <tuple>
@@ -96,38 +98,130 @@ namespace facter { namespace facts { namespace linux {
         return result;
     }
 
+    static string get_first_line(string const& path)
+    {
+        string first;
+        file::each_line(path, [&](string& line) {
+            first = move(line);
+            return false;
+        });
+        boost::trim(first);
+        return first;
+    }
+
+    void operating_system_resolver::collect_lsb_data(string const& root, data& result)
+    {
+        // Read os-release the way Debian's lsb_release does: a capitalized ID, unless NAME differs from it only in case
+        auto os_release = root + release_file::os;
+        boost::system::error_code ec;
+        if (!is_regular_file(os_release, ec)) {
+            os_release = root + "/usr/lib/os-release";
+        }
+        auto values = os_linux::key_value_file(os_release, { "ID", "NAME", "PRETTY_NAME", "VERSION_ID", "VERSION_CODENAME" });
+        auto id = values["ID"];
+        if (!id.empty()) {
+            id[0] = static_cast<char>(toupper(static_cast<unsigned char>(id[0])));
+            auto const& name = values["NAME"];
+            result.distro.id = boost::iequals(id, name) ? name : id;
+        }
+        if (!values["PRETTY_NAME"].empty()) {
+            result.distro.description = values["PRETTY_NAME"];
+        }
+        if (!values["VERSION_ID"].empty()) {
+            result.distro.release = values["VERSION_ID"];
+        }
+        if (!values["VERSION_CODENAME"].empty()) {
+            result.distro.codename = values["VERSION_CODENAME"];
+        }
+
+        // Red Hat's lsb_release describes the distribution with the release file (e.g. "CentOS Linux release 7.9.2009 (Core)")
+        // The ID is the text before "release" without "Linux" or spaces, and the codename is the parenthesized text without spaces
+        static boost::regex release_regex("^(.+?)\\s+release\\s+(\\S+)(?:\\s+\\((.*)\\))?");
+        for (auto path : { release_file::redhat, release_file::amazon }) {
+            auto description = get_first_line(root + path);
+            string distributor, version, codename;
+            if (!re_search(description, release_regex, &distributor, &version, &codename)) {
+                continue;
+            }
+            boost::erase_all(distributor, "Linux");
+            boost::erase_all(distributor, " ");
+            boost::erase_all(codename, " ");
+            result.distro.id = move(distributor);
+            result.distro.description = move(description);
+            result.distro.release = move(version);
+            result.distro.codename = move(codename);
+            break;
+        }
+
+        // The lsb-release file takes precedence (e.g. Ubuntu and Linux Mint)
+        values = os_linux::key_value_file(root + release_file::lsb, { "LSB_VERSION", "DISTRIB_ID", "DISTRIB_DESCRIPTION", "DISTRIB_RELEASE", "DISTRIB_CODENAME" });
+        if (!values["DISTRIB_ID"].empty()) {
+            result.distro.id = values["DISTRIB_ID"];
+        }
+        if (!values["DISTRIB_DESCRIPTION"].empty()) {
+            result.distro.description = values["DISTRIB_DESCRIPTION"];
+        }
+        if (!values["DISTRIB_RELEASE"].empty()) {
+            result.distro.release = values["DISTRIB_RELEASE"];
+        }
+        if (!values["DISTRIB_CODENAME"].empty()) {
+            result.distro.codename = values["DISTRIB_CODENAME"];
+        }
+
+        // The specification version lists the installed LSB modules, each of which has a file in lsb-release.d
+        result.specification_version = values["LSB_VERSION"];
+        vector<string> modules;
+        for (directory_iterator it(root + "/etc/lsb-release.d", ec), end; !ec && it != end; it.increment(ec)) {
+            modules.push_back(it->path().filename().string());
+        }
+        sort(modules.begin(), modules.end());
+        for (auto const& module : modules) {
+            result.specification_version += ":" + module;
+        }
+    }
+
+    void operating_system_resolver::parse_lsb_release(string const& line, data& result)
+    {
+        string* variable = nullptr;
+        size_t offset = 0;
+        if (boost::starts_with(line, "LSB Version:")) {
+            variable = &result.specification_version;
+            offset = 12;
+        } else if (boost::starts_with(line, "Distributor ID:")) {
+            variable = &result.distro.id;
+            offset = 15;
+        } else if (boost::starts_with(line, "Description:")) {
+            variable = &result.distro.description;
+            offset = 12;
+        } else if (boost::starts_with(line, "Codename:")) {
+            variable = &result.distro.codename;
+            offset = 9;
+        } else if (boost::starts_with(line, "Release:")) {
+            variable = &result.distro.release;
+            offset = 8;
+        }
+        if (!variable) {
+            return;
+        }
+        auto value = boost::trim_copy(line.substr(offset));
+        if (value != "n/a") {
+            *variable = move(value);
+        }
+    }
+
     operating_system_resolver::data operating_system_resolver::collect_data(collection& facts)
     {
         // Default to the base implementation
         data result = posix::operating_system_resolver::collect_data(facts);
 
-        // Populate distro info
-        execution::each_line("lsb_release", {"-a"}, [&](string& line) {
-            string* variable = nullptr;
-            size_t offset = 0;
-            if (boost::starts_with(line, "LSB Version:")) {
-                variable = &result.specification_version;
-                offset = 12;
-            } else if (boost::starts_with(line, "Distributor ID:")) {
-                variable = &result.distro.id;
-                offset = 15;
-            } else if (boost::starts_with(line, "Description:")) {
-                variable = &result.distro.description;
-                offset = 12;
-            } else if (boost::starts_with(line, "Codename:")) {
-                variable = &result.distro.codename;
-                offset = 9;
-            } else if (boost::starts_with(line, "Release:")) {
-                variable = &result.distro.release;
-                offset = 8;
-            }
-            if (!variable) {
+        // Populate distro info from the release files; lsb_release is slow to start (it is often a Python script)
+        collect_lsb_data({}, result);
+        if (result.distro.id.empty() && facts.command_fallbacks()) {
+            execution::each_line("lsb_release", {"-a"}, [&](string& line) {
+                parse_lsb_release(line, result);
                 return true;
-            }
-            *variable = line.substr(offset);
-            boost::trim(*variable);
-            return true;
-        });
+            });
+        }
 
         auto implementation = get_os();
         auto name = implementation->get_name(result.distro.id);
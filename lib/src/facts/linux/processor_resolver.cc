@@ -4,70 +4,162 @@
 #include <facter/facts/os.hpp>
 #include <facter/facts/scalar_value.hpp>
 #include <facter/util/file.hpp>
-#include <facter/util/directory.hpp>
+#include <internal/util/linux/attribute_reader.hpp>
 #include <boost/algorithm/string.hpp>
-#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
 #include <unordered_set>
 
 using namespace std;
 using namespace facter::util;
-using namespace boost::filesystem;
+using facter::util::linux::attribute_reader;
+using boost::lexical_cast;
+using boost::bad_lexical_cast;
 
 namespace facter { namespace facts { namespace linux {
 
-    processor_resolver::data processor_resolver::collect_data(collection& facts)
+    static boost::string_ref trim(boost::string_ref value)
     {
-        auto result = posix::processor_resolver::collect_data(facts);
+        while (!value.empty() && isspace(static_cast<unsigned char>(value.front()))) {
+            value.remove_prefix(1);
+        }
+        while (!value.empty() && isspace(static_cast<unsigned char>(value.back()))) {
+            value.remove_suffix(1);
+        }
+        return value;
+    }
 
-        unordered_set<string> cpus;
-        directory::each_subdirectory("/sys/devices/system/cpu", [&](string const& cpu_directory) {
+    vector<bool> processor_resolver::parse_cpu_list(string const& list)
+    {
+        vector<bool> mask;
+        vector<string> ranges;
+        boost::split(ranges, list, boost::is_any_of(","), boost::token_compress_on);
+        for (auto& range : ranges) {
+            boost::trim(range);
+            if (range.empty()) {
+                continue;
+            }
+            auto pos = range.find('-');
+            try {
+                auto first = lexical_cast<size_t>(range.substr(0, pos));
+                auto last = pos == string::npos ? first : lexical_cast<size_t>(range.substr(pos + 1));
+                if (last < first) {
+                    continue;
+                }
+                if (mask.size() <= last) {
+                    mask.resize(last + 1);
+                }
+                fill(mask.begin() + first, mask.begin() + last + 1, true);
+            } catch (bad_lexical_cast&) {
+            }
+        }
+        return mask;
+    }
+
+    bool processor_resolver::collect_topology(string const& root, data& result)
+    {
+        attribute_reader attributes(root);
+        auto present = parse_cpu_list(attributes.read("present"));
+        if (present.empty()) {
+            return false;
+        }
+
+        // Each package's CPUs are covered by reading the package's CPU list once
+        vector<bool> covered(present.size());
+        for (size_t cpu = 0; cpu < present.size(); ++cpu) {
+            if (!present[cpu]) {
+                continue;
+            }
             ++result.logical_count;
-            string id = file::read((path(cpu_directory) / "/topology/physical_package_id").string());
-            boost::trim(id);
-            if (id.empty() || cpus.emplace(move(id)).second) {
-                // Haven't seen this processor before
-                ++result.physical_count;
+            if (covered[cpu]) {
+                continue;
             }
-            return true;
-        }, "^cpu\\d+$");
+            ++result.physical_count;
 
-        // To determine model information, parse /proc/cpuinfo
-        bool have_counts = result.logical_count > 0;
-        string id;
-        file::each_line("/proc/cpuinfo", [&](string& line) {
-            // Split the line on colon
-            auto pos = line.find(":");
-            if (pos == string::npos) {
+            // Older kernels only have the core siblings list; CPUs whose topology is unavailable (e.g. offline CPUs)
+            // are counted as their own package
+            auto topology = "cpu" + to_string(cpu) + "/topology/";
+            string siblings;
+            if (!attributes.read(topology + "package_cpus_list", siblings)) {
+                attributes.read(topology + "core_siblings_list", siblings);
+            }
+            auto package = parse_cpu_list(siblings);
+            for (size_t sibling = 0; sibling < package.size() && sibling < covered.size(); ++sibling) {
+                if (package[sibling]) {
+                    covered[sibling] = true;
+                }
+            }
+        }
+        return true;
+    }
+
+    bool processor_resolver::collect_cpuinfo(string const& path, data& result, bool collect_counts)
+    {
+        bool in_processor = false;
+        unordered_set<string> packages;
+        return file::each_line_ref(path, [&](boost::string_ref line) {
+            // Only the keys of interest are split from their values
+            auto pos = line.find(':');
+            if (pos == boost::string_ref::npos) {
                 return true;
             }
-            string key = line.substr(0, pos);
-            boost::trim(key);
-            string value = line.substr(pos + 1);
-            boost::trim(value);
+            auto key = trim(line.substr(0, pos));
+            auto value = trim(line.substr(pos + 1));
 
             if (key == "processor") {
                 // Start of a logical processor
-                id = move(value);
-                if (!have_counts) {
+                in_processor = !value.empty();
+                if (collect_counts) {
                     ++result.logical_count;
                 }
-            } else if (!id.empty() && key == "model name") {
-                // Add the model for this logical processor
-                result.models.emplace_back(move(value));
-            } else if (!have_counts && key == "physical id" && cpus.emplace(move(value)).second) {
+            } else if (in_processor && key == "model name") {
+                // Processors almost always share a model, so check the last model before searching the table
+                size_t index = result.model_names.size();
+                if (!result.model_indexes.empty() && value == result.model_names[result.model_indexes.back()]) {
+                    index = result.model_indexes.back();
+                } else {
+                    for (size_t i = 0; i < result.model_names.size(); ++i) {
+                        if (value == result.model_names[i]) {
+                            index = i;
+                            break;
+                        }
+                    }
+                    if (index == result.model_names.size()) {
+                        result.model_names.emplace_back(value.data(), value.size());
+                    }
+                }
+                result.model_indexes.push_back(index);
+            } else if (collect_counts && key == "physical id" && packages.emplace(value.data(), value.size()).second) {
                 // Couldn't determine physical count from sysfs, but CPU topology is present, so use it
                 ++result.physical_count;
             }
             return true;
         });
+    }
+
+    processor_resolver::data processor_resolver::collect_data(collection& facts)
+    {
+        auto result = posix::processor_resolver::collect_data(facts);
+
+        // Only collect the data for the queried elements
+        bool collect_counts = is_collected(fact::processors, { "count" }) || is_collected(fact::processors, { "physicalcount" });
+        bool collect_models = is_collected(fact::processors, { "models" });
+
+        bool have_counts = !collect_counts || collect_topology("/sys/devices/system/cpu", result);
+
+        // To determine model information, parse /proc/cpuinfo
+        if (collect_models || !have_counts) {
+            collect_cpuinfo("/proc/cpuinfo", result, !have_counts);
+        }
 
         // Read in the max speed from the first cpu
         // The speed is in kHz
-        string speed = file::read("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq");
-        if (!speed.empty()) {
-            try {
-                result.speed = stoi(speed) * static_cast<int64_t>(1000);
-            } catch (invalid_argument&) {
+        if (is_collected(fact::processors, { "speed" })) {
+            string speed = attribute_reader("/sys/devices/system/cpu").read("cpu0/cpufreq/cpuinfo_max_freq");
+            if (!speed.empty()) {
+                try {
+                    result.speed = stoi(speed) * static_cast<int64_t>(1000);
+                } catch (invalid_argument&) {
+                }
             }
         }
 
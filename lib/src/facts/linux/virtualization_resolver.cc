@@ -9,9 +9,16 @@
 #include <leatherman/logging/logging.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cstring>
+#include <functional>
 #include <vector>
 #include <tuple>
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <cpuid.h>
+#endif
+
 using namespace std;
 using namespace facter::facts;
 using namespace facter::util;
@@ -21,58 +28,85 @@ namespace bs = boost::system;
 
 namespace facter { namespace facts { namespace linux {
 
+    vector<string> virtualization_resolver::dependencies() const
+    {
+        return { fact::bios_vendor, fact::product_name };
+    }
+
     string virtualization_resolver::get_hypervisor(collection& facts)
     {
-        // First check for Docker/LXC
-        string value = get_cgroup_vm();
+        // First check the sources that don't require running a command
+        string value = get_native_vm(facts, {}, get_cpuid_signature());
 
-        // Next check for Google Compute Engine
-        if (value.empty()) {
-            value = get_gce_vm(facts);
+        // The commands are slow to start, so only run them when command fallbacks are enabled
+        if (!value.empty() || !facts.command_fallbacks()) {
+            return value;
         }
 
-        // Next check based on the virt-what command
-        if (value.empty()) {
-            value = get_what_vm();
-        }
+        // Next fall back to the virt-what command for what can't be detected natively
+        value = get_what_vm();
 
         // Next check the vmware tool output
-        if (value.empty()) {
+        if (value.empty() && !execution::which("vmware").empty()) {
             value = get_vmware_vm();
         }
 
-        // Next check for OpenVZ
+        // Lastly, resort to lspci to look for hardware related to certain VMs
         if (value.empty()) {
-            value = get_openvz_vm();
+            value = get_lspci_vm();
         }
 
-        // Next check for VServer
-        if (value.empty()) {
-            value = get_vserver_vm();
-        }
+        return value;
+    }
 
-        // Next check for Xen
-        if (value.empty()) {
-            value = get_xen_vm();
-        }
+    string virtualization_resolver::get_native_vm(collection& facts, string const& root, string const& signature)
+    {
+        // Containers are checked first as they see the hardware and hypervisor of their host
+        static vector<tuple<string, function<string(collection&, string const&, string const&)>>> sources = {
+            make_tuple("cgroup",        [](collection&, string const& root, string const&) { return get_cgroup_vm(root); }),
+            make_tuple("environment",   [](collection&, string const& root, string const&) { return get_environ_vm(root); }),
+            make_tuple("BIOS vendor",   [](collection& facts, string const&, string const&) { return get_gce_vm(facts); }),
+            make_tuple("OpenVZ",        [](collection&, string const& root, string const&) { return get_openvz_vm(root); }),
+            make_tuple("VServer",       [](collection&, string const& root, string const&) { return get_vserver_vm(root); }),
+            make_tuple("Xen",           [](collection&, string const& root, string const& signature) { return get_xen_vm(root, signature); }),
+            make_tuple("product name",  [](collection& facts, string const&, string const&) { return get_product_name_vm(facts); }),
+            make_tuple("CPUID",         [](collection&, string const&, string const& signature) { return get_cpuid_vm(signature); }),
+            make_tuple("PCI vendor",    [](collection&, string const& root, string const&) { return get_pci_vm(root); }),
+        };
 
-        // Next check the DMI product name for the VM
-        if (value.empty()) {
-            value = get_product_name_vm(facts);
+        for (auto const& source : sources) {
+            auto value = get<1>(source)(facts, root, signature);
+            if (!value.empty()) {
+                LOG_DEBUG("hypervisor %1% was detected from the %2%.", value, get<0>(source));
+                return value;
+            }
         }
+        return {};
+    }
 
-        // Lastly, resort to lspci to look for hardware related to certain VMs
-        if (value.empty()) {
-            value = get_lspci_vm();
+    string virtualization_resolver::get_cpuid_signature()
+    {
+#if defined(__i386__) || defined(__x86_64__)
+        // The hypervisor present bit is bit 31 of ECX for leaf 1; the vendor signature is in EBX, ECX and EDX of leaf 0x40000000
+        unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1u << 31))) {
+            return {};
         }
-
-        return value;
+        __cpuid(0x40000000, eax, ebx, ecx, edx);
+        char signature[13] = {};
+        memcpy(signature, &ebx, 4);
+        memcpy(signature + 4, &ecx, 4);
+        memcpy(signature + 8, &edx, 4);
+        return boost::trim_copy(string(signature));
+#else
+        return {};
+#endif
     }
 
-    string virtualization_resolver::get_cgroup_vm()
+    string virtualization_resolver::get_cgroup_vm(string const& root)
     {
         string value;
-        file::each_line("/proc/1/cgroup", [&](string& line) {
+        file::each_line(root + "/proc/1/cgroup", [&](string& line) {
             vector<boost::iterator_range<string::iterator>> parts;
             boost::split(parts, line, boost::is_any_of(":"), boost::token_compress_on);
             if (parts.size() < 3) {
@@ -91,6 +125,30 @@ namespace facter { namespace facts { namespace linux {
         return value;
     }
 
+    string virtualization_resolver::get_environ_vm(string const& root)
+    {
+        // Docker creates /.dockerenv; other container managers (e.g. LXC) set the container variable for init
+        bs::error_code ec;
+        if (exists(root + "/.dockerenv", ec) && !ec) {
+            return vm::docker;
+        }
+        string environment;
+        if (!file::read(root + "/proc/1/environ", environment)) {
+            return {};
+        }
+        vector<string> variables;
+        boost::split(variables, environment, boost::is_any_of(string(1, '\0')), boost::token_compress_on);
+        for (auto const& variable : variables) {
+            if (variable == "container=lxc" || variable == "container=lxc-libvirt") {
+                return vm::lxc;
+            }
+            if (variable == "container=docker") {
+                return vm::docker;
+            }
+        }
+        return {};
+    }
+
     string virtualization_resolver::get_gce_vm(collection& facts)
     {
         auto vendor = facts.get<string_value>(fact::bios_vendor);
@@ -128,7 +186,7 @@ namespace facter { namespace facts { namespace linux {
         if (!value.empty()) {
             boost::to_lower(value);
             if (value == "linux_vserver") {
-                return get_vserver_vm();
+                return get_vserver_vm({});
             }
             if (value == "xen-hvm") {
                 return vm::xen_hardware;
@@ -146,10 +204,10 @@ namespace facter { namespace facts { namespace linux {
         return value;
     }
 
-    string virtualization_resolver::get_vserver_vm()
+    string virtualization_resolver::get_vserver_vm(string const& root)
     {
         string value;
-        file::each_line("/proc/self/status", [&](string& line) {
+        file::each_line(root + "/proc/self/status", [&](string& line) {
             vector<boost::iterator_range<string::iterator>> parts;
             boost::split(parts, line, boost::is_space(), boost::token_compress_on);
             if (parts.size() != 2) {
@@ -186,17 +244,17 @@ namespace facter { namespace facts { namespace linux {
         return parts[0] + '_' + parts[1];
     }
 
-    string virtualization_resolver::get_openvz_vm()
+    string virtualization_resolver::get_openvz_vm(string const& root)
     {
         // Detect if it's a OpenVZ without being CloudLinux
         bs::error_code ec;
-        if (!is_directory("/proc/vz", ec) ||
-            is_regular_file("/proc/lve/list", ec) ||
-            boost::filesystem::is_empty("/proc/vz", ec)) {
+        if (!is_directory(root + "/proc/vz", ec) ||
+            is_regular_file(root + "/proc/lve/list", ec) ||
+            boost::filesystem::is_empty(root + "/proc/vz", ec)) {
             return {};
         }
         string value;
-        file::each_line("/proc/self/status", [&](string& line) {
+        file::each_line(root + "/proc/self/status", [&](string& line) {
             vector<boost::iterator_range<string::iterator>> parts;
             boost::split(parts, line, boost::is_space(), boost::token_compress_on);
             if (parts.size() != 2) {
@@ -215,19 +273,34 @@ namespace facter { namespace facts { namespace linux {
         return value;
     }
 
-    string virtualization_resolver::get_xen_vm()
+    string virtualization_resolver::get_xen_vm(string const& root, string const& signature)
     {
+        // The control domain is the only domain with the control_d capability
+        string capabilities;
+        if (file::read(root + "/proc/xen/capabilities", capabilities) && capabilities.find("control_d") != string::npos) {
+            return vm::xen_privileged;
+        }
+
+        // Paravirtualized guests also see Xen's CPUID leaf, so only trust it when the guest type is HVM (or unknown)
+        auto guest_type = boost::trim_copy(file::read(root + "/sys/hypervisor/guest_type"));
+        if (signature == "XenVMMXenVMM" && (guest_type.empty() || guest_type == "HVM")) {
+            return vm::xen_hardware;
+        }
+
         // Check for a required Xen file
         bs::error_code ec;
-        if (exists("/dev/xen/evtchn", ec) && !ec) {
+        if (exists(root + "/dev/xen/evtchn", ec) && !ec) {
             return vm::xen_privileged;
         }
         ec.clear();
-        if (exists("/proc/xen", ec) && !ec) {
+        if (exists(root + "/proc/xen", ec) && !ec) {
             return vm::xen_unprivileged;
         }
         ec.clear();
-        if (exists("/dev/xvda1", ec) && !ec) {
+        if (exists(root + "/dev/xvda1", ec) && !ec) {
+            return vm::xen_unprivileged;
+        }
+        if (boost::trim_copy(file::read(root + "/sys/hypervisor/type")) == "xen") {
             return vm::xen_unprivileged;
         }
         return {};
@@ -262,6 +335,50 @@ namespace facter { namespace facts { namespace linux {
         return {};
     }
 
+    string virtualization_resolver::get_cpuid_vm(string const& signature)
+    {
+        static vector<tuple<string, string>> vms = {
+            make_tuple("KVMKVMKVM",     string(vm::kvm)),
+            make_tuple("VMwareVMware",  string(vm::vmware)),
+            make_tuple("Microsoft Hv",  string(vm::hyperv)),
+            make_tuple("VBoxVBoxVBox",  string(vm::virtualbox)),
+            make_tuple("prl hyperv",    string(vm::parallels)),
+        };
+
+        for (auto const& vm : vms) {
+            if (signature == get<0>(vm)) {
+                return get<1>(vm);
+            }
+        }
+        return {};
+    }
+
+    string virtualization_resolver::get_pci_vm(string const& root)
+    {
+        // The PCI vendor IDs of the devices lspci describes, in the same order of precedence
+        static vector<tuple<string, string>> vms = {
+            make_tuple("0x15ad",    string(vm::vmware)),
+            make_tuple("0x80ee",    string(vm::virtualbox)),
+            make_tuple("0x1ab8",    string(vm::parallels)),
+            make_tuple("0x5853",    string(vm::xen_hardware)),
+            make_tuple("0x1414",    string(vm::hyperv)),
+            make_tuple("0x1ae0",    string(vm::gce)),
+            make_tuple("0x1af4",    string(vm::kvm)),
+        };
+
+        vector<string> vendors;
+        bs::error_code ec;
+        for (directory_iterator it(root + "/sys/bus/pci/devices", ec), end; !ec && it != end; it.increment(ec)) {
+            vendors.emplace_back(boost::trim_copy(file::read((it->path() / "vendor").string())));
+        }
+        for (auto const& vm : vms) {
+            if (find(vendors.begin(), vendors.end(), get<0>(vm)) != vendors.end()) {
+                return get<1>(vm);
+            }
+        }
+        return {};
+    }
+
     string virtualization_resolver::get_lspci_vm()
     {
         static vector<tuple<boost::regex, string>> vms = {
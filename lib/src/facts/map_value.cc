@@ -1,9 +1,14 @@
 #include <facter/facts/map_value.hpp>
 #include <facter/facts/scalar_value.hpp>
+#include <facter/facts/json_writer.hpp>
+#include <facter/facts/msgpack.hpp>
 #include <facter/util/string.hpp>
+#include <internal/facts/string_pool.hpp>
+#include <internal/facts/value_arena.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <rapidjson/document.h>
 #include <yaml-cpp/yaml.h>
+#include <algorithm>
 
 using namespace std;
 using namespace facter::util;
@@ -21,6 +26,8 @@ namespace facter { namespace facts {
     {
         value::operator=(static_cast<value&&>(other));
         if (this != &other) {
+            _strings = std::move(other._strings);
+            _names = std::move(other._names);
             _elements = std::move(other._elements);
         }
         return *this;
@@ -33,7 +40,33 @@ namespace facter { namespace facts {
             return;
         }
 
-        _elements.emplace(move(name), move(value));
+        // Find where the element belongs; elements are usually added in order, so check the end first
+        auto it = _elements.end();
+        if (!_elements.empty() && !(*_elements.back().first < name)) {
+            it = lower_bound(_elements.begin(), _elements.end(), name, [](element const& elem, string const& key) {
+                return *elem.first < key;
+            });
+            if (*it->first == name) {
+                return;
+            }
+        }
+
+        // Intern the name in the pool of the current arena so that maps resolved together share their keys
+        // Outside of an arena the map keeps its own names; a pool per map would cost more than it saves
+        if (!_strings) {
+            auto arena = value_arena::current();
+            if (arena) {
+                _strings = arena->strings();
+            }
+        }
+        string const* key;
+        if (_strings) {
+            key = _strings->intern(move(name));
+        } else {
+            _names.emplace_back(move(name));
+            key = &_names.back();
+        }
+        _elements.emplace(it, key, move(value));
     }
 
     bool map_value::empty() const
@@ -49,7 +82,7 @@ namespace facter { namespace facts {
     void map_value::each(function<bool(string const&, value const*)> func) const
     {
         for (auto const& kvp : _elements) {
-            if (!func(kvp.first, kvp.second.get())) {
+            if (!func(*kvp.first, kvp.second.get())) {
                 break;
             }
         }
@@ -57,13 +90,24 @@ namespace facter { namespace facts {
 
     value const* map_value::operator[](string const& name) const
     {
-        auto it = _elements.find(name);
+        auto it = find(name);
         if (it == _elements.end()) {
             return nullptr;
         }
         return it->second.get();
     }
 
+    vector<map_value::element>::const_iterator map_value::find(string const& name) const
+    {
+        auto it = lower_bound(_elements.begin(), _elements.end(), name, [](element const& elem, string const& key) {
+            return *elem.first < key;
+        });
+        if (it != _elements.end() && *it->first == name) {
+            return it;
+        }
+        return _elements.end();
+    }
+
     void map_value::to_json(Allocator& allocator, rapidjson::Value& value) const
     {
         value.SetObject();
@@ -71,7 +115,26 @@ namespace facter { namespace facts {
         for (auto const& kvp : _elements) {
             rapidjson::Value child;
             kvp.second->to_json(allocator, child);
-            value.AddMember(kvp.first.c_str(), child, allocator);
+            value.AddMember(kvp.first->c_str(), child, allocator);
+        }
+    }
+
+    void map_value::write(json_writer& writer) const
+    {
+        writer.start_object();
+        for (auto const& kvp : _elements) {
+            writer.write_key(*kvp.first);
+            kvp.second->write(writer);
+        }
+        writer.end_object();
+    }
+
+    void map_value::write(msgpack_writer& writer) const
+    {
+        writer.write_map(_elements.size());
+        for (auto const& kvp : _elements) {
+            writer.write_string(*kvp.first);
+            kvp.second->write(writer);
         }
     }
 
@@ -92,7 +155,7 @@ namespace facter { namespace facts {
                 os << ",\n";
             }
             fill_n(ostream_iterator<char>(os), level * 2, ' ');
-            os << kvp.first << " => ";
+            os << *kvp.first << " => ";
             kvp.second->write(os, true /* always quote strings in a map */, level + 1);
         }
         os << "\n";
@@ -106,10 +169,10 @@ namespace facter { namespace facts {
         emitter << BeginMap;
         for (auto const& kvp : _elements) {
             emitter << Key;
-            if (needs_quotation(kvp.first)) {
+            if (needs_quotation(*kvp.first)) {
                 emitter << DoubleQuoted;
             }
-            emitter << kvp.first << YAML::Value;
+            emitter << *kvp.first << YAML::Value;
             kvp.second->write(emitter);
         }
         emitter << EndMap;
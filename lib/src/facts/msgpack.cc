@@ -0,0 +1,298 @@
+#include <facter/facts/msgpack.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <facter/facts/array_value.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/util/scope_exit.hpp>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+using namespace facter::util;
+
+namespace facter { namespace facts {
+
+    msgpack_exception::msgpack_exception(string const& message) :
+        runtime_error(message)
+    {
+    }
+
+    msgpack_writer::msgpack_writer(string& buffer) :
+        _buffer(buffer)
+    {
+    }
+
+    void msgpack_writer::write_map(size_t count)
+    {
+        if (count < 16) {
+            _buffer += static_cast<char>(0x80 | count);
+        } else if (count <= 0xFFFF) {
+            put(0xde, count, 2);
+        } else {
+            put(0xdf, count, 4);
+        }
+    }
+
+    void msgpack_writer::write_array(size_t count)
+    {
+        if (count < 16) {
+            _buffer += static_cast<char>(0x90 | count);
+        } else if (count <= 0xFFFF) {
+            put(0xdc, count, 2);
+        } else {
+            put(0xdd, count, 4);
+        }
+    }
+
+    void msgpack_writer::write_string(string const& str)
+    {
+        write_string(str.c_str(), str.size());
+    }
+
+    void msgpack_writer::write_string(char const* str, size_t length)
+    {
+        if (length < 32) {
+            _buffer += static_cast<char>(0xa0 | length);
+        } else if (length <= 0xFF) {
+            put(0xd9, length, 1);
+        } else if (length <= 0xFFFF) {
+            put(0xda, length, 2);
+        } else {
+            put(0xdb, length, 4);
+        }
+        _buffer.append(str, length);
+    }
+
+    void msgpack_writer::write_integer(int64_t i)
+    {
+        // Use the smallest encoding that can represent the integer
+        if (i >= 0 && i < 128) {
+            _buffer += static_cast<char>(i);
+        } else if (i < 0 && i >= -32) {
+            _buffer += static_cast<char>(i);
+        } else if (i >= numeric_limits<int8_t>::min() && i <= numeric_limits<int8_t>::max()) {
+            put(0xd0, static_cast<uint64_t>(i), 1);
+        } else if (i >= numeric_limits<int16_t>::min() && i <= numeric_limits<int16_t>::max()) {
+            put(0xd1, static_cast<uint64_t>(i), 2);
+        } else if (i >= numeric_limits<int32_t>::min() && i <= numeric_limits<int32_t>::max()) {
+            put(0xd2, static_cast<uint64_t>(i), 4);
+        } else {
+            put(0xd3, static_cast<uint64_t>(i), 8);
+        }
+    }
+
+    void msgpack_writer::write_boolean(bool b)
+    {
+        _buffer += static_cast<char>(b ? 0xc3 : 0xc2);
+    }
+
+    void msgpack_writer::write_double(double d)
+    {
+        static_assert(sizeof(uint64_t) == sizeof(double), "expected a 64-bit double.");
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        put(0xcb, bits, 8);
+    }
+
+    void msgpack_writer::write_nil()
+    {
+        _buffer += static_cast<char>(0xc0);
+    }
+
+    void msgpack_writer::write(value const* val)
+    {
+        if (!val) {
+            write_nil();
+            return;
+        }
+        val->write(*this);
+    }
+
+    void msgpack_writer::put(uint8_t marker, uint64_t value, size_t count)
+    {
+        // Values following a marker are written in big-endian order
+        _buffer += static_cast<char>(marker);
+        for (size_t i = count; i > 0; --i) {
+            _buffer += static_cast<char>((value >> ((i - 1) * 8)) & 0xFF);
+        }
+    }
+
+    msgpack_reader::msgpack_reader(string const& data, size_t offset, size_t length) :
+        _data(data),
+        _offset(min(offset, data.size())),
+        _end(length == string::npos || length > data.size() - _offset ? data.size() : _offset + length),
+        _depth(0)
+    {
+    }
+
+    bool msgpack_reader::done() const
+    {
+        return _offset >= _end;
+    }
+
+    size_t msgpack_reader::offset() const
+    {
+        return _offset;
+    }
+
+    unique_ptr<value> msgpack_reader::read(bool hidden)
+    {
+        auto marker = static_cast<uint8_t>(read_raw(1));
+        if (marker < 0x80) {
+            return unique_ptr<value>(new integer_value(marker, hidden));
+        }
+        if (marker >= 0xe0) {
+            return unique_ptr<value>(new integer_value(static_cast<int8_t>(marker), hidden));
+        }
+        if ((marker & 0xe0) == 0xa0) {
+            return unique_ptr<value>(new string_value(read_raw_string(marker & 0x1f), hidden));
+        }
+        if ((marker & 0xf0) == 0x90) {
+            return read_array(marker & 0x0f, hidden);
+        }
+        if ((marker & 0xf0) == 0x80) {
+            return read_map(marker & 0x0f, hidden);
+        }
+        switch (marker) {
+            case 0xc0:
+                return nullptr;
+            case 0xc2:
+            case 0xc3:
+                return unique_ptr<value>(new boolean_value(marker == 0xc3, hidden));
+            case 0xca: {
+                auto bits = static_cast<uint32_t>(read_raw(4));
+                float f;
+                memcpy(&f, &bits, sizeof(f));
+                return unique_ptr<value>(new double_value(f, hidden));
+            }
+            case 0xcb: {
+                auto bits = read_raw(8);
+                double d;
+                memcpy(&d, &bits, sizeof(d));
+                return unique_ptr<value>(new double_value(d, hidden));
+            }
+            case 0xcc:
+            case 0xcd:
+            case 0xce:
+            case 0xcf:
+                return unique_ptr<value>(new integer_value(static_cast<int64_t>(read_raw(static_cast<size_t>(1) << (marker - 0xcc))), hidden));
+            case 0xd0:
+                return unique_ptr<value>(new integer_value(static_cast<int8_t>(read_raw(1)), hidden));
+            case 0xd1:
+                return unique_ptr<value>(new integer_value(static_cast<int16_t>(read_raw(2)), hidden));
+            case 0xd2:
+                return unique_ptr<value>(new integer_value(static_cast<int32_t>(read_raw(4)), hidden));
+            case 0xd3:
+                return unique_ptr<value>(new integer_value(static_cast<int64_t>(read_raw(8)), hidden));
+            case 0xd9:
+                return unique_ptr<value>(new string_value(read_raw_string(read_raw(1)), hidden));
+            case 0xda:
+                return unique_ptr<value>(new string_value(read_raw_string(read_raw(2)), hidden));
+            case 0xdb:
+                return unique_ptr<value>(new string_value(read_raw_string(read_raw(4)), hidden));
+            case 0xdc:
+                return read_array(read_raw(2), hidden);
+            case 0xdd:
+                return read_array(read_raw(4), hidden);
+            case 0xde:
+                return read_map(read_raw(2), hidden);
+            case 0xdf:
+                return read_map(read_raw(4), hidden);
+        }
+        throw msgpack_exception("unsupported MessagePack type.");
+    }
+
+    string msgpack_reader::read_string()
+    {
+        auto marker = static_cast<uint8_t>(read_raw(1));
+        if ((marker & 0xe0) == 0xa0) {
+            return read_raw_string(marker & 0x1f);
+        }
+        switch (marker) {
+            case 0xd9:
+                return read_raw_string(read_raw(1));
+            case 0xda:
+                return read_raw_string(read_raw(2));
+            case 0xdb:
+                return read_raw_string(read_raw(4));
+        }
+        throw msgpack_exception("expected a MessagePack string.");
+    }
+
+    size_t msgpack_reader::read_map()
+    {
+        auto marker = static_cast<uint8_t>(read_raw(1));
+        if ((marker & 0xf0) == 0x80) {
+            return marker & 0x0f;
+        }
+        switch (marker) {
+            case 0xde:
+                return read_raw(2);
+            case 0xdf:
+                return read_raw(4);
+        }
+        throw msgpack_exception("expected a MessagePack map.");
+    }
+
+    uint64_t msgpack_reader::read_raw(size_t count)
+    {
+        if (_end - _offset < count) {
+            throw msgpack_exception("unexpected end of MessagePack data.");
+        }
+        uint64_t result = 0;
+        for (size_t i = 0; i < count; ++i) {
+            result = (result << 8) | static_cast<uint8_t>(_data[_offset++]);
+        }
+        return result;
+    }
+
+    string msgpack_reader::read_raw_string(size_t count)
+    {
+        if (_end - _offset < count) {
+            throw msgpack_exception("unexpected end of MessagePack data.");
+        }
+        string result = _data.substr(_offset, count);
+        _offset += count;
+        return result;
+    }
+
+    void msgpack_reader::enter()
+    {
+        if (_depth >= max_depth) {
+            throw msgpack_exception("MessagePack data is nested too deeply.");
+        }
+        ++_depth;
+    }
+
+    unique_ptr<value> msgpack_reader::read_array(size_t count, bool hidden)
+    {
+        enter();
+        scope_exit leave([&]() { --_depth; });
+
+        unique_ptr<array_value> array(new array_value(hidden));
+        for (size_t i = 0; i < count; ++i) {
+            // Arrays cannot contain null values
+            auto element = read();
+            if (element) {
+                array->add(move(element));
+            }
+        }
+        return array;
+    }
+
+    unique_ptr<value> msgpack_reader::read_map(size_t count, bool hidden)
+    {
+        enter();
+        scope_exit leave([&]() { --_depth; });
+
+        unique_ptr<map_value> map(new map_value(hidden));
+        for (size_t i = 0; i < count; ++i) {
+            auto name = read_string();
+            auto element = read();
+            if (element) {
+                map->add(move(name), move(element));
+            }
+        }
+        return map;
+    }
+
+}}  // namespace facter::facts
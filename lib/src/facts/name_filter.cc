@@ -0,0 +1,74 @@
+#include <facter/facts/name_filter.hpp>
+#include <algorithm>
+
+using namespace std;
+
+namespace facter { namespace facts {
+
+    name_filter::name_filter(vector<string> includes, vector<string> excludes) :
+        _includes(move(includes)),
+        _excludes(move(excludes))
+    {
+    }
+
+    bool name_filter::empty() const
+    {
+        return _includes.empty() && _excludes.empty();
+    }
+
+    vector<string> const& name_filter::includes() const
+    {
+        return _includes;
+    }
+
+    vector<string> const& name_filter::excludes() const
+    {
+        return _excludes;
+    }
+
+    bool name_filter::includes(string const& name) const
+    {
+        return includes({ name });
+    }
+
+    bool name_filter::includes(initializer_list<string> names) const
+    {
+        auto matches_any = [&](vector<string> const& patterns) {
+            return any_of(patterns.begin(), patterns.end(), [&](string const& pattern) {
+                return any_of(names.begin(), names.end(), [&](string const& name) { return match(pattern, name); });
+            });
+        };
+        if (!_includes.empty() && !matches_any(_includes)) {
+            return false;
+        }
+        return !matches_any(_excludes);
+    }
+
+    bool name_filter::match(string const& pattern, string const& name)
+    {
+        // On a mismatch, backtrack to the last '*' and let it consume one more character
+        size_t p = 0;
+        size_t n = 0;
+        size_t star = string::npos;
+        size_t resume = 0;
+        while (n < name.size()) {
+            if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                resume = n;
+            } else if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+                ++p;
+                ++n;
+            } else if (star != string::npos) {
+                p = star + 1;
+                n = ++resume;
+            } else {
+                return false;
+            }
+        }
+        while (p < pattern.size() && pattern[p] == '*') {
+            ++p;
+        }
+        return p == pattern.size();
+    }
+
+}}  // namespace facter::facts
@@ -52,7 +52,7 @@ namespace facter { namespace facts { namespace osx {
         return interface;
     }
 
-    map<string, string> networking_resolver::find_dhcp_servers() const
+    map<string, string> networking_resolver::find_dhcp_servers(set<string> const& interfaces) const
     {
         // We don't parse dhclient information on OSX
         return map<string, string>();
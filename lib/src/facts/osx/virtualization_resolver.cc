@@ -12,6 +12,11 @@ using namespace facter::execution;
 
 namespace facter { namespace facts { namespace osx {
 
+    vector<string> virtualization_resolver::dependencies() const
+    {
+        return { fact::sp_machine_model, fact::sp_boot_rom_version };
+    }
+
     string virtualization_resolver::get_hypervisor(collection& facts)
     {
         // Check for VMWare
@@ -0,0 +1,38 @@
+#include <internal/facts/cache.hpp>
+#include <internal/util/posix/scoped_descriptor.hpp>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace facter::util::posix;
+
+namespace facter { namespace facts {
+
+    bool fact_cache::create_private_directory(string const& path)
+    {
+        return mkdir(path.c_str(), 0700) == 0 || errno == EEXIST;
+    }
+
+    bool fact_cache::write_private_file(string const& path, string const& contents)
+    {
+        // O_EXCL ensures the file is the one created here with owner-only permissions and not a file or symlink put in its place
+        scoped_descriptor descriptor(open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600));
+        if (static_cast<int>(descriptor) < 0) {
+            return false;
+        }
+        for (size_t written = 0; written < contents.size();) {
+            auto count = write(descriptor, contents.data() + written, contents.size() - written);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            written += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+}}  // namespace facter::facts
@@ -33,6 +33,18 @@ namespace facter { namespace facts {
         return directories;
     }
 
+    string collection::get_cache_file() const
+    {
+        if (getuid()) {
+            string home;
+            if (environment::get("HOME", home)) {
+                return home + "/.puppetlabs/opt/facter/cache/cached_facts";
+            }
+            return {};
+        }
+        return "/opt/puppetlabs/facter/cache/cached_facts";
+    }
+
     vector<unique_ptr<external::resolver>> collection::get_external_resolvers()
     {
         vector<unique_ptr<external::resolver>> resolvers;
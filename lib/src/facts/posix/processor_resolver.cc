@@ -1,4 +1,5 @@
 #include <internal/facts/posix/processor_resolver.hpp>
+#include <facter/facts/fact.hpp>
 #include <facter/execution/execution.hpp>
 #include <leatherman/logging/logging.hpp>
 
@@ -10,6 +11,9 @@ namespace facter { namespace facts { namespace posix {
     processor_resolver::data processor_resolver::collect_data(collection& facts)
     {
         data result;
+        if (!is_collected(fact::processors, { "isa" })) {
+            return result;
+        }
 
         // Unfortunately there's no corresponding member in utsname for "processor", so we need to spawn
         bool success;
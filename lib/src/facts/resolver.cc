@@ -1,7 +1,10 @@
 #include <facter/facts/resolver.hpp>
 #include <facter/facts/collection.hpp>
+#include <facter/facts/value.hpp>
+#include <facter/util/scope_exit.hpp>
 #include <internal/util/regex.hpp>
 #include <leatherman/logging/logging.hpp>
+#include <algorithm>
 
 using namespace std;
 using namespace facter::util;
@@ -15,7 +18,8 @@ namespace facter { namespace facts {
 
     resolver::resolver(string name, vector<string> names, vector<string> const& patterns) :
         _name(move(name)),
-        _names(move(names))
+        _names(move(names)),
+        _patterns(patterns)
     {
         for (auto const& pattern : patterns) {
             try {
@@ -41,7 +45,10 @@ namespace facter { namespace facts {
         if (this != &other) {
             _name = std::move(other._name);
             _names = std::move(other._names);
+            _patterns = std::move(other._patterns);
             _regexes = std::move(other._regexes);
+            _query_name = std::move(other._query_name);
+            _query_path = std::move(other._query_path);
         }
         return *this;
     }
@@ -61,6 +68,21 @@ namespace facter { namespace facts {
         return _regexes.size() > 0;
     }
 
+    vector<string> const& resolver::patterns() const
+    {
+        return _patterns;
+    }
+
+    vector<string> resolver::dependencies() const
+    {
+        return {};
+    }
+
+    bool resolver::is_thread_safe() const
+    {
+        return true;
+    }
+
     bool resolver::is_match(string const& name) const
     {
         // Check to see if any of our regexes match
@@ -72,4 +94,44 @@ namespace facter { namespace facts {
         return false;
     }
 
+    bool resolver::has_legacy_facts() const
+    {
+        return false;
+    }
+
+    void resolver::resolve_legacy(collection& facts)
+    {
+    }
+
+    unique_ptr<value> resolver::resolve_query(collection& facts, string const& name, vector<string> const& path)
+    {
+        // Limit data collection to the queried part of the fact while the query is being resolved
+        _query_name = name;
+        _query_path = path;
+        scope_exit reset([&]() {
+            _query_name.clear();
+            _query_path.clear();
+        });
+        return query(facts, name, path);
+    }
+
+    unique_ptr<value> resolver::query(collection& facts, string const& name, vector<string> const& path)
+    {
+        return nullptr;
+    }
+
+    bool resolver::is_collected(string const& name, vector<string> const& path) const
+    {
+        if (_query_name.empty()) {
+            return true;
+        }
+        if (_query_name != name) {
+            return false;
+        }
+
+        // The data is needed if either path leads to the other
+        auto size = min(path.size(), _query_path.size());
+        return equal(path.begin(), path.begin() + size, _query_path.begin());
+    }
+
 }}  // namespace facter::facts
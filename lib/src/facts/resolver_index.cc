@@ -0,0 +1,161 @@
+#include <internal/facts/resolver_index.hpp>
+#include <algorithm>
+
+using namespace std;
+
+namespace facter { namespace facts {
+
+    static bool is_literal(char c)
+    {
+        static const string metacharacters = ".[]{}()\\*+?^$|";
+        return metacharacters.find(c) == string::npos;
+    }
+
+    static bool get_prefix(string const& pattern, string& prefix)
+    {
+        // Only patterns anchored at the start with no alternation have a literal prefix
+        prefix.clear();
+        if (pattern.empty() || pattern[0] != '^' || pattern.find('|') != string::npos) {
+            return false;
+        }
+
+        size_t i = 1;
+        for (; i < pattern.size() && is_literal(pattern[i]); ++i) {
+            prefix += pattern[i];
+        }
+
+        // A quantifier that allows zero occurrences makes the preceding character optional
+        if (i < pattern.size() && !prefix.empty() && (pattern[i] == '*' || pattern[i] == '?' || pattern[i] == '{')) {
+            prefix.pop_back();
+        }
+        return true;
+    }
+
+    resolver_index::resolver_index() :
+        _sequence(0)
+    {
+    }
+
+    resolver_index::node* resolver_index::insert(string const& key)
+    {
+        node* current = &_root;
+        for (auto c : key) {
+            auto& child = current->children[c];
+            if (!child) {
+                child.reset(new node());
+            }
+            current = child.get();
+        }
+        return current;
+    }
+
+    void resolver_index::add(shared_ptr<resolver> const& res)
+    {
+        if (!res || _entries.count(res)) {
+            return;
+        }
+
+        auto& entry = _entries[res];
+        entry.first = _sequence++;
+        auto& nodes = entry.second;
+
+        for (auto const& name : res->names()) {
+            auto current = insert(name);
+            current->resolvers.emplace(entry.first, res);
+            nodes.push_back(current);
+        }
+
+        string prefix;
+        for (auto const& expression : res->patterns()) {
+            pattern p;
+            p.res = res;
+
+            bool anchored = get_prefix(expression, prefix);
+
+            // A pattern that is entirely a literal prefix does not need to be matched with a regex
+            if (!anchored || prefix.size() + 1 != expression.size()) {
+                p.regex.reset(new boost::regex(expression));
+            }
+
+            if (!anchored) {
+                _unanchored.emplace(entry.first, move(p));
+                continue;
+            }
+            auto current = insert(prefix);
+            current->patterns.emplace(entry.first, move(p));
+            nodes.push_back(current);
+        }
+    }
+
+    void resolver_index::remove(shared_ptr<resolver> const& res)
+    {
+        auto it = _entries.find(res);
+        if (it == _entries.end()) {
+            return;
+        }
+
+        auto sequence = it->second.first;
+        for (auto current : it->second.second) {
+            current->resolvers.erase(sequence);
+            current->patterns.erase(sequence);
+        }
+        _unanchored.erase(sequence);
+        _entries.erase(it);
+    }
+
+    void resolver_index::clear()
+    {
+        _root.children.clear();
+        _root.resolvers.clear();
+        _root.patterns.clear();
+        _unanchored.clear();
+        _entries.clear();
+    }
+
+    shared_ptr<resolver> resolver_index::find(string const& name, bool latest) const
+    {
+        // Track the earliest (or latest) added resolver with a matching pattern
+        size_t best = 0;
+        shared_ptr<resolver> match;
+        auto check = [&](pair<size_t const, pattern> const& kvp) {
+            if (match && (latest ? kvp.first <= best : kvp.first >= best)) {
+                return true;
+            }
+            if (!kvp.second.regex || boost::regex_search(name, *kvp.second.regex)) {
+                best = kvp.first;
+                match = kvp.second.res;
+                return true;
+            }
+            return false;
+        };
+        auto search = [&](multimap<size_t, pattern> const& patterns) {
+            if (latest) {
+                find_if(patterns.rbegin(), patterns.rend(), check);
+            } else {
+                find_if(patterns.begin(), patterns.end(), check);
+            }
+        };
+
+        // Walk the trie, checking the patterns whose prefix matches the start of the name
+        node const* current = &_root;
+        search(current->patterns);
+        for (auto c : name) {
+            auto it = current->children.find(c);
+            if (it == current->children.end()) {
+                current = nullptr;
+                break;
+            }
+            current = it->second.get();
+            search(current->patterns);
+        }
+
+        // Resolvers that list the name take precedence over patterns
+        if (current && !current->resolvers.empty()) {
+            return latest ? current->resolvers.rbegin()->second : current->resolvers.begin()->second;
+        }
+
+        search(_unanchored);
+        return match;
+    }
+
+}}  // namespace facter::facts
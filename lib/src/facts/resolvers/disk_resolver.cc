@@ -33,27 +33,20 @@ namespace facter { namespace facts { namespace resolvers {
             if (disk.name.empty()) {
                 continue;
             }
-            auto value = make_value<map_value>();
             if (!disk.vendor.empty()) {
                 facts.add(string(fact::block_device) + "_" + disk.name + "_vendor" , make_value<string_value>(disk.vendor, true));
-                value->add("vendor", make_value<string_value>(move(disk.vendor)));
             }
             if (!disk.model.empty()) {
                 facts.add(string(fact::block_device) + "_" + disk.name + "_model" , make_value<string_value>(disk.model, true));
-                value->add("model", make_value<string_value>(move(disk.model)));
-            }
-            if (!disk.product.empty()) {
-                value->add("product", make_value<string_value>(move(disk.product)));
             }
             facts.add(string(fact::block_device) + "_" + disk.name + "_size" , make_value<integer_value>(static_cast<int64_t>(disk.size), true));
-            value->add("size_bytes", make_value<integer_value>(disk.size));
-            value->add("size", make_value<string_value>(si_string(disk.size)));
 
             if (names.tellp() != 0) {
                 names << ',';
             }
             names << disk.name;
 
+            auto value = make_disk_value(disk);
             disks->add(move(disk.name), move(value));
         }
 
@@ -66,4 +59,39 @@ namespace facter { namespace facts { namespace resolvers {
         }
     }
 
+    unique_ptr<value> disk_resolver::query(collection& facts, string const& name, vector<string> const& path)
+    {
+        // Only a query for a single disk can be resolved without collecting every disk
+        if (name != fact::disks || path.empty()) {
+            return nullptr;
+        }
+
+        auto data = collect_data(facts);
+
+        auto disks = make_value<map_value>();
+        for (auto const& disk : data.disks) {
+            if (disk.name == path.front()) {
+                disks->add(string(disk.name), make_disk_value(disk));
+            }
+        }
+        return disks;
+    }
+
+    unique_ptr<map_value> disk_resolver::make_disk_value(disk const& d)
+    {
+        auto value = make_value<map_value>();
+        if (!d.vendor.empty()) {
+            value->add("vendor", make_value<string_value>(d.vendor));
+        }
+        if (!d.model.empty()) {
+            value->add("model", make_value<string_value>(d.model));
+        }
+        if (!d.product.empty()) {
+            value->add("product", make_value<string_value>(d.product));
+        }
+        value->add("size_bytes", make_value<integer_value>(d.size));
+        value->add("size", make_value<string_value>(si_string(d.size)));
+        return value;
+    }
+
 }}}  // namespace facter::facts::resolvers
@@ -54,7 +54,7 @@ namespace facter { namespace facts { namespace resolvers {
         value.add(name, make_value<string_value>(move(body)));
     }
 
-    void query_metadata(client& cli, map_value& value, string const& url)
+    void query_metadata(client& cli, map_value& value, string const& url, vector<string> const& path = {}, size_t depth = 0)
     {
         // Stores the metadata names to filter out
         static set<string> filter = {
@@ -87,6 +87,11 @@ namespace facter { namespace facts { namespace resolvers {
                 return true;
             }
 
+            // Skip names that were not queried
+            if (depth < path.size() && name != path[depth] && name != path[depth] + "/") {
+                return true;
+            }
+
             // If the name does not end with a '/', then it is a key name; request the value
             if (name.back() != '/') {
                 query_metadata_value(cli, value, url, name);
@@ -95,7 +100,7 @@ namespace facter { namespace facts { namespace resolvers {
 
             // Otherwise, this is a category; recurse down it
             auto child = make_value<map_value>();
-            query_metadata(cli, *child, url + name);
+            query_metadata(cli, *child, url + name, path, depth + 1);
             trim_right_if(name, boost::is_any_of("/"));
             value.add(move(name), move(child));
             return true;
@@ -103,14 +108,18 @@ namespace facter { namespace facts { namespace resolvers {
     }
 #endif
 
+    vector<string> ec2_resolver::dependencies() const
+    {
+        return { fact::virtualization };
+    }
+
     void ec2_resolver::resolve(collection& facts)
     {
 #ifndef USE_CURL
         LOG_INFO("EC2 facts are unavailable: facter was built without libcurl support.");
         return;
 #else
-        auto virtualization = facts.get<string_value>(fact::virtualization);
-        if (!virtualization || (virtualization->value() != vm::kvm && !boost::starts_with(virtualization->value(), "xen"))) {
+        if (!is_ec2(facts)) {
             LOG_DEBUG("EC2 facts are unavailable: not running under an EC2 instance.");
             return;
         }
@@ -161,4 +170,27 @@ namespace facter { namespace facts { namespace resolvers {
 #endif
     }
 
+    unique_ptr<value> ec2_resolver::query(collection& facts, string const& name, vector<string> const& path)
+    {
+#ifndef USE_CURL
+        return nullptr;
+#else
+        // Only request the queried metadata rather than walking the entire metadata tree
+        if (name != fact::ec2_metadata || path.empty() || !is_ec2(facts)) {
+            return nullptr;
+        }
+
+        LOG_DEBUG("querying EC2 instance metadata at %1% for \"%2%\".", EC2_METADATA_ROOT_URL, boost::join(path, "/"));
+
+        auto metadata = make_value<map_value>();
+        try {
+            client cli;
+            query_metadata(cli, *metadata, EC2_METADATA_ROOT_URL, path);
+        } catch (runtime_error& ex) {
+            LOG_DEBUG("EC2 metadata request failed: %1%", ex.what());
+        }
+        return metadata;
+#endif
+    }
+
 }}}  // namespace facter::facts::resolvers
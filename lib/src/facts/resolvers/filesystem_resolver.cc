@@ -6,6 +6,7 @@
 #include <facter/facts/scalar_value.hpp>
 #include <facter/util/string.hpp>
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
 
 using namespace std;
 using namespace facter::util;
@@ -29,22 +30,78 @@ namespace facter { namespace facts { namespace resolvers {
 
         // Populate the mountpoints fact
         if (!data.mountpoints.empty()) {
-            auto mountpoints = make_value<map_value>();
-            for (auto& mountpoint : data.mountpoints) {
-                if (mountpoint.name.empty()) {
-                    continue;
-                }
+            facts.add(fact::mountpoints, make_mountpoints_value(data.mountpoints));
+        }
 
-                uint64_t used = mountpoint.size - mountpoint.available;
+        // Populate the filesystems fact
+        if (!data.filesystems.empty()) {
+            facts.add(fact::filesystems, make_value<string_value>(boost::join(data.filesystems, ",")));
+        }
 
-                auto value = make_value<map_value>();
+        // Populate the partitions fact
+        if (!data.partitions.empty()) {
+            facts.add(fact::partitions, make_partitions_value(data.partitions));
+        }
+    }
 
-                if (!mountpoint.filesystem.empty()) {
-                    value->add("filesystem", make_value<string_value>(move(mountpoint.filesystem)));
-                }
-                if (!mountpoint.device.empty()) {
-                    value->add("device", make_value<string_value>(move(mountpoint.device)));
-                }
+    unique_ptr<value> filesystem_resolver::query(collection& facts, string const& name, vector<string> const& path)
+    {
+        // Only a query for a single mountpoint or partition can be resolved without collecting every one
+        if ((name != fact::mountpoints && name != fact::partitions) || path.empty()) {
+            return nullptr;
+        }
+
+        auto data = collect_data(facts);
+        if (name == fact::mountpoints) {
+            data.mountpoints.erase(remove_if(data.mountpoints.begin(), data.mountpoints.end(), [&](mountpoint const& point) {
+                return point.name != path.front();
+            }), data.mountpoints.end());
+            return make_mountpoints_value(data.mountpoints);
+        }
+        data.partitions.erase(remove_if(data.partitions.begin(), data.partitions.end(), [&](partition const& part) {
+            return part.name != path.front();
+        }), data.partitions.end());
+        return make_partitions_value(data.partitions);
+    }
+
+    name_filter const& filesystem_resolver::mountpoint_filter() const
+    {
+        return _mountpoint_filter;
+    }
+
+    void filesystem_resolver::mountpoint_filter(name_filter filter)
+    {
+        _mountpoint_filter = move(filter);
+    }
+
+    bool filesystem_resolver::is_included(collection const& facts, string const& name, string const& filesystem) const
+    {
+        auto const& filter = _mountpoint_filter.empty() ? facts.mountpoint_filter() : _mountpoint_filter;
+        return filter.includes({ name, filesystem });
+    }
+
+    unique_ptr<map_value> filesystem_resolver::make_mountpoints_value(vector<mountpoint>& mountpoints)
+    {
+        auto result = make_value<map_value>();
+        for (auto& mountpoint : mountpoints) {
+            if (mountpoint.name.empty()) {
+                continue;
+            }
+
+            uint64_t used = mountpoint.size - mountpoint.available;
+
+            auto value = make_value<map_value>();
+
+            if (!mountpoint.filesystem.empty()) {
+                value->add("filesystem", make_value<string_value>(move(mountpoint.filesystem)));
+            }
+            if (!mountpoint.device.empty()) {
+                value->add("device", make_value<string_value>(move(mountpoint.device)));
+            }
+            // The size of a mountpoint that timed out is unknown
+            if (mountpoint.timed_out) {
+                value->add("timed_out", make_value<boolean_value>(true));
+            } else {
                 value->add("size_bytes", make_value<integer_value>(mountpoint.size));
                 value->add("size", make_value<string_value>(si_string(mountpoint.size)));
                 value->add("available_bytes", make_value<integer_value>(mountpoint.available));
@@ -52,60 +109,55 @@ namespace facter { namespace facts { namespace resolvers {
                 value->add("used_bytes", make_value<integer_value>(used));
                 value->add("used", make_value<string_value>(si_string(used)));
                 value->add("capacity", make_value<string_value>(percentage(used, mountpoint.size)));
+            }
 
-                if (!mountpoint.options.empty()) {
-                    auto options = make_value<array_value>();
-                    for (auto &option : mountpoint.options) {
-                        options->add(make_value<string_value>(move(option)));
-                    }
-                    value->add("options", move(options));
+            if (!mountpoint.options.empty()) {
+                auto options = make_value<array_value>();
+                for (auto &option : mountpoint.options) {
+                    options->add(make_value<string_value>(move(option)));
                 }
-
-                mountpoints->add(move(mountpoint.name), move(value));
+                value->add("options", move(options));
             }
-            facts.add(fact::mountpoints, move(mountpoints));
-        }
 
-        // Populate the filesystems fact
-        if (!data.filesystems.empty()) {
-            facts.add(fact::filesystems, make_value<string_value>(boost::join(data.filesystems, ",")));
+            result->add(move(mountpoint.name), move(value));
         }
+        return result;
+    }
 
-        // Populate the partitions fact
-        if (!data.partitions.empty()) {
-            auto partitions = make_value<map_value>();
-            for (auto& partition : data.partitions) {
-                if (partition.name.empty()) {
-                    continue;
-                }
-
-                auto value = make_value<map_value>();
+    unique_ptr<map_value> filesystem_resolver::make_partitions_value(vector<partition>& partitions)
+    {
+        auto result = make_value<map_value>();
+        for (auto& partition : partitions) {
+            if (partition.name.empty()) {
+                continue;
+            }
 
-                if (!partition.filesystem.empty()) {
-                    value->add("filesystem", make_value<string_value>(move(partition.filesystem)));
-                }
-                if (!partition.mount.empty()) {
-                    value->add("mount", make_value<string_value>(move(partition.mount)));
-                }
-                if (!partition.label.empty()) {
-                    value->add("label", make_value<string_value>(move(partition.label)));
-                }
-                if (!partition.partition_label.empty()) {
-                    value->add("partlabel", make_value<string_value>(move(partition.partition_label)));
-                }
-                if (!partition.uuid.empty()) {
-                    value->add("uuid", make_value<string_value>(move(partition.uuid)));
-                }
-                if (!partition.partition_uuid.empty()) {
-                    value->add("partuuid", make_value<string_value>(move(partition.partition_uuid)));
-                }
-                value->add("size_bytes", make_value<integer_value>(partition.size));
-                value->add("size", make_value<string_value>(si_string(partition.size)));
+            auto value = make_value<map_value>();
 
-                partitions->add(move(partition.name), move(value));
+            if (!partition.filesystem.empty()) {
+                value->add("filesystem", make_value<string_value>(move(partition.filesystem)));
+            }
+            if (!partition.mount.empty()) {
+                value->add("mount", make_value<string_value>(move(partition.mount)));
+            }
+            if (!partition.label.empty()) {
+                value->add("label", make_value<string_value>(move(partition.label)));
+            }
+            if (!partition.partition_label.empty()) {
+                value->add("partlabel", make_value<string_value>(move(partition.partition_label)));
             }
-            facts.add(fact::partitions, move(partitions));
+            if (!partition.uuid.empty()) {
+                value->add("uuid", make_value<string_value>(move(partition.uuid)));
+            }
+            if (!partition.partition_uuid.empty()) {
+                value->add("partuuid", make_value<string_value>(move(partition.partition_uuid)));
+            }
+            value->add("size_bytes", make_value<integer_value>(partition.size));
+            value->add("size", make_value<string_value>(si_string(partition.size)));
+
+            result->add(move(partition.name), move(value));
         }
+        return result;
     }
 
 }}}  // namespace facter::facts::resolvers
@@ -77,7 +77,7 @@ namespace facter { namespace facts { namespace resolvers {
         void String(char const* s, SizeType len, bool copy)
         {
             // If the stack is empty or the top is a map and we don't have a key yet, set the key
-            if ((_stack.empty() || dynamic_cast<map_value*>(get<1>(_stack.top()).get())) && _key.empty()) {
+            if ((_stack.empty() || value_cast<map_value>(get<1>(_stack.top()).get())) && _key.empty()) {
                 check_initialized();
                 _key = s;
                 return;
@@ -175,7 +175,7 @@ namespace facter { namespace facts { namespace resolvers {
                 current = get<1>(_stack.top()).get();
             }
 
-            auto map = dynamic_cast<map_value*>(current);
+            auto map = value_cast<map_value>(current);
             if (map) {
                 if (_key.empty()) {
                     throw external::external_fact_exception("expected non-empty key in object.");
@@ -183,7 +183,7 @@ namespace facter { namespace facts { namespace resolvers {
                 map->add(move(_key), move(val));
                 return;
             }
-            auto array = dynamic_cast<array_value*>(current);
+            auto array = value_cast<array_value>(current);
             if (array) {
                 array->add(move(val));
                 return;
@@ -208,6 +208,11 @@ namespace facter { namespace facts { namespace resolvers {
     {
     }
 
+    vector<string> gce_resolver::dependencies() const
+    {
+        return { fact::virtualization };
+    }
+
     void gce_resolver::resolve(collection& facts)
     {
         auto virtualization = facts.get<string_value>(fact::virtualization);
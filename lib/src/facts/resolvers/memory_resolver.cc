@@ -46,12 +46,6 @@ namespace facter { namespace facts { namespace resolvers {
             stats->add("available_bytes", make_value<integer_value>(result.mem_free));
             stats->add("capacity", make_value<string_value>(percentage(mem_used, result.mem_total)));
             value->add("system", move(stats));
-
-            // Add hidden facts
-            facts.add(fact::memoryfree, make_value<string_value>(si_string(result.mem_free), true));
-            facts.add(fact::memoryfree_mb, make_value<double_value>(result.mem_free / (1024.0 * 1024.0), true));
-            facts.add(fact::memorysize, make_value<string_value>(si_string(result.mem_total), true));
-            facts.add(fact::memorysize_mb, make_value<double_value>(result.mem_total / (1024.0 * 1024.0), true));
         }
 
         if (result.swap_total > 0) {
@@ -69,15 +63,6 @@ namespace facter { namespace facts { namespace resolvers {
                 stats->add("encrypted", make_value<boolean_value>(result.swap_encryption == encryption_status::encrypted));
             }
             value->add("swap", move(stats));
-
-            // Add hidden facts
-            facts.add(fact::swapfree, make_value<string_value>(si_string(result.swap_free), true));
-            facts.add(fact::swapfree_mb, make_value<double_value>(result.swap_free / (1024.0 * 1024.0), true));
-            facts.add(fact::swapsize, make_value<string_value>(si_string(result.swap_total), true));
-            facts.add(fact::swapsize_mb, make_value<double_value>(result.swap_total / (1024.0 * 1024.0), true));
-            if (result.swap_encryption != encryption_status::unknown) {
-                facts.add(fact::swapencrypted, make_value<boolean_value>(result.swap_encryption == encryption_status::encrypted, true));
-            }
         }
 
         if (!value->empty()) {
@@ -85,4 +70,51 @@ namespace facter { namespace facts { namespace resolvers {
         }
     }
 
+    bool memory_resolver::has_legacy_facts() const
+    {
+        return true;
+    }
+
+    void memory_resolver::resolve_legacy(collection& facts)
+    {
+        auto memory = facts.get<map_value>(fact::memory);
+        if (!memory) {
+            return;
+        }
+
+        // The legacy facts are copies of the system and swap statistics
+        auto add_legacy = [&](map_value const* stats, string const& free, string const& free_mb, string const& size, string const& size_mb) {
+            auto available = stats->get<string_value>("available");
+            auto available_bytes = stats->get<integer_value>("available_bytes");
+            auto total = stats->get<string_value>("total");
+            auto total_bytes = stats->get<integer_value>("total_bytes");
+            if (available) {
+                facts.add(free, make_value<string_value>(available->value(), true));
+            }
+            if (available_bytes) {
+                facts.add(free_mb, make_value<double_value>(available_bytes->value() / (1024.0 * 1024.0), true));
+            }
+            if (total) {
+                facts.add(size, make_value<string_value>(total->value(), true));
+            }
+            if (total_bytes) {
+                facts.add(size_mb, make_value<double_value>(total_bytes->value() / (1024.0 * 1024.0), true));
+            }
+        };
+
+        auto system = memory->get<map_value>("system");
+        if (system) {
+            add_legacy(system, fact::memoryfree, fact::memoryfree_mb, fact::memorysize, fact::memorysize_mb);
+        }
+
+        auto swap = memory->get<map_value>("swap");
+        if (swap) {
+            add_legacy(swap, fact::swapfree, fact::swapfree_mb, fact::swapsize, fact::swapsize_mb);
+            auto encrypted = swap->get<boolean_value>("encrypted");
+            if (encrypted) {
+                facts.add(fact::swapencrypted, make_value<boolean_value>(encrypted->value(), true));
+            }
+        }
+    }
+
 }}}  // namespace facter::facts::resolvers
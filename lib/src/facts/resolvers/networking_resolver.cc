@@ -66,81 +66,45 @@ namespace facter { namespace facts { namespace resolvers {
         }
 
         ostringstream interface_names;
-        auto dhcp_servers = make_value<map_value>(true);
         auto interfaces = make_value<map_value>();
         for (auto& interface : data.interfaces) {
-            bool primary = interface.name == data.primary_interface;
-            auto value = make_value<map_value>();
-            if (!interface.address.v4.empty()) {
-                facts.add(string(fact::ipaddress) + "_" + interface.name, make_value<string_value>(interface.address.v4, true));
-                if (primary) {
+            // Only the primary interface's values are copied eagerly; the per-interface legacy facts are
+            // derived from the interfaces map by resolve_legacy if they are used
+            if (interface.name == data.primary_interface) {
+                if (!interface.address.v4.empty()) {
                     facts.add(fact::ipaddress, make_value<string_value>(interface.address.v4, true));
                     networking->add("ip", make_value<string_value>(interface.address.v4));
                 }
-                value->add("ip", make_value<string_value>(move(interface.address.v4)));
-            }
-            if (!interface.address.v6.empty()) {
-                facts.add(string(fact::ipaddress6) + "_" + interface.name, make_value<string_value>(interface.address.v6, true));
-                if (primary) {
+                if (!interface.address.v6.empty()) {
                     facts.add(fact::ipaddress6, make_value<string_value>(interface.address.v6, true));
                     networking->add("ip6", make_value<string_value>(interface.address.v6));
                 }
-                value->add("ip6", make_value<string_value>(move(interface.address.v6)));
-            }
-            if (!interface.netmask.v4.empty()) {
-                facts.add(string(fact::netmask) + "_" + interface.name, make_value<string_value>(interface.netmask.v4, true));
-                if (primary) {
+                if (!interface.netmask.v4.empty()) {
                     facts.add(fact::netmask, make_value<string_value>(interface.netmask.v4, true));
                     networking->add("netmask", make_value<string_value>(interface.netmask.v4));
                 }
-                value->add("netmask", make_value<string_value>(move(interface.netmask.v4)));
-            }
-            if (!interface.netmask.v6.empty()) {
-                facts.add(string(fact::netmask6) + "_" + interface.name, make_value<string_value>(interface.netmask.v6, true));
-                if (primary) {
+                if (!interface.netmask.v6.empty()) {
                     facts.add(fact::netmask6, make_value<string_value>(interface.netmask.v6, true));
                     networking->add("netmask6", make_value<string_value>(interface.netmask.v6));
                 }
-                value->add("netmask6", make_value<string_value>(move(interface.netmask.v6)));
-            }
-            if (!interface.network.v4.empty()) {
-                facts.add(string(fact::network) + "_" + interface.name, make_value<string_value>(interface.network.v4, true));
-                if (primary) {
+                if (!interface.network.v4.empty()) {
                     facts.add(fact::network, make_value<string_value>(interface.network.v4, true));
                     networking->add("network", make_value<string_value>(interface.network.v4));
                 }
-                value->add("network", make_value<string_value>(move(interface.network.v4)));
-            }
-            if (!interface.network.v6.empty()) {
-                facts.add(string(fact::network6) + "_" + interface.name, make_value<string_value>(interface.network.v6, true));
-                if (primary) {
+                if (!interface.network.v6.empty()) {
                     facts.add(fact::network6, make_value<string_value>(interface.network.v6, true));
                     networking->add("network6", make_value<string_value>(interface.network.v6));
                 }
-                value->add("network6", make_value<string_value>(move(interface.network.v6)));
-            }
-            if (!interface.macaddress.empty()) {
-                facts.add(string(fact::macaddress) + "_" + interface.name, make_value<string_value>(interface.macaddress, true));
-                if (primary) {
+                if (!interface.macaddress.empty()) {
                     facts.add(fact::macaddress, make_value<string_value>(interface.macaddress, true));
                     networking->add("mac", make_value<string_value>(interface.macaddress));
                 }
-                value->add("mac", make_value<string_value>(move(interface.macaddress)));
-            }
-            if (!interface.dhcp_server.empty()) {
-                if (primary) {
-                    dhcp_servers->add("system", make_value<string_value>(interface.dhcp_server));
+                if (!interface.dhcp_server.empty()) {
                     networking->add("dhcp", make_value<string_value>(interface.dhcp_server));
                 }
-                dhcp_servers->add(string(interface.name), make_value<string_value>(interface.dhcp_server));
-                value->add("dhcp", make_value<string_value>(move(interface.dhcp_server)));
-            }
-            if (interface.mtu) {
-                facts.add(string(fact::mtu) + "_" + interface.name, make_value<integer_value>(*interface.mtu, true));
-                if (primary) {
+                if (interface.mtu) {
                     networking->add("mtu", make_value<integer_value>(*interface.mtu));
                 }
-                value->add("mtu", make_value<integer_value>(*interface.mtu));
             }
 
             // Add the interface to the list of names
@@ -149,6 +113,7 @@ namespace facter { namespace facts { namespace resolvers {
             }
             interface_names << interface.name;
 
+            auto value = make_interface_value(interface);
             interfaces->add(move(interface.name), move(value));
         }
 
@@ -156,16 +121,144 @@ namespace facter { namespace facts { namespace resolvers {
             facts.add(fact::interfaces, make_value<string_value>(interface_names.str(), true));
         }
 
+        if (!interfaces->empty()) {
+            networking->add("interfaces", move(interfaces));
+        }
+        if (!networking->empty()) {
+            facts.add(fact::networking, move(networking));
+        }
+    }
+
+    bool networking_resolver::has_legacy_facts() const
+    {
+        return true;
+    }
+
+    void networking_resolver::resolve_legacy(collection& facts)
+    {
+        auto networking = facts.get<map_value>(fact::networking);
+        if (!networking) {
+            return;
+        }
+        auto interfaces = networking->get<map_value>("interfaces");
+        if (!interfaces) {
+            return;
+        }
+
+        // Each per-interface legacy fact is named after the fact prefix and is a copy of an interface element
+        static const vector<pair<string, string>> legacy_names = {
+            { string(fact::ipaddress),  "ip" },
+            { string(fact::ipaddress6), "ip6" },
+            { string(fact::netmask),    "netmask" },
+            { string(fact::netmask6),   "netmask6" },
+            { string(fact::network),    "network" },
+            { string(fact::network6),   "network6" },
+            { string(fact::macaddress), "mac" },
+        };
+
+        auto dhcp_servers = make_value<map_value>(true);
+        auto system_dhcp = networking->get<string_value>("dhcp");
+        if (system_dhcp) {
+            dhcp_servers->add("system", make_value<string_value>(system_dhcp->value()));
+        }
+
+        interfaces->each([&](string const& name, value const* val) {
+            auto interface = value_cast<map_value>(val);
+            if (!interface) {
+                return true;
+            }
+            for (auto const& legacy : legacy_names) {
+                auto element = interface->get<string_value>(legacy.second);
+                if (element) {
+                    facts.add(legacy.first + "_" + name, make_value<string_value>(element->value(), true));
+                }
+            }
+            auto mtu = interface->get<integer_value>("mtu");
+            if (mtu) {
+                facts.add(string(fact::mtu) + "_" + name, make_value<integer_value>(mtu->value(), true));
+            }
+            auto dhcp = interface->get<string_value>("dhcp");
+            if (dhcp) {
+                dhcp_servers->add(string(name), make_value<string_value>(dhcp->value()));
+            }
+            return true;
+        });
+
         if (!dhcp_servers->empty()) {
             facts.add(fact::dhcp_servers, move(dhcp_servers));
         }
+    }
 
+    unique_ptr<value> networking_resolver::query(collection& facts, string const& name, vector<string> const& path)
+    {
+        // Only a query for a single interface can be resolved without collecting every interface
+        if (name != fact::networking || path.size() < 2 || path[0] != "interfaces") {
+            return nullptr;
+        }
+
+        auto data = collect_data(facts);
+
+        auto interfaces = make_value<map_value>();
+        for (auto const& interface : data.interfaces) {
+            if (interface.name == path[1]) {
+                interfaces->add(string(interface.name), make_interface_value(interface));
+            }
+        }
+
+        auto networking = make_value<map_value>();
         if (!interfaces->empty()) {
             networking->add("interfaces", move(interfaces));
         }
-        if (!networking->empty()) {
-            facts.add(fact::networking, move(networking));
+        return networking;
+    }
+
+    name_filter const& networking_resolver::interface_filter() const
+    {
+        return _interface_filter;
+    }
+
+    void networking_resolver::interface_filter(name_filter filter)
+    {
+        _interface_filter = move(filter);
+    }
+
+    bool networking_resolver::is_included(collection const& facts, string const& name) const
+    {
+        auto const& filter = _interface_filter.empty() ? facts.interface_filter() : _interface_filter;
+        return filter.includes(name);
+    }
+
+    unique_ptr<map_value> networking_resolver::make_interface_value(interface const& iface)
+    {
+        auto value = make_value<map_value>();
+        if (!iface.address.v4.empty()) {
+            value->add("ip", make_value<string_value>(iface.address.v4));
+        }
+        if (!iface.address.v6.empty()) {
+            value->add("ip6", make_value<string_value>(iface.address.v6));
+        }
+        if (!iface.netmask.v4.empty()) {
+            value->add("netmask", make_value<string_value>(iface.netmask.v4));
+        }
+        if (!iface.netmask.v6.empty()) {
+            value->add("netmask6", make_value<string_value>(iface.netmask.v6));
+        }
+        if (!iface.network.v4.empty()) {
+            value->add("network", make_value<string_value>(iface.network.v4));
+        }
+        if (!iface.network.v6.empty()) {
+            value->add("network6", make_value<string_value>(iface.network.v6));
+        }
+        if (!iface.macaddress.empty()) {
+            value->add("mac", make_value<string_value>(iface.macaddress));
+        }
+        if (!iface.dhcp_server.empty()) {
+            value->add("dhcp", make_value<string_value>(iface.dhcp_server));
+        }
+        if (iface.mtu) {
+            value->add("mtu", make_value<integer_value>(*iface.mtu));
         }
+        return value;
     }
 
     string networking_resolver::macaddress_to_string(uint8_t const* bytes)
@@ -44,6 +44,11 @@ namespace facter { namespace facts { namespace resolvers {
     {
     }
 
+    vector<string> operating_system_resolver::dependencies() const
+    {
+        return { fact::kernel, fact::kernel_release };
+    }
+
     void operating_system_resolver::resolve(collection& facts)
     {
         auto data = collect_data(facts);
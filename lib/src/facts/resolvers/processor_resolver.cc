@@ -30,35 +30,81 @@ namespace facter { namespace facts { namespace resolvers {
     {
         auto data = collect_data(facts);
 
-        auto cpus = make_value<map_value>();
-
         if (!data.isa.empty()) {
             facts.add(fact::hardware_isa, make_value<string_value>(data.isa, true));
-            cpus->add("isa", make_value<string_value>(move(data.isa)));
         }
-
         facts.add(fact::processor_count, make_value<integer_value>(data.logical_count, true));
-        cpus->add("count", make_value<integer_value>(data.logical_count));
-
         facts.add(fact::physical_processor_count, make_value<integer_value>(data.physical_count, true));
-        cpus->add("physicalcount", make_value<integer_value>(data.physical_count));
+        facts.add(fact::processors, make_processors_value(data));
+    }
+
+    bool processor_resolver::has_legacy_facts() const
+    {
+        return true;
+    }
 
-        if (data.speed > 0) {
-            cpus->add("speed", make_value<string_value>(frequency(data.speed)));
+    void processor_resolver::resolve_legacy(collection& facts)
+    {
+        auto processors = facts.get<map_value>(fact::processors);
+        if (!processors) {
+            return;
+        }
+        auto models = processors->get<array_value>("models");
+        if (!models) {
+            return;
         }
 
-        auto models = make_value<array_value>();
         int processor = 0;
-        for (auto& model : data.models) {
-            facts.add(fact::processor + to_string(processor++), make_value<string_value>(model, true));
+        models->each([&](value const* val) {
+            auto model = value_cast<string_value>(val);
+            if (model) {
+                facts.add(fact::processor + to_string(processor), make_value<string_value>(model->value(), true));
+            }
+            ++processor;
+            return true;
+        });
+    }
+
+    unique_ptr<value> processor_resolver::query(collection& facts, string const& name, vector<string> const& path)
+    {
+        if (name != fact::processors || path.empty()) {
+            return nullptr;
+        }
+
+        // The platform only collects the data for the queried element
+        auto data = collect_data(facts);
+        return make_processors_value(data);
+    }
+
+    unique_ptr<map_value> processor_resolver::make_processors_value(data& result)
+    {
+        auto cpus = make_value<map_value>();
+
+        if (!result.isa.empty()) {
+            cpus->add("isa", make_value<string_value>(move(result.isa)));
+        }
+
+        cpus->add("count", make_value<integer_value>(result.logical_count));
+        cpus->add("physicalcount", make_value<integer_value>(result.physical_count));
+
+        if (result.speed > 0) {
+            cpus->add("speed", make_value<string_value>(frequency(result.speed)));
+        }
+
+        auto models = make_value<array_value>();
+        for (auto& model : result.models) {
             models->add(make_value<string_value>(move(model)));
         }
+        for (auto index : result.model_indexes) {
+            if (index < result.model_names.size()) {
+                models->add(make_value<string_value>(result.model_names[index]));
+            }
+        }
 
         if (!models->empty()) {
             cpus->add("models", move(models));
         }
-
-        facts.add(fact::processors, move(cpus));
+        return cpus;
     }
 
 }}}  // namespace facter::facts::resolvers
@@ -25,6 +25,11 @@ namespace facter { namespace facts { namespace resolvers {
     {
     }
 
+    bool ruby_resolver::is_thread_safe() const
+    {
+        return false;
+    }
+
     static void ruby_fact_rescue(api const& rb, function<VALUE()> cb, string const& label)
     {
         // Use rescue, because Ruby exceptions don't call destructors. The callback cb shouldn't
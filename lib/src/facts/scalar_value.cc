@@ -1,4 +1,6 @@
 #include <facter/facts/scalar_value.hpp>
+#include <facter/facts/json_writer.hpp>
+#include <facter/facts/msgpack.hpp>
 #include <facter/util/string.hpp>
 #include <rapidjson/document.h>
 #include <yaml-cpp/yaml.h>
@@ -35,6 +37,54 @@ namespace facter { namespace facts {
         value.SetDouble(_value);
     }
 
+    template <>
+    void scalar_value<string>::write(json_writer& writer) const
+    {
+        writer.write_string(_value);
+    }
+
+    template <>
+    void scalar_value<int64_t>::write(json_writer& writer) const
+    {
+        writer.write_integer(_value);
+    }
+
+    template <>
+    void scalar_value<bool>::write(json_writer& writer) const
+    {
+        writer.write_boolean(_value);
+    }
+
+    template <>
+    void scalar_value<double>::write(json_writer& writer) const
+    {
+        writer.write_double(_value);
+    }
+
+    template <>
+    void scalar_value<string>::write(msgpack_writer& writer) const
+    {
+        writer.write_string(_value);
+    }
+
+    template <>
+    void scalar_value<int64_t>::write(msgpack_writer& writer) const
+    {
+        writer.write_integer(_value);
+    }
+
+    template <>
+    void scalar_value<bool>::write(msgpack_writer& writer) const
+    {
+        writer.write_boolean(_value);
+    }
+
+    template <>
+    void scalar_value<double>::write(msgpack_writer& writer) const
+    {
+        writer.write_double(_value);
+    }
+
     template <>
     Emitter& scalar_value<string>::write(Emitter& emitter) const
     {
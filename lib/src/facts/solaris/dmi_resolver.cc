@@ -12,6 +12,11 @@ using namespace facter::execution;
 
 namespace facter { namespace facts { namespace solaris {
 
+    vector<string> dmi_resolver::dependencies() const
+    {
+        return { fact::architecture };
+    }
+
     dmi_resolver::data dmi_resolver::collect_data(collection& facts)
     {
         data result;
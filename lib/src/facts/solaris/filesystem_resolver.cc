@@ -27,12 +27,12 @@ namespace facter { namespace facts { namespace solaris {
     filesystem_resolver::data filesystem_resolver::collect_data(collection& facts)
     {
         data result;
-        collect_mountpoint_data(result);
+        collect_mountpoint_data(facts, result);
         collect_filesystem_data(result);
         return result;
     }
 
-    void filesystem_resolver::collect_mountpoint_data(data& result)
+    void filesystem_resolver::collect_mountpoint_data(collection& facts, data& result)
     {
         scoped_file file(fopen("/etc/mnttab", "r"));
         if (!static_cast<FILE*>(file)) {
@@ -42,6 +42,11 @@ namespace facter { namespace facts { namespace solaris {
 
         mnttab entry;
         while (getmntent(file, &entry) == 0) {
+            // Skip filtered mountpoints before gathering any data for them
+            if (!is_included(facts, entry.mnt_mountp, entry.mnt_fstype)) {
+                continue;
+            }
+
             mountpoint point;
 
             struct statvfs64 stats;
@@ -1,5 +1,6 @@
 #include <internal/facts/solaris/networking_resolver.hpp>
 #include <internal/util/posix/scoped_descriptor.hpp>
+#include <facter/facts/fact.hpp>
 #include <facter/execution/execution.hpp>
 #include <facter/util/string.hpp>
 #include <leatherman/logging/logging.hpp>
@@ -42,6 +43,10 @@ namespace facter { namespace facts { namespace solaris {
         // grouped together.
         multimap<string, const lifreq*> interface_map;
         for (lifreq const& lreq : buffer) {
+            // Skip interfaces that were not queried or are filtered out
+            if (!is_collected(fact::networking, { "interfaces", lreq.lifr_name }) || !is_included(facts, lreq.lifr_name)) {
+                continue;
+            }
             interface_map.insert({lreq.lifr_name, &lreq});
         }
 
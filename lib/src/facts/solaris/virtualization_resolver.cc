@@ -16,6 +16,11 @@ using namespace facter::execution;
 
 namespace facter { namespace facts { namespace solaris {
 
+    vector<string> virtualization_resolver::dependencies() const
+    {
+        return { fact::architecture };
+    }
+
     string virtualization_resolver::get_hypervisor(collection& facts)
     {
         // works for both x86 & sparc.
@@ -0,0 +1,20 @@
+#include <internal/facts/string_pool.hpp>
+#include <boost/thread/locks.hpp>
+
+using namespace std;
+
+namespace facter { namespace facts {
+
+    string const* string_pool::intern(string str)
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        return &*_strings.emplace(move(str)).first;
+    }
+
+    size_t string_pool::size() const
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        return _strings.size();
+    }
+
+}}  // namespace facter::facts
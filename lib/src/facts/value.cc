@@ -0,0 +1,53 @@
+#include <facter/facts/value.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <facter/facts/array_value.hpp>
+#include <facter/facts/map_value.hpp>
+#include <internal/facts/value_arena.hpp>
+
+using namespace std;
+
+namespace facter { namespace facts {
+
+    void* value::operator new(size_t size)
+    {
+        return value_arena::allocate(size);
+    }
+
+    void value::operator delete(void* ptr)
+    {
+        value_arena::deallocate(ptr);
+    }
+
+    void value::accept(value_visitor& visitor) const
+    {
+        // The type tag identifies the derived type, so no dynamic_cast is required
+        switch (_type) {
+            case value_type::string:
+                visitor.visit(static_cast<string_value const&>(*this));
+                break;
+            case value_type::integer:
+                visitor.visit(static_cast<integer_value const&>(*this));
+                break;
+            case value_type::boolean:
+                visitor.visit(static_cast<boolean_value const&>(*this));
+                break;
+            case value_type::floating_point:
+                visitor.visit(static_cast<double_value const&>(*this));
+                break;
+            case value_type::array:
+                visitor.visit(static_cast<array_value const&>(*this));
+                break;
+            case value_type::map:
+                visitor.visit(static_cast<map_value const&>(*this));
+                break;
+            default:
+                visitor.visit(*this);
+                break;
+        }
+    }
+
+    void value_visitor::visit(value const& val)
+    {
+    }
+
+}}  // namespace facter::facts
@@ -0,0 +1,143 @@
+#include <internal/facts/value_arena.hpp>
+#include <internal/facts/string_pool.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/tss.hpp>
+#include <atomic>
+#include <new>
+
+using namespace std;
+
+namespace facter { namespace facts {
+
+    // Every allocation is preceded by a header that records the block it was allocated from
+    // The header is padded so that allocations keep the alignment guaranteed by operator new
+    static const size_t alignment = 16;
+
+    struct header
+    {
+        void* owner;
+    };
+
+    static const size_t header_size = (sizeof(header) + alignment - 1) & ~(alignment - 1);
+
+    struct value_arena::block
+    {
+        explicit block(size_t size) :
+            references(1),
+            used(0),
+            size(size)
+        {
+        }
+
+        // One reference is held for each live allocation and one by the arena while it allocates from the block
+        atomic<size_t> references;
+        size_t used;
+        size_t size;
+    };
+
+    static void no_cleanup(value_arena*)
+    {
+    }
+
+    static boost::thread_specific_ptr<value_arena> current_arena(no_cleanup);
+
+    value_arena::value_arena(size_t block_size) :
+        _block_size(block_size),
+        _current(nullptr),
+        _strings(make_shared<string_pool>())
+    {
+    }
+
+    value_arena::~value_arena()
+    {
+        if (_current) {
+            release(_current);
+        }
+    }
+
+    void* value_arena::allocate(size_t size)
+    {
+        auto arena = current_arena.get();
+        if (arena) {
+            auto ptr = arena->allocate_from_block(size);
+            if (ptr) {
+                return ptr;
+            }
+        }
+
+        auto memory = static_cast<char*>(::operator new(header_size + size));
+        reinterpret_cast<header*>(memory)->owner = nullptr;
+        return memory + header_size;
+    }
+
+    void value_arena::deallocate(void* ptr)
+    {
+        if (!ptr) {
+            return;
+        }
+        auto memory = static_cast<char*>(ptr) - header_size;
+        auto owner = static_cast<block*>(reinterpret_cast<header*>(memory)->owner);
+        if (!owner) {
+            ::operator delete(memory);
+            return;
+        }
+        release(owner);
+    }
+
+    value_arena* value_arena::current()
+    {
+        return current_arena.get();
+    }
+
+    shared_ptr<string_pool> const& value_arena::strings() const
+    {
+        return _strings;
+    }
+
+    void* value_arena::allocate_from_block(size_t size)
+    {
+        // Large values are allocated from the heap so they don't waste the remainder of a block
+        size_t total = header_size + ((size + alignment - 1) & ~(alignment - 1));
+        if (total > _block_size / 4) {
+            return nullptr;
+        }
+
+        static const size_t block_header_size = (sizeof(block) + alignment - 1) & ~(alignment - 1);
+
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        if (!_current || _current->used + total > _current->size) {
+            auto memory = ::operator new(block_header_size + _block_size);
+            auto next = new (memory) block(_block_size);
+            if (_current) {
+                release(_current);
+            }
+            _current = next;
+        }
+
+        auto memory = reinterpret_cast<char*>(_current) + block_header_size + _current->used;
+        _current->used += total;
+        ++_current->references;
+        reinterpret_cast<header*>(memory)->owner = _current;
+        return memory + header_size;
+    }
+
+    void value_arena::release(block* b)
+    {
+        if (--b->references == 0) {
+            b->~block();
+            ::operator delete(b);
+        }
+    }
+
+    value_arena::scope::scope(value_arena* arena) :
+        _previous(current_arena.get())
+    {
+        current_arena.reset(arena);
+    }
+
+    value_arena::scope::~scope()
+    {
+        current_arena.reset(_previous);
+    }
+
+}}  // namespace facter::facts
@@ -0,0 +1,23 @@
+#include <internal/facts/cache.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+
+using namespace std;
+
+namespace facter { namespace facts {
+
+    bool fact_cache::create_private_directory(string const& path)
+    {
+        // The directory inherits the access control list of its parent (the user's profile or ProgramData)
+        boost::system::error_code ec;
+        boost::filesystem::create_directory(path, ec);
+        return !ec;
+    }
+
+    bool fact_cache::write_private_file(string const& path, string const& contents)
+    {
+        boost::nowide::ofstream out(path.c_str(), ios::binary | ios::trunc);
+        return out && out.write(contents.data(), contents.size());
+    }
+
+}}  // namespace facter::facts
@@ -56,6 +56,26 @@ namespace facter { namespace facts {
         return {};
     }
 
+    string collection::get_cache_file() const
+    {
+        if (user::is_admin()) {
+            TCHAR szPath[MAX_PATH];
+            if (SUCCEEDED(SHGetFolderPath(NULL, CSIDL_COMMON_APPDATA, NULL, 0, szPath))) {
+                path p = path(szPath) / "PuppetLabs" / "facter" / "cache" / "cached_facts";
+                return p.string();
+            }
+            LOG_DEBUG("error finding COMMON_APPDATA, fact cache unavailable: %1%", system_error());
+            return {};
+        }
+
+        auto home = user::home_dir();
+        if (!home.empty()) {
+            path p = path(home) / ".puppetlabs" / "opt" / "facter" / "cache" / "cached_facts";
+            return p.string();
+        }
+        return {};
+    }
+
     vector<unique_ptr<external::resolver>> collection::get_external_resolvers()
     {
         vector<unique_ptr<external::resolver>> resolvers;
@@ -2,6 +2,7 @@
 #include <leatherman/windows/registry.hpp>
 #include <leatherman/windows/system_error.hpp>
 #include <internal/util/windows/wsa.hpp>
+#include <facter/facts/fact.hpp>
 #include <leatherman/windows/windows.hpp>
 #include <leatherman/logging/logging.hpp>
 #include <boost/algorithm/string.hpp>
@@ -204,6 +205,11 @@ namespace facter { namespace facts { namespace windows {
             interface net_interface;
             net_interface.name = boost::nowide::narrow(pCurAddr->FriendlyName);
 
+            // Skip interfaces that were not queried or are filtered out
+            if (!is_collected(fact::networking, { "interfaces", net_interface.name }) || !is_included(facts, net_interface.name)) {
+                continue;
+            }
+
             // Only supported on platforms after Windows Server 2003.
             if (pCurAddr->Flags & IP_ADAPTER_DHCP_ENABLED && pCurAddr->Length >= sizeof(IP_ADAPTER_ADDRESSES_LH)) {
                 auto adapter = reinterpret_cast<IP_ADAPTER_ADDRESSES_LH&>(*pCurAddr);
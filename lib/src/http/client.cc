@@ -139,6 +139,12 @@ namespace facter { namespace http {
             throw http_request_exception(req, curl_easy_strerror(result));
         }
 
+        // Don't let curl use signals for timeouts as requests may be performed off the main thread
+        result = curl_easy_setopt(_handle, CURLOPT_NOSIGNAL, 1);
+        if (result != CURLE_OK) {
+            throw http_request_exception(req, curl_easy_strerror(result));
+        }
+
         // Set tracing from libcurl if enabled (we don't care if this fails)
         if (LOG_IS_DEBUG_ENABLED()) {
             curl_easy_setopt(_handle, CURLOPT_DEBUGFUNCTION, debug);
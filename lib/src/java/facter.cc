@@ -45,45 +45,79 @@ static jclass find_class(JNIEnv* env, char const* name)
     return static_cast<jclass>(env->NewGlobalRef(klass));
 }
 
-static jobject to_object(JNIEnv* env, value const* val)
+static jobject to_object(JNIEnv* env, value const* val);
+
+struct object_visitor : value_visitor
 {
-    if (!val) {
-        return nullptr;
+    explicit object_visitor(JNIEnv* env) :
+        _env(env),
+        _result(nullptr)
+    {
     }
-    if (auto ptr = dynamic_cast<string_value const*>(val)) {
-        return env->NewStringUTF(ptr->value().c_str());
+
+    virtual void visit(string_value const& val) override
+    {
+        _result = _env->NewStringUTF(val.value().c_str());
     }
-    if (auto ptr = dynamic_cast<integer_value const*>(val)) {
-        return env->NewObject(long_class, long_constructor, static_cast<jlong>(ptr->value()));
+
+    virtual void visit(integer_value const& val) override
+    {
+        _result = _env->NewObject(long_class, long_constructor, static_cast<jlong>(val.value()));
     }
-    if (auto ptr = dynamic_cast<boolean_value const*>(val)) {
-        return env->NewObject(boolean_class, boolean_constructor, static_cast<jboolean>(ptr->value()));
+
+    virtual void visit(boolean_value const& val) override
+    {
+        _result = _env->NewObject(boolean_class, boolean_constructor, static_cast<jboolean>(val.value()));
     }
-    if (auto ptr = dynamic_cast<double_value const*>(val)) {
-        return env->NewObject(double_class, double_constructor, static_cast<jdouble>(ptr->value()));
+
+    virtual void visit(double_value const& val) override
+    {
+        _result = _env->NewObject(double_class, double_constructor, static_cast<jdouble>(val.value()));
     }
-    if (auto ptr = dynamic_cast<array_value const*>(val)) {
-        auto array = env->NewObjectArray(ptr->size(), object_class, nullptr);
+
+    virtual void visit(array_value const& val) override
+    {
+        auto array = _env->NewObjectArray(val.size(), object_class, nullptr);
 
         // Recurse on each element of the array
         jsize index = 0;
-        ptr->each([&](value const* element) {
-            env->SetObjectArrayElement(array, index++, to_object(env, element));
+        val.each([&](value const* element) {
+            _env->SetObjectArrayElement(array, index++, to_object(_env, element));
             return true;
         });
-        return array;
+        _result = array;
     }
-    if (auto ptr = dynamic_cast<map_value const*>(val)) {
-        auto hashmap = env->NewObject(hash_class, hash_constructor, static_cast<jint>(ptr->size()));
+
+    virtual void visit(map_value const& val) override
+    {
+        auto hashmap = _env->NewObject(hash_class, hash_constructor, static_cast<jint>(val.size()));
 
         // Recurse on each element in the map
-        ptr->each([&](string const& name, value const* element) {
-            env->CallObjectMethod(hashmap, hash_put, env->NewStringUTF(name.c_str()), to_object(env, element));
+        val.each([&](string const& name, value const* element) {
+            _env->CallObjectMethod(hashmap, hash_put, _env->NewStringUTF(name.c_str()), to_object(_env, element));
             return true;
         });
-        return hashmap;
+        _result = hashmap;
+    }
+
+    jobject result() const
+    {
+        return _result;
+    }
+
+ private:
+    JNIEnv* _env;
+    jobject _result;
+};
+
+static jobject to_object(JNIEnv* env, value const* val)
+{
+    if (!val) {
+        return nullptr;
     }
-    return nullptr;
+    object_visitor visitor(env);
+    val->accept(visitor);
+    return visitor.result();
 }
 
 extern "C" {
@@ -391,43 +391,80 @@ namespace facter { namespace ruby {
         return _false;
     }
 
-    VALUE api::to_ruby(value const* val) const
+    // Converts each type of fact value to its Ruby equivalent
+    struct ruby_visitor : value_visitor
     {
-        if (!val) {
-            return _nil;
+        explicit ruby_visitor(api const& ruby) :
+            _ruby(ruby),
+            _result(ruby.nil_value())
+        {
         }
-        if (auto ptr = dynamic_cast<ruby_value const*>(val)) {
-            return ptr->value();
-        }
-        if (auto ptr = dynamic_cast<string_value const*>(val)) {
-            return utf8_value(ptr->value());
+
+        virtual void visit(string_value const& val) override
+        {
+            _result = _ruby.utf8_value(val.value());
         }
-        if (auto ptr = dynamic_cast<integer_value const*>(val)) {
-            return rb_int2inum(static_cast<SIGNED_VALUE>(ptr->value()));
+
+        virtual void visit(integer_value const& val) override
+        {
+            _result = _ruby.rb_int2inum(static_cast<SIGNED_VALUE>(val.value()));
         }
-        if (auto ptr = dynamic_cast<boolean_value const*>(val)) {
-            return ptr->value() ? _true : _false;
+
+        virtual void visit(boolean_value const& val) override
+        {
+            _result = val.value() ? _ruby.true_value() : _ruby.false_value();
         }
-        if (auto ptr = dynamic_cast<double_value const*>(val)) {
-            return rb_float_new_in_heap(ptr->value());
+
+        virtual void visit(double_value const& val) override
+        {
+            _result = _ruby.rb_float_new_in_heap(val.value());
         }
-        if (auto ptr = dynamic_cast<array_value const*>(val)) {
-            volatile VALUE array = rb_ary_new_capa(static_cast<long>(ptr->size()));
-            ptr->each([&](value const* element) {
-                rb_ary_push(array, to_ruby(element));
+
+        virtual void visit(array_value const& val) override
+        {
+            volatile VALUE array = _ruby.rb_ary_new_capa(static_cast<long>(val.size()));
+            val.each([&](value const* element) {
+                _ruby.rb_ary_push(array, _ruby.to_ruby(element));
                 return true;
             });
-            return array;
+            _result = array;
         }
-        if (auto ptr = dynamic_cast<map_value const*>(val)) {
-            volatile VALUE hash = rb_hash_new();
-            ptr->each([&](string const& name, value const* element) {
-                rb_hash_aset(hash, utf8_value(name), to_ruby(element));
+
+        virtual void visit(map_value const& val) override
+        {
+            volatile VALUE hash = _ruby.rb_hash_new();
+            val.each([&](string const& name, value const* element) {
+                _ruby.rb_hash_aset(hash, _ruby.utf8_value(name), _ruby.to_ruby(element));
                 return true;
             });
-            return hash;
+            _result = hash;
         }
-        return _nil;
+
+        virtual void visit(value const& val) override
+        {
+            if (auto ptr = value_cast<ruby_value>(&val)) {
+                _result = ptr->value();
+            }
+        }
+
+        VALUE result() const
+        {
+            return _result;
+        }
+
+     private:
+        api const& _ruby;
+        volatile VALUE _result;
+    };
+
+    VALUE api::to_ruby(value const* val) const
+    {
+        if (!val) {
+            return _nil;
+        }
+        ruby_visitor visitor(*this);
+        val->accept(visitor);
+        return visitor.result();
     }
 
     VALUE api::lookup(std::initializer_list<std::string> const& names) const
@@ -271,6 +271,9 @@ namespace facter { namespace ruby {
 
         auto const& ruby = *api::instance();
 
+        // Custom facts run their commands with the collection's command cache current
+        command_cache::scope commands(_collection.command_cache());
+
         // Get the value from all facts
         for (auto const& kvp : _facts) {
             ruby.to_native<fact>(kvp.second)->value();
@@ -1,4 +1,6 @@
 #include <internal/ruby/ruby_value.hpp>
+#include <facter/facts/json_writer.hpp>
+#include <facter/facts/msgpack.hpp>
 #include <facter/util/string.hpp>
 #include <rapidjson/document.h>
 #include <yaml-cpp/yaml.h>
@@ -44,6 +46,18 @@ namespace facter { namespace ruby {
         to_json(ruby, _value, allocator, value);
     }
 
+    void ruby_value::write(json_writer& writer) const
+    {
+        auto const& ruby = *api::instance();
+        write(ruby, _value, writer);
+    }
+
+    void ruby_value::write(msgpack_writer& writer) const
+    {
+        auto const& ruby = *api::instance();
+        write(ruby, _value, writer);
+    }
+
     ostream& ruby_value::write(ostream& os, bool quoted, unsigned int level) const
     {
         auto const& ruby = *api::instance();
@@ -125,6 +139,118 @@ namespace facter { namespace ruby {
         json.SetNull();
     }
 
+    void ruby_value::write(api const& ruby, VALUE value, json_writer& writer)
+    {
+        if (ruby.is_true(value)) {
+            writer.write_boolean(true);
+            return;
+        }
+        if (ruby.is_false(value)) {
+            writer.write_boolean(false);
+            return;
+        }
+        if (ruby.is_string(value) || ruby.is_symbol(value)) {
+            volatile VALUE temp = value;
+
+            if (ruby.is_symbol(value)) {
+                temp = ruby.rb_funcall(value, ruby.rb_intern("to_s"), 0);
+            }
+
+            size_t size = static_cast<size_t>(ruby.rb_num2ulong(ruby.rb_funcall(temp, ruby.rb_intern("bytesize"), 0)));
+            char const* str = ruby.rb_string_value_ptr(&temp);
+            writer.write_string(str, size);
+            return;
+        }
+        if (ruby.is_fixednum(value)) {
+            writer.write_integer(ruby.rb_num2ulong(value));
+            return;
+        }
+        if (ruby.is_float(value)) {
+            writer.write_double(ruby.rb_num2dbl(value));
+            return;
+        }
+        if (ruby.is_array(value)) {
+            writer.start_array();
+            ruby.array_for_each(value, [&](VALUE element) {
+                write(ruby, element, writer);
+                return true;
+            });
+            writer.end_array();
+            return;
+        }
+        if (ruby.is_hash(value)) {
+            writer.start_object();
+            ruby.hash_for_each(value, [&](VALUE key, VALUE element) {
+                // If the key isn't a string, convert to string
+                if (!ruby.is_string(key)) {
+                    key = ruby.rb_funcall(key, ruby.rb_intern("to_s"), 0);
+                }
+                writer.write_key(ruby.rb_string_value_ptr(&key));
+                write(ruby, element, writer);
+                return true;
+            });
+            writer.end_object();
+            return;
+        }
+
+        writer.write_null();
+    }
+
+    void ruby_value::write(api const& ruby, VALUE value, msgpack_writer& writer)
+    {
+        if (ruby.is_true(value)) {
+            writer.write_boolean(true);
+            return;
+        }
+        if (ruby.is_false(value)) {
+            writer.write_boolean(false);
+            return;
+        }
+        if (ruby.is_string(value) || ruby.is_symbol(value)) {
+            volatile VALUE temp = value;
+
+            if (ruby.is_symbol(value)) {
+                temp = ruby.rb_funcall(value, ruby.rb_intern("to_s"), 0);
+            }
+
+            size_t size = static_cast<size_t>(ruby.rb_num2ulong(ruby.rb_funcall(temp, ruby.rb_intern("bytesize"), 0)));
+            char const* str = ruby.rb_string_value_ptr(&temp);
+            writer.write_string(str, size);
+            return;
+        }
+        if (ruby.is_fixednum(value)) {
+            writer.write_integer(ruby.rb_num2ulong(value));
+            return;
+        }
+        if (ruby.is_float(value)) {
+            writer.write_double(ruby.rb_num2dbl(value));
+            return;
+        }
+        if (ruby.is_array(value)) {
+            writer.write_array(static_cast<size_t>(ruby.rb_num2ulong(ruby.rb_funcall(value, ruby.rb_intern("size"), 0))));
+            ruby.array_for_each(value, [&](VALUE element) {
+                write(ruby, element, writer);
+                return true;
+            });
+            return;
+        }
+        if (ruby.is_hash(value)) {
+            writer.write_map(static_cast<size_t>(ruby.rb_num2ulong(ruby.rb_funcall(value, ruby.rb_intern("size"), 0))));
+            ruby.hash_for_each(value, [&](VALUE key, VALUE element) {
+                // If the key isn't a string, convert to string
+                if (!ruby.is_string(key)) {
+                    key = ruby.rb_funcall(key, ruby.rb_intern("to_s"), 0);
+                }
+                writer.write_string(ruby.rb_string_value_ptr(&key));
+                write(ruby, element, writer);
+                return true;
+            });
+            return;
+        }
+
+        writer.write_nil();
+    }
+
     void ruby_value::write(api const& ruby, VALUE value, ostream& os, bool quoted, unsigned int level)
     {
         if (ruby.is_true(value)) {
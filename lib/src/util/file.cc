@@ -1,27 +1,68 @@
 #include <facter/util/file.hpp>
 #include <boost/nowide/fstream.hpp>
-#include <sstream>
+#include <cstring>
 
 using namespace std;
 
 namespace facter { namespace util {
 
-    bool file::each_line(string const& path, function<bool(string&)> callback)
+    template <typename Callback>
+    static void split_lines(char const* data, size_t size, Callback&& callback)
     {
-        boost::nowide::ifstream in(path.c_str());
-        if (!in) {
-            return false;
-        }
-
-        string line;
-        while (getline(in, line)) {
-            if (!callback(line)) {
+        auto end = data + size;
+        while (data < end) {
+            auto line_end = static_cast<char const*>(memchr(data, '\n', end - data));
+            if (!line_end) {
+                line_end = end;
+            }
+            // Strip the carriage return of a CRLF line ending, as the file is read in binary mode
+            auto length = static_cast<size_t>(line_end - data);
+            if (length > 0 && data[length - 1] == '\r') {
+                --length;
+            }
+            if (!callback(data, length)) {
                 break;
             }
+            data = line_end + 1;
         }
+    }
+
+    template <typename Callback>
+    static bool each_line_in(string const& path, Callback&& callback)
+    {
+        // The file is read rather than mapped into memory, as a mapped file that is truncated while being read raises SIGBUS
+        string contents;
+        if (!file::read(path, contents)) {
+            return false;
+        }
+        split_lines(contents.data(), contents.size(), callback);
         return true;
     }
 
+    bool file::each_line(string const& path, function<bool(string&)> callback)
+    {
+        // Reuse the line so that it is only reallocated when a longer line is read
+        string line;
+        return each_line_in(path, [&](char const* data, size_t size) {
+            line.assign(data, size);
+            return callback(line);
+        });
+    }
+
+    bool file::each_line_ref(string const& path, function<bool(boost::string_ref)> callback)
+    {
+        return each_line_in(path, [&](char const* data, size_t size) {
+            return callback(boost::string_ref(data, size));
+        });
+    }
+
+    void file::each_line_ref(char const* data, size_t size, function<bool(boost::string_ref)> const& callback)
+    {
+        split_lines(data, size, [&](char const* line, size_t length) {
+            return callback(boost::string_ref(line, length));
+        });
+    }
+
     string file::read(string const& path)
     {
         string contents;
@@ -34,12 +75,27 @@ namespace facter { namespace util {
     bool file::read(string const& path, string& contents)
     {
         boost::nowide::ifstream in(path.c_str(), ios::in | ios::binary);
-        ostringstream buffer;
         if (!in) {
             return false;
         }
-        buffer << in.rdbuf();
-        contents = buffer.str();
+
+        // Read directly into the string; files in /proc report no size, so grow the string until the end is reached
+        auto buffer = in.rdbuf();
+        auto end = buffer->pubseekoff(0, ios::end, ios::in);
+        buffer->pubseekoff(0, ios::beg, ios::in);
+        size_t size = 0;
+        contents.resize(end > 0 ? static_cast<size_t>(end) + 1 : 4096);
+        while (true) {
+            auto count = buffer->sgetn(&contents[size], contents.size() - size);
+            if (count <= 0) {
+                break;
+            }
+            size += static_cast<size_t>(count);
+            if (size == contents.size()) {
+                contents.resize(contents.size() * 2);
+            }
+        }
+        contents.resize(size);
         return true;
     }
 
@@ -0,0 +1,358 @@
+#include <internal/util/linux/attribute_reader.hpp>
+#include <leatherman/logging/logging.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#ifdef USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif  // USE_IO_URING
+
+using namespace std;
+using namespace facter::util::posix;
+
+namespace facter { namespace util { namespace linux {
+
+    static void assign_trimmed(string& value, char const* data, size_t size)
+    {
+        char const* begin = data;
+        char const* end = data + size;
+        while (begin != end && isspace(static_cast<unsigned char>(*begin))) {
+            ++begin;
+        }
+        while (end != begin && isspace(static_cast<unsigned char>(*(end - 1)))) {
+            --end;
+        }
+        value.assign(begin, end);
+    }
+
+#ifdef USE_IO_URING
+    // Set once io_uring is found to be unavailable (e.g. an old kernel or a seccomp filter) so it is not tried again
+    static atomic<bool> io_uring_unavailable(false);
+
+    // The number of attributes read with each submission
+    static const size_t io_uring_batch_size = 128;
+
+    // A minimal io_uring that opens, reads and closes each attribute with a chain of linked requests
+    // The files are opened as direct descriptors (slots in the ring's file table), so the read can be linked to the open
+    struct attribute_reader::uring
+    {
+        uring() :
+            fd(-1),
+            sq_ring(MAP_FAILED),
+            cq_ring(MAP_FAILED),
+            sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+            sq_ring_size(0),
+            cq_ring_size(0),
+            sqes_size(0)
+        {
+        }
+
+        ~uring()
+        {
+            if (sqes != MAP_FAILED) {
+                munmap(sqes, sqes_size);
+            }
+            if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+                munmap(cq_ring, cq_ring_size);
+            }
+            if (sq_ring != MAP_FAILED) {
+                munmap(sq_ring, sq_ring_size);
+            }
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+
+        bool setup(unsigned int entries)
+        {
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) {
+                return false;
+            }
+
+            // Opening into a direct descriptor requires 5.15; skipping completions (5.17) is the closest feature bit
+            if (!(params.features & IORING_FEAT_CQE_SKIP)) {
+                errno = EOPNOTSUPP;
+                return false;
+            }
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single_mmap) {
+                sq_ring_size = cq_ring_size = max(sq_ring_size, cq_ring_size);
+            }
+            sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sq_ring == MAP_FAILED) {
+                return false;
+            }
+            cq_ring = single_mmap ? sq_ring : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cq_ring == MAP_FAILED) {
+                return false;
+            }
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+            if (sqes == MAP_FAILED) {
+                return false;
+            }
+
+            auto sq = static_cast<char*>(sq_ring);
+            sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+            sq_mask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+            auto cq = static_cast<char*>(cq_ring);
+            cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+            cq_mask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            // Register an empty file table with a slot for each attribute of a batch
+            vector<int> slots(io_uring_batch_size, -1);
+            return syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES, slots.data(), static_cast<unsigned int>(slots.size())) == 0;
+        }
+
+        io_uring_sqe* next_sqe()
+        {
+            // The kernel only consumes entries on submission, so the ring is never full between submissions
+            auto tail = *sq_tail;
+            auto index = tail & sq_mask;
+            sq_array[index] = index;
+            __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+            auto sqe = &sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            return sqe;
+        }
+
+        bool submit_and_wait(unsigned int count)
+        {
+            // Every request has a completion, including the requests cancelled by a failed open
+            unsigned int submitted = 0;
+            while (submitted < count) {
+                auto result = syscall(__NR_io_uring_enter, fd, count - submitted, count, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (result < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                submitted += static_cast<unsigned int>(result);
+            }
+            while (pending() < count) {
+                if (syscall(__NR_io_uring_enter, fd, 0, count, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        unsigned int pending() const
+        {
+            return __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) - *cq_head;
+        }
+
+        template <typename Callback>
+        void each_completion(Callback callback)
+        {
+            auto head = *cq_head;
+            auto tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; ++head) {
+                callback(cqes[head & cq_mask]);
+            }
+            __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        }
+
+        int fd;
+        void* sq_ring;
+        void* cq_ring;
+        io_uring_sqe* sqes;
+        size_t sq_ring_size;
+        size_t cq_ring_size;
+        size_t sqes_size;
+        unsigned int* sq_tail;
+        unsigned int sq_mask;
+        unsigned int* sq_array;
+        unsigned int* cq_head;
+        unsigned int* cq_tail;
+        unsigned int cq_mask;
+        io_uring_cqe* cqes;
+    };
+#else
+    struct attribute_reader::uring
+    {
+    };
+#endif  // USE_IO_URING
+
+    attribute_reader::attribute_reader(string const& directory) :
+        _directory(open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC))
+    {
+    }
+
+    attribute_reader::~attribute_reader()
+    {
+    }
+
+    attribute_reader::operator bool() const
+    {
+        return static_cast<int>(_directory) >= 0;
+    }
+
+    bool attribute_reader::exists(string const& name) const
+    {
+        return *this && faccessat(_directory, name.c_str(), F_OK, 0) == 0;
+    }
+
+    bool attribute_reader::read(string const& name, string& value)
+    {
+        value.clear();
+        if (!*this) {
+            return false;
+        }
+
+        scoped_descriptor file(openat(_directory, name.c_str(), O_RDONLY | O_CLOEXEC));
+        if (static_cast<int>(file) < 0) {
+            return false;
+        }
+
+        // Attributes are usually returned by a single read; keep reading for regular files larger than the buffer
+        if (_buffer.size() < batch_attribute_size) {
+            _buffer.resize(batch_attribute_size);
+        }
+        size_t size = 0;
+        while (true) {
+            if (size == _buffer.size()) {
+                _buffer.resize(_buffer.size() * 2);
+            }
+            auto result = ::read(file, _buffer.data() + size, _buffer.size() - size);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (result == 0) {
+                break;
+            }
+            size += static_cast<size_t>(result);
+        }
+        assign_trimmed(value, _buffer.data(), size);
+        return true;
+    }
+
+    string attribute_reader::read(string const& name)
+    {
+        string value;
+        read(name, value);
+        return value;
+    }
+
+    vector<string> attribute_reader::read_all(vector<string> const& names)
+    {
+        vector<string> values(names.size());
+        if (!*this) {
+            return values;
+        }
+
+        size_t offset = 0;
+#ifdef USE_IO_URING
+        // The ring is set up once per reader, so any batch of more than one attribute is worth submitting
+        if (names.size() > 1 && !io_uring_unavailable) {
+            for (; offset < names.size(); offset += io_uring_batch_size) {
+                if (!read_batch(names, offset, min(io_uring_batch_size, names.size() - offset), values)) {
+                    break;
+                }
+            }
+        }
+#endif  // USE_IO_URING
+        for (; offset < names.size(); ++offset) {
+            read(names[offset], values[offset]);
+        }
+        return values;
+    }
+
+    bool attribute_reader::read_batch(vector<string> const& names, size_t offset, size_t count, vector<string>& values)
+    {
+#ifdef USE_IO_URING
+        if (!_ring) {
+            unique_ptr<uring> ring(new uring());
+            if (!ring->setup(static_cast<unsigned int>(io_uring_batch_size * 3))) {
+                LOG_DEBUG("io_uring is unavailable: %1% (%2%): attributes will be read individually.", strerror(errno), errno);
+                io_uring_unavailable = true;
+                return false;
+            }
+            _ring = move(ring);
+        }
+
+        // Each attribute is opened into its slot, read and closed by one chain of requests
+        // The close is hard linked to the read so that it runs even when the read is short or fails
+        if (_buffer.size() < count * batch_attribute_size) {
+            _buffer.resize(count * batch_attribute_size);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            auto sqe = _ring->next_sqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = _directory;
+            sqe->addr = reinterpret_cast<uint64_t>(names[offset + i].c_str());
+            sqe->open_flags = O_RDONLY;
+            sqe->file_index = static_cast<uint32_t>(i + 1);
+            sqe->flags = IOSQE_IO_LINK;
+            sqe->user_data = i * 3;
+
+            sqe = _ring->next_sqe();
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = static_cast<int>(i);
+            sqe->addr = reinterpret_cast<uint64_t>(_buffer.data() + i * batch_attribute_size);
+            sqe->len = batch_attribute_size;
+            sqe->off = 0;
+            sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+            sqe->user_data = i * 3 + 1;
+
+            sqe = _ring->next_sqe();
+            sqe->opcode = IORING_OP_CLOSE;
+            sqe->file_index = static_cast<uint32_t>(i + 1);
+            sqe->user_data = i * 3 + 2;
+        }
+
+        vector<int> sizes(count, -1);
+        bool submitted = _ring->submit_and_wait(static_cast<unsigned int>(count * 3));
+        bool unsupported = false;
+        _ring->each_completion([&](io_uring_cqe const& cqe) {
+            auto index = static_cast<size_t>(cqe.user_data / 3);
+            switch (cqe.user_data % 3) {
+                case 0:
+                    unsupported = unsupported || cqe.res == -EINVAL;
+                    break;
+                case 1:
+                    sizes[index] = cqe.res;
+                    unsupported = unsupported || cqe.res == -EINVAL || cqe.res == -EOPNOTSUPP;
+                    break;
+                default:
+                    break;
+            }
+        });
+        if (!submitted || unsupported) {
+            LOG_DEBUG("io_uring reads are unsupported: attributes will be read individually.");
+            io_uring_unavailable = true;
+            return false;
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            if (sizes[i] >= 0) {
+                assign_trimmed(values[offset + i], _buffer.data() + i * batch_attribute_size, static_cast<size_t>(sizes[i]));
+            }
+        }
+        return true;
+#else
+        return false;
+#endif  // USE_IO_URING
+    }
+
+}}}  // namespace facter::util::linux
@@ -0,0 +1,184 @@
+#include <internal/util/smbios.hpp>
+#include <facter/util/file.hpp>
+#include <leatherman/logging/logging.hpp>
+#include <boost/algorithm/string.hpp>
+#include <cstring>
+#include <limits>
+
+using namespace std;
+
+namespace facter { namespace util {
+
+    static uint8_t get_byte(string const& data, size_t offset)
+    {
+        return static_cast<uint8_t>(data[offset]);
+    }
+
+    static uint16_t get_word(string const& data, size_t offset)
+    {
+        return static_cast<uint16_t>(get_byte(data, offset) | (get_byte(data, offset + 1) << 8));
+    }
+
+    static uint32_t get_dword(string const& data, size_t offset)
+    {
+        return static_cast<uint32_t>(get_word(data, offset)) | (static_cast<uint32_t>(get_word(data, offset + 2)) << 16);
+    }
+
+    static bool valid_checksum(string const& data, size_t offset, size_t length)
+    {
+        if (offset + length > data.size()) {
+            return false;
+        }
+        uint8_t sum = 0;
+        for (size_t i = offset; i < offset + length; ++i) {
+            sum += get_byte(data, i);
+        }
+        return sum == 0;
+    }
+
+    uint8_t smbios::structure::byte(size_t offset) const
+    {
+        return offset < formatted.size() ? formatted[offset] : 0;
+    }
+
+    uint16_t smbios::structure::word(size_t offset) const
+    {
+        return offset + 1 < formatted.size() ? static_cast<uint16_t>(formatted[offset] | (formatted[offset + 1] << 8)) : 0;
+    }
+
+    string smbios::structure::text(size_t offset) const
+    {
+        // String number 0 means the field has no string
+        auto number = byte(offset);
+        if (number == 0 || number > strings.size()) {
+            return {};
+        }
+        return boost::trim_copy(strings[number - 1]);
+    }
+
+    smbios::smbios() :
+        _version(0)
+    {
+    }
+
+    bool smbios::read(string const& directory)
+    {
+        string entry_point;
+        string table;
+        if (!file::read(directory + "/smbios_entry_point", entry_point) || !file::read(directory + "/DMI", table)) {
+            LOG_DEBUG("SMBIOS tables could not be read from %1%.", directory);
+            return false;
+        }
+        return decode(entry_point, table);
+    }
+
+    bool smbios::decode(string const& entry_point, string const& table)
+    {
+        _version = 0;
+        _structures.clear();
+
+        size_t max_structures = numeric_limits<size_t>::max();
+        size_t table_size = table.size();
+        if (entry_point.compare(0, 5, "_SM3_") == 0) {
+            // The 64-bit entry point has a maximum table size rather than a structure count
+            if (entry_point.size() < 0x18 || !valid_checksum(entry_point, 0, get_byte(entry_point, 0x06))) {
+                LOG_DEBUG("SMBIOS 3 entry point is invalid.");
+                return false;
+            }
+            _version = static_cast<uint16_t>((get_byte(entry_point, 0x07) << 8) | get_byte(entry_point, 0x08));
+            table_size = min<size_t>(table_size, get_dword(entry_point, 0x0C));
+        } else if (entry_point.compare(0, 4, "_SM_") == 0) {
+            // The intermediate entry point follows the 32-bit entry point at offset 0x10
+            if (entry_point.size() < 0x1F || !valid_checksum(entry_point, 0, get_byte(entry_point, 0x05)) || !valid_checksum(entry_point, 0x10, 0x0F)) {
+                LOG_DEBUG("SMBIOS entry point is invalid.");
+                return false;
+            }
+            _version = static_cast<uint16_t>((get_byte(entry_point, 0x06) << 8) | get_byte(entry_point, 0x07));
+            table_size = min<size_t>(table_size, get_word(entry_point, 0x16));
+            max_structures = get_word(entry_point, 0x1C);
+        } else if (entry_point.compare(0, 5, "_DMI_") == 0) {
+            // The legacy entry point has a BCD version
+            if (entry_point.size() < 0x0F || !valid_checksum(entry_point, 0, 0x0F)) {
+                LOG_DEBUG("legacy DMI entry point is invalid.");
+                return false;
+            }
+            auto bcd = get_byte(entry_point, 0x0E);
+            _version = static_cast<uint16_t>(((bcd >> 4) << 8) | (bcd & 0x0F));
+            table_size = min<size_t>(table_size, get_word(entry_point, 0x06));
+            max_structures = get_word(entry_point, 0x0C);
+        } else {
+            LOG_DEBUG("SMBIOS entry point has an unknown anchor.");
+            return false;
+        }
+
+        decode_table(table.substr(0, table_size), max_structures);
+        return true;
+    }
+
+    uint16_t smbios::version() const
+    {
+        return _version;
+    }
+
+    vector<smbios::structure> const& smbios::structures() const
+    {
+        return _structures;
+    }
+
+    smbios::structure const* smbios::find(uint8_t type) const
+    {
+        for (auto const& s : _structures) {
+            if (s.type == type) {
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+
+    void smbios::decode_table(string const& table, size_t max_structures)
+    {
+        // Each structure is a formatted area starting with a 4 byte header followed by a set of strings ending in two nulls
+        size_t offset = 0;
+        while (_structures.size() < max_structures && offset + 4 <= table.size()) {
+            auto length = get_byte(table, offset + 1);
+            if (length < 4 || offset + length > table.size()) {
+                LOG_DEBUG("SMBIOS structure at offset %1% is truncated.", offset);
+                break;
+            }
+
+            structure s;
+            s.type = get_byte(table, offset);
+            s.handle = get_word(table, offset + 2);
+            s.formatted.assign(table.begin() + offset, table.begin() + offset + length);
+
+            // Read the strings up to the terminating empty string
+            offset += length;
+            bool terminated = false;
+            while (offset < table.size()) {
+                auto end = table.find('\0', offset);
+                if (end == string::npos) {
+                    break;
+                }
+                if (end == offset) {
+                    // An empty string set is still terminated by two nulls
+                    offset += s.strings.empty() ? 2 : 1;
+                    terminated = true;
+                    break;
+                }
+                s.strings.emplace_back(table, offset, end - offset);
+                offset = end + 1;
+            }
+            if (!terminated) {
+                LOG_DEBUG("SMBIOS structure %1% has unterminated strings.", s.handle);
+                break;
+            }
+
+            auto type = s.type;
+            _structures.emplace_back(move(s));
+            if (type == end_of_table) {
+                break;
+            }
+        }
+    }
+
+}}  // namespace facter::util
@@ -0,0 +1,151 @@
+#include <catch.hpp>
+#include <facter/util/file.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/nowide/fstream.hpp>
+#include "measure.hpp"
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace facter::util;
+using namespace facter::testing;
+namespace fs = boost::filesystem;
+
+static void write_cpuinfo(string const& path, int processors)
+{
+    boost::nowide::ofstream out(path.c_str(), ios::binary);
+    for (int i = 0; i < processors; ++i) {
+        out << "processor\t: " << i << "\n"
+            << "vendor_id\t: GenuineIntel\n"
+            << "cpu family\t: 6\n"
+            << "model\t\t: 85\n"
+            << "model name\t: Intel(R) Xeon(R) Platinum 8175M CPU @ 2.50GHz\n"
+            << "physical id\t: " << i / 48 << "\n"
+            << "core id\t\t: " << i % 48 << "\n"
+            << "flags\t\t: fpu vme de pse tsc msr pae mce cx8 apic sep mtrr pge mca cmov pat pse36 clflush mmx fxsr sse sse2 ss ht syscall nx pdpe1gb rdtscp lm "
+               "constant_tsc rep_good nopl xtopology nonstop_tsc cpuid aperfmperf pni pclmulqdq ssse3 fma cx16 pcid sse4_1 sse4_2 x2apic movbe popcnt "
+               "tsc_deadline_timer aes xsave avx f16c rdrand hypervisor lahf_lm abm 3dnowprefetch invpcid_single pti fsgsbase tsc_adjust bmi1 hle avx2 "
+               "smep bmi2 erms invpcid rtm mpx avx512f avx512dq rdseed adx smap clflushopt clwb avx512cd avx512bw avx512vl xsaveopt xsavec xgetbv1 xsaves ida arat pku ospke\n"
+            << "\n";
+    }
+}
+
+static void write_mountinfo(string const& path, int mounts)
+{
+    boost::nowide::ofstream out(path.c_str(), ios::binary);
+    for (int i = 0; i < mounts; ++i) {
+        out << 100 + i << " 1 253:" << i % 16 << " / /var/lib/kubelet/pods/" << i
+            << "/volumes/kubernetes.io~secret/token rw,relatime shared:" << i << " - tmpfs tmpfs rw,size=4096k,inode64\n";
+    }
+}
+
+static void write_leases(string const& path, int leases)
+{
+    boost::nowide::ofstream out(path.c_str(), ios::binary);
+    for (int i = 0; i < leases; ++i) {
+        out << "lease {\n"
+            << "  interface \"eth" << i % 4 << "\";\n"
+            << "  fixed-address 10.0." << (i / 256) % 256 << "." << i % 256 << ";\n"
+            << "  option subnet-mask 255.255.255.0;\n"
+            << "  option routers 10.0.0.1;\n"
+            << "  option dhcp-lease-time 3600;\n"
+            << "  option dhcp-server-identifier 10.0.0.1;\n"
+            << "  renew 2 2015/05/12 18:27:43;\n"
+            << "  rebind 2 2015/05/12 18:49:58;\n"
+            << "  expire 2 2015/05/12 18:57:28;\n"
+            << "}\n";
+    }
+}
+
+// The line and content readers as they were before file::each_line_ref
+static bool each_line_with_getline(string const& path, function<bool(string&)> callback)
+{
+    boost::nowide::ifstream in(path.c_str());
+    if (!in) {
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        if (!callback(line)) {
+            break;
+        }
+    }
+    return true;
+}
+
+static bool read_with_stringstream(string const& path, string& contents)
+{
+    boost::nowide::ifstream in(path.c_str(), ios::in | ios::binary);
+    ostringstream buffer;
+    if (!in) {
+        return false;
+    }
+    buffer << in.rdbuf();
+    contents = buffer.str();
+    return true;
+}
+
+SCENARIO("benchmarking reading files", "[.][benchmark]") {
+    auto directory = fs::temp_directory_path() / fs::unique_path("facter-file-%%%%-%%%%");
+    fs::create_directories(directory);
+    vector<pair<string, string>> files = {
+        { "cpuinfo", (directory / "cpuinfo").string() },
+        { "mountinfo", (directory / "mountinfo").string() },
+        { "leases", (directory / "dhclient.leases").string() },
+    };
+    write_cpuinfo(files[0].second, 192);
+    write_mountinfo(files[1].second, 10000);
+    write_leases(files[2].second, 20000);
+    const int iterations = 20;
+
+    cout << boost::format("%-10s %10s %12s %12s %12s %12s %12s\n") % "file" % "bytes" % "getline" % "each_line" % "line_ref" % "stringstream" % "read";
+    for (auto const& file_path : files) {
+        auto const& path = file_path.second;
+        size_t expected = 0;
+        REQUIRE(each_line_with_getline(path, [&](string& line) {
+            expected += line.size();
+            return true;
+        }));
+
+        size_t total = 0;
+        auto getline_time = measure(iterations, [&]() {
+            total = 0;
+            each_line_with_getline(path, [&](string& line) {
+                total += line.size();
+                return true;
+            });
+        });
+        REQUIRE(total == expected);
+        auto each_line_time = measure(iterations, [&]() {
+            total = 0;
+            file::each_line(path, [&](string& line) {
+                total += line.size();
+                return true;
+            });
+        });
+        REQUIRE(total == expected);
+        auto line_ref_time = measure(iterations, [&]() {
+            total = 0;
+            file::each_line_ref(path, [&](boost::string_ref line) {
+                total += line.size();
+                return true;
+            });
+        });
+        REQUIRE(total == expected);
+
+        string contents;
+        auto stringstream_time = measure(iterations, [&]() {
+            read_with_stringstream(path, contents);
+        });
+        auto size = contents.size();
+        auto read_time = measure(iterations, [&]() {
+            file::read(path, contents);
+        });
+        REQUIRE(contents.size() == size);
+
+        cout << boost::format("%-10s %10d %12.3f %12.3f %12.3f %12.3f %12.3f\n") %
+            file_path.first % size % getline_time % each_line_time % line_ref_time % stringstream_time % read_time;
+    }
+    fs::remove_all(directory);
+}
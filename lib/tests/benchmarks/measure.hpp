@@ -0,0 +1,25 @@
+#pragma once
+
+#include <boost/chrono.hpp>
+
+namespace facter { namespace testing {
+
+    /**
+     * Measures the average time taken to call a function.
+     * @tparam Func The type of function to call.
+     * @param iterations The number of times to call the function.
+     * @param func The function to call.
+     * @return Returns the average time of a call, in milliseconds.
+     */
+    template <typename Func>
+    double measure(int iterations, Func func)
+    {
+        auto start = boost::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            func();
+        }
+        auto elapsed = boost::chrono::steady_clock::now() - start;
+        return boost::chrono::duration_cast<boost::chrono::duration<double, boost::milli>>(elapsed).count() / iterations;
+    }
+
+}}  // namespace facter::testing
@@ -0,0 +1,71 @@
+#include <catch.hpp>
+#include <facter/execution/execution.hpp>
+#include <boost/format.hpp>
+#include "../measure.hpp"
+#include <iostream>
+#include <vector>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace facter::execution;
+using namespace facter::testing;
+
+// The launch path as it was before posix_spawn: fork, close every descriptor up to the limit, and exec
+static void fork_and_exec(string const& executable)
+{
+    pid_t child = fork();
+    if (child == 0) {
+        auto limit = sysconf(_SC_OPEN_MAX);
+        for (long i = 3; i < limit; ++i) {
+            close(static_cast<int>(i));
+        }
+        char const* args[] = { executable.c_str(), nullptr };
+        execv(executable.c_str(), const_cast<char* const*>(args));
+        _exit(127);
+    }
+    REQUIRE(child > 0);
+    int status = 0;
+    REQUIRE(waitpid(child, &status, 0) == child);
+    REQUIRE(WIFEXITED(status));
+}
+
+SCENARIO("benchmarking process launch", "[.][benchmark]") {
+    auto executable = which("true");
+    REQUIRE_FALSE(executable.empty());
+    const int iterations = 50;
+
+    // Raise the descriptor limit as far as allowed to model LimitNOFILE under systemd
+    rlimit original = {};
+    REQUIRE(getrlimit(RLIMIT_NOFILE, &original) == 0);
+    rlimit raised = original;
+    raised.rlim_cur = raised.rlim_max == RLIM_INFINITY ? 1048576 : raised.rlim_max;
+
+    auto run = [&](string const& label) {
+        auto fork_time = measure(iterations, [&]() {
+            fork_and_exec(executable);
+        });
+        auto spawn_time = measure(iterations, [&]() {
+            bool success;
+            string output, error;
+            tie(success, output, error) = execute(executable);
+            REQUIRE(success);
+        });
+        cout << boost::format("%-28s %12.3f %12.3f\n") % label % fork_time % spawn_time;
+    };
+
+    cout << boost::format("%-28s %12s %12s\n") % "parent" % "fork (ms)" % "spawn (ms)";
+    run("small");
+    {
+        setrlimit(RLIMIT_NOFILE, &raised);
+        run((boost::format("nofile=%1%") % raised.rlim_cur).str());
+        setrlimit(RLIMIT_NOFILE, &original);
+    }
+    {
+        // Touch a large heap to model a loaded Ruby VM and fact tree
+        vector<char> heap(512 * 1024 * 1024, 1);
+        run("512 MiB resident");
+        REQUIRE(heap.back() == 1);
+    }
+}
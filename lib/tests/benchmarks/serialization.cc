@@ -0,0 +1,93 @@
+#include <catch.hpp>
+#include <facter/facts/collection.hpp>
+#include <facter/facts/msgpack.hpp>
+#include <facter/facts/array_value.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <boost/format.hpp>
+#include <rapidjson/document.h>
+#include <yaml-cpp/yaml.h>
+#include "measure.hpp"
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace facter::facts;
+using namespace facter::testing;
+
+static void add_synthetic_facts(collection& facts, int count)
+{
+    // Model the large structured facts (mountpoints, partitions) that dominate output size
+    auto mountpoints = make_value<map_value>();
+    auto partitions = make_value<map_value>();
+    for (int i = 0; i < count; ++i) {
+        auto mountpoint = make_value<map_value>();
+        mountpoint->add("available", make_value<string_value>("12.34 GiB"));
+        mountpoint->add("available_bytes", make_value<integer_value>(13249974272 + i));
+        mountpoint->add("capacity", make_value<string_value>("42.00%"));
+        mountpoint->add("device", make_value<string_value>((boost::format("/dev/mapper/volume-%1%") % i).str()));
+        mountpoint->add("filesystem", make_value<string_value>("ext4"));
+        auto options = make_value<array_value>();
+        options->add(make_value<string_value>("rw"));
+        options->add(make_value<string_value>("relatime"));
+        options->add(make_value<string_value>("errors=remount-ro"));
+        mountpoint->add("options", move(options));
+        mountpoint->add("size_bytes", make_value<integer_value>(31546671104 + i));
+        mountpoints->add((boost::format("/srv/volume/%1%") % i).str(), move(mountpoint));
+
+        auto partition = make_value<map_value>();
+        partition->add("filesystem", make_value<string_value>("xfs"));
+        partition->add("mount", make_value<string_value>((boost::format("/srv/volume/%1%") % i).str()));
+        partition->add("size_bytes", make_value<integer_value>(31546671104 + i));
+        partition->add("uuid", make_value<string_value>("6b4a2c1e-8f0d-4d3b-9e57-0c2a1f3d4e5f"));
+        partition->add("ratio", make_value<double_value>(0.42));
+        partition->add("removable", make_value<boolean_value>(false));
+        partitions->add((boost::format("/dev/sd%1%") % i).str(), move(partition));
+    }
+    facts.add("mountpoints", move(mountpoints));
+    facts.add("partitions", move(partitions));
+}
+
+SCENARIO("benchmarking fact serialization formats", "[.][benchmark]") {
+    collection facts;
+    add_synthetic_facts(facts, 2000);
+    const int iterations = 10;
+
+    string json, yaml, msgpack;
+    auto json_encode = measure(iterations, [&]() {
+        ostringstream ss;
+        facts.write(ss, format::json);
+        json = ss.str();
+    });
+    auto yaml_encode = measure(iterations, [&]() {
+        ostringstream ss;
+        facts.write(ss, format::yaml);
+        yaml = ss.str();
+    });
+    auto msgpack_encode = measure(iterations, [&]() {
+        ostringstream ss;
+        facts.write(ss, format::msgpack);
+        msgpack = ss.str();
+    });
+
+    auto json_decode = measure(iterations, [&]() {
+        rapidjson::Document document;
+        document.Parse<0>(json.c_str());
+        REQUIRE_FALSE(document.HasParseError());
+    });
+    auto yaml_decode = measure(iterations, [&]() {
+        auto node = YAML::Load(yaml);
+        REQUIRE(node.IsMap());
+    });
+    auto msgpack_decode = measure(iterations, [&]() {
+        msgpack_reader reader(msgpack);
+        REQUIRE(reader.read());
+    });
+
+    cout << boost::format("%-8s %12s %12s %12s\n") % "format" % "bytes" % "encode (ms)" % "decode (ms)";
+    cout << boost::format("%-8s %12d %12.2f %12.2f\n") % "json" % json.size() % json_encode % json_decode;
+    cout << boost::format("%-8s %12d %12.2f %12.2f\n") % "yaml" % yaml.size() % yaml_encode % yaml_decode;
+    cout << boost::format("%-8s %12d %12.2f %12.2f\n") % "msgpack" % msgpack.size() % msgpack_encode % msgpack_decode;
+
+    REQUIRE(msgpack.size() < json.size());
+}
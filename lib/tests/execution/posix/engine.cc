@@ -0,0 +1,164 @@
+#include <catch.hpp>
+#include <facter/execution/execution.hpp>
+#include <internal/execution/execution.hpp>
+#include <internal/execution/posix/engine.hpp>
+#include <facter/util/scope_exit.hpp>
+#include <boost/chrono.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include "../../fixtures.hpp"
+#include <cerrno>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace facter::util;
+using namespace facter::execution;
+using namespace facter::execution::posix;
+
+static size_t spawn_shell(engine& processes, string const& script, uint32_t timeout = 0, function<bool(string&)> stdout_callback = nullptr)
+{
+    auto shell = which("sh");
+    REQUIRE_FALSE(shell.empty());
+    vector<string> arguments = { "-c", script };
+    return processes.spawn(shell, "sh", &arguments, nullptr, stdout_callback, nullptr, { execution_options::trim_output, execution_options::merge_environment, execution_options::redirect_stderr_to_null }, timeout);
+}
+
+SCENARIO("running child processes with the execution engine") {
+    GIVEN("several children") {
+        engine processes;
+        auto start = boost::chrono::steady_clock::now();
+        vector<size_t> ids;
+        for (int i = 0; i < 3; ++i) {
+            ids.push_back(spawn_shell(processes, "sleep 1; echo child " + to_string(i)));
+        }
+        processes.run();
+        auto elapsed = boost::chrono::steady_clock::now() - start;
+        THEN("they should run concurrently") {
+            REQUIRE(elapsed < boost::chrono::milliseconds(2500));
+        }
+        THEN("each should have its own output") {
+            for (int i = 0; i < 3; ++i) {
+                auto& result = processes.get(ids[i]);
+                REQUIRE(result.success);
+                REQUIRE_FALSE(result.timed_out);
+                REQUIRE(result.pid != 0);
+                REQUIRE(result.output == "child " + to_string(i));
+            }
+        }
+    }
+    GIVEN("children with different timeouts") {
+        engine processes;
+        vector<string> arguments = { LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/sleep.sh" };
+        auto sleeping = processes.spawn(which("sh"), "sh", &arguments, nullptr, nullptr, nullptr, { execution_options::redirect_stderr_to_null }, 1);
+        auto quick = spawn_shell(processes, "sleep 2; echo done", 10);
+        processes.run();
+        THEN("only the child that exceeded its timeout should be killed") {
+            auto& timed_out = processes.get(sleeping);
+            REQUIRE(timed_out.timed_out);
+            REQUIRE(timed_out.output.empty());
+            int status = 0;
+            REQUIRE(waitpid(-static_cast<pid_t>(timed_out.pid), &status, WNOHANG) == -1);
+            REQUIRE(errno == ECHILD);
+
+            auto& completed = processes.get(quick);
+            REQUIRE_FALSE(completed.timed_out);
+            REQUIRE(completed.success);
+            REQUIRE(completed.output == "done");
+        }
+    }
+    GIVEN("a callback that stops processing output") {
+        engine processes;
+        vector<string> lines;
+        auto id = spawn_shell(processes, "echo line1; echo line2; echo line3", 0, [&](string& line) {
+            lines.push_back(line);
+            return false;
+        });
+        processes.run();
+        THEN("the child should complete without further callbacks") {
+            REQUIRE(lines == vector<string>({ "line1" }));
+            REQUIRE(processes.get(id).pid != 0);
+        }
+    }
+    GIVEN("an executable that cannot be spawned") {
+        engine processes;
+        auto id = processes.spawn(LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/does_not_exist", "does_not_exist", nullptr, nullptr, nullptr, nullptr, {}, 0);
+        processes.run();
+        THEN("the result should have the error") {
+            auto& result = processes.get(id);
+            REQUIRE(result.pid == 0);
+            REQUIRE_FALSE(result.success);
+            REQUIRE(result.status == ENOENT);
+        }
+    }
+}
+
+SCENARIO("executing commands with timeouts on multiple threads") {
+    bool timed_out = false;
+    string output;
+    boost::thread sleeping([&]() {
+        try {
+            execute("sh", { LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/sleep.sh" }, 1);
+        } catch (timeout_exception const&) {
+            timed_out = true;
+        }
+    });
+    boost::thread quick([&]() {
+        output = get<1>(execute("sh", { "-c", "sleep 2; echo done" }, 10));
+    });
+    sleeping.join();
+    quick.join();
+    THEN("each command should have its own timeout") {
+        REQUIRE(timed_out);
+        REQUIRE(output == "done");
+    }
+}
+
+SCENARIO("executing several commands with execution::execute_all") {
+    option_set<execution_options> options = { execution_options::trim_output, execution_options::merge_environment, execution_options::throw_on_failure };
+    GIVEN("commands that each wait for the other") {
+        auto directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("facter-execute-all-%%%%-%%%%");
+        boost::filesystem::create_directories(directory);
+        scope_exit cleanup([&]() {
+            boost::system::error_code ec;
+            boost::filesystem::remove_all(directory, ec);
+        });
+        auto wait_for = [&](string const& self, string const& other) {
+            return "touch '" + (directory / self).string() + "'; while [ ! -e '" + (directory / other).string() + "' ]; do sleep 0.1; done; echo " + self;
+        };
+        auto results = execute_all({
+            { "sh", { "-c", wait_for("first", "second") }, nullptr, nullptr, options, 10 },
+            { "sh", { "-c", wait_for("second", "first") }, nullptr, nullptr, options, 10 },
+        });
+        THEN("they should run concurrently") {
+            REQUIRE(results.size() == 2u);
+            REQUIRE_FALSE(results[0].exception);
+            REQUIRE(results[0].success);
+            REQUIRE(results[0].output == "first");
+            REQUIRE_FALSE(results[1].exception);
+            REQUIRE(results[1].success);
+            REQUIRE(results[1].output == "second");
+        }
+    }
+    GIVEN("commands that fail") {
+        vector<string> lines;
+        auto results = execute_all({
+            { LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/does_not_exist", {}, nullptr, nullptr, options, 0 },
+            { "sh", { "-c", "echo output; exit 2" }, nullptr, nullptr, options, 0 },
+            { "sh", { "-c", "echo line1; echo line2" }, [&](string& line) { lines.push_back(line); return true; }, nullptr, options, 0 },
+        });
+        THEN("each failure should be reported with its command") {
+            REQUIRE(results.size() == 3u);
+            REQUIRE_THROWS_AS(rethrow_exception(results[0].exception), child_exit_exception);
+            try {
+                rethrow_exception(results[1].exception);
+                FAIL("did not throw child exit exception");
+            } catch (child_exit_exception const& ex) {
+                REQUIRE(ex.status_code() == 2);
+                REQUIRE(ex.output() == "output");
+            }
+            REQUIRE_FALSE(results[2].exception);
+            REQUIRE(results[2].success);
+            REQUIRE(lines == vector<string>({ "line1", "line2" }));
+        }
+    }
+}
@@ -8,6 +8,8 @@
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace facter::util;
@@ -190,6 +192,16 @@ SCENARIO("executing commands with execution::execute") {
                 REQUIRE(variables["LANG"] == "FOO");
             }
         }
+        WHEN("the parent has an inheritable descriptor open") {
+            int descriptor = open("/dev/null", O_RDONLY);
+            REQUIRE(descriptor > 2);
+            tie(success, output, error) = execute("sh", { "-c", "if [ -e /dev/fd/" + to_string(descriptor) + " ]; then echo open; else echo closed; fi" });
+            close(descriptor);
+            THEN("the descriptor should not be inherited by the child") {
+                REQUIRE(success);
+                REQUIRE(output == "closed");
+            }
+        }
     }
     GIVEN("a command that fails") {
         WHEN("default options are used") {
@@ -537,3 +549,128 @@ SCENARIO("executing commands with execution::each_line") {
         }
     }
 }
+
+SCENARIO("caching command results with execution::command_cache") {
+    // The shell prints its own process id, so each execution has different output
+    vector<string> arguments = { "-c", "echo $$" };
+    GIVEN("no command cache") {
+        THEN("each command should be executed") {
+            auto first = get<1>(execute("sh", arguments));
+            auto second = get<1>(execute("sh", arguments));
+            REQUIRE_FALSE(first.empty());
+            REQUIRE(first != second);
+        }
+    }
+    GIVEN("a command cache that is not current") {
+        command_cache cache;
+        THEN("each command should be executed") {
+            auto first = get<1>(execute("sh", arguments));
+            auto second = get<1>(execute("sh", arguments));
+            REQUIRE(first != second);
+            REQUIRE(cache.statistics().command_misses == 0u);
+        }
+    }
+    GIVEN("two command caches") {
+        command_cache first_cache;
+        command_cache second_cache;
+        WHEN("each is made current in turn") {
+            string first;
+            string second;
+            {
+                command_cache::scope scope(&first_cache);
+                first = get<1>(execute("sh", arguments));
+            }
+            {
+                command_cache::scope scope(&second_cache);
+                second = get<1>(execute("sh", arguments));
+            }
+            THEN("each cache should keep its own results") {
+                REQUIRE(first != second);
+                REQUIRE(first_cache.statistics().command_misses == 1u);
+                REQUIRE(second_cache.statistics().command_misses == 1u);
+                REQUIRE(second_cache.statistics().command_hits == 0u);
+            }
+        }
+    }
+    GIVEN("a current command cache") {
+        command_cache cache;
+        command_cache::scope scope(&cache);
+        WHEN("the same command is executed twice") {
+            auto first = get<1>(execute("sh", arguments));
+            auto second = get<1>(execute("sh", arguments));
+            THEN("the cached output should be returned") {
+                REQUIRE_FALSE(first.empty());
+                REQUIRE(first == second);
+                auto statistics = cache.statistics();
+                REQUIRE(statistics.command_hits == 1u);
+                REQUIRE(statistics.command_misses == 1u);
+            }
+        }
+        WHEN("the same command is executed with different environments") {
+            vector<string> print_variable = { "-c", "echo $TEST_VARIABLE" };
+            auto first = get<1>(execute("sh", print_variable, { { "TEST_VARIABLE", "first" } }));
+            auto second = get<1>(execute("sh", print_variable, { { "TEST_VARIABLE", "second" } }));
+            THEN("each command should be executed") {
+                REQUIRE(first == "first");
+                REQUIRE(second == "second");
+                REQUIRE(cache.statistics().command_misses == 2u);
+            }
+        }
+        WHEN("lines of output are processed twice") {
+            vector<string> first;
+            vector<string> second;
+            REQUIRE(each_line("cat", { LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/ls/file4.txt" }, [&](string& line) {
+                first.push_back(line);
+                return true;
+            }));
+            REQUIRE(each_line("cat", { LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/ls/file4.txt" }, [&](string& line) {
+                second.push_back(line);
+                return true;
+            }));
+            THEN("the cached lines should be replayed") {
+                REQUIRE(first.size() == 4u);
+                REQUIRE(first == second);
+                REQUIRE(cache.statistics().command_hits == 1u);
+            }
+        }
+        WHEN("a callback stops processing output") {
+            each_line("cat", { LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/ls/file4.txt" }, [&](string& line) {
+                return false;
+            });
+            size_t count = 0;
+            each_line("cat", { LIBFACTER_TESTS_DIRECTORY "/fixtures/execution/ls/file4.txt" }, [&](string& line) {
+                ++count;
+                return true;
+            });
+            THEN("the incomplete output should not be cached") {
+                REQUIRE(count == 4u);
+                REQUIRE(cache.statistics().command_hits == 0u);
+            }
+        }
+        WHEN("a failing command is executed twice") {
+            vector<string> fail = { "-c", "exit 3" };
+            for (int i = 0; i < 2; ++i) {
+                try {
+                    execute("sh", fail, 0, { execution_options::throw_on_nonzero_exit });
+                    FAIL("did not throw child exit exception");
+                } catch (child_exit_exception const& ex) {
+                    REQUIRE(ex.status_code() == 3);
+                }
+            }
+            THEN("the failure should be cached") {
+                REQUIRE(cache.statistics().command_hits == 1u);
+            }
+        }
+        WHEN("searching for a program twice") {
+            auto first = which("sh");
+            auto second = which("sh");
+            THEN("the search paths should be probed once") {
+                REQUIRE_FALSE(first.empty());
+                REQUIRE(first == second);
+                auto statistics = cache.statistics();
+                REQUIRE(statistics.path_hits == 1u);
+                REQUIRE(statistics.path_misses == 1u);
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#include <catch.hpp>
+#include <internal/facts/bsd/networking_resolver.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include "../../fixtures.hpp"
+#include <fcntl.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace facter::facts::bsd;
+namespace fs = boost::filesystem;
+
+SCENARIO("reading dhclient lease files") {
+    string fixture = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/bsd/dhclient/dhclient.leases";
+    GIVEN("an interface with only a recent lease to find") {
+        auto servers = networking_resolver::read_dhclient_leases(fixture, { "eth0" });
+        THEN("reading should stop at the interface's most recent lease") {
+            REQUIRE(servers.size() == 1u);
+            REQUIRE(servers["eth0"] == "192.168.1.2");
+        }
+    }
+    GIVEN("no interfaces to find") {
+        auto servers = networking_resolver::read_dhclient_leases(fixture, {});
+        THEN("the server of the most recent lease of every interface should be found") {
+            REQUIRE(servers.size() == 2u);
+            REQUIRE(servers["eth0"] == "192.168.1.2");
+            REQUIRE(servers["eth1"] == "10.0.0.1");
+        }
+    }
+    GIVEN("interfaces that include an interface without a lease") {
+        auto servers = networking_resolver::read_dhclient_leases(fixture, { "eth1", "eth2" });
+        THEN("the whole file should be read") {
+            REQUIRE(servers.size() == 2u);
+            REQUIRE(servers["eth0"] == "192.168.1.2");
+            REQUIRE(servers["eth1"] == "10.0.0.1");
+        }
+    }
+    GIVEN("a lease file named for an interface") {
+        string named = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/bsd/dhclient/dhclient.eth0.leases";
+        auto servers = networking_resolver::read_dhclient_leases(named, { "eth0", "eth1" });
+        THEN("reading should stop at that interface's most recent lease") {
+            REQUIRE(servers.size() == 1u);
+            REQUIRE(servers["eth0"] == "192.168.1.2");
+        }
+    }
+    GIVEN("per-interface lease files") {
+        string directory = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/bsd/dhclient/";
+        string uuid_file = directory + "dhclient-7f2c5b9e-13a4-4d4e-9b1a-0c5e8f1d2a3b-eth0.100.lease";
+        THEN("the interface should be found from the file name") {
+            REQUIRE(networking_resolver::get_lease_file_interface(directory + "dhclient.eth0.leases", { "eth0", "eth1" }) == "eth0");
+            REQUIRE(networking_resolver::get_lease_file_interface(uuid_file, { "eth0", "eth0.100", "100" }) == "eth0.100");
+            REQUIRE(networking_resolver::get_lease_file_interface(directory + "dhclient-eth1.lease", { "eth0", "eth1" }) == "eth1");
+            REQUIRE(networking_resolver::get_lease_file_interface(directory + "dhclient.eth0.leases", { "th0", "eth1" }).empty());
+            REQUIRE(networking_resolver::get_lease_file_interface(fixture, { "eth0", "eth1" }).empty());
+        }
+        THEN("each file should provide the lease of its interface") {
+            REQUIRE(networking_resolver::read_dhclient_leases(uuid_file, { "eth0.100" })["eth0.100"] == "172.16.0.1");
+        }
+    }
+    GIVEN("a file that does not exist") {
+        THEN("no servers should be found") {
+            REQUIRE(networking_resolver::read_dhclient_leases(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/bsd/dhclient/missing", {}).empty());
+        }
+    }
+    GIVEN("a lease file rewritten with the same size within a second") {
+        auto path = (fs::temp_directory_path() / fs::unique_path("facter-dhclient-%%%%-%%%%.leases")).string();
+        auto write = [&](string const& server, long nanoseconds) {
+            {
+                boost::nowide::ofstream out(path.c_str());
+                out << "lease {\n  interface \"eth0\";\n  option dhcp-server-identifier " << server << ";\n}\n";
+            }
+            timespec times[2] = { { 1500000000, nanoseconds }, { 1500000000, nanoseconds } };
+            REQUIRE(utimensat(AT_FDCWD, path.c_str(), times, 0) == 0);
+        };
+        write("10.4.4.1", 100);
+        REQUIRE(networking_resolver::read_dhclient_leases(path, {})["eth0"] == "10.4.4.1");
+        write("10.4.4.2", 200);
+        THEN("the cached servers should not be used") {
+            REQUIRE(networking_resolver::read_dhclient_leases(path, {})["eth0"] == "10.4.4.2");
+        }
+        fs::remove(path);
+    }
+    GIVEN("a lease file larger than a read block") {
+        auto path = (fs::temp_directory_path() / fs::unique_path("facter-dhclient-%%%%-%%%%.leases")).string();
+        {
+            boost::nowide::ofstream out(path.c_str());
+            out << "lease {\n  interface \"eth0\";\n  option dhcp-server-identifier 10.1.1.1;\n}\n";
+            for (int i = 0; i < 2000; ++i) {
+                out << "lease {\n  interface \"eth1\";\n  option routers 10.2.2.254;\n  option dhcp-server-identifier 10.2.2." << (i % 250) << ";\n}\n";
+            }
+        }
+        auto servers = networking_resolver::read_dhclient_leases(path, {});
+        THEN("leases spanning blocks should be read") {
+            REQUIRE(servers.size() == 2u);
+            REQUIRE(servers["eth0"] == "10.1.1.1");
+            REQUIRE(servers["eth1"] == "10.2.2.249");
+        }
+        WHEN("the file is changed") {
+            {
+                boost::nowide::ofstream out(path.c_str(), ios::app);
+                out << "lease {\n  interface \"eth0\";\n  option dhcp-server-identifier 10.3.3.3;\n}\n";
+            }
+            THEN("the cached servers should not be used") {
+                servers = networking_resolver::read_dhclient_leases(path, {});
+                REQUIRE(servers["eth0"] == "10.3.3.3");
+                REQUIRE(servers["eth1"] == "10.2.2.249");
+            }
+        }
+        fs::remove(path);
+    }
+}
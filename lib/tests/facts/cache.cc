@@ -0,0 +1,206 @@
+#include <catch.hpp>
+#include <internal/facts/cache.hpp>
+#include <facter/facts/collection.hpp>
+#include <facter/facts/resolver.hpp>
+#include <facter/facts/array_value.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <facter/util/scope_exit.hpp>
+
+using namespace std;
+using namespace facter::facts;
+using namespace facter::util;
+namespace fs = boost::filesystem;
+
+struct cached_resolver : facter::facts::resolver
+{
+    cached_resolver() :
+        resolver("cached", { "foo", "bar" }),
+        resolved(0)
+    {
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        ++resolved;
+        facts.add("foo", make_value<string_value>("value"));
+        auto bar = make_value<map_value>();
+        bar->add("integer", make_value<integer_value>(-12345678901));
+        bar->add("small", make_value<integer_value>(5));
+        bar->add("double", make_value<double_value>(12.5));
+        bar->add("boolean", make_value<boolean_value>(true));
+        auto array = make_value<array_value>();
+        array->add(make_value<string_value>(string(300, 'x')));
+        array->add(make_value<string_value>(""));
+        bar->add("array", move(array));
+        facts.add("bar", move(bar));
+    }
+
+    int resolved;
+};
+
+static vector<pair<string, value const*>> to_facts(vector<pair<string, unique_ptr<value>>> const& facts)
+{
+    vector<pair<string, value const*>> result;
+    for (auto const& kvp : facts) {
+        result.emplace_back(kvp.first, kvp.second.get());
+    }
+    return result;
+}
+
+SCENARIO("caching facts") {
+    auto path = (fs::temp_directory_path() / fs::unique_path("facter-cache-%%%%-%%%%") / "cached_facts").string();
+    scope_exit cleanup([&]() {
+        boost::system::error_code ec;
+        fs::remove_all(fs::path(path).parent_path(), ec);
+    });
+
+    vector<pair<string, unique_ptr<value>>> facts;
+    facts.emplace_back("string", make_value<string_value>("hello"));
+    facts.emplace_back("hidden", make_value<integer_value>(1234, true));
+
+    GIVEN("a resolver without a time-to-live") {
+        fact_cache cache(path, { { "other", 60 } }, false);
+        THEN("facts should not be cached") {
+            REQUIRE_FALSE(cache.is_cached("test"));
+            cache.store("test", to_facts(facts));
+            vector<pair<string, unique_ptr<value>>> loaded;
+            REQUIRE_FALSE(cache.load("test", loaded));
+        }
+    }
+    GIVEN("a resolver with a time-to-live of 0") {
+        fact_cache cache(path, { { "test", 0 } }, false);
+        THEN("facts should not be cached") {
+            REQUIRE_FALSE(cache.is_cached("test"));
+        }
+    }
+    GIVEN("facts stored in the cache file") {
+        {
+            fact_cache cache(path, { { "test", 60 } }, false);
+            REQUIRE(cache.is_cached("test"));
+            cache.store("test", to_facts(facts));
+            cache.save();
+        }
+        REQUIRE(fs::exists(path));
+        WHEN("the cache file is loaded") {
+            fact_cache cache(path, { { "test", 60 } }, false);
+            vector<pair<string, unique_ptr<value>>> loaded;
+            REQUIRE(cache.load("test", loaded));
+            THEN("the facts should be the same") {
+                REQUIRE(loaded.size() == 2u);
+                REQUIRE(loaded[0].first == "string");
+                auto str = dynamic_cast<string_value const*>(loaded[0].second.get());
+                REQUIRE(str);
+                REQUIRE(str->value() == "hello");
+                REQUIRE_FALSE(str->hidden());
+                REQUIRE(loaded[1].first == "hidden");
+                auto integer = dynamic_cast<integer_value const*>(loaded[1].second.get());
+                REQUIRE(integer);
+                REQUIRE(integer->value() == 1234);
+                REQUIRE(integer->hidden());
+            }
+        }
+        WHEN("the cache is refreshed") {
+            fact_cache cache(path, { { "test", 60 } }, true);
+            vector<pair<string, unique_ptr<value>>> loaded;
+            THEN("the cached facts should not be loaded") {
+                REQUIRE_FALSE(cache.load("test", loaded));
+                REQUIRE(loaded.empty());
+            }
+        }
+        WHEN("the cache file is corrupted") {
+            {
+                boost::nowide::fstream file(path.c_str(), ios::in | ios::out | ios::binary);
+                file.seekp(20);
+                file.put('\xff');
+            }
+            fact_cache cache(path, { { "test", 60 } }, false);
+            vector<pair<string, unique_ptr<value>>> loaded;
+            THEN("the cached facts should not be loaded") {
+                REQUIRE_FALSE(cache.load("test", loaded));
+            }
+        }
+        WHEN("the cache file is truncated") {
+            fs::resize_file(path, fs::file_size(path) - 1);
+            fact_cache cache(path, { { "test", 60 } }, false);
+            vector<pair<string, unique_ptr<value>>> loaded;
+            THEN("the cached facts should not be loaded") {
+                REQUIRE_FALSE(cache.load("test", loaded));
+            }
+        }
+    }
+    GIVEN("facts that can only be read by root") {
+        auto serial = make_value<string_value>("serial");
+        fact_cache cache(path, { { "test", 60 }, { "dmi", 60 } }, false);
+        cache.store("test", to_facts(facts));
+        cache.store("dmi", { { "manufacturer", facts[0].second.get() }, { "serialnumber", serial.get() } });
+        cache.save();
+        THEN("the facts should not be cached") {
+            fact_cache loaded_cache(path, { { "test", 60 }, { "dmi", 60 } }, false);
+            vector<pair<string, unique_ptr<value>>> loaded;
+            REQUIRE_FALSE(loaded_cache.load("dmi", loaded));
+            REQUIRE(loaded_cache.load("test", loaded));
+        }
+    }
+    GIVEN("a fact collection with the cache enabled") {
+        auto res = make_shared<cached_resolver>();
+        {
+            collection facts;
+            facts.enable_cache({ { "cached", 60 } }, false, path);
+            facts.add(res);
+            REQUIRE(facts.size() == 2u);
+            REQUIRE(res->resolved == 1);
+        }
+        WHEN("the facts are resolved again") {
+            collection facts;
+            facts.enable_cache({ { "cached", 60 } }, false, path);
+            facts.add(res);
+            THEN("the facts should be loaded from the cache") {
+                REQUIRE(facts.size() == 2u);
+                REQUIRE(res->resolved == 1);
+                auto foo = facts.get<string_value>("foo");
+                REQUIRE(foo);
+                REQUIRE(foo->value() == "value");
+                auto bar = facts.get<map_value>("bar");
+                REQUIRE(bar);
+                auto integer = bar->get<integer_value>("integer");
+                REQUIRE(integer);
+                REQUIRE(integer->value() == -12345678901);
+                auto small = bar->get<integer_value>("small");
+                REQUIRE(small);
+                REQUIRE(small->value() == 5);
+                auto dbl = bar->get<double_value>("double");
+                REQUIRE(dbl);
+                REQUIRE(dbl->value() == Approx(12.5));
+                auto boolean = bar->get<boolean_value>("boolean");
+                REQUIRE(boolean);
+                REQUIRE(boolean->value());
+                auto array = bar->get<array_value>("array");
+                REQUIRE(array);
+                REQUIRE(array->size() == 2u);
+                auto first = array->get<string_value>(0);
+                REQUIRE(first);
+                REQUIRE(first->value() == string(300, 'x'));
+            }
+        }
+        WHEN("the cache is refreshed") {
+            collection facts;
+            facts.enable_cache({ { "cached", 60 } }, true, path);
+            facts.add(res);
+            THEN("the resolver should be resolved") {
+                REQUIRE(facts.size() == 2u);
+                REQUIRE(res->resolved == 2);
+            }
+        }
+        WHEN("the cache is not enabled") {
+            collection facts;
+            facts.add(res);
+            THEN("the resolver should be resolved") {
+                REQUIRE(facts.size() == 2u);
+                REQUIRE(res->resolved == 2);
+            }
+        }
+    }
+}
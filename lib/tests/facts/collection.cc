@@ -7,6 +7,9 @@
 #include <facter/util/environment.hpp>
 #include "../fixtures.hpp"
 #include <sstream>
+#include <atomic>
+#include <boost/thread/thread.hpp>
+#include <boost/chrono.hpp>
 
 using namespace std;
 using namespace facter::facts;
@@ -38,6 +41,209 @@ struct multi_resolver : facter::facts::resolver
     }
 };
 
+struct dependent_resolver : facter::facts::resolver
+{
+    dependent_resolver(string name, string fact, string dependency) :
+        resolver(name, { fact }),
+        _fact(move(fact)),
+        _dependency(move(dependency))
+    {
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        // Sleep to give other threads a chance to resolve out of order
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+        auto dependency = facts.get<string_value>(_dependency);
+        facts.add(_fact, make_value<string_value>(dependency ? dependency->value() + "+" + _fact : _fact));
+    }
+
+ private:
+    string _fact;
+    string _dependency;
+};
+
+struct resolution_order
+{
+    void add(string const& name)
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        _names.push_back(name);
+    }
+
+    size_t position(string const& name)
+    {
+        boost::lock_guard<boost::mutex> lock(_mutex);
+        return find(_names.begin(), _names.end(), name) - _names.begin();
+    }
+
+ private:
+    boost::mutex _mutex;
+    vector<string> _names;
+};
+
+struct declared_resolver : facter::facts::resolver
+{
+    declared_resolver(string name, string fact, string dependency, resolution_order& order) :
+        resolver(name, { fact }),
+        _fact(move(fact)),
+        _dependency(move(dependency)),
+        _order(order)
+    {
+    }
+
+    virtual vector<string> dependencies() const override
+    {
+        return { _dependency };
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        _order.add(name());
+        auto dependency = facts.get<string_value>(_dependency);
+        facts.add(_fact, make_value<string_value>(dependency ? dependency->value() + "+" + _fact : _fact));
+    }
+
+ private:
+    string _fact;
+    string _dependency;
+    resolution_order& _order;
+};
+
+struct thread_resolver : facter::facts::resolver
+{
+    thread_resolver(string const& name, bool thread_safe) :
+        resolver(name, { name + "_thread" }),
+        _thread_safe(thread_safe)
+    {
+    }
+
+    virtual bool is_thread_safe() const override
+    {
+        return _thread_safe;
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        ostringstream ss;
+        ss << boost::this_thread::get_id();
+        facts.add(names().front(), make_value<string_value>(ss.str()));
+    }
+
+ private:
+    bool _thread_safe;
+};
+
+struct query_resolver : facter::facts::resolver
+{
+    explicit query_resolver(string first = "1") :
+        resolver("query", { "structured" }),
+        _first(move(first))
+    {
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        ++resolved;
+        auto value = make_value<map_value>();
+        value->add("first", make_value<string_value>(_first));
+        value->add("second", make_value<string_value>("2"));
+        facts.add("structured", move(value));
+    }
+
+    size_t resolved = 0;
+    size_t queried = 0;
+
+ protected:
+    virtual unique_ptr<facter::facts::value> query(collection& facts, string const& name, vector<string> const& path) override
+    {
+        if (path.front() != "first") {
+            return nullptr;
+        }
+        ++queried;
+        auto value = make_value<map_value>();
+        value->add("first", make_value<string_value>(_first));
+        return value;
+    }
+
+ private:
+    string _first;
+};
+
+struct slow_query_resolver : facter::facts::resolver
+{
+    slow_query_resolver() : resolver("slow", { "slow" })
+    {
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        facts.add("slow", make_first());
+    }
+
+    atomic<bool> overlapped{false};
+
+ protected:
+    virtual unique_ptr<facter::facts::value> query(collection& facts, string const& name, vector<string> const& path) override
+    {
+        return make_first();
+    }
+
+ private:
+    unique_ptr<map_value> make_first()
+    {
+        // Report if the resolver is ever used by more than one thread at a time
+        if (_active++) {
+            overlapped = true;
+        }
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+        --_active;
+        auto value = make_value<map_value>();
+        value->add("first", make_value<string_value>("1"));
+        return value;
+    }
+
+    atomic<int> _active{0};
+};
+
+struct legacy_resolver : facter::facts::resolver
+{
+    legacy_resolver() : resolver("legacy", { "structured" }, { "^legacy_" })
+    {
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        auto value = make_value<map_value>();
+        value->add("first", make_value<string_value>("1"));
+        value->add("second", make_value<string_value>("2"));
+        facts.add("structured", move(value));
+    }
+
+    virtual bool has_legacy_facts() const override
+    {
+        return true;
+    }
+
+    virtual void resolve_legacy(collection& facts) override
+    {
+        ++resolved;
+        auto structured = facts.get<map_value>("structured");
+        if (!structured) {
+            return;
+        }
+        structured->each([&](string const& name, value const* val) {
+            auto str = value_cast<string_value>(val);
+            if (str) {
+                facts.add("legacy_" + name, make_value<string_value>(str->value(), true));
+            }
+            return true;
+        });
+    }
+
+    int resolved = 0;
+};
+
 struct temp_variable
 {
     temp_variable(string name, string const& value) :
@@ -401,3 +607,243 @@ SCENARIO("using the fact collection with a default external fact path") {
         }
     }
 }
+
+SCENARIO("resolving facts concurrently") {
+    collection_fixture facts;
+    facts.concurrency(4);
+    REQUIRE(facts.concurrency() == 4u);
+
+    GIVEN("resolvers that depend on facts from other resolvers") {
+        facts.add(make_shared<dependent_resolver>("fourth", "d", "c"));
+        facts.add(make_shared<dependent_resolver>("third", "c", "b"));
+        facts.add(make_shared<dependent_resolver>("second", "b", "a"));
+        facts.add(make_shared<dependent_resolver>("first", "a", "none"));
+        facts.add(make_shared<dependent_resolver>("other", "e", "a"));
+        THEN("the facts should match the serial resolution") {
+            collection_fixture serial;
+            serial.add(make_shared<dependent_resolver>("fourth", "d", "c"));
+            serial.add(make_shared<dependent_resolver>("third", "c", "b"));
+            serial.add(make_shared<dependent_resolver>("second", "b", "a"));
+            serial.add(make_shared<dependent_resolver>("first", "a", "none"));
+            serial.add(make_shared<dependent_resolver>("other", "e", "a"));
+
+            ostringstream expected;
+            serial.write(expected, format::json);
+            ostringstream actual;
+            facts.write(actual, format::json);
+            REQUIRE(actual.str() == expected.str());
+            REQUIRE(facts.get<string_value>("d")->value() == "a+b+c+d");
+            REQUIRE(facts.get<string_value>("e")->value() == "a+e");
+        }
+    }
+    GIVEN("resolvers that depend on each other") {
+        facts.add(make_shared<dependent_resolver>("first", "a", "b"));
+        facts.add(make_shared<dependent_resolver>("second", "b", "a"));
+        THEN("resolution should not deadlock") {
+            REQUIRE(facts.size() == 2u);
+            REQUIRE(facts.get<string_value>("a"));
+            REQUIRE(facts.get<string_value>("b"));
+        }
+    }
+    GIVEN("multiple resolvers for the same fact") {
+        facts.add(make_shared<dependent_resolver>("first", "a", "none"));
+        facts.add(make_shared<simple_resolver>());
+        facts.add(make_shared<dependent_resolver>("second", "foo", "a"));
+        THEN("the facts should match the serial resolution") {
+            collection_fixture serial;
+            serial.add(make_shared<dependent_resolver>("first", "a", "none"));
+            serial.add(make_shared<simple_resolver>());
+            serial.add(make_shared<dependent_resolver>("second", "foo", "a"));
+            serial.resolve_facts();
+            facts.resolve_facts();
+            REQUIRE(facts.get<string_value>("foo"));
+            REQUIRE(facts.get<string_value>("foo")->value() == serial.get<string_value>("foo")->value());
+        }
+    }
+    GIVEN("a resolver that is not thread-safe") {
+        for (int i = 0; i < 8; ++i) {
+            facts.add(make_shared<thread_resolver>("safe" + to_string(i), true));
+        }
+        facts.add(make_shared<thread_resolver>("unsafe", false));
+        THEN("it should be resolved on the calling thread") {
+            facts.resolve_facts();
+            ostringstream ss;
+            ss << boost::this_thread::get_id();
+            REQUIRE(facts.get<string_value>("unsafe_thread"));
+            REQUIRE(facts.get<string_value>("unsafe_thread")->value() == ss.str());
+            REQUIRE(facts.size() == 9u);
+        }
+    }
+}
+
+SCENARIO("resolving facts with declared dependencies") {
+    collection_fixture facts;
+    resolution_order order;
+
+    GIVEN("resolvers added before the resolvers they depend on") {
+        facts.add(make_shared<declared_resolver>("third", "c", "b", order));
+        facts.add(make_shared<declared_resolver>("second", "b", "a", order));
+        facts.add(make_shared<declared_resolver>("other", "e", "a", order));
+        facts.add(make_shared<declared_resolver>("first", "a", "none", order));
+        THEN("dependencies should be resolved first") {
+            REQUIRE(facts.size() == 4u);
+            REQUIRE(order.position("first") == 0u);
+            REQUIRE(order.position("second") < order.position("third"));
+            REQUIRE(facts.get<string_value>("c")->value() == "a+b+c");
+            REQUIRE(facts.get<string_value>("e")->value() == "a+e");
+        }
+        THEN("querying a dependent fact should resolve its dependencies first") {
+            REQUIRE(facts.get<string_value>("c"));
+            REQUIRE(facts.get<string_value>("c")->value() == "a+b+c");
+            REQUIRE(order.position("first") == 0u);
+            REQUIRE(order.position("second") == 1u);
+            REQUIRE(order.position("third") == 2u);
+            REQUIRE(order.position("other") == 3u);
+        }
+        THEN("dependencies should be resolved first when resolving concurrently") {
+            facts.concurrency(4);
+            REQUIRE(facts.size() == 4u);
+            REQUIRE(order.position("first") == 0u);
+            REQUIRE(order.position("second") < order.position("third"));
+            REQUIRE(facts.get<string_value>("c")->value() == "a+b+c");
+            REQUIRE(facts.get<string_value>("e")->value() == "a+e");
+        }
+    }
+    GIVEN("resolvers with a circular dependency") {
+        facts.add(make_shared<declared_resolver>("first", "a", "c", order));
+        facts.add(make_shared<declared_resolver>("second", "b", "a", order));
+        THEN("adding the resolver that completes the cycle should throw") {
+            REQUIRE_THROWS_AS(facts.add(make_shared<declared_resolver>("third", "c", "b", order)), circular_dependency_exception);
+            REQUIRE(facts.size() == 2u);
+            REQUIRE(facts.get<string_value>("b")->value() == "a+b");
+        }
+    }
+    GIVEN("a resolver that depends on a fact it resolves") {
+        facts.add(make_shared<declared_resolver>("first", "a", "a", order));
+        THEN("it should not be considered a cycle") {
+            REQUIRE(facts.size() == 1u);
+            REQUIRE(facts.get<string_value>("a")->value() == "a");
+        }
+    }
+}
+
+SCENARIO("querying facts") {
+    collection_fixture facts;
+    auto resolver = make_shared<query_resolver>();
+    facts.add(resolver);
+
+    GIVEN("a query the resolver can resolve partially") {
+        THEN("only the queried part of the fact should be resolved") {
+            auto first = facts.query<string_value>("structured.first");
+            REQUIRE(first);
+            REQUIRE(first->value() == "1");
+            REQUIRE(facts.query<string_value>("structured.first") == first);
+            REQUIRE(resolver->queried == 1u);
+            REQUIRE(resolver->resolved == 0u);
+            REQUIRE_FALSE(facts.get_resolved("structured"));
+        }
+    }
+    GIVEN("a query the resolver cannot resolve partially") {
+        THEN("the entire fact should be resolved") {
+            auto second = facts.query<string_value>("structured.second");
+            REQUIRE(second);
+            REQUIRE(second->value() == "2");
+            REQUIRE(resolver->resolved == 1u);
+            auto first = facts.query<string_value>("structured.first");
+            REQUIRE(first);
+            REQUIRE(first->value() == "1");
+            REQUIRE(resolver->queried == 0u);
+        }
+    }
+    GIVEN("a query for a fact that was already resolved") {
+        REQUIRE(facts.get<map_value>("structured"));
+        THEN("the resolved fact should be used") {
+            auto first = facts.query<string_value>("structured.first");
+            REQUIRE(first);
+            REQUIRE(first->value() == "1");
+            REQUIRE(resolver->queried == 0u);
+            REQUIRE(resolver->resolved == 1u);
+        }
+    }
+    GIVEN("a resolver added later for the same fact") {
+        auto overriding = make_shared<query_resolver>("one");
+        facts.add(overriding);
+        THEN("the later resolver should answer the query") {
+            auto first = facts.query<string_value>("structured.first");
+            REQUIRE(first);
+            REQUIRE(first->value() == "one");
+            REQUIRE(overriding->queried == 1u);
+            REQUIRE(resolver->queried == 0u);
+        }
+    }
+    GIVEN("queries from multiple threads") {
+        auto slow = make_shared<slow_query_resolver>();
+        facts.add(slow);
+        vector<string> values(4);
+        boost::thread_group threads;
+        for (size_t i = 0; i < values.size(); ++i) {
+            threads.create_thread([&, i]() {
+                auto map = i % 2 ? nullptr : facts.get<map_value>("slow");
+                auto value = map ? map->get<string_value>("first") : facts.query<string_value>("slow.first");
+                values[i] = value ? value->value() : string();
+            });
+        }
+        threads.join_all();
+        THEN("the resolver should never answer a query while resolving") {
+            REQUIRE_FALSE(slow->overlapped);
+            REQUIRE(values == vector<string>({ "1", "1", "1", "1" }));
+        }
+    }
+}
+
+SCENARIO("adding legacy facts lazily") {
+    collection facts;
+    auto res = make_shared<legacy_resolver>();
+    facts.add(res);
+    GIVEN("the structured fact is resolved") {
+        REQUIRE(facts.get<map_value>("structured"));
+        THEN("the legacy facts should not be added") {
+            REQUIRE(res->resolved == 0);
+            ostringstream ss;
+            facts.write(ss, format::json);
+            REQUIRE(ss.str() == "{\n  \"structured\": {\n    \"first\": \"1\",\n    \"second\": \"2\"\n  }\n}");
+            REQUIRE(res->resolved == 0);
+        }
+        WHEN("a legacy fact is requested") {
+            auto first = facts.get<string_value>("legacy_first");
+            THEN("the legacy facts should be added once") {
+                REQUIRE(first);
+                REQUIRE(first->value() == "1");
+                REQUIRE(first->hidden());
+                REQUIRE(facts.get<string_value>("legacy_second"));
+                REQUIRE_FALSE(facts.get<string_value>("legacy_third"));
+                REQUIRE(res->resolved == 1);
+            }
+        }
+        WHEN("a legacy fact is queried") {
+            REQUIRE(facts.query<string_value>("legacy_second"));
+            THEN("the legacy facts should be added") {
+                REQUIRE(res->resolved == 1);
+            }
+        }
+        WHEN("all facts are enumerated") {
+            set<string> names;
+            facts.each([&](string const& name, value const*) {
+                names.insert(name);
+                return true;
+            });
+            THEN("the legacy facts should be included") {
+                REQUIRE(names == set<string>({ "legacy_first", "legacy_second", "structured" }));
+                REQUIRE(facts.size() == 3u);
+                REQUIRE(res->resolved == 1);
+            }
+        }
+        WHEN("a legacy fact is replaced") {
+            facts.add("legacy_first", make_value<string_value>("replaced"));
+            THEN("the replacement should not be overwritten by the legacy facts") {
+                REQUIRE(facts.size() == 3u);
+                REQUIRE(facts.get<string_value>("legacy_first")->value() == "replaced");
+            }
+        }
+    }
+}
@@ -55,6 +55,23 @@ SCENARIO("resolving external executable facts") {
                 REQUIRE(re_search(output, boost::regex("WARN  puppetlabs\\.facter - external fact file \".*/error_message\" had output on stderr: error message!")));
             }
         }
+        WHEN("several files are resolved together") {
+            auto errors = resolver.resolve_all({
+                LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/external/posix/execution/facts",
+                LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/external/posix/execution/failed",
+                LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/external/posix/execution/error_message"
+            }, facts);
+            THEN("the facts of each file are populated") {
+                REQUIRE(facts.get<string_value>("exe_fact1"));
+                REQUIRE(facts.get<string_value>("exe_fact1")->value() == "value1");
+                REQUIRE(facts.get<string_value>("foo"));
+                REQUIRE(facts.get<string_value>("foo")->value() == "bar");
+            }
+            THEN("only the file that failed has an error") {
+                REQUIRE(errors.size() == 1u);
+                REQUIRE(errors.count(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/external/posix/execution/failed") == 1u);
+            }
+        }
         THEN("the file can be resolved") {
             REQUIRE(resolver.can_resolve(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/external/posix/execution/facts"));
         }
@@ -43,4 +43,13 @@ SCENARIO("resolving external text facts") {
             REQUIRE(facts.get<string_value>("txt_fact4")->value() == "value2");
         }
     }
+    GIVEN("a text file with CRLF line endings") {
+        THEN("the carriage returns should not be part of the values") {
+            resolver.resolve(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/external/text/crlf/facts.txt", facts);
+            REQUIRE(facts.get<string_value>("txt_crlf1"));
+            REQUIRE(facts.get<string_value>("txt_crlf1")->value() == "value1");
+            REQUIRE(facts.get<string_value>("txt_crlf2"));
+            REQUIRE(facts.get<string_value>("txt_crlf2")->value() == "value2");
+        }
+    }
 }
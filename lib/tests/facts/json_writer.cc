@@ -0,0 +1,75 @@
+#include <catch.hpp>
+#include <facter/facts/json_writer.hpp>
+#include <facter/facts/array_value.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+using namespace facter::facts;
+
+SCENARIO("writing JSON with the streaming writer") {
+    map_value value;
+    auto array = make_value<array_value>();
+    array->add(make_value<string_value>("1"));
+    array->add(make_value<integer_value>(-2));
+    array->add(make_value<double_value>(3.5));
+    value.add("array", move(array));
+    value.add("boolean", make_value<boolean_value>(false));
+    value.add("empty_array", make_value<array_value>());
+    value.add("empty_map", make_value<map_value>());
+    auto map = make_value<map_value>();
+    map->add("foo", make_value<string_value>("bar"));
+    value.add("map", move(map));
+    value.add("string", make_value<string_value>("\"quoted\"\\\n\t\x01"));
+
+    GIVEN("pretty output") {
+        ostringstream stream;
+        {
+            json_writer writer(stream);
+            value.write(writer);
+        }
+        THEN("the output should be indented") {
+            REQUIRE(stream.str() ==
+                "{\n"
+                "  \"array\": [\n"
+                "    \"1\",\n"
+                "    -2,\n"
+                "    3.5\n"
+                "  ],\n"
+                "  \"boolean\": false,\n"
+                "  \"empty_array\": [],\n"
+                "  \"empty_map\": {},\n"
+                "  \"map\": {\n"
+                "    \"foo\": \"bar\"\n"
+                "  },\n"
+                "  \"string\": \"\\\"quoted\\\"\\\\\\n\\t\\u0001\"\n"
+                "}");
+        }
+    }
+    GIVEN("compact output") {
+        ostringstream stream;
+        {
+            json_writer writer(stream, false);
+            value.write(writer);
+        }
+        THEN("the output should not contain whitespace") {
+            REQUIRE(stream.str() == "{\"array\":[\"1\",-2,3.5],\"boolean\":false,\"empty_array\":[],\"empty_map\":{},\"map\":{\"foo\":\"bar\"},\"string\":\"\\\"quoted\\\"\\\\\\n\\t\\u0001\"}");
+        }
+    }
+    GIVEN("a buffer smaller than the output") {
+        ostringstream stream;
+        json_writer writer(stream, false, 4);
+        writer.start_array();
+        writer.write_integer(numeric_limits<int64_t>::min());
+        writer.write_null();
+        writer.write_boolean(true);
+        writer.end_array();
+        THEN("output should be written to the stream as the buffer fills") {
+            REQUIRE_FALSE(stream.str().empty());
+            writer.flush();
+            REQUIRE(stream.str() == "[-9223372036854775808,null,true]");
+        }
+    }
+}
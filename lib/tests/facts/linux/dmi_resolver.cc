@@ -0,0 +1,76 @@
+#include <catch.hpp>
+#include <internal/facts/linux/dmi_resolver.hpp>
+#include "../../fixtures.hpp"
+
+using namespace std;
+using namespace facter::facts::linux;
+using facter::util::smbios;
+
+struct test_linux_dmi_resolver : dmi_resolver
+{
+    using dmi_resolver::data;
+    using dmi_resolver::collect_smbios_data;
+};
+
+SCENARIO("collecting DMI data from SMBIOS tables") {
+    string fixtures = LIBFACTER_TESTS_DIRECTORY "/fixtures/util/smbios/";
+    smbios tables;
+    test_linux_dmi_resolver::data result;
+    GIVEN("an empty table") {
+        THEN("no data is collected") {
+            REQUIRE_FALSE(test_linux_dmi_resolver::collect_smbios_data(tables, result));
+        }
+    }
+    GIVEN("a virtual machine's table") {
+        REQUIRE(tables.read(fixtures + "qemu"));
+        REQUIRE(test_linux_dmi_resolver::collect_smbios_data(tables, result));
+        THEN("the BIOS information is collected") {
+            REQUIRE(result.bios_vendor == "SeaBIOS");
+            REQUIRE(result.bios_version == "1.13.0-1ubuntu1.1");
+            REQUIRE(result.bios_release_date == "04/01/2014");
+        }
+        THEN("the system information is collected") {
+            REQUIRE(result.manufacturer == "QEMU");
+            REQUIRE(result.product_name == "Standard PC (i440FX + PIIX, 1996)");
+            REQUIRE(result.serial_number.empty());
+        }
+        THEN("the UUID is decoded with little-endian fields") {
+            REQUIRE(result.uuid == "00112233-4455-6677-8899-aabbccddeeff");
+        }
+        THEN("the missing baseboard information is empty") {
+            REQUIRE(result.board_manufacturer.empty());
+            REQUIRE(result.board_product_name.empty());
+            REQUIRE(result.board_serial_number.empty());
+            REQUIRE(result.board_asset_tag.empty());
+        }
+        THEN("the chassis information is collected") {
+            REQUIRE(result.chassis_type == "Other");
+            REQUIRE(result.chassis_asset_tag.empty());
+        }
+    }
+    GIVEN("a server's table") {
+        REQUIRE(tables.read(fixtures + "server"));
+        REQUIRE(test_linux_dmi_resolver::collect_smbios_data(tables, result));
+        THEN("the BIOS information is collected") {
+            REQUIRE(result.bios_vendor == "Dell Inc.");
+            REQUIRE(result.bios_version == "2.11.2");
+            REQUIRE(result.bios_release_date == "04/08/2021");
+        }
+        THEN("the system information is collected") {
+            REQUIRE(result.manufacturer == "Dell Inc.");
+            REQUIRE(result.product_name == "PowerEdge R640");
+            REQUIRE(result.serial_number == "9R5V52");
+            REQUIRE(result.uuid == "4c4c4544-0030-4e10-8052-b8c04f563532");
+        }
+        THEN("the baseboard information is collected") {
+            REQUIRE(result.board_manufacturer == "Dell Inc.");
+            REQUIRE(result.board_product_name == "0H28RR");
+            REQUIRE(result.board_serial_number == ".9R5V52.CNFCP0012C00TS.");
+            REQUIRE(result.board_asset_tag == "board-tag");
+        }
+        THEN("the chassis type is collected without the lock bit") {
+            REQUIRE(result.chassis_type == "Rack Mount Chassis");
+            REQUIRE(result.chassis_asset_tag == "rack-42");
+        }
+    }
+}
@@ -0,0 +1,128 @@
+#include <catch.hpp>
+#include <internal/facts/linux/filesystem_resolver.hpp>
+#include "../../fixtures.hpp"
+
+using namespace std;
+using namespace facter::facts::linux;
+
+struct test_filesystem_resolver : filesystem_resolver
+{
+    using filesystem_resolver::partition;
+};
+
+SCENARIO("reading mountpoints from mountinfo") {
+    string fixture = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/mountinfo/mountinfo";
+    GIVEN("a mountinfo file") {
+        auto mountpoints = filesystem_resolver::read_mountinfo(fixture);
+        THEN("only mountpoints of devices should be read") {
+            REQUIRE(mountpoints.size() == 4u);
+            REQUIRE(mountpoints[0].name == "/");
+            REQUIRE(mountpoints[0].device == "/dev/vda1");
+            REQUIRE(mountpoints[0].filesystem == "ext4");
+            REQUIRE(mountpoints[3].name == "/boot");
+            REQUIRE(mountpoints[3].device == "/dev/vda2");
+        }
+        THEN("escaped paths should be unescaped") {
+            REQUIRE(mountpoints[1].name == "/mnt/my data");
+        }
+        THEN("options should be combined in the order of /proc/mounts") {
+            REQUIRE(mountpoints[0].options == (vector<string>{ "rw", "relatime", "errors=remount-ro" }));
+            REQUIRE(mountpoints[1].options == (vector<string>{ "rw", "sync", "lazytime", "noatime", "attr2", "inode64" }));
+            REQUIRE(mountpoints[2].options == (vector<string>{ "ro", "relatime", "space_cache" }));
+            REQUIRE(mountpoints[3].options == (vector<string>{ "rw", "relatime" }));
+        }
+    }
+    GIVEN("a filter") {
+        auto mountpoints = filesystem_resolver::read_mountinfo(fixture, [](string const& name, string const& filesystem) {
+            return name != "/boot" && filesystem != "xfs";
+        });
+        THEN("mountpoints should be skipped by path or file system") {
+            REQUIRE(mountpoints.size() == 2u);
+            REQUIRE(mountpoints[0].name == "/");
+            REQUIRE(mountpoints[1].name == "/mnt/backup");
+        }
+    }
+    GIVEN("a file that does not exist") {
+        THEN("no mountpoints should be read") {
+            REQUIRE(filesystem_resolver::read_mountinfo(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/mountinfo/missing").empty());
+        }
+    }
+}
+
+SCENARIO("getting the sizes of mountpoints") {
+    auto mountpoints = filesystem_resolver::read_mountinfo(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/mountinfo/mountinfo");
+    REQUIRE(mountpoints.size() == 4u);
+    mountpoints[0].name = LIBFACTER_TESTS_DIRECTORY;
+    mountpoints[1].name = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/mountinfo/missing";
+    vector<decltype(&mountpoints[0])> points;
+    for (auto& point : mountpoints) {
+        points.push_back(&point);
+    }
+    GIVEN("a pool of threads") {
+        filesystem_resolver::stat_mountpoints(points, 2, filesystem_resolver::statfs_timeout);
+        THEN("the sizes of existing mountpoints should be found") {
+            REQUIRE(mountpoints[0].size > 0u);
+            REQUIRE(mountpoints[0].size >= mountpoints[0].available);
+            REQUIRE_FALSE(mountpoints[0].timed_out);
+        }
+        THEN("mountpoints that cannot be statted should have no size") {
+            REQUIRE(mountpoints[1].size == 0u);
+            REQUIRE_FALSE(mountpoints[1].timed_out);
+        }
+    }
+    GIVEN("a single thread") {
+        filesystem_resolver::stat_mountpoints(points, 1, filesystem_resolver::statfs_timeout);
+        THEN("every mountpoint should be statted") {
+            REQUIRE(mountpoints[0].size > 0u);
+            for (auto const& point : mountpoints) {
+                REQUIRE_FALSE(point.timed_out);
+            }
+        }
+    }
+}
+
+SCENARIO("reading partitions from the udev database") {
+    string fixture = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/block";
+    vector<test_filesystem_resolver::partition> unprobed;
+    GIVEN("block devices in sysfs") {
+        auto partitions = filesystem_resolver::read_partitions(fixture + "/sys", fixture + "/udev", nullptr, unprobed);
+        THEN("devices with a file system in the udev database should be read") {
+            REQUIRE(partitions.size() == 3u);
+            REQUIRE(partitions[0].name == "/dev/mapper/vg-swap");
+            REQUIRE(partitions[0].filesystem == "swap");
+            REQUIRE(partitions[0].uuid == "77aa");
+            REQUIRE(partitions[0].size == 10240u);
+            REQUIRE(partitions[1].name == "/dev/sda1");
+            REQUIRE(partitions[1].filesystem == "ext4");
+            REQUIRE(partitions[1].uuid == "0c0b9b1d-1f4a-4c38-9b53-5d1d6f1a5b2e");
+            REQUIRE(partitions[1].label == "my root");
+            REQUIRE(partitions[1].partition_label == "Linux filesystem");
+            REQUIRE(partitions[1].partition_uuid == "5f1e2d3c-0000-4000-8000-00000000abcd");
+            REQUIRE(partitions[1].size == 204800u);
+            REQUIRE(partitions[2].name == "/dev/sdb");
+            REQUIRE(partitions[2].filesystem == "xfs");
+        }
+        THEN("devices missing from the udev database should need probing") {
+            REQUIRE(unprobed.size() == 1u);
+            REQUIRE(unprobed[0].name == "/dev/sda2");
+            REQUIRE(unprobed[0].size == 307200u);
+            REQUIRE(unprobed[0].filesystem.empty());
+        }
+    }
+    GIVEN("a filter") {
+        auto partitions = filesystem_resolver::read_partitions(fixture + "/sys", fixture + "/udev", [](string const& name) {
+            return name == "/dev/sda1";
+        }, unprobed);
+        THEN("only included devices should be read") {
+            REQUIRE(partitions.size() == 1u);
+            REQUIRE(partitions[0].name == "/dev/sda1");
+            REQUIRE(unprobed.empty());
+        }
+    }
+    GIVEN("a missing sysfs directory") {
+        THEN("no partitions should be read") {
+            REQUIRE(filesystem_resolver::read_partitions(fixture + "/missing", fixture + "/udev", nullptr, unprobed).empty());
+            REQUIRE(unprobed.empty());
+        }
+    }
+}
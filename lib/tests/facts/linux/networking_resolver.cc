@@ -0,0 +1,52 @@
+#include <catch.hpp>
+#include <internal/facts/linux/networking_resolver.hpp>
+#include "../../fixtures.hpp"
+
+using namespace std;
+using namespace facter::facts::linux;
+
+SCENARIO("finding DHCP servers in lease stores") {
+    GIVEN("systemd-networkd lease files") {
+        auto servers = networking_resolver::find_networkd_dhcp_servers(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/networkd_leases");
+        THEN("the server of each interface index should be found") {
+            REQUIRE(servers.size() == 2u);
+            REQUIRE(servers[2] == "192.168.1.1");
+            REQUIRE(servers[3] == "10.0.0.1");
+        }
+    }
+    GIVEN("dhcpcd lease files") {
+        auto servers = networking_resolver::find_dhcpcd_lease_servers(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/dhcpcd");
+        THEN("the server identifier option of each lease should be found") {
+            REQUIRE(servers.size() == 2u);
+            REQUIRE(servers["eth0"] == "172.16.0.1");
+            REQUIRE(servers["wlan0"] == "192.168.0.254");
+        }
+    }
+    GIVEN("dhcpcd") {
+        auto servers = networking_resolver::find_dhcpcd_servers(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/dhcpcd.sh", { "eth0", "eth1", "wlan0" });
+        THEN("the server of each interface with a lease should be found") {
+            REQUIRE(servers.size() == 2u);
+            REQUIRE(servers["eth0"] == "10.0.0.1");
+            REQUIRE(servers["eth1"] == "10.1.0.1");
+        }
+    }
+    GIVEN("dhcpcd is not installed") {
+        THEN("no servers should be found") {
+            REQUIRE(networking_resolver::find_dhcpcd_servers(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/missing", { "eth0" }).empty());
+        }
+    }
+    GIVEN("a directory that does not exist") {
+        THEN("no servers should be found") {
+            REQUIRE(networking_resolver::find_networkd_dhcp_servers(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/missing").empty());
+            REQUIRE(networking_resolver::find_dhcpcd_lease_servers(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/missing").empty());
+        }
+    }
+}
+
+SCENARIO("determining which links use DHCP") {
+    REQUIRE(networking_resolver::is_dhcp_kind(""));
+    REQUIRE(networking_resolver::is_dhcp_kind("vlan"));
+    REQUIRE_FALSE(networking_resolver::is_dhcp_kind("veth"));
+    REQUIRE_FALSE(networking_resolver::is_dhcp_kind("bridge"));
+    REQUIRE_FALSE(networking_resolver::is_dhcp_kind("tun"));
+}
@@ -0,0 +1,75 @@
+#include <catch.hpp>
+#include <internal/facts/linux/operating_system_resolver.hpp>
+#include <facter/util/file.hpp>
+#include "../../fixtures.hpp"
+
+using namespace std;
+using namespace facter::facts::linux;
+using facter::util::file;
+
+struct test_linux_operating_system_resolver : operating_system_resolver
+{
+    using operating_system_resolver::data;
+    using operating_system_resolver::collect_lsb_data;
+    using operating_system_resolver::parse_lsb_release;
+};
+
+static test_linux_operating_system_resolver::data parse_fixture_output(string const& path)
+{
+    test_linux_operating_system_resolver::data result;
+    file::each_line(path, [&](string& line) {
+        test_linux_operating_system_resolver::parse_lsb_release(line, result);
+        return true;
+    });
+    return result;
+}
+
+SCENARIO("collecting LSB data from release files") {
+    string fixtures = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/lsb/";
+    for (auto distribution : { "amazon", "centos", "debian", "fedora", "redhat", "ubuntu" }) {
+        GIVEN(string("the release files of ") + distribution) {
+            test_linux_operating_system_resolver::data result;
+            test_linux_operating_system_resolver::collect_lsb_data(fixtures + distribution, result);
+            auto expected = parse_fixture_output(fixtures + distribution + "/lsb_release");
+            THEN("the data should match the output of lsb_release") {
+                REQUIRE_FALSE(result.distro.id.empty());
+                REQUIRE(result.specification_version == expected.specification_version);
+                REQUIRE(result.distro.id == expected.distro.id);
+                REQUIRE(result.distro.description == expected.distro.description);
+                REQUIRE(result.distro.release == expected.distro.release);
+                REQUIRE(result.distro.codename == expected.distro.codename);
+            }
+        }
+    }
+    GIVEN("a root without release files") {
+        test_linux_operating_system_resolver::data result;
+        test_linux_operating_system_resolver::collect_lsb_data(fixtures + "does_not_exist", result);
+        THEN("no data should be collected") {
+            REQUIRE(result.specification_version.empty());
+            REQUIRE(result.distro.id.empty());
+            REQUIRE(result.distro.description.empty());
+            REQUIRE(result.distro.release.empty());
+            REQUIRE(result.distro.codename.empty());
+        }
+    }
+}
+
+SCENARIO("parsing lsb_release output") {
+    test_linux_operating_system_resolver::data result;
+    GIVEN("values of n/a") {
+        result.distro.codename = "bookworm";
+        test_linux_operating_system_resolver::parse_lsb_release("LSB Version:\tn/a", result);
+        test_linux_operating_system_resolver::parse_lsb_release("Codename:\tn/a", result);
+        THEN("they should be treated as missing") {
+            REQUIRE(result.specification_version.empty());
+            REQUIRE(result.distro.codename == "bookworm");
+        }
+    }
+    GIVEN("unrecognized lines") {
+        test_linux_operating_system_resolver::parse_lsb_release("No LSB modules are available.", result);
+        THEN("they should be ignored") {
+            REQUIRE(result.specification_version.empty());
+            REQUIRE(result.distro.id.empty());
+        }
+    }
+}
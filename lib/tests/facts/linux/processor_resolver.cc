@@ -0,0 +1,92 @@
+#include <catch.hpp>
+#include <internal/facts/linux/processor_resolver.hpp>
+#include "../../fixtures.hpp"
+
+using namespace std;
+using namespace facter::facts::linux;
+
+struct test_linux_processor_resolver : processor_resolver
+{
+    using processor_resolver::data;
+    using processor_resolver::collect_topology;
+    using processor_resolver::collect_cpuinfo;
+};
+
+SCENARIO("parsing CPU lists") {
+    GIVEN("an empty list") {
+        THEN("no CPUs are listed") {
+            REQUIRE(processor_resolver::parse_cpu_list("").empty());
+            REQUIRE(processor_resolver::parse_cpu_list("\n").empty());
+        }
+    }
+    GIVEN("a single CPU") {
+        THEN("only that CPU is listed") {
+            REQUIRE(processor_resolver::parse_cpu_list("0\n") == vector<bool>({ true }));
+            REQUIRE(processor_resolver::parse_cpu_list("2") == vector<bool>({ false, false, true }));
+        }
+    }
+    GIVEN("ranges of CPUs") {
+        THEN("every CPU in the ranges is listed") {
+            REQUIRE(processor_resolver::parse_cpu_list("0-2,5,7-8\n") == vector<bool>({ true, true, true, false, false, true, false, true, true }));
+        }
+    }
+    GIVEN("malformed ranges") {
+        THEN("the malformed ranges are ignored") {
+            REQUIRE(processor_resolver::parse_cpu_list("x,3-1,1") == vector<bool>({ false, true }));
+        }
+    }
+}
+
+SCENARIO("collecting the CPU topology from sysfs") {
+    test_linux_processor_resolver::data result;
+    GIVEN("a sysfs CPU directory") {
+        REQUIRE(test_linux_processor_resolver::collect_topology(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/cpu/sys", result));
+        THEN("every present CPU is counted") {
+            REQUIRE(result.logical_count == 8);
+        }
+        THEN("each package is counted once") {
+            REQUIRE(result.physical_count == 2);
+        }
+    }
+    GIVEN("a directory without a present CPU list") {
+        THEN("the topology is unavailable") {
+            REQUIRE_FALSE(test_linux_processor_resolver::collect_topology(LIBFACTER_TESTS_DIRECTORY "/fixtures/does_not_exist", result));
+            REQUIRE(result.logical_count == 0);
+            REQUIRE(result.physical_count == 0);
+        }
+    }
+}
+
+SCENARIO("collecting processors from cpuinfo") {
+    string fixture = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/cpu/cpuinfo";
+    test_linux_processor_resolver::data result;
+    GIVEN("only the models are collected") {
+        REQUIRE(test_linux_processor_resolver::collect_cpuinfo(fixture, result, false));
+        THEN("each distinct model is stored once") {
+            REQUIRE(result.model_names == vector<string>({
+                "Intel(R) Xeon(R) CPU E5-2680 v4 @ 2.40GHz",
+                "Intel(R) Xeon(R) CPU E5-2690 v4 @ 2.60GHz"
+            }));
+        }
+        THEN("each processor refers to its model") {
+            REQUIRE(result.model_indexes == vector<size_t>({ 0, 0, 0, 0, 1, 1, 1, 1 }));
+        }
+        THEN("the counts are not collected") {
+            REQUIRE(result.logical_count == 0);
+            REQUIRE(result.physical_count == 0);
+        }
+    }
+    GIVEN("the counts are collected") {
+        REQUIRE(test_linux_processor_resolver::collect_cpuinfo(fixture, result, true));
+        THEN("the logical and physical processors are counted") {
+            REQUIRE(result.logical_count == 8);
+            REQUIRE(result.physical_count == 2);
+        }
+    }
+    GIVEN("a file that does not exist") {
+        THEN("nothing is collected") {
+            REQUIRE_FALSE(test_linux_processor_resolver::collect_cpuinfo(LIBFACTER_TESTS_DIRECTORY "/fixtures/does_not_exist", result, true));
+            REQUIRE(result.model_indexes.empty());
+        }
+    }
+}
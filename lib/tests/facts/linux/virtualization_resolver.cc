@@ -0,0 +1,91 @@
+#include <catch.hpp>
+#include <internal/facts/linux/virtualization_resolver.hpp>
+#include <facter/facts/fact.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <facter/facts/vm.hpp>
+#include "../../collection_fixture.hpp"
+#include "../../fixtures.hpp"
+
+using namespace std;
+using namespace facter::facts;
+using namespace facter::facts::linux;
+using namespace facter::testing;
+
+struct test_linux_virtualization_resolver : virtualization_resolver
+{
+    using virtualization_resolver::get_native_vm;
+};
+
+SCENARIO("detecting hypervisors without running commands") {
+    string fixtures = LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/virtualization/";
+    collection_fixture facts;
+    GIVEN("a physical machine") {
+        THEN("no hypervisor is detected") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", {}).empty());
+        }
+    }
+    GIVEN("container markers") {
+        THEN("the container is detected from the cgroup of init") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "docker", {}) == string(vm::docker));
+        }
+        THEN("the container is detected from the environment of init") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "lxc", {}) == string(vm::lxc));
+        }
+        THEN("the container takes precedence over the hypervisor of the host") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "docker", "KVMKVMKVM") == string(vm::docker));
+        }
+    }
+    GIVEN("an OpenVZ container") {
+        THEN("the container is detected from the environment ID") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "openvz", {}) == string(vm::openvz_ve));
+        }
+    }
+    GIVEN("Xen domains") {
+        THEN("the control domain is privileged") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "xen_dom0", {}) == string(vm::xen_privileged));
+        }
+        THEN("a paravirtualized guest is unprivileged") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "xen_domu", {}) == string(vm::xen_unprivileged));
+        }
+        THEN("a fully virtualized guest is detected from the CPUID signature") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "XenVMMXenVMM") == string(vm::xen_hardware));
+        }
+        THEN("a fully virtualized guest is detected from its guest type") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "xen_hvm", "XenVMMXenVMM") == string(vm::xen_hardware));
+        }
+        THEN("a paravirtualized guest that sees the CPUID signature is unprivileged") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "xen_pv", "XenVMMXenVMM") == string(vm::xen_unprivileged));
+        }
+    }
+    GIVEN("CPUID signatures") {
+        THEN("known signatures are detected") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "KVMKVMKVM") == string(vm::kvm));
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "VMwareVMware") == string(vm::vmware));
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "Microsoft Hv") == string(vm::hyperv));
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "VBoxVBoxVBox") == string(vm::virtualbox));
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "prl hyperv") == string(vm::parallels));
+        }
+        THEN("unknown signatures are ignored") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "foobar").empty());
+        }
+    }
+    GIVEN("DMI facts") {
+        THEN("GCE is detected from the BIOS vendor") {
+            facts.add(fact::bios_vendor, make_value<string_value>("Google"));
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "KVMKVMKVM") == string(vm::gce));
+        }
+        THEN("the product name takes precedence over the CPUID signature") {
+            facts.add(fact::product_name, make_value<string_value>("VirtualBox"));
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "physical", "KVMKVMKVM") == string(vm::virtualbox));
+        }
+    }
+    GIVEN("PCI devices") {
+        THEN("the hypervisor is detected from the vendor IDs") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "kvm", {}) == string(vm::kvm));
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "vmware", {}) == string(vm::vmware));
+        }
+        THEN("more specific vendors take precedence over virtio") {
+            REQUIRE(test_linux_virtualization_resolver::get_native_vm(facts, fixtures + "gce", {}) == string(vm::gce));
+        }
+    }
+}
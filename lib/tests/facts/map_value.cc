@@ -2,6 +2,8 @@
 #include <facter/facts/map_value.hpp>
 #include <facter/facts/array_value.hpp>
 #include <facter/facts/scalar_value.hpp>
+#include <internal/facts/string_pool.hpp>
+#include <internal/facts/value_arena.hpp>
 #include <rapidjson/document.h>
 #include <yaml-cpp/yaml.h>
 #include <sstream>
@@ -114,3 +116,95 @@ SCENARIO("using a map fact value") {
         }
     }
 }
+
+SCENARIO("adding elements to a map fact value") {
+    map_value value;
+    GIVEN("elements added out of order") {
+        value.add("c", make_value<integer_value>(3));
+        value.add("a", make_value<integer_value>(1));
+        value.add("d", make_value<integer_value>(4));
+        value.add("b", make_value<integer_value>(2));
+        THEN("they should be found by name") {
+            REQUIRE(value.get<integer_value>("a")->value() == 1);
+            REQUIRE(value.get<integer_value>("b")->value() == 2);
+            REQUIRE(value.get<integer_value>("c")->value() == 3);
+            REQUIRE(value.get<integer_value>("d")->value() == 4);
+            REQUIRE_FALSE(value["e"]);
+            REQUIRE_FALSE(value[""]);
+        }
+        THEN("they should be enumerated in sort order") {
+            vector<string> names;
+            value.each([&](string const& name, struct value const*) {
+                names.push_back(name);
+                return true;
+            });
+            REQUIRE(names == vector<string>({ "a", "b", "c", "d" }));
+        }
+    }
+    GIVEN("an element with a name already in the map") {
+        value.add("foo", make_value<string_value>("first"));
+        value.add("foo", make_value<string_value>("second"));
+        THEN("the first element should be kept") {
+            REQUIRE(value.size() == 1u);
+            REQUIRE(value.get<string_value>("foo")->value() == "first");
+        }
+    }
+}
+
+SCENARIO("interning map keys") {
+    GIVEN("maps created while an arena is current") {
+        value_arena arena;
+        value_arena::scope scope(&arena);
+        map_value first;
+        first.add("ip", make_value<string_value>("127.0.0.1"));
+        first.add("mtu", make_value<integer_value>(65536));
+        map_value second;
+        second.add("mtu", make_value<integer_value>(1500));
+        second.add("ip", make_value<string_value>("10.0.0.1"));
+        THEN("the maps should share their keys") {
+            REQUIRE(arena.strings()->size() == 2u);
+            string const* first_key = nullptr;
+            string const* second_key = nullptr;
+            first.each([&](string const& name, struct value const*) {
+                first_key = &name;
+                return false;
+            });
+            second.each([&](string const& name, struct value const*) {
+                second_key = &name;
+                return false;
+            });
+            REQUIRE(first_key);
+            REQUIRE(*first_key == "ip");
+            REQUIRE(first_key == second_key);
+        }
+    }
+    GIVEN("maps created without an arena") {
+        map_value first;
+        first.add("ip", make_value<string_value>("127.0.0.1"));
+        first.add("mtu", make_value<integer_value>(65536));
+        map_value moved(move(first));
+        THEN("the map should keep its own keys") {
+            REQUIRE(moved.size() == 2u);
+            REQUIRE(moved.get<string_value>("ip")->value() == "127.0.0.1");
+            REQUIRE(moved.get<integer_value>("mtu")->value() == 65536);
+            vector<string> names;
+            moved.each([&](string const& name, struct value const*) {
+                names.push_back(name);
+                return true;
+            });
+            REQUIRE(names == vector<string>({ "ip", "mtu" }));
+        }
+    }
+    GIVEN("a map that outlives the arena it was created in") {
+        unique_ptr<map_value> escaped;
+        {
+            value_arena arena;
+            value_arena::scope scope(&arena);
+            escaped.reset(new map_value());
+            escaped->add("netmask", make_value<string_value>("255.0.0.0"));
+        }
+        THEN("its keys should still be valid") {
+            REQUIRE(escaped->get<string_value>("netmask")->value() == "255.0.0.0");
+        }
+    }
+}
@@ -0,0 +1,144 @@
+#include <catch.hpp>
+#include <facter/facts/msgpack.hpp>
+#include <facter/facts/collection.hpp>
+#include <facter/facts/array_value.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <limits>
+#include <sstream>
+
+using namespace std;
+using namespace facter::facts;
+
+SCENARIO("writing and reading MessagePack") {
+    GIVEN("scalar values") {
+        string buffer;
+        msgpack_writer writer(buffer);
+        writer.write_integer(5);
+        writer.write_integer(-5);
+        writer.write_integer(-100);
+        writer.write_integer(1000);
+        writer.write_integer(-100000);
+        writer.write_integer(numeric_limits<int64_t>::max());
+        writer.write_integer(numeric_limits<int64_t>::min());
+        writer.write_boolean(true);
+        writer.write_double(-1.25);
+        writer.write_string(string(40, 'a'));
+        writer.write_string(string(300, 'b'));
+        writer.write_string(string(70000, 'c'));
+        writer.write_nil();
+        THEN("the smallest encodings should be used") {
+            REQUIRE(static_cast<uint8_t>(buffer[0]) == 0x05);
+            REQUIRE(static_cast<uint8_t>(buffer[1]) == 0xfb);
+            REQUIRE(static_cast<uint8_t>(buffer[2]) == 0xd0);
+            REQUIRE(static_cast<uint8_t>(buffer[4]) == 0xd1);
+            REQUIRE(static_cast<uint8_t>(buffer[7]) == 0xd2);
+        }
+        THEN("the values should be read back") {
+            msgpack_reader reader(buffer);
+            int64_t expected[] = { 5, -5, -100, 1000, -100000, numeric_limits<int64_t>::max(), numeric_limits<int64_t>::min() };
+            for (auto i : expected) {
+                auto val = reader.read();
+                auto integer = dynamic_cast<integer_value const*>(val.get());
+                REQUIRE(integer);
+                REQUIRE(integer->value() == i);
+            }
+            auto boolean = reader.read();
+            REQUIRE(dynamic_cast<boolean_value const*>(boolean.get()));
+            REQUIRE(dynamic_cast<boolean_value const*>(boolean.get())->value());
+            auto dbl = reader.read();
+            REQUIRE(dynamic_cast<double_value const*>(dbl.get()));
+            REQUIRE(dynamic_cast<double_value const*>(dbl.get())->value() == Approx(-1.25));
+            REQUIRE(reader.read_string() == string(40, 'a'));
+            REQUIRE(reader.read_string() == string(300, 'b'));
+            REQUIRE(reader.read_string() == string(70000, 'c'));
+            REQUIRE_FALSE(reader.read());
+            REQUIRE(reader.done());
+        }
+        THEN("truncated data should throw") {
+            msgpack_reader reader(buffer, 0, buffer.size() - 2);
+            REQUIRE_THROWS_AS(([&]() { while (!reader.done()) { reader.read(); } })(), msgpack_exception);
+        }
+    }
+    GIVEN("deeply nested arrays") {
+        // Each 0x91 byte is an array containing the next
+        string nested(msgpack_reader::max_depth, '\x91');
+        nested += '\xc0';
+        THEN("arrays nested up to the maximum depth should be read") {
+            msgpack_reader reader(nested);
+            REQUIRE(dynamic_cast<array_value*>(reader.read().get()));
+            REQUIRE(reader.done());
+        }
+        THEN("arrays nested beyond the maximum depth should throw") {
+            string deeper = "\x91" + nested;
+            msgpack_reader reader(deeper);
+            REQUIRE_THROWS_AS(reader.read(), msgpack_exception);
+        }
+        THEN("corrupt data nested far beyond the maximum depth should throw rather than overflow the stack") {
+            // Each entry is a map with the key "a" whose value is the next map
+            string corrupt;
+            for (int i = 0; i < 1000000; ++i) {
+                corrupt += "\x81\xa1" "a";
+            }
+            msgpack_reader reader(corrupt);
+            REQUIRE_THROWS_AS(reader.read(), msgpack_exception);
+        }
+    }
+    GIVEN("a map value") {
+        map_value value;
+        auto array = make_value<array_value>();
+        for (int i = 0; i < 20; ++i) {
+            array->add(make_value<integer_value>(i));
+        }
+        value.add("array", move(array));
+        auto map = make_value<map_value>();
+        map->add("foo", make_value<string_value>("bar"));
+        value.add("map", move(map));
+        value.add("string", make_value<string_value>("hello"));
+
+        string buffer;
+        msgpack_writer writer(buffer);
+        writer.write(&value);
+        WHEN("read back") {
+            msgpack_reader reader(buffer);
+            auto result = reader.read();
+            THEN("it should contain the same values") {
+                auto read = dynamic_cast<map_value const*>(result.get());
+                REQUIRE(read);
+                REQUIRE(read->size() == 3u);
+                auto read_array = read->get<array_value>("array");
+                REQUIRE(read_array);
+                REQUIRE(read_array->size() == 20u);
+                REQUIRE(read_array->get<integer_value>(19)->value() == 19);
+                REQUIRE(read->get<map_value>("map")->get<string_value>("foo")->value() == "bar");
+                REQUIRE(read->get<string_value>("string")->value() == "hello");
+                ostringstream expected;
+                value.write(expected);
+                ostringstream actual;
+                read->write(actual);
+                REQUIRE(actual.str() == expected.str());
+            }
+        }
+    }
+    GIVEN("a fact collection") {
+        collection facts;
+        facts.add("foo", make_value<string_value>("bar"));
+        facts.add("hidden", make_value<string_value>("secret", true));
+        facts.add("number", make_value<integer_value>(42));
+        WHEN("serialized to MessagePack") {
+            ostringstream ss;
+            facts.write(ss, format::msgpack);
+            string buffer = ss.str();
+            THEN("it should read back as a map without hidden facts") {
+                msgpack_reader reader(buffer);
+                auto result = reader.read();
+                REQUIRE(reader.done());
+                auto read = dynamic_cast<map_value const*>(result.get());
+                REQUIRE(read);
+                REQUIRE(read->size() == 2u);
+                REQUIRE(read->get<string_value>("foo")->value() == "bar");
+                REQUIRE(read->get<integer_value>("number")->value() == 42);
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#include <catch.hpp>
+#include <facter/facts/name_filter.hpp>
+
+using namespace std;
+using namespace facter::facts;
+
+SCENARIO("matching wildcard patterns") {
+    REQUIRE(name_filter::match("eth0", "eth0"));
+    REQUIRE_FALSE(name_filter::match("eth0", "eth01"));
+    REQUIRE_FALSE(name_filter::match("eth0", "eth"));
+    REQUIRE(name_filter::match("veth*", "veth"));
+    REQUIRE(name_filter::match("veth*", "veth1a2b3c"));
+    REQUIRE_FALSE(name_filter::match("veth*", "eth0"));
+    REQUIRE(name_filter::match("*", ""));
+    REQUIRE(name_filter::match("eth?", "eth1"));
+    REQUIRE_FALSE(name_filter::match("eth?", "eth10"));
+    REQUIRE(name_filter::match("/var/lib/docker/*/merged", "/var/lib/docker/overlay2/abc/merged"));
+    REQUIRE_FALSE(name_filter::match("/var/lib/docker/*/merged", "/var/lib/docker/overlay2/abc/diff"));
+    REQUIRE(name_filter::match("*a*b", "xaxxab"));
+    REQUIRE_FALSE(name_filter::match("*a*b", "xaxxa"));
+}
+
+SCENARIO("filtering names") {
+    GIVEN("an empty filter") {
+        name_filter filter;
+        THEN("every name is included") {
+            REQUIRE(filter.empty());
+            REQUIRE(filter.includes("eth0"));
+            REQUIRE(filter.includes({ "/", "ext4" }));
+        }
+    }
+    GIVEN("a filter with only exclude patterns") {
+        name_filter filter({}, { "veth*", "docker*" });
+        THEN("names matching an exclude pattern are filtered out") {
+            REQUIRE_FALSE(filter.empty());
+            REQUIRE(filter.includes("eth0"));
+            REQUIRE_FALSE(filter.includes("veth1234"));
+            REQUIRE_FALSE(filter.includes("docker0"));
+        }
+    }
+    GIVEN("a filter with include and exclude patterns") {
+        name_filter filter({ "eth*", "en*" }, { "eth1" });
+        THEN("only included names that are not excluded pass the filter") {
+            REQUIRE(filter.includes("eth0"));
+            REQUIRE(filter.includes("enp0s3"));
+            REQUIRE_FALSE(filter.includes("eth1"));
+            REQUIRE_FALSE(filter.includes("lo"));
+        }
+    }
+    GIVEN("an object with several names") {
+        name_filter filter({}, { "tmpfs", "/run/*" });
+        THEN("the object is filtered out if any name is excluded") {
+            REQUIRE(filter.includes({ "/", "ext4" }));
+            REQUIRE_FALSE(filter.includes({ "/dev/shm", "tmpfs" }));
+            REQUIRE_FALSE(filter.includes({ "/run/user", "ext4" }));
+        }
+        THEN("the object is included if any name is included") {
+            name_filter includes({ "xfs", "/boot" });
+            REQUIRE(includes.includes({ "/boot", "ext4" }));
+            REQUIRE(includes.includes({ "/data", "xfs" }));
+            REQUIRE_FALSE(includes.includes({ "/", "ext4" }));
+        }
+    }
+}
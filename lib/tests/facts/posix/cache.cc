@@ -0,0 +1,43 @@
+#include <catch.hpp>
+#include <internal/facts/cache.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <facter/util/scope_exit.hpp>
+#include <boost/filesystem.hpp>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace facter::facts;
+using namespace facter::util;
+namespace fs = boost::filesystem;
+
+static mode_t get_mode(string const& path)
+{
+    struct stat status;
+    REQUIRE(stat(path.c_str(), &status) == 0);
+    return status.st_mode & 0777;
+}
+
+SCENARIO("writing the fact cache on POSIX systems") {
+    auto directory = fs::temp_directory_path() / fs::unique_path("facter-cache-%%%%-%%%%");
+    auto path = (directory / "cache" / "cached_facts").string();
+    scope_exit cleanup([&]() {
+        boost::system::error_code ec;
+        fs::remove_all(directory, ec);
+    });
+
+    auto value = make_value<string_value>("value");
+    {
+        fact_cache cache(path, { { "test", 60 } }, false);
+        cache.store("test", { { "string", value.get() } });
+        cache.save();
+    }
+    THEN("only the owner should be able to read the cache file") {
+        REQUIRE(get_mode(path) == 0600u);
+    }
+    THEN("only the owner should be able to list the directory created for it") {
+        REQUIRE(get_mode(fs::path(path).parent_path().string()) == 0700u);
+    }
+    THEN("the parents of the directory should not be made private") {
+        REQUIRE(get_mode(directory.string()) != 0700u);
+    }
+}
@@ -0,0 +1,111 @@
+#include <catch.hpp>
+#include <internal/facts/resolver_index.hpp>
+#include <facter/facts/collection.hpp>
+
+using namespace std;
+using namespace facter::facts;
+
+struct index_resolver : facter::facts::resolver
+{
+    index_resolver(string name, vector<string> names, vector<string> const& patterns = {}) :
+        resolver(move(name), move(names), patterns)
+    {
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+    }
+};
+
+SCENARIO("finding resolvers with the resolver index") {
+    resolver_index index;
+    REQUIRE_FALSE(index.find("foo"));
+
+    GIVEN("resolvers with names") {
+        auto first = make_shared<index_resolver>("first", vector<string>{ "foo", "bar" });
+        auto second = make_shared<index_resolver>("second", vector<string>{ "foo", "foobar" });
+        index.add(first);
+        index.add(second);
+        THEN("the first resolver added for a name should be found") {
+            REQUIRE(index.find("foo") == first);
+            REQUIRE(index.find("bar") == first);
+            REQUIRE(index.find("foobar") == second);
+        }
+        THEN("the last resolver added for a name should be found when requested") {
+            REQUIRE(index.find("foo", true) == second);
+            REQUIRE(index.find("bar", true) == first);
+        }
+        THEN("names that are only a prefix should not be found") {
+            REQUIRE_FALSE(index.find("fo"));
+            REQUIRE_FALSE(index.find("foob"));
+            REQUIRE_FALSE(index.find("foobarbaz"));
+        }
+        THEN("removed resolvers should not be found") {
+            index.remove(first);
+            REQUIRE(index.find("foo") == second);
+            REQUIRE_FALSE(index.find("bar"));
+        }
+        THEN("no resolvers should be found after clearing") {
+            index.clear();
+            REQUIRE_FALSE(index.find("foo"));
+            REQUIRE_FALSE(index.find("foobar"));
+        }
+    }
+    GIVEN("resolvers with patterns") {
+        auto prefix = make_shared<index_resolver>("prefix", vector<string>{ "ipaddress" }, vector<string>{ "^ipaddress_", "^mtu_" });
+        auto regex = make_shared<index_resolver>("regex", vector<string>{}, vector<string>{ "^processor[0-9]+$", "^zone_.+_id$" });
+        auto optional = make_shared<index_resolver>("optional", vector<string>{}, vector<string>{ "^abc?d$" });
+        auto unanchored = make_shared<index_resolver>("unanchored", vector<string>{}, vector<string>{ "_suffix$", "^x|^y" });
+        index.add(prefix);
+        index.add(regex);
+        index.add(optional);
+        index.add(unanchored);
+        THEN("literal prefixes should match") {
+            REQUIRE(index.find("ipaddress") == prefix);
+            REQUIRE(index.find("ipaddress_eth0") == prefix);
+            REQUIRE(index.find("mtu_lo") == prefix);
+            REQUIRE_FALSE(index.find("mtu"));
+            REQUIRE_FALSE(index.find("ipaddress6_eth0"));
+        }
+        THEN("the remainder of a pattern should be matched") {
+            REQUIRE(index.find("processor0") == regex);
+            REQUIRE(index.find("processor12") == regex);
+            REQUIRE_FALSE(index.find("processor"));
+            REQUIRE_FALSE(index.find("processor1a"));
+            REQUIRE(index.find("zone_global_id") == regex);
+            REQUIRE_FALSE(index.find("zone_global_name"));
+        }
+        THEN("optional characters should not be part of the prefix") {
+            REQUIRE(index.find("abd") == optional);
+            REQUIRE(index.find("abcd") == optional);
+            REQUIRE_FALSE(index.find("abcc"));
+        }
+        THEN("unanchored patterns should match") {
+            REQUIRE(index.find("foo_suffix") == unanchored);
+            REQUIRE(index.find("x") == unanchored);
+            REQUIRE(index.find("y") == unanchored);
+        }
+        THEN("names should take precedence over patterns") {
+            auto named = make_shared<index_resolver>("named", vector<string>{ "processor0" });
+            index.add(named);
+            REQUIRE(index.find("processor0") == named);
+            REQUIRE(index.find("processor1") == regex);
+        }
+        THEN("the first resolver added with a matching pattern should be found") {
+            auto later = make_shared<index_resolver>("later", vector<string>{}, vector<string>{ "^ip" });
+            index.add(later);
+            REQUIRE(index.find("ipaddress_eth0") == prefix);
+            REQUIRE(index.find("iphone") == later);
+            index.remove(prefix);
+            REQUIRE(index.find("ipaddress_eth0") == later);
+            REQUIRE_FALSE(index.find("mtu_lo"));
+        }
+        THEN("the last resolver added with a matching pattern should be found when requested") {
+            auto later = make_shared<index_resolver>("later", vector<string>{}, vector<string>{ "^ip" });
+            index.add(later);
+            REQUIRE(index.find("ipaddress_eth0", true) == later);
+            REQUIRE(index.find("ipaddress", true) == prefix);
+            REQUIRE(index.find("mtu_lo", true) == prefix);
+        }
+    }
+}
@@ -111,4 +111,16 @@ SCENARIO("using the disk resolver") {
             REQUIRE(devices->value() == names);
         }
     }
+    GIVEN("a query for a single disk") {
+        resolver->add_disk("disk0", "vendor0", "model0", "product0", 12345);
+        resolver->add_disk("disk1", "vendor1", "model1", "product1", 12346);
+        THEN("only the queried disk should be resolved") {
+            auto model = facts.query<string_value>("disks.disk1.model");
+            REQUIRE(model);
+            REQUIRE(model->value() == "model1");
+            REQUIRE_FALSE(facts.query("disks.disk2"));
+            REQUIRE_FALSE(facts.get_resolved(fact::disks));
+            REQUIRE_FALSE(facts.get_resolved("blockdevice_disk1_model"));
+        }
+    }
 }
@@ -26,6 +26,16 @@ struct test_filesystem_resolver : filesystem_resolver
         mountpoints.emplace_back(move(mp));
     }
 
+    void add_timed_out_mountpoint(string name, string device, string filesystem)
+    {
+        mountpoint mp;
+        mp.name = move(name);
+        mp.device = move(device);
+        mp.filesystem = move(filesystem);
+        mp.timed_out = true;
+        mountpoints.emplace_back(move(mp));
+    }
+
     void add_filesystem(string filesystem)
     {
         filesystems.emplace(move(filesystem));
@@ -133,6 +143,23 @@ SCENARIO("using the file system resolver") {
             }
         }
     }
+    WHEN("getting the size of a mount point timed out") {
+        resolver->add_timed_out_mountpoint("/mnt/nfs", "server:/export", "nfs");
+        THEN("the mount point is marked as timed out without a size") {
+            auto mountpoints = facts.get<map_value>(fact::mountpoints);
+            REQUIRE(mountpoints);
+            auto mountpoint = mountpoints->get<map_value>("/mnt/nfs");
+            REQUIRE(mountpoint);
+            auto timed_out = mountpoint->get<boolean_value>("timed_out");
+            REQUIRE(timed_out);
+            REQUIRE(timed_out->value());
+            REQUIRE_FALSE(mountpoint->get<integer_value>("size_bytes"));
+            REQUIRE_FALSE(mountpoint->get<string_value>("capacity"));
+            auto device = mountpoint->get<string_value>("device");
+            REQUIRE(device);
+            REQUIRE(device->value() == "server:/export");
+        }
+    }
     WHEN("file system data is present") {
         resolver->add_filesystem("foo");
         resolver->add_filesystem("bar");
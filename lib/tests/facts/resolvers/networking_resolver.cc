@@ -67,6 +67,8 @@ struct test_missing_fqdn_resolver : networking_resolver
 
 struct test_interface_resolver : networking_resolver
 {
+    size_t collected = 0;
+
  protected:
     virtual data collect_data(collection& facts) override
     {
@@ -76,6 +78,10 @@ struct test_interface_resolver : networking_resolver
 
             interface iface;
             iface.name = "iface" + num;
+            if (!is_collected(fact::networking, { "interfaces", iface.name }) || !is_included(facts, iface.name)) {
+                continue;
+            }
+            ++collected;
             iface.dhcp_server = "dhcp" + num;
             iface.address.v4 = "ip" + num;
             iface.address.v6 = "ip6" + num;
@@ -341,4 +347,58 @@ SCENARIO("using the networking resolver") {
             }
         }
     }
+    WHEN("querying a single interface") {
+        auto resolver = make_shared<test_interface_resolver>();
+        facts.add(resolver);
+        THEN("only the queried interface is collected") {
+            auto ip = facts.query<string_value>("networking.interfaces.iface3.ip");
+            REQUIRE(ip);
+            REQUIRE(ip->value() == "ip3");
+            auto mtu = facts.query<integer_value>("networking.interfaces.iface3.mtu");
+            REQUIRE(mtu);
+            REQUIRE(mtu->value() == 3);
+            REQUIRE(resolver->collected == 2u);
+            REQUIRE_FALSE(facts.query("networking.interfaces.iface5"));
+            REQUIRE(resolver->collected == 2u);
+            REQUIRE_FALSE(facts.get_resolved(fact::networking));
+            REQUIRE_FALSE(facts.get_resolved("ipaddress_iface3"));
+        }
+        THEN("other queries resolve all interfaces") {
+            auto ip = facts.query<string_value>("networking.ip");
+            REQUIRE(ip);
+            REQUIRE(ip->value() == "ip2");
+            REQUIRE(resolver->collected == 5u);
+            ip = facts.query<string_value>("networking.interfaces.iface3.ip");
+            REQUIRE(ip);
+            REQUIRE(ip->value() == "ip3");
+            REQUIRE(resolver->collected == 5u);
+        }
+    }
+    WHEN("filtering interfaces in the collection") {
+        auto resolver = make_shared<test_interface_resolver>();
+        facts.add(resolver);
+        facts.interface_filter(name_filter({}, { "iface3", "iface4" }));
+        THEN("filtered interfaces are not collected") {
+            auto interfaces = facts.get<string_value>(fact::interfaces);
+            REQUIRE(interfaces);
+            REQUIRE(interfaces->value() == "iface0,iface1,iface2");
+            REQUIRE(resolver->collected == 3u);
+            REQUIRE_FALSE(facts.get<string_value>("ipaddress_iface4"));
+        }
+    }
+    WHEN("filtering interfaces in the resolver") {
+        auto resolver = make_shared<test_interface_resolver>();
+        resolver->interface_filter(name_filter({ "iface?" }, { "iface2" }));
+        facts.interface_filter(name_filter({}, { "*" }));
+        facts.add(resolver);
+        THEN("the resolver's filter is used instead of the collection's filter") {
+            auto interfaces = facts.get<string_value>(fact::interfaces);
+            REQUIRE(interfaces);
+            REQUIRE(interfaces->value() == "iface0,iface1,iface3,iface4");
+            REQUIRE(resolver->collected == 4u);
+        }
+        THEN("a filtered primary interface is not reported") {
+            REQUIRE_FALSE(facts.get<string_value>(fact::ipaddress));
+        }
+    }
 }
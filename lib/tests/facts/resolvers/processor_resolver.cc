@@ -41,6 +41,23 @@ struct test_processor_resolver : processor_resolver
     }
 };
 
+struct model_table_processor_resolver : processor_resolver
+{
+ protected:
+    virtual data collect_data(collection& facts) override
+    {
+        data result;
+        result.logical_count = 4;
+        result.physical_count = 2;
+        result.model_names = {
+            "model1",
+            "model2"
+        };
+        result.model_indexes = { 0, 0, 1, 1 };
+        return result;
+    }
+};
+
 SCENARIO("using the processor resolver") {
     collection_fixture facts;
     WHEN("data is not present") {
@@ -110,4 +127,26 @@ SCENARIO("using the processor resolver") {
             }
         }
     }
+    WHEN("models are stored in a model table") {
+        facts.add(make_shared<model_table_processor_resolver>());
+        THEN("a model is added for each processor") {
+            auto processors = facts.get<map_value>(fact::processors);
+            REQUIRE(processors);
+            auto models = processors->get<array_value>("models");
+            REQUIRE(models);
+            REQUIRE(models->size() == 4u);
+            for (size_t i = 0; i < 4; ++i) {
+                auto model = models->get<string_value>(i);
+                REQUIRE(model);
+                REQUIRE(model->value() == "model" + to_string(i / 2 + 1));
+            }
+        }
+        THEN("a legacy fact is added for each processor") {
+            for (size_t i = 0; i < 4; ++i) {
+                auto model = facts.get<string_value>(fact::processor + to_string(i));
+                REQUIRE(model);
+                REQUIRE(model->value() == "model" + to_string(i / 2 + 1));
+            }
+        }
+    }
 }
@@ -0,0 +1,163 @@
+#include <catch.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <facter/facts/array_value.hpp>
+#include <facter/facts/map_value.hpp>
+
+using namespace std;
+using namespace facter::facts;
+
+struct custom_value : value
+{
+    virtual void to_json(rapidjson::Allocator& allocator, rapidjson::Value& value) const override
+    {
+    }
+
+    virtual void write(json_writer& writer) const override
+    {
+    }
+
+    virtual void write(msgpack_writer& writer) const override
+    {
+    }
+
+    virtual std::ostream& write(std::ostream& os, bool quoted = true, unsigned int level = 1) const override
+    {
+        return os;
+    }
+
+    virtual YAML::Emitter& write(YAML::Emitter& emitter) const override
+    {
+        return emitter;
+    }
+};
+
+struct recording_visitor : value_visitor
+{
+    virtual void visit(string_value const& val) override
+    {
+        visited.push_back("string:" + val.value());
+    }
+
+    virtual void visit(integer_value const& val) override
+    {
+        visited.push_back("integer:" + to_string(val.value()));
+    }
+
+    virtual void visit(boolean_value const& val) override
+    {
+        visited.push_back(string("boolean:") + (val.value() ? "true" : "false"));
+    }
+
+    virtual void visit(double_value const& val) override
+    {
+        visited.push_back("double");
+    }
+
+    virtual void visit(array_value const& val) override
+    {
+        visited.push_back("array");
+        val.each([&](value const* element) {
+            element->accept(*this);
+            return true;
+        });
+    }
+
+    virtual void visit(map_value const& val) override
+    {
+        visited.push_back("map");
+        val.each([&](string const& name, value const* element) {
+            visited.push_back("key:" + name);
+            element->accept(*this);
+            return true;
+        });
+    }
+
+    virtual void visit(value const& val) override
+    {
+        visited.push_back("other");
+    }
+
+    vector<string> visited;
+};
+
+SCENARIO("value type tags") {
+    REQUIRE(string_value("foo").type() == value_type::string);
+    REQUIRE(integer_value(1).type() == value_type::integer);
+    REQUIRE(boolean_value(true).type() == value_type::boolean);
+    REQUIRE(double_value(1.0).type() == value_type::floating_point);
+    REQUIRE(array_value().type() == value_type::array);
+    REQUIRE(map_value().type() == value_type::map);
+    REQUIRE(custom_value().type() == value_type::other);
+    GIVEN("a moved value") {
+        string_value original("foo");
+        string_value moved(move(original));
+        THEN("the type tag should be moved") {
+            REQUIRE(moved.type() == value_type::string);
+        }
+    }
+}
+
+SCENARIO("casting values") {
+    GIVEN("a null value") {
+        THEN("casting should return null") {
+            REQUIRE_FALSE(value_cast<string_value>(static_cast<value const*>(nullptr)));
+            REQUIRE_FALSE(value_cast<custom_value>(static_cast<value const*>(nullptr)));
+        }
+    }
+    GIVEN("a string value") {
+        unique_ptr<value> val = make_value<string_value>("foo");
+        THEN("it should only cast to a string value") {
+            REQUIRE(value_cast<string_value>(val.get()) == val.get());
+            REQUIRE(value_cast<value>(static_cast<value const*>(val.get())) == val.get());
+            REQUIRE_FALSE(value_cast<integer_value>(val.get()));
+            REQUIRE_FALSE(value_cast<map_value>(val.get()));
+            REQUIRE_FALSE(value_cast<custom_value>(val.get()));
+        }
+    }
+    GIVEN("a map value") {
+        unique_ptr<value> val = make_value<map_value>();
+        THEN("it should cast to a mutable map value") {
+            auto map = value_cast<map_value>(val.get());
+            REQUIRE(map);
+            map->add("foo", make_value<integer_value>(1));
+            REQUIRE(map->size() == 1u);
+            REQUIRE_FALSE(value_cast<array_value>(val.get()));
+        }
+    }
+    GIVEN("a value of a type without a type tag") {
+        unique_ptr<value> val(new custom_value());
+        THEN("it should cast to its own type") {
+            REQUIRE(value_cast<custom_value>(val.get()) == val.get());
+            REQUIRE_FALSE(value_cast<string_value>(val.get()));
+        }
+    }
+}
+
+SCENARIO("visiting values") {
+    recording_visitor visitor;
+    GIVEN("a structured value") {
+        auto array = make_value<array_value>();
+        array->add(make_value<integer_value>(5));
+        array->add(make_value<boolean_value>(false));
+        array->add(make_value<double_value>(1.5));
+        map_value map;
+        map.add("array", move(array));
+        map.add("string", make_value<string_value>("bar"));
+        map.add("custom", unique_ptr<value>(new custom_value()));
+        map.accept(visitor);
+        THEN("each value should be visited by its type") {
+            REQUIRE(visitor.visited == vector<string>({
+                "map",
+                "key:array",
+                "array",
+                "integer:5",
+                "boolean:false",
+                "double",
+                "key:custom",
+                "other",
+                "key:string",
+                "string:bar"
+            }));
+        }
+    }
+}
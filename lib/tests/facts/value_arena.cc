@@ -0,0 +1,92 @@
+#include <catch.hpp>
+#include <internal/facts/value_arena.hpp>
+#include <facter/facts/scalar_value.hpp>
+#include <facter/facts/map_value.hpp>
+#include <facter/facts/collection.hpp>
+#include <string>
+
+using namespace std;
+using namespace facter::facts;
+
+struct arena_resolver : facter::facts::resolver
+{
+    arena_resolver() :
+        resolver("arena", { "arena" })
+    {
+    }
+
+    virtual void resolve(collection& facts) override
+    {
+        auto map = make_value<map_value>();
+        for (int i = 0; i < 1000; ++i) {
+            map->add("key" + to_string(i), make_value<string_value>("value" + to_string(i)));
+        }
+        facts.add("arena", move(map));
+    }
+};
+
+SCENARIO("allocating values from an arena") {
+    GIVEN("no current arena") {
+        THEN("values should be allocated from the heap") {
+            auto val = make_value<string_value>("foo");
+            REQUIRE(val->value() == "foo");
+        }
+    }
+    GIVEN("a current arena") {
+        unique_ptr<value> escaped;
+        {
+            value_arena arena(1024);
+            value_arena::scope scope(&arena);
+            vector<unique_ptr<value>> values;
+            for (int i = 0; i < 100; ++i) {
+                values.emplace_back(make_value<integer_value>(i));
+            }
+            THEN("values should be allocated from the arena's blocks") {
+                REQUIRE(value_cast<integer_value>(values[99].get())->value() == 99);
+                auto first = reinterpret_cast<uintptr_t>(values[0].get());
+                auto second = reinterpret_cast<uintptr_t>(values[1].get());
+                REQUIRE(second > first);
+                REQUIRE(second - first < 1024);
+            }
+            escaped = move(values[50]);
+        }
+        THEN("values should outlive the arena") {
+            REQUIRE(value_cast<integer_value>(escaped.get())->value() == 50);
+        }
+    }
+    GIVEN("a value larger than a quarter of a block") {
+        value_arena arena(64);
+        value_arena::scope scope(&arena);
+        auto val = make_value<map_value>();
+        val->add("foo", make_value<string_value>("bar"));
+        THEN("the value should be allocated from the heap") {
+            REQUIRE(val->size() == 1u);
+        }
+    }
+    GIVEN("nested scopes") {
+        value_arena outer;
+        value_arena::scope outer_scope(&outer);
+        {
+            value_arena::scope inner_scope(nullptr);
+            auto val = make_value<string_value>("inner");
+            REQUIRE(val->value() == "inner");
+        }
+        auto val = make_value<string_value>("outer");
+        THEN("the outer arena should be restored") {
+            REQUIRE(val->value() == "outer");
+        }
+    }
+}
+
+SCENARIO("resolving facts into a collection's arena") {
+    {
+        collection facts;
+        facts.add(make_shared<arena_resolver>());
+        auto map = facts.get<map_value>("arena");
+        REQUIRE(map);
+        REQUIRE(map->size() == 1000u);
+        auto element = map->get<string_value>("key999");
+        REQUIRE(element);
+        REQUIRE(element->value() == "value999");
+    }
+}
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Dumps the lease of an interface like "dhcpcd -U <interface>"
+[ "$1" = "-U" ] && [ -n "$2" ] || exit 1
+case "$2" in
+    eth0)
+        echo "ip_address=10.0.0.5"
+        echo "dhcp_server_identifier='10.0.0.1'"
+        ;;
+    eth1)
+        echo "dhcp_server_identifier=10.1.0.1"
+        ;;
+    *)
+        exit 1
+        ;;
+esac
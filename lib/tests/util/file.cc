@@ -2,11 +2,14 @@
 #include <facter/util/file.hpp>
 #include <facter/util/string.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
 #include "../fixtures.hpp"
 
 using namespace std;
 using namespace facter::util;
 using namespace facter::testing;
+namespace fs = boost::filesystem;
 
 SCENARIO("reading each line of a file") {
     string fixture_path = "util/multiline_file.txt";
@@ -49,6 +52,103 @@ SCENARIO("reading each line of a file") {
     }
 }
 
+SCENARIO("reading each line of a file without copying") {
+    string fixture_path = "util/multiline_file.txt";
+    string fixture_file_path = LIBFACTER_TESTS_DIRECTORY "/fixtures/" + fixture_path;
+
+    string data;
+    REQUIRE(load_fixture(fixture_path, data));
+    vector<string> fixture_lines;
+    boost::split(fixture_lines, data, boost::is_any_of("\n\r"), boost::token_compress_on);
+
+    GIVEN("a file that does not exist") {
+        THEN("false is returned") {
+            REQUIRE_FALSE(file::each_line_ref("does_not_exist", [](boost::string_ref line) {
+                FAIL("should not be called");
+                return true;
+            }));
+        }
+    }
+    GIVEN("a callback that returns true") {
+        THEN("all lines are returned") {
+            vector<string> lines;
+            REQUIRE(file::each_line_ref(fixture_file_path, [&](boost::string_ref line) {
+                lines.emplace_back(line.to_string());
+                return true;
+            }));
+            REQUIRE(lines == fixture_lines);
+        }
+    }
+    GIVEN("a callback that returns false") {
+        THEN("only the first line is returned") {
+            vector<string> lines;
+            REQUIRE(file::each_line_ref(fixture_file_path, [&](boost::string_ref line) {
+                lines.emplace_back(line.to_string());
+                return false;
+            }));
+            REQUIRE(lines.size() == 1u);
+            REQUIRE(lines[0] == fixture_lines[0]);
+        }
+    }
+    GIVEN("a large file") {
+        auto path = (fs::temp_directory_path() / fs::unique_path("facter-lines-%%%%-%%%%")).string();
+        {
+            boost::nowide::ofstream out(path.c_str(), ios::binary);
+            for (int i = 0; i < 100000; ++i) {
+                out << "line " << i << " of a file that is read into a single buffer\n";
+            }
+        }
+        REQUIRE(fs::file_size(path) >= 1024u * 1024u);
+        THEN("all lines are returned") {
+            int count = 0;
+            string last;
+            REQUIRE(file::each_line_ref(path, [&](boost::string_ref line) {
+                ++count;
+                last = line.to_string();
+                return true;
+            }));
+            REQUIRE(count == 100000);
+            REQUIRE(last == "line 99999 of a file that is read into a single buffer");
+        }
+        fs::remove(path);
+    }
+}
+
+SCENARIO("splitting a buffer into lines") {
+    vector<string> lines;
+    auto collect = [&](boost::string_ref line) {
+        lines.emplace_back(line.to_string());
+        return true;
+    };
+    GIVEN("an empty buffer") {
+        file::each_line_ref("", 0, collect);
+        THEN("no lines are returned") {
+            REQUIRE(lines.empty());
+        }
+    }
+    GIVEN("a buffer with a trailing newline") {
+        string buffer = "first\n\nthird\n";
+        file::each_line_ref(buffer.data(), buffer.size(), collect);
+        THEN("the trailing newline does not start another line") {
+            REQUIRE(lines == vector<string>({ "first", "", "third" }));
+        }
+    }
+    GIVEN("a buffer with CRLF line endings") {
+        string buffer = "first\r\n\r\nthird\r";
+        file::each_line_ref(buffer.data(), buffer.size(), collect);
+        THEN("the carriage returns should not be part of the lines") {
+            REQUIRE(lines == vector<string>({ "first", "", "third" }));
+        }
+    }
+    GIVEN("a buffer without a trailing newline") {
+        string buffer = "first\nsecond";
+        file::each_line_ref(buffer.data(), buffer.size(), collect);
+        THEN("the last line is returned") {
+            REQUIRE(lines == vector<string>({ "first", "second" }));
+        }
+    }
+}
+
 SCENARIO("reading the entire contents of a file") {
     string fixture_path = "util/multiline_file.txt";
     string fixture_file_path = LIBFACTER_TESTS_DIRECTORY "/fixtures/" + fixture_path;
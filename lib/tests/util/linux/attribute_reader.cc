@@ -0,0 +1,75 @@
+#include <catch.hpp>
+#include <internal/util/linux/attribute_reader.hpp>
+#include "../../fixtures.hpp"
+#include <boost/filesystem.hpp>
+#include <iterator>
+
+using namespace std;
+using namespace facter::util::linux;
+
+SCENARIO("reading attributes") {
+    GIVEN("a directory that does not exist") {
+        attribute_reader attributes(LIBFACTER_TESTS_DIRECTORY "/fixtures/does_not_exist");
+        THEN("the reader is not opened") {
+            REQUIRE_FALSE(attributes);
+            REQUIRE_FALSE(attributes.exists("sda"));
+        }
+        THEN("attributes are empty") {
+            string value = "unchanged";
+            REQUIRE_FALSE(attributes.read("sda/size", value));
+            REQUIRE(value.empty());
+            REQUIRE(attributes.read_all({ "sda/size", "sdb/size" }) == vector<string>({ "", "" }));
+        }
+    }
+    GIVEN("a directory of attributes") {
+        attribute_reader attributes(LIBFACTER_TESTS_DIRECTORY "/fixtures/facts/linux/block/sys");
+        REQUIRE(attributes);
+        THEN("existing files and directories are found") {
+            REQUIRE(attributes.exists("sda"));
+            REQUIRE(attributes.exists("dm-0/dm/name"));
+            REQUIRE_FALSE(attributes.exists("sda/dm/name"));
+        }
+        THEN("an attribute is read without its trailing newline") {
+            string value;
+            REQUIRE(attributes.read("sda/size", value));
+            REQUIRE(value == "2000");
+            REQUIRE(attributes.read("dm-0/dm/name") == "vg-swap");
+        }
+        THEN("a missing attribute is not read") {
+            string value;
+            REQUIRE_FALSE(attributes.read("sda/dm/name", value));
+            REQUIRE(value.empty());
+            REQUIRE(attributes.read("sda/dm/name").empty());
+        }
+        THEN("a batch of attributes is read in order") {
+            auto values = attributes.read_all({
+                "sda/size",
+                "sda/dev",
+                "sda/dm/name",
+                "dm-0/dm/name",
+                "sdb/dev",
+                "loop0/size",
+            });
+            REQUIRE(values == vector<string>({ "2000", "8:0", "", "vg-swap", "8:16", "0" }));
+        }
+        THEN("batches are read repeatedly without leaking descriptors") {
+            vector<string> names;
+            vector<string> expected;
+            for (int i = 0; i < 300; ++i) {
+                names.push_back(i % 2 ? "sda/dm/name" : "sda/size");
+                expected.push_back(i % 2 ? "" : "2000");
+            }
+            // The first batch may set up the reader's ring, which stays open until the reader is destroyed
+            REQUIRE(attributes.read_all(names) == expected);
+            auto descriptors = distance(boost::filesystem::directory_iterator("/proc/self/fd"), boost::filesystem::directory_iterator());
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(attributes.read_all(names) == expected);
+                REQUIRE(attributes.read_all({ "sdb/dev", "dm-0/dm/name", "sdb/missing" }) == vector<string>({ "8:16", "vg-swap", "" }));
+            }
+            REQUIRE(distance(boost::filesystem::directory_iterator("/proc/self/fd"), boost::filesystem::directory_iterator()) == descriptors);
+        }
+        THEN("an empty batch is read") {
+            REQUIRE(attributes.read_all({}).empty());
+        }
+    }
+}
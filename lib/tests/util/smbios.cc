@@ -0,0 +1,96 @@
+#include <catch.hpp>
+#include <internal/util/smbios.hpp>
+#include <facter/util/file.hpp>
+#include "../fixtures.hpp"
+
+using namespace std;
+using namespace facter::util;
+
+SCENARIO("decoding SMBIOS tables") {
+    string fixtures = LIBFACTER_TESTS_DIRECTORY "/fixtures/util/smbios/";
+    smbios tables;
+    GIVEN("a directory without tables") {
+        THEN("nothing is decoded") {
+            REQUIRE_FALSE(tables.read(fixtures + "does_not_exist"));
+            REQUIRE(tables.version() == 0);
+            REQUIRE(tables.structures().empty());
+        }
+    }
+    GIVEN("a table with a 32-bit entry point") {
+        REQUIRE(tables.read(fixtures + "qemu"));
+        THEN("the version is decoded") {
+            REQUIRE(tables.version() == 0x0208);
+        }
+        THEN("every structure up to the end of the table is decoded") {
+            auto const& structures = tables.structures();
+            REQUIRE(structures.size() == 9u);
+            REQUIRE(structures.front().type == 0);
+            REQUIRE(structures.back().type == static_cast<uint8_t>(smbios::end_of_table));
+            REQUIRE(structures[1].handle == 0x0100);
+        }
+        THEN("the strings of a structure are decoded") {
+            auto bios = tables.find(0);
+            REQUIRE(bios);
+            REQUIRE(bios->strings == vector<string>({ "SeaBIOS", "1.13.0-1ubuntu1.1", "04/01/2014" }));
+            REQUIRE(bios->text(0x04) == "SeaBIOS");
+            REQUIRE(bios->text(0x08) == "04/01/2014");
+        }
+        THEN("fields without strings are empty") {
+            auto system = tables.find(1);
+            REQUIRE(system);
+            REQUIRE(system->text(0x07).empty());
+            REQUIRE(system->text(0xFF).empty());
+        }
+        THEN("structures without strings are decoded") {
+            auto memory = tables.find(16);
+            REQUIRE(memory);
+            REQUIRE(memory->strings.empty());
+            REQUIRE(memory->byte(0x05) == 3);
+            REQUIRE(memory->word(0x0D) == 1);
+            REQUIRE(tables.find(19));
+        }
+        THEN("missing structures are not found") {
+            REQUIRE_FALSE(tables.find(2));
+        }
+    }
+    GIVEN("a table with a 64-bit entry point") {
+        REQUIRE(tables.read(fixtures + "server"));
+        THEN("the version is decoded") {
+            REQUIRE(tables.version() == 0x0302);
+        }
+        THEN("decoding stops at the end of the table") {
+            REQUIRE(tables.structures().size() == 5u);
+            REQUIRE(tables.structures().back().type == static_cast<uint8_t>(smbios::end_of_table));
+        }
+        THEN("surrounding whitespace is removed from strings") {
+            auto bios = tables.find(0);
+            REQUIRE(bios);
+            REQUIRE(bios->strings[1] == "2.11.2 ");
+            REQUIRE(bios->text(0x05) == "2.11.2");
+        }
+    }
+    GIVEN("an entry point with an invalid checksum") {
+        string entry_point = file::read(fixtures + "qemu/smbios_entry_point");
+        string table = file::read(fixtures + "qemu/DMI");
+        entry_point[0x04] ^= 0xFF;
+        THEN("the table is not decoded") {
+            REQUIRE_FALSE(tables.decode(entry_point, table));
+            REQUIRE(tables.structures().empty());
+        }
+    }
+    GIVEN("an entry point with an unknown anchor") {
+        THEN("the table is not decoded") {
+            REQUIRE_FALSE(tables.decode("_XX_", file::read(fixtures + "qemu/DMI")));
+        }
+    }
+    GIVEN("a truncated table") {
+        string entry_point = file::read(fixtures + "server/smbios_entry_point");
+        string table = file::read(fixtures + "server/DMI");
+        table.resize(0x40);
+        REQUIRE(tables.decode(entry_point, table));
+        THEN("only the complete structures are decoded") {
+            REQUIRE(tables.structures().size() == 1u);
+            REQUIRE(tables.structures().front().type == 0);
+        }
+    }
+}